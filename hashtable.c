@@ -12,15 +12,54 @@
 #include "hashtable_api.h"
 
 
+#if defined(HASHTABLE_DISABLE_SIMD)
+// Portable control byte matching only
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SLOT_GROUP_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SLOT_GROUP_NEON
+#endif // HASHTABLE_DISABLE_SIMD
+
+
+#if defined(HASHTABLE_DISABLE_SIMD)
+// Portable CRC-32C only
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define CRC32C_SSE42
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+#include <arm_acle.h>
+#define CRC32C_ARM
+#endif // HASHTABLE_DISABLE_SIMD
+
+
+/**
+ * @brief Hash function used when no configuration is given
+ */
+#ifndef HASHTABLE_DEFAULT_HASH
+#define HASHTABLE_DEFAULT_HASH hashtable_hash_fnv1a
+#endif // HASHTABLE_DEFAULT_HASH
+
+
 /**
- * @brief Max. size for an error message string
+ * @brief Storage class used for the last error, so that each thread has its own
  */
-#define MAX_ERROR_MSG_SIZE  (256u)
+#if !defined(HASHTABLE_THREAD_LOCAL)
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_THREADS__)
+#define HASHTABLE_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+#define HASHTABLE_THREAD_LOCAL __thread
+#else
+#define HASHTABLE_THREAD_LOCAL
+#endif // __STDC_VERSION__
+#endif // HASHTABLE_THREAD_LOCAL
 
 /**
- * @brief Internal error message macro
+ * @brief Internal error macro, records an error code and a pointer to a constant message
+ *        string (no message data is copied)
  */
-#define ERROR(msg) ((void) strncpy(_error_msg, msg, sizeof(_error_msg)))
+#define ERROR(error_code, msg) ((void) (_last_error.code = (error_code), _last_error.message = (msg)))
 
 
 /**
@@ -35,518 +74,7302 @@
  * given a specific number of array elements
  */
 #define ARRAY_SIZE_BYTES(array_count) \
-    (((array_count) * sizeof(_keyval_pair_list_t)) + sizeof(_keyval_pair_list_table_t))
+    ROUND_UP_PTRSIZE(((array_count) * sizeof(_keyval_pair_list_t)) + sizeof(_keyval_pair_list_table_t) + \
+                     _HASHTABLE_OCCUPANCY_BITMAP_SIZE(array_count) + _HASHTABLE_BLOOM_FILTER_SIZE(array_count))
+
+
+/**
+ * @brief Number of bits taken up by each table array slot after the table array, in the
+ * occupancy bitmap (and bloom filter, if HASHTABLE_BLOOM_FILTER is defined)
+ */
+#ifdef HASHTABLE_BLOOM_FILTER
+#define ARRAY_SLOT_EXTRA_BITS (1u + HASHTABLE_BLOOM_BITS_PER_SLOT)
+#else
+#define ARRAY_SLOT_EXTRA_BITS (1u)
+#endif // HASHTABLE_BLOOM_FILTER
+
+
+/**
+ * Number of lists migrated by each insert/remove/retrieve/has_key call while an
+ * incremental resize is in progress (in addition to the list for the key being accessed)
+ */
+#ifndef HASHTABLE_RESIZE_LISTS_PER_OP
+#define HASHTABLE_RESIZE_LISTS_PER_OP (8u)
+#endif // HASHTABLE_RESIZE_LISTS_PER_OP
+
+
+/**
+ * Number of table array slots zeroed by each insert/remove/retrieve/has_key call after
+ * hashtable_clear, until all slots left by the clear have been zeroed
+ */
+#ifndef HASHTABLE_CLEAR_LISTS_PER_OP
+#define HASHTABLE_CLEAR_LISTS_PER_OP (32u)
+#endif // HASHTABLE_CLEAR_LISTS_PER_OP
+
+
+/**
+ * @brief Helper macro for getting the size of a _keyval_pair_slot_table_t section,
+ * given a specific number of slots
+ */
+#define SLOT_TABLE_SIZE_BYTES(slot_count) \
+    ROUND_UP_PTRSIZE(sizeof(_keyval_pair_slot_table_t) + ((slot_count) * (sizeof(_HASHTABLE_LINK(_keyval_pair_t)) + 1u)))
 
 
 /**
  * @brief Helper macro for rounding a number up to the nearest multiple of the size of a pointer
  */
-#define ROUND_UP_PTRSIZE(size) (((size) + (sizeof(int *) - 1u)) & ~(sizeof(int *) - 1u))
+#define ROUND_UP_PTRSIZE(size) _HASHTABLE_ROUND_UP_PTRSIZE(size)
 
 
-static char _error_msg[MAX_ERROR_MSG_SIZE]  = {'\0'};
+/**
+ * @brief Helper macros for reading and writing links between structures in a table buffer
+ *        (see _HASHTABLE_LINK). 'td' is the table data section that the link is stored in.
+ */
+#ifdef HASHTABLE_OFFSET_POINTERS
+#define LINK_GET(td, link) ((void *) ((0u == (link)) ? NULL : (((uint8_t *) (td)) + (link))))
+#define LINK_SET(td, ptr) ((uint32_t) ((NULL == (ptr)) ? 0u : (((uint8_t *) (ptr)) - ((uint8_t *) (td)))))
+#else
+#define LINK_GET(td, link) ((void) (td), (link))
+#define LINK_SET(td, ptr) ((void) (td), (ptr))
+#endif // HASHTABLE_OFFSET_POINTERS
 
 
-// Default hash function
-static uint32_t _fnv1a_hash(const char *data, const hashtable_size_t size)
-{
-    // Constants taken from:
-    // https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
-    const uint32_t fnv32_prime = 0x01000193u;
-    uint32_t hash = 0x811c9dc5u;
+/**
+ * @brief Helper macros for following specific links in a table buffer
+ */
+#define PAIR_NEXT(td, pair) ((_keyval_pair_t *) LINK_GET(td, (pair)->next))
+#define LIST_HEAD(td, list) ((_keyval_pair_t *) LINK_GET(td, (list)->head))
+#ifndef HASHTABLE_NO_LIST_TAIL
+#define LIST_TAIL(td, list) ((_keyval_pair_t *) LINK_GET(td, (list)->tail))
+#endif // HASHTABLE_NO_LIST_TAIL
+#define SLOT_PAIR(td, slot_table, slot) ((_keyval_pair_t *) LINK_GET(td, (slot_table)->slots[slot]))
+#define FREELIST_HEAD(td, block, sizeclass) ((_keyval_pair_t *) LINK_GET(td, (block)->freelists[sizeclass]))
+#define CURSOR_ITEM(td) ((_keyval_pair_t *) LINK_GET(td, (td)->cursor_item))
+#define LIST_TABLE(td) ((_keyval_pair_list_table_t *) LINK_GET(td, (td)->list_table))
+#define SLOT_TABLE(td) ((_keyval_pair_slot_table_t *) LINK_GET(td, (td)->slot_table))
+#define DATA_BLOCK(td) ((_keyval_pair_data_block_t *) LINK_GET(td, (td)->data_block))
 
-    for (hashtable_size_t i = 0u; i < size; i++)
-    {
-        hash ^= (uint32_t) data[i];
-        hash *= fnv32_prime;
-    }
 
-    return hash;
-}
+/**
+ * @brief Helper macro for getting a pointer to the control bytes of a slot table, which
+ *        follow the slots[] array
+ */
+#define SLOT_CTRL(slot_table) ((uint8_t *) &(slot_table)->slots[(slot_table)->slot_count])
 
 
 /**
- * Append a new tail item to a list of keypairs
- *
- * @param list   Pointer to list to append
- * @param pair   Pointer to keypair to append
+ * @brief Largest key/value pair size held in an exact size class free list
  */
-static void _list_append(_keyval_pair_list_t *list, _keyval_pair_t *pair)
-{
-    if (NULL == list->head)
-    {
-        list->head = pair;
-        list->tail = pair;
-    }
-    else
-    {
-        list->tail->next = pair;
-        list->tail = pair;
-    }
+#define FREELIST_EXACT_MAX_SIZE (_HASHTABLE_FREELIST_EXACT_CLASSES * sizeof(int *))
 
-    pair->next = NULL;
-}
+
+/**
+ * @brief Smallest possible key/value pair size; unused space smaller than this is not split
+ *        off from a re-used free list pair
+ */
+#define FREELIST_MIN_PAIR_SIZE (ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t)))
 
 
 /**
- * Remove an item from any position in a list of keypairs
- *
- * @param list   Pointer to list to remove from
- * @param pair   Pointer to keypair to remove
- * @param prev   Pointer to previous keypair in the list
+ * @brief Lowest bit of the first word in unused space that is too small to hold a key/value pair
  */
-static void _list_remove(_keyval_pair_list_t *list, _keyval_pair_t *pair, _keyval_pair_t *prev)
-{
-    if (pair == list->head)
-    {
-        list->head = pair->next;
-    }
+#define GAP_MARKER_BIT (1u)
 
-    if (pair == list->tail)
-    {
-        list->tail = prev;
-    }
 
-    if (NULL != prev)
-    {
-        prev->next = pair->next;
-    }
+/**
+ * @brief Bit set in the link to the next pair in the free list, held in the first field of a
+ * freed key/value pair, so that freed pairs can be told apart from stored pairs when walking
+ * the data block. Links always point to aligned pairs, so the bit is never set otherwise.
+ */
+#define FREED_MARKER_BIT (2u)
+#define PAIR_IS_FREED(pair) (0u != (((uintptr_t) (pair)->next) & FREED_MARKER_BIT))
+#define FREED_LINK_SET(td, ptr) \
+    ((_HASHTABLE_LINK(_keyval_pair_t)) (((uintptr_t) LINK_SET(td, ptr)) | FREED_MARKER_BIT))
+#define FREED_NEXT(td, pair) ((_keyval_pair_t *) \
+    LINK_GET(td, (_HASHTABLE_LINK(_keyval_pair_t)) (((uintptr_t) (pair)->next) & ~((uintptr_t) FREED_MARKER_BIT))))
 
-    pair->next = NULL;
-}
+
+/**
+ * @brief Value stored at the start of every table buffer, "HTB" followed by a version number
+ */
+#define BUFFER_MAGIC (0x48544203u)
 
 
 /**
- * Calculate a hash for the given key data, and return a pointer to the list at the
- * corresponding table index, such that 'table_index := hash (mod) max_array_count'
- *
- * @param table     Pointer to hashtable instance
- * @param key       Pointer to key data
- * @param key_size  Key data size in bytes
- *
- * @return Pointer to list at corresponding table index
+ * @brief Key data hashed to make the hash function check value stored in a table buffer
  */
-static _keyval_pair_list_t *_get_table_list_by_key(hashtable_t *table, const char *key,
-                                                   const hashtable_size_t key_size)
-{
-    uint32_t hash = table->config.hash(key, key_size);
+#define HASH_CHECK_KEY "hashtable"
 
-    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
-    uint32_t table_index = hash % td->list_table->array_count;
-    return &td->list_table->table[table_index];
-}
+
+/**
+ * @brief Initial hash value for FNV-1a
+ */
+#define FNV1A_OFFSET_BASIS (0x811c9dc5u)
 
 
 /**
- * Search the list of freed key/value pairs, for one that is the same size or larger than
- * a specific size. If found, the pair will be removed from the free list and a pointer
- * to the pair will be returned.
- *
- * @param table          Pointer to hashtable instance
- * @param size_required  Number of bytes needed, look for a freed pair equal to or larger than this
- *
- * @return Pointer to pair that satisfies size requirement, or NULL if none was found
+ * @brief Value at the start of a snapshot written by hashtable_save ("HTS1" when read as bytes)
  */
-static _keyval_pair_t *_search_free_list(hashtable_t *table, size_t size_required)
-{
-    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
-    _keyval_pair_t *curr = td->data_block->freelist.head;
-    _keyval_pair_t *prev = NULL;
+#define SNAPSHOT_MAGIC (0x31535448u)
 
-    while (NULL != curr)
-    {
-        size_t size_available = ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + curr->key_size + curr->value_size);
-        if (size_available >= size_required)
-        {
-            /* Found a freed pair that is the same size or larger than what we need,
-             * so remove it from the free list and return a pointer */
-             _list_remove(&td->data_block->freelist, curr, prev);
 
-            return curr;
-        }
+/**
+ * @brief Snapshot format version written by hashtable_save
+ */
+#define SNAPSHOT_VERSION (1u)
 
-        // Save pointer from previous iteration, in case we need to remove the next item
-        prev = curr;
-        curr = curr->next;
-    }
 
-    return NULL;
-}
+/**
+ * @brief Sizes of the snapshot header, and of the header before each key/value pair
+ */
+#define SNAPSHOT_HEADER_SIZE (16u)
+#define SNAPSHOT_PAIR_HEADER_SIZE (8u)
+
 
 /**
- * Store a new key/value pair in the table->table_data section of a hashtable.
- *
- * This function will first try to find a suitable existing key/value pair in the
- * free list (data_block->freelist). If there is none, it will try to carve out the
- * required space in data_block->data. If data_block->data doesn't have the required
- * space, then a NULL pointer is returned.
- *
- * @param table       Pointer to hashtable instance
- * @param key         Pointer to key data
- * @param key_size    Key data size in bytes
- * @param value       Pointer to value data
- * @param value_size  Value data size in bytes
- *
- * @return Pointer to stored key/value pair, or NULL if there was not sufficient space to store
+ * @brief Flags stored in the layout descriptor of a table buffer
  */
-static _keyval_pair_t *_store_keyval_pair(hashtable_t *table, const char *key, const hashtable_size_t key_size,
-                                          const char *value, const hashtable_size_t value_size)
-{
-    _keyval_pair_t *ret = NULL;
-    size_t size_required = ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + key_size + value_size);
+#define LAYOUT_FLAG_STORE_HASH (0x1u)
+#define LAYOUT_FLAG_OFFSET_POINTERS (0x2u)
+#define LAYOUT_FLAG_PACKED_STRUCT (0x4u)
+#define LAYOUT_FLAG_POW2_ARRAY_COUNT (0x8u)
+#define LAYOUT_FLAG_FAST_RANGE (0x10u)
+#define LAYOUT_FLAG_BUCKET_HASH (0x20u)
+#define LAYOUT_FLAG_NO_LIST_TAIL (0x40u)
+#define LAYOUT_FLAG_BLOOM_FILTER (0x80u)
+#define LAYOUT_FLAG_ENABLE_STATS (0x100u)
+#define LAYOUT_FLAG_CACHE_EVICTION (0x200u)
 
-    // Prefer finding a suitable block in the free list, so check there first
-    ret = _search_free_list(table, size_required);
-    if (NULL == ret)
-    {
-        // Nothing suitable in the free list, see if we can carve out space in the data block
-        _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
-        size_t size_remaining = td->data_block->total_bytes - td->data_block->bytes_used;
 
-        if (size_required > size_remaining)
-        {
-            // Not enough space
-            return NULL;
-        }
+/**
+ * @brief Type of a gap marker, same as the first field of a key/value pair
+ */
+#ifdef HASHTABLE_OFFSET_POINTERS
+typedef uint32_t _gap_marker_t;
+#else
+typedef uintptr_t _gap_marker_t;
+#endif // HASHTABLE_OFFSET_POINTERS
 
-        // There is space in the data block
-        ret = (_keyval_pair_t *) (td->data_block->data + td->data_block->bytes_used);
 
-        // Increment bytes used
-        td->data_block->bytes_used += size_required;
-    }
+#if defined(HASHTABLE_BUCKET_HASH) && defined(HASHTABLE_NO_LIST_TAIL)
+#error("HASHTABLE_BUCKET_HASH needs the list tail link, and cannot be used with HASHTABLE_NO_LIST_TAIL")
+#endif // HASHTABLE_BUCKET_HASH && HASHTABLE_NO_LIST_TAIL
 
-    // Populate new entry
-    ret->key_size = key_size;
-    ret->value_size = value_size;
-    (void) memcpy(ret->data, key, key_size);
 
-    if ((0u < value_size) && (NULL != value))
-    {
-        (void) memcpy(ret->data + key_size, value, value_size);
-    }
+#if defined(HASHTABLE_POW2_ARRAY_COUNT) && defined(HASHTABLE_FAST_RANGE)
+#error("HASHTABLE_POW2_ARRAY_COUNT and HASHTABLE_FAST_RANGE cannot both be defined")
+#endif // HASHTABLE_POW2_ARRAY_COUNT && HASHTABLE_FAST_RANGE
 
-    return ret;
-}
+
+#if defined(HASHTABLE_CACHE_EVICTION) && (defined(HASHTABLE_CONCURRENT) || defined(HASHTABLE_RCU))
+#error("HASHTABLE_CACHE_EVICTION cannot be used with HASHTABLE_CONCURRENT or HASHTABLE_RCU")
+#endif // HASHTABLE_CACHE_EVICTION && (HASHTABLE_CONCURRENT || HASHTABLE_RCU)
 
 
 /**
- * Initialize the buffer for a new table structure
- *
- * @param table        Pointer to hashtable instance
- * @param array_count  Key/value pair list table array count
- * @param buffer       Pointer to location to buffer area
- * @param buffer_size  Buffer area size in bytes
- *
- * @return 0 if successful, -1 if an error occurred
+ * @brief 2^32 divided by the golden ratio, used to spread hash bits before reducing
+ * a hash value to a table index (fibonacci hashing)
  */
-static int _setup_new_table(uint32_t array_count, void *buffer, size_t buffer_size)
-{
-    size_t array_size = ARRAY_SIZE_BYTES(array_count);
-    size_t min_required_size = HASHTABLE_MIN_BUFFER_SIZE(array_count);
+#define FIBONACCI_MULTIPLIER (0x9e3779b9u)
 
-    if (buffer_size < min_required_size)
-    {
-        return 1;
-    }
 
-    uint8_t *u8_ret = (uint8_t *) buffer;
+/**
+ * @brief Multipliers for the murmur3 finalizer used to mix hash values before picking
+ * bloom filter words and bits, since a single multiply leaves the bits for nearby keys
+ * related when the table's hash function is weak (e.g. FNV-1a on integer keys)
+ */
+#define BLOOM_MIX_MULTIPLIER1 (0x85ebca6bu)
+#define BLOOM_MIX_MULTIPLIER2 (0xc2b2ae35u)
 
-    // Populate convenience pointers
-    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) buffer;
-    td->list_table = (_keyval_pair_list_table_t *) (u8_ret + sizeof(_keyval_pair_table_data_t));
-    td->data_block = (_keyval_pair_data_block_t *) (u8_ret + sizeof(_keyval_pair_table_data_t) + array_size);
 
-    // NULL-ify all the array entries
-    (void) memset(td->list_table, 0, array_size);
+/**
+ * @brief Helper macros for reading, setting and clearing bits in occupancy bitmap and
+ * bloom filter words. Atomic when table functions can be called from several threads at
+ * once, since one word covers table array slots that may be protected by different locks.
+ */
+#if defined(HASHTABLE_CONCURRENT) || defined(HASHTABLE_RCU)
+#define BITS_LOAD(word) __atomic_load_n(&(word), __ATOMIC_RELAXED)
+#define BITS_SET(word, bits) ((void) __atomic_fetch_or(&(word), (bits), __ATOMIC_RELAXED))
+#define BITS_CLEAR(word, bits) ((void) __atomic_fetch_and(&(word), ~(bits), __ATOMIC_RELAXED))
+#else
+#define BITS_LOAD(word) (word)
+#define BITS_SET(word, bits) ((void) ((word) |= (bits)))
+#define BITS_CLEAR(word, bits) ((void) ((word) &= ~(bits)))
+#endif // HASHTABLE_CONCURRENT || HASHTABLE_RCU
 
-    // Initialize cursor values
-    td->cursor_array_index = 0u;
-    td->cursor_items_traversed = 0u;
-    td->cursor_item = td->list_table->table[0].head;
-    td->cursor_limit = 0u;
 
-    td->list_table->array_count = array_count;
+/**
+ * @brief Helper macro for adding to a counter in the table data section (see
+ * HASHTABLE_ENABLE_STATS). Relaxed atomic when table functions can be called from several
+ * threads at once, and expands to nothing if HASHTABLE_ENABLE_STATS is not defined.
+ */
+#ifdef HASHTABLE_ENABLE_STATS
+#if defined(HASHTABLE_CONCURRENT) || defined(HASHTABLE_RCU)
+#define STATS_ADD(td, counter, n) ((void) __atomic_fetch_add(&(td)->stats.counter, (n), __ATOMIC_RELAXED))
+#define STATS_LOAD(td, counter) __atomic_load_n(&(td)->stats.counter, __ATOMIC_RELAXED)
+#else
+#define STATS_ADD(td, counter, n) ((void) ((td)->stats.counter += (n)))
+#define STATS_LOAD(td, counter) ((td)->stats.counter)
+#endif // HASHTABLE_CONCURRENT || HASHTABLE_RCU
+#else
+#define STATS_ADD(td, counter, n)
+#endif // HASHTABLE_ENABLE_STATS
 
-    // Initialize key/pair value data block
-    td->data_block->freelist.head = NULL;
-    td->data_block->freelist.tail = NULL;
-    td->data_block->total_bytes = buffer_size - min_required_size;
-    td->data_block->bytes_used = 0u;
 
-    return 0;
-}
+/**
+ * @brief Largest array count that can be rounded up to a power of 2
+ */
+#define MAX_POW2_ARRAY_COUNT (0x80000000u)
 
 
 /**
- * Search a single key/pair list for match key data
- *
- * @param table      Pointer to hashtable instance
- * @param list       Pointer to key/val pair list to search
- * @param key        Pointer to key data
- * @param key_size   Size of key data in bytes
- * @param previous   Pointer to location to store pointer to the item before the
- *                   matching item. Will only be populated if a matching item is
- *                   found (this may be needed if the caller wants to unlink the
- *                   matching item from the list).
- *
- * @return Pointer to key/val pair with matching key data, or NULL if none was found
+ * @brief Helper macro for rounding a slot count up to the nearest multiple of HASHTABLE_SLOT_GROUP_SIZE
  */
-static _keyval_pair_t *_search_list_by_key(_keyval_pair_list_t *list,
-                                           const char *key, const hashtable_size_t key_size,
-                                           _keyval_pair_t **previous)
+#define ROUND_UP_GROUP_SIZE(count) (((count) + (HASHTABLE_SLOT_GROUP_SIZE - 1u)) & ~(HASHTABLE_SLOT_GROUP_SIZE - 1u))
+
+
+/**
+ * @brief Control byte values for open addressing slots. Slots that are in use hold the
+ * lowest 7 bits of the hash value for the stored key (so the top bit is always clear)
+ */
+#define CTRL_EMPTY   (0x80u)
+#define CTRL_DELETED (0xfeu)
+#define CTRL_TAG(hash) ((uint8_t) ((hash) & 0x7fu))
+#define CTRL_IS_FULL(ctrl) (0u == ((ctrl) & 0x80u))
+
+
+/**
+ * @brief Returned by _slot_table_search when no matching slot was found
+ */
+#define SLOT_NOT_FOUND (UINT32_MAX)
+
+
+/**
+ * @brief Number of keys that batch functions hash and prefetch for at once
+ */
+#define BATCH_CHUNK_SIZE (16u)
+
+
+/**
+ * @brief Helper macro for issuing a prefetch of the cache line holding an address
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void) (addr))
+#endif // __GNUC__
+
+
+/**
+ * @brief Last error that occurred in the calling thread
+ */
+typedef struct
 {
-    _keyval_pair_t *curr = list->head;
-    _keyval_pair_t *prev = NULL;
+    hashtable_error_t code;  ///< Error code
+    const char *message;     ///< Error message, points to a string constant
+} _last_error_t;
 
-    while (NULL != curr)
-    {
-        if (curr->key_size == key_size)
-        {
-            if (0 == memcmp(key, curr->data, key_size))
-            {
-                if (NULL != previous)
-                {
-                    *previous = prev;
-                }
 
-                return curr;
-            }
-        }
+static HASHTABLE_THREAD_LOCAL _last_error_t _last_error = {HASHTABLE_ERROR_NONE, ""};
 
-        prev = curr;
-        curr = curr->next;
-    }
 
-    return NULL;
+#if defined(SLOT_GROUP_NEON)
+// Convert a NEON comparison result (0xff or 0x00 per byte) to a 16-bit mask
+static uint32_t _neon_movemask(uint8x16_t compare)
+{
+    static const uint8_t bits[16] = {1u, 2u, 4u, 8u, 16u, 32u, 64u, 128u,
+                                     1u, 2u, 4u, 8u, 16u, 32u, 64u, 128u};
+    uint8x16_t masked = vandq_u8(compare, vld1q_u8(bits));
+    return ((uint32_t) vaddv_u8(vget_low_u8(masked))) | (((uint32_t) vaddv_u8(vget_high_u8(masked))) << 8u);
 }
+#endif // SLOT_GROUP_NEON
 
 
 /**
- * Unlink a stored key/val pair from a specific key/val list, and add it to the free list
+ * Continue an FNV-1a hash over more data
  *
- * @param table   Pointer to hashtable instance
- * @param list    Pointer to list to remove key/val pair list from
- * @param item    Pointer to key/val pair to remove
- * @param prev    Pointer to item before the key/val pair to be removed
+ * @param hash  Hash value computed for all previous data
+ * @param data  Pointer to data
+ * @param size  Data size in bytes
  *
- * @return 0 if successful, -1 if an error occurred
+ * @return Hash value computed for all previous data, followed by the new data
  */
-static int _remove_from_table(hashtable_t *table, _keyval_pair_list_t *list,
-                              _keyval_pair_t *item, _keyval_pair_t *prev)
+static uint32_t _fnv1a_update(uint32_t hash, const char *data, size_t size)
 {
-    // Remove item from table list
-    _list_remove(list, item, prev);
+    // Constants taken from:
+    // https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
+    const uint32_t fnv32_prime = 0x01000193u;
 
-    // Add item to free list
-    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
-    _list_append(&td->data_block->freelist, item);
-    table->entry_count -= 1u;
+    for (size_t i = 0u; i < size; i++)
+    {
+        hash ^= (uint32_t) data[i];
+        hash *= fnv32_prime;
+    }
 
-    return 0;
+    return hash;
 }
 
 
 /**
- * Store a new key/value pair and insert references into the list table.
- * Uses the following steps:
- *
- * 1. First, look up the given key to see if it already exists in the hashtable.
- *    If it *does* already exist, and the space allocated is large enough for the
- *    new value data being inserted, then all we have to do is write the new value
- *    data in-place to the already-stored key/value. This would be optimal, both
+ * @see hashtable_api.h
+ */
+uint32_t hashtable_hash_fnv1a(const char *data, const hashtable_size_t size)
+{
+    return _fnv1a_update(FNV1A_OFFSET_BASIS, data, size);
+}
+
+
+/**
+ * Multiply two 64-bit values, and return the 128-bit result split into 2 halves
+ *
+ * @param a  Pointer to first value, replaced with the lower 64 bits of the result
+ * @param b  Pointer to second value, replaced with the upper 64 bits of the result
+ */
+static void _wyhash_mum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = ((__uint128_t) *a) * (*b);
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64u);
+#else
+    uint64_t ha = *a >> 32u;
+    uint64_t hb = *b >> 32u;
+    uint64_t la = (uint32_t) *a;
+    uint64_t lb = (uint32_t) *b;
+    uint64_t rh = ha * hb;
+    uint64_t rm0 = ha * lb;
+    uint64_t rm1 = hb * la;
+    uint64_t rl = la * lb;
+    uint64_t t = rl + (rm0 << 32u);
+    uint64_t c = (t < rl) ? 1u : 0u;
+    uint64_t lo = t + (rm1 << 32u);
+    c += (lo < t) ? 1u : 0u;
+    *a = lo;
+    *b = rh + (rm0 >> 32u) + (rm1 >> 32u) + c;
+#endif // __SIZEOF_INT128__
+}
+
+
+/**
+ * Multiply two 64-bit values, and fold the 128-bit result into 64 bits
+ */
+static uint64_t _wyhash_mix(uint64_t a, uint64_t b)
+{
+    _wyhash_mum(&a, &b);
+    return a ^ b;
+}
+
+
+// Read 8 or 4 bytes of key data, which may not be aligned
+static uint64_t _read64(const uint8_t *p)
+{
+    uint64_t v;
+    (void) memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t _read32(const uint8_t *p)
+{
+    uint32_t v;
+    (void) memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+
+/**
+ * wyhash (final version 4), by Wang Yi, folded to 32 bits. Key data is read 16 bytes at
+ * a time (48 bytes at a time for long keys).
+ *
+ * @param data  Pointer to key data
+ * @param size  Key data size in bytes
+ * @param seed  Seed value
+ *
+ * @return Hash value
+ */
+static uint32_t _wyhash(const char *data, size_t size, uint64_t seed)
+{
+    static const uint64_t secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                                       0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+    const uint8_t *p = (const uint8_t *) data;
+    uint64_t a = 0u;
+    uint64_t b = 0u;
+
+    seed ^= _wyhash_mix(seed ^ secret[0], secret[1]);
+
+    if (size <= 16u)
+    {
+        if (size >= 4u)
+        {
+            a = (_read32(p) << 32u) | _read32(p + ((size >> 3u) << 2u));
+            b = (_read32(p + size - 4u) << 32u) | _read32(p + size - 4u - ((size >> 3u) << 2u));
+        }
+        else if (size > 0u)
+        {
+            a = (((uint64_t) p[0]) << 16u) | (((uint64_t) p[size >> 1u]) << 8u) | p[size - 1u];
+        }
+    }
+    else
+    {
+        size_t i = size;
+
+        if (i > 48u)
+        {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+
+            do
+            {
+                seed = _wyhash_mix(_read64(p) ^ secret[1], _read64(p + 8u) ^ seed);
+                see1 = _wyhash_mix(_read64(p + 16u) ^ secret[2], _read64(p + 24u) ^ see1);
+                see2 = _wyhash_mix(_read64(p + 32u) ^ secret[3], _read64(p + 40u) ^ see2);
+                p += 48u;
+                i -= 48u;
+            }
+            while (i > 48u);
+
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16u)
+        {
+            seed = _wyhash_mix(_read64(p) ^ secret[1], _read64(p + 8u) ^ seed);
+            i -= 16u;
+            p += 16u;
+        }
+
+        a = _read64(p + i - 16u);
+        b = _read64(p + i - 8u);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    _wyhash_mum(&a, &b);
+
+    uint64_t hash = _wyhash_mix(a ^ secret[0] ^ size, b ^ secret[1]);
+    return (uint32_t) (hash ^ (hash >> 32u));
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+uint32_t hashtable_hash_wyhash(const char *data, const hashtable_size_t size)
+{
+    return _wyhash(data, size, 0u);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+uint32_t hashtable_hash_wyhash_seeded(const char *data, const hashtable_size_t size, uint64_t seed)
+{
+    return _wyhash(data, size, seed);
+}
+
+
+/**
+ * Continue a CRC-32C over more data (without the final inversion)
+ *
+ * @param crc   CRC value computed for all previous data
+ * @param data  Pointer to data
+ * @param size  Data size in bytes
+ *
+ * @return CRC value computed for all previous data, followed by the new data
+ */
+static uint32_t _crc32c_update(uint32_t crc, const char *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *) data;
+
+#if defined(CRC32C_SSE42) || defined(CRC32C_ARM)
+    uint64_t crc64 = crc;
+
+    for (; size >= 8u; size -= 8u, p += 8u)
+    {
+#if defined(CRC32C_SSE42)
+        crc64 = _mm_crc32_u64(crc64, _read64(p));
+#else
+        crc64 = __crc32cd((uint32_t) crc64, _read64(p));
+#endif // CRC32C_SSE42
+    }
+
+    crc = (uint32_t) crc64;
+
+    for (; size > 0u; size--, p++)
+    {
+#if defined(CRC32C_SSE42)
+        crc = _mm_crc32_u8(crc, *p);
+#else
+        crc = __crc32cb(crc, *p);
+#endif // CRC32C_SSE42
+    }
+#else
+    // One nibble at a time, with reflected polynomial 0x82f63b78
+    static const uint32_t nibble_table[16] =
+    {
+        0x00000000u, 0x105ec76fu, 0x20bd8edeu, 0x30e349b1u, 0x417b1dbcu, 0x5125dad3u, 0x61c69362u, 0x7198540du,
+        0x82f63b78u, 0x92a8fc17u, 0xa24bb5a6u, 0xb21572c9u, 0xc38d26c4u, 0xd3d3e1abu, 0xe330a81au, 0xf36e6f75u
+    };
+
+    for (; size > 0u; size--, p++)
+    {
+        crc ^= *p;
+        crc = (crc >> 4u) ^ nibble_table[crc & 0xfu];
+        crc = (crc >> 4u) ^ nibble_table[crc & 0xfu];
+    }
+#endif // CRC32C_SSE42 || CRC32C_ARM
+
+    return crc;
+}
+
+
+/**
+ * CRC-32C of key data, starting from a seed, with the result mixed so that all bits
+ * depend on all input bits (a plain CRC has weak upper bits for short keys)
+ *
+ * @param data  Pointer to key data
+ * @param size  Key data size in bytes
+ * @param seed  Seed value
+ *
+ * @return Hash value
+ */
+static uint32_t _crc32c_hash(const char *data, size_t size, uint64_t seed)
+{
+    uint32_t hash = ~_crc32c_update(~((uint32_t) (seed ^ (seed >> 32u))), data, size);
+
+    // Finalizer from MurmurHash3
+    hash ^= hash >> 16u;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13u;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16u;
+
+    return hash;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+uint32_t hashtable_hash_crc32c(const char *data, const hashtable_size_t size)
+{
+    return _crc32c_hash(data, size, 0u);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+uint32_t hashtable_hash_crc32c_seeded(const char *data, const hashtable_size_t size, uint64_t seed)
+{
+    return _crc32c_hash(data, size, seed);
+}
+
+
+/**
+ * Hash key data with the hash function from a table configuration
+ *
+ * @param config    Pointer to table configuration
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return Hash value computed for key data
+ */
+static uint32_t _config_hash(const hashtable_config_t *config, const char *key, const hashtable_size_t key_size)
+{
+    if (NULL != config->seeded_hash)
+    {
+        return config->seeded_hash(key, key_size, config->seed);
+    }
+
+    return config->hash(key, key_size);
+}
+
+
+/**
+ * Get the occupancy bitmap stored after the table array
+ *
+ * @param list_table  Pointer to table array
+ *
+ * @return Pointer to first occupancy bitmap word
+ */
+static uint32_t *_occupancy_bitmap(_keyval_pair_list_table_t *list_table)
+{
+    return (uint32_t *) &list_table->table[list_table->array_count];
+}
+
+
+/**
+ * Mark a list in the table array as empty or not empty in the occupancy bitmap
+ *
+ * @param td        Pointer to table data section holding the list
+ * @param list      Pointer to list
+ * @param occupied  1 if the list is not empty, 0 if it is empty
+ */
+static void _occupancy_update(_keyval_pair_table_data_t *td, _keyval_pair_list_t *list, int occupied)
+{
+    _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+    uint32_t index = (uint32_t) (list - list_table->table);
+    uint32_t *word = &_occupancy_bitmap(list_table)[index / 32u];
+    uint32_t bit = 1u << (index % 32u);
+
+    if (occupied)
+    {
+        BITS_SET(*word, bit);
+    }
+    else
+    {
+        BITS_CLEAR(*word, bit);
+    }
+}
+
+
+/**
+ * Check the occupancy bitmap bit of a list in the table array. A list with its bit clear is
+ * either empty, or left by hashtable_clear and not yet zeroed.
+ *
+ * @param td     Pointer to table data section holding the list
+ * @param index  Table array index of list
+ *
+ * @return 1 if the list is not empty, 0 otherwise
+ */
+static int _list_occupied(_keyval_pair_table_data_t *td, uint32_t index)
+{
+    return (0u != (BITS_LOAD(_occupancy_bitmap(LIST_TABLE(td))[index / 32u]) & (1u << (index % 32u)))) ? 1 : 0;
+}
+
+
+#ifdef HASHTABLE_BLOOM_FILTER
+/**
+ * Mix a hash value for picking bloom filter words and bits
+ *
+ * @param hash  Hash value computed for key data
+ *
+ * @return Mixed hash value
+ */
+static uint32_t _bloom_mix(uint32_t hash)
+{
+    hash ^= hash >> 16u;
+    hash *= BLOOM_MIX_MULTIPLIER1;
+    hash ^= hash >> 13u;
+    hash *= BLOOM_MIX_MULTIPLIER2;
+    hash ^= hash >> 16u;
+
+    return hash;
+}
+
+
+/**
+ * Get the bloom filter stored after the occupancy bitmap
+ *
+ * @param list_table  Pointer to table array
+ *
+ * @return Pointer to first bloom filter word
+ */
+static uint32_t *_bloom_filter(_keyval_pair_list_table_t *list_table)
+{
+    return _occupancy_bitmap(list_table) + (_HASHTABLE_OCCUPANCY_BITMAP_SIZE(list_table->array_count) / sizeof(uint32_t));
+}
+
+
+/**
+ * Find the bloom filter word for a hash value
+ *
+ * @param td    Pointer to table data section
+ * @param hash  Hash value computed for key data
+ *
+ * @return Pointer to bloom filter word
+ */
+static uint32_t *_bloom_word(_keyval_pair_table_data_t *td, uint32_t hash)
+{
+    _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+    uint32_t *filter = _bloom_filter(list_table);
+    uint32_t words = (uint32_t) (_HASHTABLE_BLOOM_FILTER_SIZE(list_table->array_count) / sizeof(uint32_t));
+
+    return &filter[(uint32_t) ((((uint64_t) _bloom_mix(hash)) * words) >> 32u)];
+}
+
+
+/**
+ * Get the 3 bloom filter bits set in a bloom filter word for a hash value
+ *
+ * @param hash  Hash value computed for key data
+ *
+ * @return Bloom filter bits
+ */
+static uint32_t _bloom_bits(uint32_t hash)
+{
+    // Low bits of the mixed hash, since the high bits pick the filter word
+    uint32_t mixed = _bloom_mix(hash);
+
+    return (1u << (mixed & 31u)) | (1u << ((mixed >> 5u) & 31u)) | (1u << ((mixed >> 10u) & 31u));
+}
+
+
+/**
+ * Add a hash value to the bloom filter of a table
+ *
+ * @param td    Pointer to table data section
+ * @param hash  Hash value computed for key data
+ */
+static void _bloom_add(_keyval_pair_table_data_t *td, uint32_t hash)
+{
+    BITS_SET(*_bloom_word(td, hash), _bloom_bits(hash));
+}
+
+
+/**
+ * Check if a hash value might have been added to the bloom filter of a table
+ *
+ * @param td    Pointer to table data section
+ * @param hash  Hash value computed for key data
+ *
+ * @return 1 if the hash value might have been added, 0 if it has definitely not been added
+ */
+static int _bloom_may_contain(_keyval_pair_table_data_t *td, uint32_t hash)
+{
+    uint32_t bits = _bloom_bits(hash);
+
+    return (BITS_LOAD(*_bloom_word(td, hash)) & bits) == bits;
+}
+#endif // HASHTABLE_BLOOM_FILTER
+
+
+/**
+ * Append a new tail item to a list of keypairs, or push a new head item if
+ * HASHTABLE_NO_LIST_TAIL is defined (since there is no link to the tail item)
+ *
+ * @param td     Pointer to table data section holding the list
+ * @param list   Pointer to list to append
+ * @param pair   Pointer to keypair to append
+ * @param hash   Hash value computed for key data of keypair to append
+ */
+static void _list_append(_keyval_pair_table_data_t *td, _keyval_pair_list_t *list, _keyval_pair_t *pair,
+                         uint32_t hash)
+{
+#if !defined(HASHTABLE_BUCKET_HASH) && !defined(HASHTABLE_BLOOM_FILTER)
+    (void) hash;
+#endif // !HASHTABLE_BUCKET_HASH && !HASHTABLE_BLOOM_FILTER
+
+#ifdef HASHTABLE_BLOOM_FILTER
+    _bloom_add(td, hash);
+#endif // HASHTABLE_BLOOM_FILTER
+
+#ifdef HASHTABLE_NO_LIST_TAIL
+    if (NULL == LIST_HEAD(td, list))
+    {
+        _occupancy_update(td, list, 1);
+    }
+
+    pair->next = list->head;
+    list->head = LINK_SET(td, pair);
+#else
+    if (NULL == LIST_HEAD(td, list))
+    {
+        _occupancy_update(td, list, 1);
+        list->head = LINK_SET(td, pair);
+        list->tail = LINK_SET(td, pair);
+#ifdef HASHTABLE_BUCKET_HASH
+        list->head_hash = hash;
+#endif // HASHTABLE_BUCKET_HASH
+    }
+    else
+    {
+        LIST_TAIL(td, list)->next = LINK_SET(td, pair);
+        list->tail = LINK_SET(td, pair);
+    }
+
+    pair->next = LINK_SET(td, NULL);
+#endif // HASHTABLE_NO_LIST_TAIL
+}
+
+
+/**
+ * Remove an item from any position in a list of keypairs
+ *
+ * @param td     Pointer to table data section holding the list
+ * @param list   Pointer to list to remove from
+ * @param pair   Pointer to keypair to remove
+ * @param prev   Pointer to previous keypair in the list
+ */
+static void _list_remove(_keyval_pair_table_data_t *td, _keyval_pair_list_t *list,
+                         _keyval_pair_t *pair, _keyval_pair_t *prev)
+{
+    if (pair == LIST_HEAD(td, list))
+    {
+        list->head = pair->next;
+
+        if (NULL == LIST_HEAD(td, list))
+        {
+            _occupancy_update(td, list, 0);
+        }
+    }
+
+#ifndef HASHTABLE_NO_LIST_TAIL
+    if (pair == LIST_TAIL(td, list))
+    {
+        list->tail = LINK_SET(td, prev);
+    }
+#endif // HASHTABLE_NO_LIST_TAIL
+
+    if (NULL != prev)
+    {
+        prev->next = pair->next;
+    }
+
+    pair->next = LINK_SET(td, NULL);
+}
+
+
+/**
+ * Reduce a hash value to an index in the range 0 to (count - 1). By default this is
+ * 'hash (mod) count'. With HASHTABLE_POW2_ARRAY_COUNT, count is always a power of 2, and
+ * the index is taken from the low bits of the hash value after multiplying by
+ * FIBONACCI_MULTIPLIER and folding the high bits down. With HASHTABLE_FAST_RANGE, the
+ * index is taken from the high bits of (hash * FIBONACCI_MULTIPLIER) * count. Neither
+ * needs a division, and the multiply spreads weak hash values over all indices.
+ *
+ * @param hash   Hash value computed for key data
+ * @param count  Number of possible indices, must not be 0
+ *
+ * @return Index
+ */
+static uint32_t _reduce_hash(uint32_t hash, uint32_t count)
+{
+#if defined(HASHTABLE_POW2_ARRAY_COUNT)
+    uint32_t mixed = hash * FIBONACCI_MULTIPLIER;
+    return (mixed ^ (mixed >> 16u)) & (count - 1u);
+#elif defined(HASHTABLE_FAST_RANGE)
+    return (uint32_t) ((((uint64_t) (hash * FIBONACCI_MULTIPLIER)) * count) >> 32u);
+#else
+    return hash % count;
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+}
+
+
+/**
+ * Return the table index corresponding to a hash value (see _reduce_hash)
+ *
+ * @param td    Pointer to table data section
+ * @param hash  Hash value computed for key data
+ *
+ * @return Table index
+ */
+static uint32_t _get_table_index(_keyval_pair_table_data_t *td, uint32_t hash)
+{
+    return _reduce_hash(hash, LIST_TABLE(td)->array_count);
+}
+
+
+/**
+ * Return a pointer to the list at the table index corresponding to a hash value
+ *
+ * @param td    Pointer to table data section
+ * @param hash  Hash value computed for key data
+ *
+ * @return Pointer to list at corresponding table index
+ */
+static _keyval_pair_list_t *_get_table_list_by_hash(_keyval_pair_table_data_t *td, uint32_t hash)
+{
+    uint32_t index = _get_table_index(td, hash);
+    _keyval_pair_list_t *list = &LIST_TABLE(td)->table[index];
+
+    // A slot left by hashtable_clear is zeroed before it is used
+    if (td->clear_in_progress && (index >= td->clear_index) && !_list_occupied(td, index))
+    {
+        (void) memset(list, 0, sizeof(*list));
+    }
+
+    return list;
+}
+
+
+/**
+ * Zero table array slots left by hashtable_clear, in index order from the first slot not
+ * yet zeroed. Slots with their occupancy bit set have been used since the clear, and are
+ * left alone. When the last slot is reached, the clear is complete.
+ *
+ * @param td         Pointer to table data section
+ * @param max_lists  Maximum number of table array slots to zero
+ */
+static void _clear_lists(_keyval_pair_table_data_t *td, uint32_t max_lists)
+{
+    _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+
+    for (uint32_t i = 0u; (i < max_lists) && (td->clear_index < list_table->array_count); i++)
+    {
+        if (!_list_occupied(td, td->clear_index))
+        {
+            (void) memset(&list_table->table[td->clear_index], 0, sizeof(_keyval_pair_list_t));
+        }
+
+        td->clear_index += 1u;
+    }
+
+    if (td->clear_index >= list_table->array_count)
+    {
+        td->clear_in_progress = 0u;
+    }
+}
+
+
+/**
+ * Zero all table array slots left by hashtable_clear, if any, so that every list in the
+ * table array can be read directly
+ *
+ * @param td  Pointer to table data section
+ */
+static void _clear_finish(_keyval_pair_table_data_t *td)
+{
+    if (td->clear_in_progress)
+    {
+        _clear_lists(td, UINT32_MAX);
+    }
+}
+
+
+/**
+ * Count trailing zero bits in a non-zero value
+ */
+static uint32_t _ctz32(uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t) __builtin_ctz(value);
+#else
+    uint32_t count = 0u;
+    while (0u == (value & 1u))
+    {
+        value >>= 1u;
+        count += 1u;
+    }
+
+    return count;
+#endif // __GNUC__
+}
+
+
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+/**
+ * Round a value up to the nearest power of 2
+ *
+ * @param value  Value to round up, must not be 0 or larger than MAX_POW2_ARRAY_COUNT
+ *
+ * @return Rounded value
+ */
+static uint32_t _round_up_pow2(uint32_t value)
+{
+    value -= 1u;
+    value |= value >> 1u;
+    value |= value >> 2u;
+    value |= value >> 4u;
+    value |= value >> 8u;
+    value |= value >> 16u;
+
+    return value + 1u;
+}
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+
+/**
+ * Get the number of bytes occupied by a key/value pair in the data block
+ *
+ * @param pair  Pointer to key/value pair
+ *
+ * @return Size of key/value pair in bytes
+ */
+static size_t _pair_size(const _keyval_pair_t *pair)
+{
+    return ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + pair->key_size + pair->value_size);
+}
+
+
+/**
+ * Get the free list size class for a key/value pair size. Small sizes map to one class
+ * per multiple of pointer size, larger sizes map to one class per power of two.
+ *
+ * @param size  Key/value pair size in bytes (always a multiple of pointer size)
+ *
+ * @return Size class index
+ */
+static uint32_t _freelist_class(size_t size)
+{
+    if (size <= FREELIST_EXACT_MAX_SIZE)
+    {
+        return (uint32_t) (size / sizeof(int *)) - 1u;
+    }
+
+    // Find the class for the highest bit set above FREELIST_EXACT_MAX_SIZE
+    uint32_t sizeclass = _HASHTABLE_FREELIST_EXACT_CLASSES;
+    size >>= 1u;
+    while ((size > FREELIST_EXACT_MAX_SIZE) && (sizeclass < (_HASHTABLE_FREELIST_CLASSES - 1u)))
+    {
+        size >>= 1u;
+        sizeclass += 1u;
+    }
+
+    return sizeclass;
+}
+
+
+/**
+ * Add a key/value pair to the free list for its size class
+ *
+ * @param td     Pointer to table data section
+ * @param pair   Pointer to key/value pair to add
+ */
+static void _freelist_push(_keyval_pair_table_data_t *td, _keyval_pair_t *pair)
+{
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    size_t size = _pair_size(pair);
+    uint32_t sizeclass = _freelist_class(size);
+
+    pair->next = FREED_LINK_SET(td, FREELIST_HEAD(td, block, sizeclass));
+    block->freelists[sizeclass] = LINK_SET(td, pair);
+    block->freelist_bitmap |= (1u << sizeclass);
+    block->free_count += 1u;
+    block->bytes_free += size;
+}
+
+
+/**
+ * Remove a key/value pair from the free list for a size class
+ *
+ * @param td         Pointer to table data section
+ * @param sizeclass  Size class index of free list to remove from
+ * @param pair       Pointer to key/value pair to remove
+ * @param prev       Pointer to previous key/value pair in the free list, NULL if pair is the head
+ */
+static void _freelist_remove(_keyval_pair_table_data_t *td, uint32_t sizeclass,
+                             _keyval_pair_t *pair, _keyval_pair_t *prev)
+{
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+
+    if (NULL == prev)
+    {
+        block->freelists[sizeclass] = LINK_SET(td, FREED_NEXT(td, pair));
+        if (NULL == FREED_NEXT(td, pair))
+        {
+            block->freelist_bitmap &= ~(1u << sizeclass);
+        }
+    }
+    else
+    {
+        prev->next = pair->next;
+    }
+
+    pair->next = LINK_SET(td, NULL);
+    block->free_count -= 1u;
+    block->bytes_free -= _pair_size(pair);
+}
+
+
+/**
+ * Empty all the free lists in a data block
+ *
+ * @param block  Pointer to data block
+ */
+static void _freelist_reset(_keyval_pair_data_block_t *block)
+{
+    (void) memset(block->freelists, 0, sizeof(block->freelists));
+    block->freelist_bitmap = 0u;
+    block->free_count = 0u;
+    block->bytes_free = 0u;
+}
+
+
+/**
+ * Release a freed key/value pair, by adding it to the free list for its size class. If an
+ * incremental compaction has not reached the pair yet, it is not added, and the space is
+ * reclaimed when the compaction gets there.
+ *
+ * @param td    Pointer to table data section
+ * @param pair  Pointer to freed key/value pair
+ */
+static void _release_pair(_keyval_pair_table_data_t *td, _keyval_pair_t *pair)
+{
+    if (td->compact_in_progress && (((uint8_t *) pair) >= (DATA_BLOCK(td)->data + td->compact_read_offset)))
+    {
+        pair->next = FREED_LINK_SET(td, NULL);
+        return;
+    }
+
+    _freelist_push(td, pair);
+}
+
+
+/**
+ * Write a gap marker to unused space in the data block, so that compaction (and anything
+ * else walking the data block) can step over it
+ *
+ * @param start  Pointer to start of unused space
+ * @param size   Size of unused space in bytes (always a non-zero multiple of pointer size)
+ */
+static void _write_gap(uint8_t *start, size_t size)
+{
+    _gap_marker_t marker = ((_gap_marker_t) size) | GAP_MARKER_BIT;
+    (void) memcpy(start, &marker, sizeof(marker));
+}
+
+
+/**
+ * Release unused space at the end of a stored key/value pair. If the space is large enough
+ * to hold a key/value pair, it becomes a new freed pair, otherwise a gap marker is written
+ * to it so that compaction can step over it.
+ *
+ * @param td     Pointer to table data section
+ * @param start  Pointer to start of unused space
+ * @param size   Size of unused space in bytes (always a multiple of pointer size)
+ */
+static void _release_unused(_keyval_pair_table_data_t *td, uint8_t *start, size_t size)
+{
+    if (size >= FREELIST_MIN_PAIR_SIZE)
+    {
+        _keyval_pair_t *split = (_keyval_pair_t *) start;
+        size_t data_size = size - sizeof(_keyval_pair_t);
+
+        split->key_size = (hashtable_size_t) (data_size / 2u);
+        split->value_size = (hashtable_size_t) (data_size - split->key_size);
+        _release_pair(td, split);
+    }
+    else if (0u < size)
+    {
+        _write_gap(start, size);
+    }
+}
+
+
+/**
+ * Get the size of a gap marked by #_release_unused, at a position in the data block where
+ * a key/value pair could also start. The first field of a key/value pair is always a link to
+ * an aligned pair (or NULL), so a gap marker can be told apart by its lowest bit.
+ *
+ * @param start  Pointer to position in data block
+ *
+ * @return Size of gap in bytes, or 0 if a key/value pair starts at this position
+ */
+static size_t _gap_size(const uint8_t *start)
+{
+    _gap_marker_t marker;
+    (void) memcpy(&marker, start, sizeof(marker));
+
+    return (0u != (marker & GAP_MARKER_BIT)) ? (size_t) (marker & ~((_gap_marker_t) GAP_MARKER_BIT)) : 0u;
+}
+
+
+/**
+ * Get the number of bytes that a new key/value pair should be moved forward by, so that the
+ * pair header and key data (everything read when searching for a key) sit in one cache line.
+ * If they are larger than a cache line, the pair is moved to the next cache line boundary.
+ * Always 0 unless HASHTABLE_CACHE_ALIGN_PAIRS is defined.
+ *
+ * @param start     Pointer to position in data block where the pair would start
+ * @param key_size  Key data size in bytes
+ *
+ * @return Number of padding bytes needed before the pair, always a multiple of pointer size
+ */
+static size_t _cache_align_padding(const uint8_t *start, const hashtable_size_t key_size)
+{
+#ifdef HASHTABLE_CACHE_ALIGN_PAIRS
+    size_t line_offset = (size_t) (((uintptr_t) start) & (_HASHTABLE_CACHE_LINE_SIZE - 1u));
+    size_t search_size = sizeof(_keyval_pair_t) + (size_t) key_size;
+
+    if ((0u == line_offset) || ((line_offset + search_size) <= _HASHTABLE_CACHE_LINE_SIZE))
+    {
+        return 0u;
+    }
+
+    return ROUND_UP_PTRSIZE(_HASHTABLE_CACHE_LINE_SIZE - line_offset);
+#else
+    (void) start;
+    (void) key_size;
+    return 0u;
+#endif // HASHTABLE_CACHE_ALIGN_PAIRS
+}
+
+
+/**
+ * Search the lists of freed key/value pairs, for one that is the same size or larger than
+ * a specific size. If found, the pair will be removed from its free list and a pointer
+ * to the pair will be returned.
+ *
+ * The size class for the required size is checked first (any pair in an exact size class
+ * is a fit, for other classes only the head pair is checked), and then the next non-empty
+ * larger size class is taken from the free list bitmap. If the pair found is large enough,
+ * the unused end of it is split off and added back to the free lists as a separate pair.
+ *
+ * @param td             Pointer to table data section
+ * @param size_required  Number of bytes needed, look for a freed pair equal to or larger than this
+ *
+ * @return Pointer to pair that satisfies size requirement, or NULL if none was found
+ */
+static _keyval_pair_t *_search_free_list(_keyval_pair_table_data_t *td, size_t size_required)
+{
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    uint32_t sizeclass = _freelist_class(size_required);
+    _keyval_pair_t *ret = NULL;
+    _keyval_pair_t *prev = NULL;
+
+    if (0u == block->freelist_bitmap)
+    {
+        return NULL;
+    }
+
+    STATS_ADD(td, freelist_searches, 1u);
+
+    ret = FREELIST_HEAD(td, block, sizeclass);
+    if (sizeclass == (_HASHTABLE_FREELIST_CLASSES - 1u))
+    {
+        // Largest class has no upper bound, so it needs to be searched
+        while ((NULL != ret) && (_pair_size(ret) < size_required))
+        {
+            STATS_ADD(td, freelist_search_steps, 1u);
+            prev = ret;
+            ret = FREED_NEXT(td, ret);
+        }
+    }
+    else if ((NULL != ret) && (_pair_size(ret) < size_required))
+    {
+        STATS_ADD(td, freelist_search_steps, 1u);
+        ret = NULL;
+    }
+
+    if (NULL == ret)
+    {
+        // All pairs in larger classes are large enough, take the first one
+        uint32_t larger = (sizeclass == (_HASHTABLE_FREELIST_CLASSES - 1u)) ? 0u :
+                          (block->freelist_bitmap & ~((2u << sizeclass) - 1u));
+        if (0u == larger)
+        {
+            return NULL;
+        }
+
+        sizeclass = _ctz32(larger);
+        ret = FREELIST_HEAD(td, block, sizeclass);
+        prev = NULL;
+    }
+
+    // The pair that is taken
+    STATS_ADD(td, freelist_search_steps, 1u);
+
+    _freelist_remove(td, sizeclass, ret, prev);
+
+    // Split off the unused end
+    _release_unused(td, ((uint8_t *) ret) + size_required, _pair_size(ret) - size_required);
+
+    return ret;
+}
+
+
+/**
+ * Allocate space for a new key/value pair in the table data section of a hashtable.
+ *
+ * This function will first try to find a suitable existing key/value pair in the
+ * free lists (data_block->freelists). If there is none, it will try to carve out the
+ * required space in data_block->data. If data_block->data doesn't have the required
+ * space, then a NULL pointer is returned.
+ *
+ * The key and value sizes of the new pair are populated, but the key and value data
+ * (and the hash, if HASHTABLE_STORE_HASH is defined) are not.
+ *
+ * @param td          Pointer to table data section
+ * @param reserved    Number of bytes at the end of data_block->data that must be left
+ *                    unused (space held back for pairs still waiting to be migrated by
+ *                    an incremental resize)
+ * @param key_size    Key data size in bytes
+ * @param value_size  Value data size in bytes
+ *
+ * @return Pointer to new key/value pair, or NULL if there was not sufficient space
+ */
+static _keyval_pair_t *_alloc_keyval_pair(_keyval_pair_table_data_t *td, size_t reserved,
+                                          const hashtable_size_t key_size, const hashtable_size_t value_size)
+{
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    _keyval_pair_t *ret = NULL;
+    size_t size_required = ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + key_size + value_size);
+
+    // Prefer finding a suitable block in the free list, so check there first
+    ret = _search_free_list(td, size_required);
+    if (NULL == ret)
+    {
+        // Nothing suitable in the free list, see if we can carve out space in the data block
+        size_t size_remaining = block->total_bytes - block->bytes_used;
+
+        if ((size_required > size_remaining) || (reserved > (size_remaining - size_required)))
+        {
+            // Not enough space
+            return NULL;
+        }
+
+        // Pad up to the next cache line only if it doesn't take space that is held back
+        size_t padding = _cache_align_padding(block->data + block->bytes_used, key_size);
+        if ((0u < padding) && (padding <= (size_remaining - size_required - reserved)))
+        {
+            _write_gap(block->data + block->bytes_used, padding);
+            block->bytes_used += padding;
+        }
+
+        // There is space in the data block
+        ret = (_keyval_pair_t *) (block->data + block->bytes_used);
+
+        // Increment bytes used
+        block->bytes_used += size_required;
+    }
+
+    // Populate new entry
+    ret->next = LINK_SET(td, NULL);
+    ret->key_size = key_size;
+    ret->value_size = value_size;
+#ifdef HASHTABLE_CACHE_EVICTION
+    ret->expiry = 0u;
+    ret->referenced = 0u;
+#endif // HASHTABLE_CACHE_EVICTION
+
+    return ret;
+}
+
+
+/**
+ * Store a new key/value pair in the table data section of a hashtable. Space for the
+ * pair is allocated by _alloc_keyval_pair.
+ *
+ * @param td          Pointer to table data section
+ * @param reserved    Number of bytes at the end of data_block->data that must be left
+ *                    unused (see _alloc_keyval_pair)
+ * @param hash        Hash value computed for key data
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data
+ * @param value_size  Value data size in bytes
+ *
+ * @return Pointer to stored key/value pair, or NULL if there was not sufficient space to store
+ */
+static _keyval_pair_t *_store_keyval_pair(_keyval_pair_table_data_t *td, size_t reserved, uint32_t hash,
+                                          const char *key, const hashtable_size_t key_size,
+                                          const char *value, const hashtable_size_t value_size)
+{
+    _keyval_pair_t *ret = _alloc_keyval_pair(td, reserved, key_size, value_size);
+    if (NULL == ret)
+    {
+        return NULL;
+    }
+
+#ifdef HASHTABLE_STORE_HASH
+    ret->hash = hash;
+#else
+    (void) hash;
+#endif // HASHTABLE_STORE_HASH
+    (void) memcpy(ret->data, key, key_size);
+
+    if ((0u < value_size) && (NULL != value))
+    {
+        (void) memcpy(ret->data + key_size, value, value_size);
+    }
+
+    return ret;
+}
+
+
+/**
+ * Get the hash value for a stored key/value pair. Uses the stored hash if
+ * HASHTABLE_STORE_HASH is defined, otherwise the key data is hashed again.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param pair   Pointer to stored key/value pair
+ *
+ * @return Hash value for key data
+ */
+static uint32_t _pair_hash(hashtable_t *table, _keyval_pair_t *pair)
+{
+#ifdef HASHTABLE_STORE_HASH
+    (void) table;
+    return pair->hash;
+#else
+    return _config_hash(&table->config, (char *) pair->data, pair->key_size);
+#endif // HASHTABLE_STORE_HASH
+}
+
+
+/**
+ * Update the hash value cached for the head item of a list (see HASHTABLE_BUCKET_HASH),
+ * after an item was removed from the list. Does nothing unless the head item was removed.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section holding the list
+ * @param list   Pointer to list an item was removed from
+ * @param prev   Pointer to item before the removed item, NULL if the head item was removed
+ */
+static void _list_update_head_hash(hashtable_t *table, _keyval_pair_table_data_t *td,
+                                   _keyval_pair_list_t *list, _keyval_pair_t *prev)
+{
+#ifdef HASHTABLE_BUCKET_HASH
+    _keyval_pair_t *head = LIST_HEAD(td, list);
+
+    if ((NULL == prev) && (NULL != head))
+    {
+        list->head_hash = _pair_hash(table, head);
+    }
+#else
+    (void) table;
+    (void) td;
+    (void) list;
+    (void) prev;
+#endif // HASHTABLE_BUCKET_HASH
+}
+
+
+/**
+ * Check if a stored key/value pair has matching key data. If HASHTABLE_STORE_HASH is
+ * defined, the stored hash is compared first, and key data is only compared if the
+ * hash matches.
+ *
+ * @param pair      Pointer to stored key/value pair
+ * @param hash      Hash value computed for key data
+ * @param key       Pointer to key data
+ * @param key_size  Size of key data in bytes
+ *
+ * @return 1 if key data matches, 0 otherwise
+ */
+static int _pair_has_key(_keyval_pair_t *pair, uint32_t hash, const char *key, const hashtable_size_t key_size)
+{
+#ifdef HASHTABLE_STORE_HASH
+    if (pair->hash != hash)
+    {
+        return 0;
+    }
+#else
+    (void) hash;
+#endif // HASHTABLE_STORE_HASH
+
+    return (pair->key_size == key_size) && (0 == memcmp(key, pair->data, key_size));
+}
+
+
+/**
+ * Get a bitmask of all control bytes in a group that are equal to a specific value
+ * (bit N set means control byte N matched).
+ *
+ * @param ctrl   Pointer to first control byte in the group
+ * @param value  Control byte value to match
+ *
+ * @return Bitmask of matching control bytes
+ */
+static uint32_t _group_match(const uint8_t *ctrl, uint8_t value)
+{
+#if defined(SLOT_GROUP_SSE2)
+    __m128i group = _mm_loadu_si128((const __m128i *) ctrl);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) value)));
+#elif defined(SLOT_GROUP_NEON)
+    return _neon_movemask(vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(value)));
+#else
+    uint32_t mask = 0u;
+    for (uint32_t i = 0u; i < HASHTABLE_SLOT_GROUP_SIZE; i++)
+    {
+        mask |= ((uint32_t) (ctrl[i] == value)) << i;
+    }
+
+    return mask;
+#endif // SLOT_GROUP_SSE2
+}
+
+
+/**
+ * Get a bitmask of all control bytes in a group that are either empty or deleted
+ * (bit N set means control byte N is not in use).
+ *
+ * @param ctrl   Pointer to first control byte in the group
+ *
+ * @return Bitmask of empty or deleted control bytes
+ */
+static uint32_t _group_match_empty_or_deleted(const uint8_t *ctrl)
+{
+    // Empty and deleted control bytes are the only ones with the top bit set
+#if defined(SLOT_GROUP_SSE2)
+    return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) ctrl));
+#elif defined(SLOT_GROUP_NEON)
+    return _neon_movemask(vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(ctrl)), vdupq_n_s8(0)));
+#else
+    uint32_t mask = 0u;
+    for (uint32_t i = 0u; i < HASHTABLE_SLOT_GROUP_SIZE; i++)
+    {
+        mask |= ((uint32_t) (ctrl[i] >> 7u)) << i;
+    }
+
+    return mask;
+#endif // SLOT_GROUP_SSE2
+}
+
+
+/**
+ * Get the index of the first group in the probe sequence for a specific hash value
+ *
+ * @param slot_table  Pointer to slot table
+ * @param hash        Hash value computed for key data
+ *
+ * @return Group index
+ */
+static uint32_t _slot_table_first_group(_keyval_pair_slot_table_t *slot_table, uint32_t hash)
+{
+    return _reduce_hash(hash >> 7u, slot_table->slot_count / HASHTABLE_SLOT_GROUP_SIZE);
+}
+
+
+/**
+ * Search a slot table for a key/value pair with matching key data. Groups of control
+ * bytes are probed in order starting from the group selected by the hash value, and the
+ * search stops at the first group that contains an empty slot.
+ *
+ * @param td          Pointer to table data section holding the slot table to search
+ * @param hash        Hash value computed for key data
+ * @param key         Pointer to key data
+ * @param key_size    Size of key data in bytes
+ *
+ * @return Index of slot holding matching key/value pair, or SLOT_NOT_FOUND if none was found
+ */
+static uint32_t _slot_table_search(_keyval_pair_table_data_t *td, uint32_t hash,
+                                   const char *key, const hashtable_size_t key_size)
+{
+    _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+    uint32_t group_count = slot_table->slot_count / HASHTABLE_SLOT_GROUP_SIZE;
+    uint32_t group = _slot_table_first_group(slot_table, hash);
+    uint8_t tag = CTRL_TAG(hash);
+
+    STATS_ADD(td, lookups, 1u);
+
+    for (uint32_t probes = 0u; probes < group_count; probes++)
+    {
+        const uint8_t *ctrl = SLOT_CTRL(slot_table) + (group * HASHTABLE_SLOT_GROUP_SIZE);
+        uint32_t mask = _group_match(ctrl, tag);
+
+        STATS_ADD(td, lookup_probes, 1u);
+
+        while (0u != mask)
+        {
+            uint32_t slot = (group * HASHTABLE_SLOT_GROUP_SIZE) + _ctz32(mask);
+            if (_pair_has_key(SLOT_PAIR(td, slot_table, slot), hash, key, key_size))
+            {
+                return slot;
+            }
+
+            // Clear lowest set bit
+            mask &= mask - 1u;
+        }
+
+        if (0u != _group_match(ctrl, CTRL_EMPTY))
+        {
+            // Key would have been stored in this group, if it existed
+            return SLOT_NOT_FOUND;
+        }
+
+        group = ((group + 1u) == group_count) ? 0u : (group + 1u);
+    }
+
+    return SLOT_NOT_FOUND;
+}
+
+
+/**
+ * Find the first empty or deleted slot in the probe sequence for a specific hash value.
+ * The caller must make sure that at least one slot is not in use.
+ *
+ * @param slot_table  Pointer to slot table to search
+ * @param hash        Hash value computed for key data
+ *
+ * @return Index of first empty or deleted slot
+ */
+static uint32_t _slot_table_find_unused(_keyval_pair_slot_table_t *slot_table, uint32_t hash)
+{
+    uint32_t group_count = slot_table->slot_count / HASHTABLE_SLOT_GROUP_SIZE;
+    uint32_t group = _slot_table_first_group(slot_table, hash);
+
+    while (1)
+    {
+        uint32_t mask = _group_match_empty_or_deleted(SLOT_CTRL(slot_table) + (group * HASHTABLE_SLOT_GROUP_SIZE));
+        if (0u != mask)
+        {
+            return (group * HASHTABLE_SLOT_GROUP_SIZE) + _ctz32(mask);
+        }
+
+        group = ((group + 1u) == group_count) ? 0u : (group + 1u);
+    }
+}
+
+
+/**
+ * Store a key/value pair pointer in the first unused slot in the probe sequence for
+ * a specific hash value. The caller must make sure that at least one slot is not in use.
+ *
+ * @param td          Pointer to table data section holding the slot table
+ * @param hash        Hash value computed for key data
+ * @param pair        Pointer to key/value pair to store
+ */
+static void _slot_table_place(_keyval_pair_table_data_t *td, uint32_t hash, _keyval_pair_t *pair)
+{
+    _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+    uint32_t slot = _slot_table_find_unused(slot_table, hash);
+
+    if (CTRL_DELETED == SLOT_CTRL(slot_table)[slot])
+    {
+        slot_table->deleted_count -= 1u;
+    }
+
+    SLOT_CTRL(slot_table)[slot] = CTRL_TAG(hash);
+    slot_table->slots[slot] = LINK_SET(td, pair);
+    slot_table->used_count += 1u;
+}
+
+
+/**
+ * Mark a slot as no longer in use. If the slot's group already contains an empty slot,
+ * then no search could have probed past this group, and the slot can be marked as empty.
+ * Otherwise it must be marked as deleted, so that searches continue past it.
+ *
+ * @param td          Pointer to table data section holding the slot table
+ * @param slot        Index of slot to release
+ */
+static void _slot_table_release(_keyval_pair_table_data_t *td, uint32_t slot)
+{
+    _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+    uint8_t *ctrl = SLOT_CTRL(slot_table);
+
+    if (0u != _group_match(ctrl + (slot & ~(HASHTABLE_SLOT_GROUP_SIZE - 1u)), CTRL_EMPTY))
+    {
+        ctrl[slot] = CTRL_EMPTY;
+    }
+    else
+    {
+        ctrl[slot] = CTRL_DELETED;
+        slot_table->deleted_count += 1u;
+    }
+
+    slot_table->slots[slot] = LINK_SET(td, NULL);
+    slot_table->used_count -= 1u;
+}
+
+
+/**
+ * Re-arrange all stored pairs in a slot table in-place, so that no deleted slots remain.
+ * This is done when a new pair cannot be stored because too many slots are deleted.
+ *
+ * All in-use slots are first marked as deleted (meaning "waiting to be placed"), and all
+ * deleted slots are marked as empty. Then each waiting pair is moved to the first unused
+ * slot in its probe sequence, swapping with any waiting pair found there.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param td          Pointer to table data section holding the slot table
+ */
+static void _slot_table_drop_deleted(hashtable_t *table, _keyval_pair_table_data_t *td)
+{
+    _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+    uint8_t *ctrl = SLOT_CTRL(slot_table);
+
+    for (uint32_t i = 0u; i < slot_table->slot_count; i++)
+    {
+        ctrl[i] = (CTRL_DELETED == ctrl[i]) ? CTRL_EMPTY : ((CTRL_EMPTY == ctrl[i]) ? CTRL_EMPTY : CTRL_DELETED);
+    }
+
+    uint32_t group_count = slot_table->slot_count / HASHTABLE_SLOT_GROUP_SIZE;
+
+    for (uint32_t i = 0u; i < slot_table->slot_count; i++)
+    {
+        if (CTRL_DELETED != ctrl[i])
+        {
+            continue;
+        }
+
+        uint32_t hash = _pair_hash(table, SLOT_PAIR(td, slot_table, i));
+        uint32_t first_group = _slot_table_first_group(slot_table, hash);
+        uint32_t target = _slot_table_find_unused(slot_table, hash);
+
+        // Number of groups probed before reaching the current and target slots
+        uint32_t current_probes = ((i / HASHTABLE_SLOT_GROUP_SIZE) + group_count - first_group) % group_count;
+        uint32_t target_probes = ((target / HASHTABLE_SLOT_GROUP_SIZE) + group_count - first_group) % group_count;
+
+        if (current_probes <= target_probes)
+        {
+            // Already in the best available group
+            ctrl[i] = CTRL_TAG(hash);
+        }
+        else if (CTRL_EMPTY == ctrl[target])
+        {
+            ctrl[target] = CTRL_TAG(hash);
+            slot_table->slots[target] = slot_table->slots[i];
+            ctrl[i] = CTRL_EMPTY;
+            slot_table->slots[i] = LINK_SET(td, NULL);
+        }
+        else
+        {
+            // Target holds another waiting pair, swap and process the current slot again
+            _HASHTABLE_LINK(_keyval_pair_t) tmp = slot_table->slots[target];
+            ctrl[target] = CTRL_TAG(hash);
+            slot_table->slots[target] = slot_table->slots[i];
+            slot_table->slots[i] = tmp;
+            i -= 1u;
+        }
+    }
+
+    slot_table->deleted_count = 0u;
+}
+
+
+/**
+ * Check if another key/value pair can be stored in a slot table, removing all deleted
+ * slots first if necessary. At most 7/8ths of the slots are used, so that searches always
+ * find an empty slot quickly. While an incremental resize is in progress, table->entry_count
+ * includes all pairs not yet migrated, so slots are also held back for those pairs.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param td          Pointer to table data section holding the slot table
+ *
+ * @return 1 if a new pair can be stored, 0 otherwise
+ */
+static int _slot_table_has_space(hashtable_t *table, _keyval_pair_table_data_t *td)
+{
+    _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+    uint32_t max_used = slot_table->slot_count - (slot_table->slot_count / 8u);
+
+    if ((table->entry_count + slot_table->deleted_count) < max_used)
+    {
+        return 1;
+    }
+
+    if (0u < slot_table->deleted_count)
+    {
+        _slot_table_drop_deleted(table, td);
+    }
+
+    return table->entry_count < max_used;
+}
+
+
+/**
+ * Number of table array slots, or open addressing slots, in a table data section
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section
+ */
+static uint32_t _array_count(hashtable_t *table, _keyval_pair_table_data_t *td)
+{
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        return SLOT_TABLE(td)->slot_count;
+    }
+
+    return LIST_TABLE(td)->array_count;
+}
+
+
+/**
+ * Copy a key/value pair from the table being migrated from by an incremental resize, into
+ * the table->table_data section. Space for the copy is guaranteed to be available, since
+ * table->resize_bytes_pending bytes are held back from all other allocations until the
+ * resize is complete.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param pair   Pointer to key/value pair to migrate
+ */
+static void _resize_migrate_pair(hashtable_t *table, _keyval_pair_t *pair)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    uint32_t hash = _pair_hash(table, pair);
+    char *key = (char *) pair->data;
+    size_t size = _pair_size(pair);
+
+    // Space for pairs still waiting to be migrated is held back from this one too
+    size_t reserved = (size < table->resize_bytes_pending) ? (table->resize_bytes_pending - size) : 0u;
+
+    _keyval_pair_t *copy = _store_keyval_pair(td, reserved, hash, key, pair->key_size,
+                                              key + pair->key_size, pair->value_size);
+#ifdef HASHTABLE_CACHE_EVICTION
+    copy->expiry = pair->expiry;
+    copy->referenced = pair->referenced;
+#endif // HASHTABLE_CACHE_EVICTION
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _slot_table_place(td, hash, copy);
+    }
+    else
+    {
+        _list_append(td, _get_table_list_by_hash(td, hash), copy, hash);
+    }
+
+    table->resize_bytes_pending = (size < table->resize_bytes_pending) ? (table->resize_bytes_pending - size) : 0u;
+}
+
+
+/**
+ * Migrate a single table array slot (or open addressing slot) from the table being migrated
+ * from by an incremental resize, leaving it empty.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param index  Index of table array slot to migrate
+ */
+static void _resize_migrate_index(hashtable_t *table, uint32_t index)
+{
+    _keyval_pair_table_data_t *old_td = (_keyval_pair_table_data_t *) table->resize_table_data;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(old_td);
+
+        if (CTRL_IS_FULL(SLOT_CTRL(slot_table)[index]))
+        {
+            _resize_migrate_pair(table, SLOT_PAIR(old_td, slot_table, index));
+
+            // Marked as deleted rather than empty, so searches of the old table still work
+            SLOT_CTRL(slot_table)[index] = CTRL_DELETED;
+        }
+
+        return;
+    }
+
+    _keyval_pair_list_t *list = &LIST_TABLE(old_td)->table[index];
+    for (_keyval_pair_t *curr = LIST_HEAD(old_td, list); NULL != curr; curr = PAIR_NEXT(old_td, curr))
+    {
+        _resize_migrate_pair(table, curr);
+    }
+
+    list->head = LINK_SET(old_td, NULL);
+#ifndef HASHTABLE_NO_LIST_TAIL
+    list->tail = LINK_SET(old_td, NULL);
+#endif // HASHTABLE_NO_LIST_TAIL
+}
+
+
+/**
+ * Stop using the buffer being migrated from by an incremental resize, and free it if it was
+ * allocated with the table's allocator
+ *
+ * @param table  Pointer to hashtable instance
+ */
+static void _resize_end(hashtable_t *table)
+{
+    if (table->resize_buffer_allocated)
+    {
+        table->config.allocator->free(table->config.allocator->ctx, table->resize_table_data);
+        table->resize_buffer_allocated = 0u;
+    }
+
+    table->resize_table_data = NULL;
+    table->resize_bytes_pending = 0u;
+    table->resize_array_index = 0u;
+}
+
+
+/**
+ * Migrate up to a specific number of table array slots from the table being migrated from
+ * by an incremental resize. If all slots have been migrated, the resize is completed and the
+ * buffer being migrated from is no longer used by the hashtable.
+ *
+ * @param table      Pointer to hashtable instance
+ * @param max_lists  Maximum number of table array slots to migrate
+ */
+static void _resize_migrate_lists(hashtable_t *table, uint32_t max_lists)
+{
+    uint32_t array_count = _array_count(table, (_keyval_pair_table_data_t *) table->resize_table_data);
+
+    for (uint32_t i = 0u; (i < max_lists) && (table->resize_array_index < array_count); i++)
+    {
+        _resize_migrate_index(table, table->resize_array_index);
+        table->resize_array_index += 1u;
+    }
+
+    if (table->resize_array_index >= array_count)
+    {
+        _resize_end(table);
+    }
+}
+
+
+/**
+ * Migrate the pair with matching key data (if any) from the table being migrated from by
+ * an incremental resize, and then migrate HASHTABLE_RESIZE_LISTS_PER_OP more table array
+ * slots to move the resize along.
+ *
+ * @param table     Pointer to hashtable instance
+ * @param hash      Hash value computed for key data
+ * @param key       Pointer to key data
+ * @param key_size  Size of key data in bytes
+ */
+static void _resize_migrate_for_key(hashtable_t *table, uint32_t hash,
+                                    const char *key, const hashtable_size_t key_size)
+{
+    _keyval_pair_table_data_t *old_td = (_keyval_pair_table_data_t *) table->resize_table_data;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot = _slot_table_search(old_td, hash, key, key_size);
+        if (SLOT_NOT_FOUND != slot)
+        {
+            _resize_migrate_index(table, slot);
+        }
+    }
+    else
+    {
+        _resize_migrate_index(table, _get_table_index(old_td, hash));
+    }
+
+    _resize_migrate_lists(table, HASHTABLE_RESIZE_LISTS_PER_OP);
+}
+
+
+/**
+ * Prepare a table for accessing key data with an already computed hash. If an incremental
+ * resize is in progress, the pair with matching key data in the table being migrated from
+ * is migrated first (along with a few more table array slots), so that table->table_data
+ * always contains all stored pairs that could match the given key. A few more table array
+ * slots left by hashtable_clear are also zeroed, if any are left.
+ *
+ * @param table     Pointer to hashtable instance
+ * @param hash      Hash value computed for key data
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return Hash value computed for key data
+ */
+static uint32_t _prepare_hash(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size)
+{
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_for_key(table, hash, key, key_size);
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    if (td->clear_in_progress)
+    {
+        _clear_lists(td, HASHTABLE_CLEAR_LISTS_PER_OP);
+    }
+
+    return hash;
+}
+
+
+/**
+ * Calculate a hash for the given key data, and prepare the table for accessing the key
+ * data (see _prepare_hash).
+ *
+ * @param table     Pointer to hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return Hash value computed for key data
+ */
+static uint32_t _hash_key(hashtable_t *table, const char *key, const hashtable_size_t key_size)
+{
+    return _prepare_hash(table, _config_hash(&table->config, key, key_size), key, key_size);
+}
+
+
+/**
+ * Get the min. required buffer size for a specific engine and array count
+ *
+ * @param engine       Hashtable engine
+ * @param array_count  Table array count, or number of slots for open addressing
+ *
+ * @return Min. required buffer size in bytes
+ */
+static size_t _min_buffer_size(hashtable_engine_t engine, uint32_t array_count)
+{
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == engine)
+    {
+        return HASHTABLE_MIN_BUFFER_SIZE_OPEN_ADDRESSING(array_count);
+    }
+
+    return HASHTABLE_MIN_BUFFER_SIZE(array_count);
+}
+
+
+/**
+ * Reset the iteration cursor for a table data section
+ *
+ * @param td  Pointer to table data section
+ */
+static void _reset_cursor(_keyval_pair_table_data_t *td)
+{
+    td->cursor_array_index = 0u;
+    td->cursor_items_traversed = 0u;
+    td->cursor_item = LINK_SET(td, NULL);
+    td->cursor_limit = 0u;
+}
+
+
+/**
+ * Describe the build options that affect the layout of a table buffer, so that a buffer
+ * created by an incompatible build can be detected by hashtable_attach
+ *
+ * @return Layout descriptor value
+ */
+static uint32_t _buffer_layout(void)
+{
+    uint32_t flags = 0u;
+
+#ifdef HASHTABLE_STORE_HASH
+    flags |= LAYOUT_FLAG_STORE_HASH;
+#endif // HASHTABLE_STORE_HASH
+
+#ifdef HASHTABLE_OFFSET_POINTERS
+    flags |= LAYOUT_FLAG_OFFSET_POINTERS;
+#endif // HASHTABLE_OFFSET_POINTERS
+
+#ifdef HASHTABLE_PACKED_STRUCT
+    flags |= LAYOUT_FLAG_PACKED_STRUCT;
+#endif // HASHTABLE_PACKED_STRUCT
+
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+    flags |= LAYOUT_FLAG_POW2_ARRAY_COUNT;
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+#ifdef HASHTABLE_FAST_RANGE
+    flags |= LAYOUT_FLAG_FAST_RANGE;
+#endif // HASHTABLE_FAST_RANGE
+
+#ifdef HASHTABLE_BUCKET_HASH
+    flags |= LAYOUT_FLAG_BUCKET_HASH;
+#endif // HASHTABLE_BUCKET_HASH
+
+#ifdef HASHTABLE_NO_LIST_TAIL
+    flags |= LAYOUT_FLAG_NO_LIST_TAIL;
+#endif // HASHTABLE_NO_LIST_TAIL
+
+#ifdef HASHTABLE_BLOOM_FILTER
+    flags |= LAYOUT_FLAG_BLOOM_FILTER;
+#endif // HASHTABLE_BLOOM_FILTER
+
+#ifdef HASHTABLE_ENABLE_STATS
+    flags |= LAYOUT_FLAG_ENABLE_STATS;
+#endif // HASHTABLE_ENABLE_STATS
+
+#ifdef HASHTABLE_CACHE_EVICTION
+    flags |= LAYOUT_FLAG_CACHE_EVICTION;
+#endif // HASHTABLE_CACHE_EVICTION
+
+    // Sizes of hashtable_size_t and pointers are at most 8, so they take 4 bits each
+    return ((uint32_t) sizeof(_keyval_pair_t)) |
+           (((uint32_t) sizeof(hashtable_size_t)) << 8u) |
+           (((uint32_t) sizeof(void *)) << 12u) |
+           (flags << 16u);
+}
+
+
+/**
+ * Compute the check value stored in a table buffer for a hash function, so that
+ * hashtable_attach can detect a buffer that was created with a different hash function
+ * (or seed)
+ *
+ * @param config  Pointer to table configuration holding the hash function
+ *
+ * @return Check value
+ */
+static uint32_t _hash_check_value(const hashtable_config_t *config)
+{
+    return _config_hash(config, HASH_CHECK_KEY, (hashtable_size_t) (sizeof(HASH_CHECK_KEY) - 1u));
+}
+
+
+/**
+ * Initialize the buffer for a new table structure
+ *
+ * @param config       Pointer to table configuration (the array count is ignored)
+ * @param array_count  Key/value pair list table array count, or number of slots for
+ *                     open addressing (must be a multiple of HASHTABLE_SLOT_GROUP_SIZE)
+ * @param buffer       Pointer to location to buffer area
+ * @param buffer_size  Buffer area size in bytes
+ *
+ * @return 0 if successful, 1 if buffer size is not large enough, -1 if an error occurred
+ */
+static int _setup_new_table(const hashtable_config_t *config, uint32_t array_count,
+                            void *buffer, size_t buffer_size)
+{
+    size_t min_required_size = _min_buffer_size(config->engine, array_count);
+
+    if (buffer_size < min_required_size)
+    {
+        return 1;
+    }
+
+#ifdef HASHTABLE_OFFSET_POINTERS
+    if (buffer_size > UINT32_MAX)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Buffer size must be 4GB or less with HASHTABLE_OFFSET_POINTERS");
+        return -1;
+    }
+#endif // HASHTABLE_OFFSET_POINTERS
+
+    uint8_t *u8_ret = (uint8_t *) buffer;
+    size_t array_size;
+
+    // Populate buffer header
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) buffer;
+    td->magic = BUFFER_MAGIC;
+    td->layout = _buffer_layout();
+    td->hash_check = _hash_check_value(config);
+    td->engine = (uint32_t) config->engine;
+
+    // Populate convenience pointers
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == config->engine)
+    {
+        array_size = SLOT_TABLE_SIZE_BYTES(array_count);
+
+        _keyval_pair_slot_table_t *slot_table = (_keyval_pair_slot_table_t *) (u8_ret + sizeof(_keyval_pair_table_data_t));
+        td->list_table = LINK_SET(td, NULL);
+        td->slot_table = LINK_SET(td, slot_table);
+
+        // NULL-ify all the slots
+        (void) memset(slot_table, 0, array_size);
+
+        slot_table->slot_count = array_count;
+        slot_table->used_count = 0u;
+        slot_table->deleted_count = 0u;
+
+        // Mark all slots as empty
+        (void) memset(SLOT_CTRL(slot_table), CTRL_EMPTY, array_count);
+    }
+    else
+    {
+        array_size = ARRAY_SIZE_BYTES(array_count);
+
+        _keyval_pair_list_table_t *list_table = (_keyval_pair_list_table_t *) (u8_ret + sizeof(_keyval_pair_table_data_t));
+        td->slot_table = LINK_SET(td, NULL);
+        td->list_table = LINK_SET(td, list_table);
+
+        // NULL-ify all the array entries
+        (void) memset(list_table, 0, array_size);
+
+        list_table->array_count = array_count;
+    }
+
+    _keyval_pair_data_block_t *block = (_keyval_pair_data_block_t *) (u8_ret + sizeof(_keyval_pair_table_data_t) + array_size);
+    td->data_block = LINK_SET(td, block);
+
+    // Initialize cursor values
+    _reset_cursor(td);
+
+    // Initialize key/pair value data block
+    _freelist_reset(block);
+    td->compact_in_progress = 0u;
+    td->compact_read_offset = 0u;
+    td->compact_write_offset = 0u;
+    td->clear_in_progress = 0u;
+    td->clear_index = 0u;
+#ifdef HASHTABLE_CACHE_EVICTION
+    td->clock_hand = 0u;
+#endif // HASHTABLE_CACHE_EVICTION
+#ifdef HASHTABLE_ENABLE_STATS
+    (void) memset(&td->stats, 0, sizeof(td->stats));
+#endif // HASHTABLE_ENABLE_STATS
+    block->total_bytes = buffer_size - min_required_size;
+    block->bytes_used = 0u;
+
+    return 0;
+}
+
+
+/**
+ * Search a single key/pair list for match key data. If HASHTABLE_STORE_HASH is defined,
+ * the hash stored with each pair is compared first, and key data is only compared
+ * for pairs with a matching hash.
+ *
+ * @param td         Pointer to table data section holding the list
+ * @param list       Pointer to key/val pair list to search
+ * @param hash       Hash value computed for key data
+ * @param key        Pointer to key data
+ * @param key_size   Size of key data in bytes
+ * @param previous   Pointer to location to store pointer to the item before the
+ *                   matching item. Will only be populated if a matching item is
+ *                   found (this may be needed if the caller wants to unlink the
+ *                   matching item from the list).
+ *
+ * @return Pointer to key/val pair with matching key data, or NULL if none was found
+ */
+static _keyval_pair_t *_search_list_by_key(_keyval_pair_table_data_t *td, _keyval_pair_list_t *list,
+                                           uint32_t hash, const char *key, const hashtable_size_t key_size,
+                                           _keyval_pair_t **previous)
+{
+    STATS_ADD(td, lookups, 1u);
+
+#ifdef HASHTABLE_BLOOM_FILTER
+    if (!_bloom_may_contain(td, hash))
+    {
+        return NULL;
+    }
+#endif // HASHTABLE_BLOOM_FILTER
+
+#ifdef HASHTABLE_BUCKET_HASH
+    // A list with 0 or 1 items can be ruled out without reading the item
+    if ((list->head == list->tail) && (list->head_hash != hash))
+    {
+        return NULL;
+    }
+#endif // HASHTABLE_BUCKET_HASH
+
+    _keyval_pair_t *curr = LIST_HEAD(td, list);
+    _keyval_pair_t *prev = NULL;
+
+#if !defined(HASHTABLE_STORE_HASH) && !defined(HASHTABLE_BUCKET_HASH) && !defined(HASHTABLE_BLOOM_FILTER)
+    (void) hash;
+#endif // !HASHTABLE_STORE_HASH && !HASHTABLE_BUCKET_HASH && !HASHTABLE_BLOOM_FILTER
+
+    while (NULL != curr)
+    {
+        STATS_ADD(td, lookup_probes, 1u);
+
+#ifdef HASHTABLE_STORE_HASH
+        if ((curr->hash == hash) && (curr->key_size == key_size))
+#else
+        if (curr->key_size == key_size)
+#endif // HASHTABLE_STORE_HASH
+        {
+            if (0 == memcmp(key, curr->data, key_size))
+            {
+                if (NULL != previous)
+                {
+                    *previous = prev;
+                }
+
+                return curr;
+            }
+        }
+
+        prev = curr;
+        curr = PAIR_NEXT(td, curr);
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Unlink a stored key/val pair from a specific key/val list, and add it to the free list
+ *
+ * @param table   Pointer to hashtable instance
+ * @param list    Pointer to list to remove key/val pair list from
+ * @param item    Pointer to key/val pair to remove
+ * @param prev    Pointer to item before the key/val pair to be removed
+ *
+ * @return 0 if successful, -1 if an error occurred
+ */
+static int _remove_from_table(hashtable_t *table, _keyval_pair_list_t *list,
+                              _keyval_pair_t *item, _keyval_pair_t *prev)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    // Remove item from table list
+    _list_remove(td, list, item, prev);
+    _list_update_head_hash(table, td, list, prev);
+
+    // Add item to free list
+    _release_pair(td, item);
+    table->entry_count -= 1u;
+
+    return 0;
+}
+
+
+/**
+ * Write new value data in-place to a stored key/value pair. The new value must be the
+ * same size or smaller than the existing value. Any space no longer needed by the pair
+ * is released.
+ *
+ * @param td          Pointer to table data section
+ * @param pair        Pointer to stored key/value pair
+ * @param value       Pointer to value data
+ * @param value_size  Value data size in bytes
+ */
+static void _overwrite_value(_keyval_pair_table_data_t *td, _keyval_pair_t *pair,
+                             const char *value, const hashtable_size_t value_size)
+{
+    size_t old_size = _pair_size(pair);
+
+    if ((0u < value_size) && (NULL != value))
+    {
+        (void) memcpy(pair->data + pair->key_size, value, value_size);
+    }
+
+    pair->value_size = value_size;
+#ifdef HASHTABLE_CACHE_EVICTION
+    pair->expiry = 0u;
+#endif // HASHTABLE_CACHE_EVICTION
+
+    size_t new_size = _pair_size(pair);
+    _release_unused(td, ((uint8_t *) pair) + new_size, old_size - new_size);
+}
+
+
+/**
+ * Store a new key/value pair and insert references into the list table.
+ * Uses the following steps:
+ *
+ * 1. First, look up the given key to see if it already exists in the hashtable.
+ *    If it *does* already exist, and the space allocated is large enough for the
+ *    new value data being inserted, then all we have to do is write the new value
+ *    data in-place to the already-stored key/value. This would be optimal, both
  *    in terms of execution time and memory efficiency.
  *
- *    If the given key *did* exist, but the available size was not large enough for the
- *    new value data, then we need to remove the existing key/pair data for the given
- *    key, and add it to the free list, since the next step involves storing new
- *    key/pair data with the given key.
+ *    If the given key *did* exist, but the available size was not large enough for the
+ *    new value data, then we need to remove the existing key/pair data for the given
+ *    key, and add it to the free list, since the next step involves storing new
+ *    key/pair data with the given key.
+ *
+ * 2. If the previous step failed, invoke _store_keyval_pair to find storage (either
+ *    from the free list, or by allocating new space in the data block) for the new
+ *    key/val pair.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param reserved    Number of bytes at the end of data_block->data that must be left
+ *                    unused (see _alloc_keyval_pair)
+ * @param hash        Hash value computed for key data by _hash_key
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data
+ * @param value_size  Value data size in bytes
+ *
+ * @return 0 if successful, -1 if enough space was not available
+ */
+static int _insert_keyval_pair(hashtable_t *table, size_t reserved, uint32_t hash,
+                               const char *key, const hashtable_size_t key_size,
+                               const char *value, const hashtable_size_t value_size)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+
+    _keyval_pair_t *prev = NULL;
+    _keyval_pair_t *pair = _search_list_by_key(td, list, hash, key, key_size, &prev);
+    if (NULL != pair)
+    {
+        // Item with this key already exists, check if new item can fit in existing slot
+        if (value_size <= pair->value_size)
+        {
+            // New value is the same size or smaller than existing, easy/quick update
+            _overwrite_value(td, pair, value, value_size);
+            return 0;
+        }
+        else
+        {
+            // Existing item is too small, need to remove it and insert a new item
+            if (_remove_from_table(table, list, pair, prev) < 0)
+            {
+                ERROR(HASHTABLE_ERROR_INVALID_STATE, "Item removal failed");
+                return -1;
+            }
+        }
+    }
+
+    // No item with this key exists, try to allocate new space
+    pair = _store_keyval_pair(td, reserved, hash, key, key_size, value, value_size);
+    if (NULL == pair)
+    {
+        return 1;
+    }
+
+    _list_append(td, list, pair, hash);
+    table->entry_count += 1u;
+
+    return 0;
+}
+
+
+/**
+ * Store a new key/value pair and insert a reference into the slot table. Works the same
+ * way as _insert_keyval_pair, but for open addressing tables.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param reserved    Number of bytes at the end of data_block->data that must be left
+ *                    unused (see _alloc_keyval_pair)
+ * @param hash        Hash value computed for key data by _hash_key
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data
+ * @param value_size  Value data size in bytes
+ *
+ * @return 0 if successful, 1 if enough space was not available
+ */
+static int _slot_table_insert_keyval_pair(hashtable_t *table, size_t reserved, uint32_t hash,
+                                          const char *key, const hashtable_size_t key_size,
+                                          const char *value, const hashtable_size_t value_size)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+    _keyval_pair_t *pair = NULL;
+
+    uint32_t slot = _slot_table_search(td, hash, key, key_size);
+    if (SLOT_NOT_FOUND != slot)
+    {
+        pair = SLOT_PAIR(td, slot_table, slot);
+
+        // Item with this key already exists, check if new item can fit in existing slot
+        if (value_size <= pair->value_size)
+        {
+            _overwrite_value(td, pair, value, value_size);
+            return 0;
+        }
+
+        // Existing item is too small, free it and store a new item in the same slot
+        _release_pair(td, pair);
+
+        pair = _store_keyval_pair(td, reserved, hash, key, key_size, value, value_size);
+        if (NULL == pair)
+        {
+            _slot_table_release(td, slot);
+            table->entry_count -= 1u;
+            return 1;
+        }
+
+        slot_table->slots[slot] = LINK_SET(td, pair);
+        return 0;
+    }
+
+    if (!_slot_table_has_space(table, td))
+    {
+        return 1;
+    }
+
+    pair = _store_keyval_pair(td, reserved, hash, key, key_size, value, value_size);
+    if (NULL == pair)
+    {
+        return 1;
+    }
+
+    _slot_table_place(td, hash, pair);
+    table->entry_count += 1u;
+
+    return 0;
+}
+
+
+/**
+ * Start migrating all stored key/value pairs into a new buffer. After this function
+ * returns, table->table_data points to the new buffer and table->resize_table_data
+ * points to the old one.
+ *
+ * @param table          Pointer to hashtable instance
+ * @param buffer         Pointer to new buffer
+ * @param buffer_size    New buffer size in bytes
+ * @param array_count    Table array count to use for new buffer, or 0 to choose one
+ * @param bytes_needed   Number of bytes of key/value pair data space that must be
+ *                       available in the new buffer to hold all stored pairs
+ *
+ * @return 0 if successful, 1 if the new buffer is not large enough, -1 if an error occurred
+ */
+static int _resize_start(hashtable_t *table, void *buffer, size_t buffer_size,
+                         uint32_t array_count, size_t bytes_needed)
+{
+    // Lists are migrated by table array index, so they must all be valid in the old buffer
+    _clear_finish((_keyval_pair_table_data_t *) table->table_data);
+
+    uintptr_t old_start = (uintptr_t) table->table_data;
+    uintptr_t new_start = (uintptr_t) buffer;
+
+    if ((new_start < (old_start + table->data_size)) && (old_start < (new_start + buffer_size)))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "New buffer overlaps existing table buffer");
+        return -1;
+    }
+
+    if (0u == array_count)
+    {
+        hashtable_config_t config;
+        (void) hashtable_default_config(&config, buffer_size);
+        array_count = config.array_count;
+    }
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        if (array_count > (UINT32_MAX - HASHTABLE_SLOT_GROUP_SIZE))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Array count too large");
+            return -1;
+        }
+
+        array_count = ROUND_UP_GROUP_SIZE(array_count);
+    }
+
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+    if (array_count > MAX_POW2_ARRAY_COUNT)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Array count too large");
+        return -1;
+    }
+
+    array_count = _round_up_pow2(array_count);
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        // Need enough slots for all stored pairs, without going over the max. load
+        if (table->entry_count >= (array_count - (array_count / 8u)))
+        {
+            return 1;
+        }
+    }
+
+    size_t min_required_size = _min_buffer_size(table->config.engine, array_count);
+    if ((buffer_size < min_required_size) || ((buffer_size - min_required_size) < bytes_needed))
+    {
+        return 1;
+    }
+
+    int ret = _setup_new_table(&table->config, array_count, buffer, buffer_size);
+    if (0 != ret)
+    {
+        return ret;
+    }
+
+#ifdef HASHTABLE_ENABLE_STATS
+    // Counters carry on in the new buffer
+    ((_keyval_pair_table_data_t *) buffer)->stats = ((_keyval_pair_table_data_t *) table->table_data)->stats;
+#endif // HASHTABLE_ENABLE_STATS
+
+    table->resize_table_data = table->table_data;
+    table->resize_bytes_pending = bytes_needed;
+    table->resize_array_index = 0u;
+    table->resize_buffer_allocated = table->buffer_allocated;
+    table->table_data = buffer;
+    table->data_size = buffer_size;
+    table->buffer_allocated = 0u;
+    table->config.array_count = array_count;
+
+    if (0u == table->entry_count)
+    {
+        // Nothing to migrate
+        _resize_end(table);
+    }
+
+    return 0;
+}
+
+
+/**
+ * Allocate a new buffer with the table's allocator, and start migrating all stored key/value
+ * pairs into it (see _resize_start). The new buffer is freed again if the resize can't start.
+ *
+ * @param table          Pointer to hashtable instance
+ * @param buffer_size    New buffer size in bytes
+ * @param array_count    Table array count to use for new buffer, or 0 to choose one
+ * @param bytes_needed   Number of bytes of key/value pair data space that must be
+ *                       available in the new buffer to hold all stored pairs
+ *
+ * @return 0 if successful, 1 if the buffer could not be allocated or is not large enough,
+ *         -1 if an error occurred
+ */
+static int _resize_start_allocated(hashtable_t *table, size_t buffer_size,
+                                   uint32_t array_count, size_t bytes_needed)
+{
+    const hashtable_allocator_t *allocator = table->config.allocator;
+
+    void *buffer = allocator->alloc(allocator->ctx, buffer_size);
+    if (NULL == buffer)
+    {
+        return 1;
+    }
+
+    int ret = _resize_start(table, buffer, buffer_size, array_count, bytes_needed);
+    if (0 != ret)
+    {
+        allocator->free(allocator->ctx, buffer);
+        return ret;
+    }
+
+    table->buffer_allocated = 1u;
+
+    return 0;
+}
+
+
+/**
+ * Start an incremental resize into a newly allocated buffer twice the size of the current
+ * buffer, with twice the array count, when an insertion found no space left. Any incremental
+ * resize already in progress is completed first.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param pair_space  Number of bytes needed for the key/value pair being inserted
+ *
+ * @return 0 if successful, 1 if a larger buffer could not be allocated, -1 if an error occurred
+ */
+static int _grow_table(hashtable_t *table, size_t pair_space)
+{
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    size_t bytes_needed = DATA_BLOCK(td)->bytes_used;
+    uint32_t array_count = table->config.array_count;
+
+    if (array_count <= (UINT32_MAX / 4u))
+    {
+        array_count *= 2u;
+    }
+
+    size_t min_size = _min_buffer_size(table->config.engine, array_count);
+    if ((SIZE_MAX - min_size - bytes_needed) < pair_space)
+    {
+        return 1;
+    }
+
+    min_size += bytes_needed + pair_space;
+    size_t buffer_size = (table->data_size > (SIZE_MAX / 2u)) ? SIZE_MAX : (table->data_size * 2u);
+    if (buffer_size < min_size)
+    {
+        buffer_size = min_size;
+    }
+
+#ifdef HASHTABLE_OFFSET_POINTERS
+    if (buffer_size > UINT32_MAX)
+    {
+        // Offsets can't address more than 4GB, _resize_start will fail if this is too small
+        buffer_size = UINT32_MAX;
+    }
+#endif // HASHTABLE_OFFSET_POINTERS
+
+    return _resize_start_allocated(table, buffer_size, array_count, bytes_needed);
+}
+
+
+/**
+ * Move a key/value pair visited by compaction to a new location, if it is stored in the
+ * table, and update the reference to it in the table (and in the iteration cursor).
+ *
+ * Freed pairs are not referenced by the table, so they are found to be not stored (a freed
+ * pair may have the same key as a stored pair, so the pair pointers must be compared).
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section
+ * @param pair   Pointer to key/value pair visited by compaction
+ * @param dest   Pointer to location to move pair to, must not be higher than pair
+ *
+ * @return 1 if pair is stored in the table and was moved, 0 if pair is a freed pair
+ */
+static int _compact_move_pair(hashtable_t *table, _keyval_pair_table_data_t *td,
+                              _keyval_pair_t *pair, _keyval_pair_t *dest)
+{
+    uint32_t hash = _pair_hash(table, pair);
+    char *key = (char *) pair->data;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot = _slot_table_search(td, hash, key, pair->key_size);
+        if ((SLOT_NOT_FOUND == slot) || (SLOT_PAIR(td, SLOT_TABLE(td), slot) != pair))
+        {
+            return 0;
+        }
+
+        (void) memmove(dest, pair, _pair_size(pair));
+        SLOT_TABLE(td)->slots[slot] = LINK_SET(td, dest);
+
+        return 1;
+    }
+
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+    _keyval_pair_t *prev = NULL;
+
+    if (_search_list_by_key(td, list, hash, key, pair->key_size, &prev) != pair)
+    {
+        return 0;
+    }
+
+    (void) memmove(dest, pair, _pair_size(pair));
+
+    // Update references to the moved pair
+    if (NULL == prev)
+    {
+        list->head = LINK_SET(td, dest);
+    }
+    else
+    {
+        prev->next = LINK_SET(td, dest);
+    }
+
+#ifndef HASHTABLE_NO_LIST_TAIL
+    if (LIST_TAIL(td, list) == pair)
+    {
+        list->tail = LINK_SET(td, dest);
+    }
+#endif // HASHTABLE_NO_LIST_TAIL
+
+    if (CURSOR_ITEM(td) == pair)
+    {
+        td->cursor_item = LINK_SET(td, dest);
+    }
+
+    return 1;
+}
+
+
+/**
+ * Start an incremental compaction. All free lists are emptied, since freed pairs will be
+ * reclaimed by the compaction.
+ *
+ * @param td  Pointer to table data section
+ */
+static void _compact_start(_keyval_pair_table_data_t *td)
+{
+    if (!td->compact_in_progress)
+    {
+        _freelist_reset(DATA_BLOCK(td));
+        td->compact_read_offset = 0u;
+        td->compact_write_offset = 0u;
+        td->compact_in_progress = 1u;
+    }
+}
+
+
+#ifdef HASHTABLE_BLOOM_FILTER
+/**
+ * Rebuild the bloom filter of a table from the stored key/value pairs, dropping the bits
+ * that were only set by removed keys
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section
+ */
+static void _bloom_rebuild(hashtable_t *table, _keyval_pair_table_data_t *td)
+{
+    _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+
+    _clear_finish(td);
+    (void) memset(_bloom_filter(list_table), 0, _HASHTABLE_BLOOM_FILTER_SIZE(list_table->array_count));
+
+    for (uint32_t i = 0u; i < list_table->array_count; i++)
+    {
+        for (_keyval_pair_t *curr = LIST_HEAD(td, &list_table->table[i]); NULL != curr; curr = PAIR_NEXT(td, curr))
+        {
+            _bloom_add(td, _pair_hash(table, curr));
+        }
+    }
+}
+#endif // HASHTABLE_BLOOM_FILTER
+
+
+/**
+ * Visit key/value pairs for an incremental compaction, starting from the lowest address
+ * not yet visited; stored pairs are moved down to the end of the pairs already compacted,
+ * and freed pairs and gaps are skipped. When the end of the used space in the data block
+ * is reached, the compaction is complete and the space after the last moved pair becomes
+ * unused.
+ *
+ * @param table      Pointer to hashtable instance
+ * @param max_bytes  Maximum number of bytes to visit (at least one pair is visited)
+ */
+static void _compact_pairs(hashtable_t *table, size_t max_bytes)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    size_t bytes_visited = 0u;
+
+    while ((td->compact_read_offset < block->bytes_used) && (bytes_visited < max_bytes))
+    {
+        uint8_t *start = block->data + td->compact_read_offset;
+        size_t size = _gap_size(start);
+
+        if (0u == size)
+        {
+            _keyval_pair_t *pair = (_keyval_pair_t *) start;
+            size = _pair_size(pair);
+
+            // A pair is never moved up past its own position to make room for padding
+            size_t padding = _cache_align_padding(block->data + td->compact_write_offset, pair->key_size);
+            if (padding > (td->compact_read_offset - td->compact_write_offset))
+            {
+                padding = td->compact_read_offset - td->compact_write_offset;
+            }
+
+            // Freed pairs are skipped without searching the table for them
+            if ((!PAIR_IS_FREED(pair)) &&
+                _compact_move_pair(table, td, pair,
+                                   (_keyval_pair_t *) (block->data + td->compact_write_offset + padding)))
+            {
+                if (0u < padding)
+                {
+                    _write_gap(block->data + td->compact_write_offset, padding);
+                }
+
+                td->compact_write_offset += padding + size;
+            }
+        }
+
+        td->compact_read_offset += size;
+        bytes_visited += size;
+    }
+
+    if (td->compact_read_offset >= block->bytes_used)
+    {
+        block->bytes_used = td->compact_write_offset;
+        td->compact_in_progress = 0u;
+#ifdef HASHTABLE_CACHE_EVICTION
+        // Pairs have moved, so the hand may no longer point at the start of one
+        td->clock_hand = 0u;
+#endif // HASHTABLE_CACHE_EVICTION
+
+#ifdef HASHTABLE_BLOOM_FILTER
+        if (HASHTABLE_ENGINE_CHAINING == table->config.engine)
+        {
+            _bloom_rebuild(table, td);
+        }
+#endif // HASHTABLE_BLOOM_FILTER
+    }
+}
+
+
+#ifdef HASHTABLE_CACHE_EVICTION
+/**
+ * Check if a stored key/value pair has expired, at the current time of a table
+ *
+ * @param table  Pointer to hashtable instance
+ * @param pair   Pointer to stored key/value pair
+ *
+ * @return 1 if the pair has expired, 0 otherwise
+ */
+static int _pair_expired(hashtable_t *table, _keyval_pair_t *pair)
+{
+    // Times are compared by their wrapping difference, so the table time can wrap around
+    return (0u != pair->expiry) && ((table->cache_time - pair->expiry) < 0x80000000u);
+}
+
+
+/**
+ * Remove a key/value pair from the table->table_data section, if it is stored in the table.
+ * Pairs that are not referenced by the table (such as a pair reserved by hashtable_reserve)
+ * are left alone, so the pair pointers must be compared.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param pair   Pointer to key/value pair in the table->table_data section
+ *
+ * @return 1 if the pair was stored in the table and was removed, 0 otherwise
+ */
+static int _cache_remove_pair(hashtable_t *table, _keyval_pair_t *pair)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    uint32_t hash = _pair_hash(table, pair);
+    char *key = (char *) pair->data;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot = _slot_table_search(td, hash, key, pair->key_size);
+        if ((SLOT_NOT_FOUND == slot) || (SLOT_PAIR(td, SLOT_TABLE(td), slot) != pair))
+        {
+            return 0;
+        }
+
+        _release_pair(td, pair);
+        _slot_table_release(td, slot);
+        table->entry_count -= 1u;
+
+        return 1;
+    }
+
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+    _keyval_pair_t *prev = NULL;
+
+    if (_search_list_by_key(td, list, hash, key, pair->key_size, &prev) != pair)
+    {
+        return 0;
+    }
+
+    (void) _remove_from_table(table, list, pair, prev);
+    return 1;
+}
+
+
+/**
+ * Evict one key/value pair from the table->table_data section, picked by the CLOCK hand.
+ * The hand walks the data block in address order from where it last stopped, stepping over
+ * gaps and freed pairs, and clears the reference bit of each pair found by a search since
+ * the hand last passed it. The first pair that has expired, or has no reference bit set,
+ * is evicted.
+ *
+ * @param table  Pointer to hashtable instance
+ *
+ * @return 0 if a pair was evicted, 1 if no pair could be evicted
+ */
+static int _cache_evict(hashtable_t *table)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+
+    // Pairs are moved by a compaction, so the hand can only walk the data block once it is complete
+    if (td->compact_in_progress)
+    {
+        _compact_pairs(table, SIZE_MAX);
+    }
+
+    // All reference bits are cleared by one pass over the data block, so a second pass evicts any pair
+    size_t bytes_visited = 0u;
+
+    while (bytes_visited < (2u * block->bytes_used))
+    {
+        if (td->clock_hand >= block->bytes_used)
+        {
+            td->clock_hand = 0u;
+        }
+
+        uint8_t *start = block->data + td->clock_hand;
+        size_t size = _gap_size(start);
+
+        if (0u == size)
+        {
+            _keyval_pair_t *pair = (_keyval_pair_t *) start;
+            size = _pair_size(pair);
+
+            if (!PAIR_IS_FREED(pair))
+            {
+                if (pair->referenced && !_pair_expired(table, pair))
+                {
+                    pair->referenced = 0u;
+                }
+                else if (_cache_remove_pair(table, pair))
+                {
+                    td->clock_hand += size;
+                    return 0;
+                }
+            }
+        }
+
+        td->clock_hand += size;
+        bytes_visited += size;
+    }
+
+    return 1;
+}
+
+
+/**
+ * Make space for a new key/value pair in a table that is full. Freed pairs are never merged,
+ * so if enough space is free in total for the new pair, the data block is compacted, so that
+ * all of the free space becomes unused space at the end. Otherwise a stored pair is evicted
+ * (see _cache_evict), and if none is left in the table->table_data section, any incremental
+ * resize in progress is completed so that the migrated pairs can be evicted. Nothing is
+ * evicted for a pair that is larger than the whole data block.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param key_size    Key data size in bytes
+ * @param value_size  Value data size in bytes
+ *
+ * @return 0 if the caller should retry, 1 if no stored pair is left to evict
+ */
+static int _cache_make_space(hashtable_t *table, const hashtable_size_t key_size,
+                             const hashtable_size_t value_size)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    size_t size_required = ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + key_size + value_size);
+    size_t bytes_free = (block->total_bytes - block->bytes_used) + block->bytes_free;
+
+    // Don't evict anything for a pair that would not fit even in an empty data block
+    if (size_required > block->total_bytes)
+    {
+        return 1;
+    }
+
+    /* Compaction empties the free lists, so the data block is not compacted again until more
+     * pairs are freed. A full open addressing table needs a free slot more than free space. */
+    if ((0u < block->bytes_free) && (size_required <= bytes_free) &&
+        (NULL == table->resize_table_data) && (NULL == table->reserved_pair) &&
+        ((HASHTABLE_ENGINE_CHAINING == table->config.engine) || _slot_table_has_space(table, td)))
+    {
+        _compact_start(td);
+        _compact_pairs(table, SIZE_MAX);
+        return 0;
+    }
+
+    if (0 == _cache_evict(table))
+    {
+        return 0;
+    }
+
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_lists(table, UINT32_MAX);
+        return 0;
+    }
+
+    return 1;
+}
+#endif // HASHTABLE_CACHE_EVICTION
+
+
+/**
+ * Handle a table running out of space for a new key/value pair. With
+ * HASHTABLE_CACHE_EVICTION, space is made by evicting stored pairs first (see
+ * _cache_make_space). If the table has an allocator, it starts moving into a larger buffer,
+ * and the hash is prepared again for the new buffer (see _prepare_hash) so the caller can retry.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param hash        Pointer to hash value computed for key data by _hash_key
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value_size  Value data size in bytes
+ *
+ * @return 0 if the caller should retry, 1 if no more space is available, -1 if an error occurred
+ */
+static int _grow_for_pair(hashtable_t *table, uint32_t *hash, const char *key, const hashtable_size_t key_size,
+                          const hashtable_size_t value_size)
+{
+#ifdef HASHTABLE_CACHE_EVICTION
+    if (0 == _cache_make_space(table, key_size, value_size))
+    {
+        return 0;
+    }
+#endif // HASHTABLE_CACHE_EVICTION
+
+    if (NULL == table->config.allocator)
+    {
+        return 1;
+    }
+
+    // Out of space, start moving into a larger buffer and try again
+    int ret = _grow_table(table, ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + key_size + value_size));
+    if (0 != ret)
+    {
+        return ret;
+    }
+
+    // The key may already be stored in the buffer being migrated from
+    *hash = _prepare_hash(table, *hash, key, key_size);
+    return 0;
+}
+
+
+/**
+ * Insert a key/value pair, using the insertion function for the table's engine
+ *
+ * @param table       Pointer to hashtable instance
+ * @param hash        Hash value computed for key data by _hash_key
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data
+ * @param value_size  Value data size in bytes
+ *
+ * @return 0 if successful, 1 if enough space was not available, -1 if an error occurred
+ */
+static int _insert_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size,
+                          const char *value, const hashtable_size_t value_size)
+{
+    for (;;)
+    {
+        int ret;
+
+        if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+        {
+            ret = _slot_table_insert_keyval_pair(table, table->resize_bytes_pending, hash, key, key_size,
+                                                 value, value_size);
+        }
+        else
+        {
+            ret = _insert_keyval_pair(table, table->resize_bytes_pending, hash, key, key_size, value, value_size);
+        }
+
+        if (1 != ret)
+        {
+            return ret;
+        }
+
+        ret = _grow_for_pair(table, &hash, key, key_size, value_size);
+        if (0 != ret)
+        {
+            return ret;
+        }
+    }
+}
+
+
+/**
+ * Set the value pointer and value size outputs of a lookup for a stored key/value pair.
+ * The value pointer is left unchanged if the value is empty.
+ *
+ * @param pair        Pointer to stored key/value pair
+ * @param value       Pointer to location to store value pointer, may be NULL
+ * @param value_size  Pointer to location to store value size, may be NULL
+ */
+static void _get_pair_value(_keyval_pair_t *pair, char **value, hashtable_size_t *value_size)
+{
+    if ((NULL != value) && (0u < pair->value_size))
+    {
+        *value = (char *) (pair->data + pair->key_size);
+    }
+
+    if (NULL != value_size)
+    {
+        *value_size = pair->value_size;
+    }
+}
+
+
+/**
+ * Search a table for a stored key/value pair with matching key data, using the search
+ * function for the table's engine
+ *
+ * @param table     Pointer to hashtable instance
+ * @param hash      Hash value computed for key data by _hash_key
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return Pointer to key/val pair with matching key data, or NULL if none was found
+ */
+static _keyval_pair_t *_search_keyval_pair(hashtable_t *table, uint32_t hash,
+                                           const char *key, const hashtable_size_t key_size)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot = _slot_table_search(td, hash, key, key_size);
+
+        return (SLOT_NOT_FOUND == slot) ? NULL : SLOT_PAIR(td, SLOT_TABLE(td), slot);
+    }
+
+    return _search_list_by_key(td, _get_table_list_by_hash(td, hash), hash, key, key_size, NULL);
+}
+
+
+/**
+ * Find a stored key/value pair with matching key data. With HASHTABLE_CACHE_EVICTION, a
+ * matching pair that has expired is removed and not returned, and the reference bit of a
+ * returned pair is set.
+ *
+ * @param table     Pointer to hashtable instance
+ * @param hash      Hash value computed for key data by _hash_key
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return Pointer to key/val pair with matching key data, or NULL if none was found
+ */
+static _keyval_pair_t *_find_keyval_pair(hashtable_t *table, uint32_t hash,
+                                         const char *key, const hashtable_size_t key_size)
+{
+    _keyval_pair_t *pair = _search_keyval_pair(table, hash, key, key_size);
+
+#ifdef HASHTABLE_CACHE_EVICTION
+    if (NULL != pair)
+    {
+        if (_pair_expired(table, pair))
+        {
+            (void) _cache_remove_pair(table, pair);
+            return NULL;
+        }
+
+        pair->referenced = 1u;
+    }
+#endif // HASHTABLE_CACHE_EVICTION
+
+    return pair;
+}
+
+
+/**
+ * Issue prefetches for the part of the table that will be read first when searching
+ * for a key: the list in the table array, or the control bytes and slots of the first
+ * group in the probe sequence
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section
+ * @param hash   Hash value computed for key data
+ */
+static void _prefetch_table_entry(hashtable_t *table, _keyval_pair_table_data_t *td, uint32_t hash)
+{
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+        uint32_t first = _slot_table_first_group(slot_table, hash) * HASHTABLE_SLOT_GROUP_SIZE;
+
+        PREFETCH(SLOT_CTRL(slot_table) + first);
+        PREFETCH(&slot_table->slots[first]);
+    }
+    else
+    {
+        PREFETCH(_get_table_list_by_hash(td, hash));
+    }
+}
+
+
+/**
+ * Issue a prefetch for the first key/value pair that will be compared when searching
+ * for a key. Should be called after the table entry was prefetched by _prefetch_table_entry.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section
+ * @param hash   Hash value computed for key data
+ */
+static void _prefetch_first_pair(hashtable_t *table, _keyval_pair_table_data_t *td, uint32_t hash)
+{
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+        uint32_t first = _slot_table_first_group(slot_table, hash) * HASHTABLE_SLOT_GROUP_SIZE;
+        uint32_t mask = _group_match(SLOT_CTRL(slot_table) + first, CTRL_TAG(hash));
+
+        if (0u != mask)
+        {
+            PREFETCH(SLOT_PAIR(td, slot_table, first + _ctz32(mask)));
+        }
+    }
+    else
+    {
+        _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+
+#ifdef HASHTABLE_BLOOM_FILTER
+        if (!_bloom_may_contain(td, hash))
+        {
+            // Search will not read the pair
+            return;
+        }
+#endif // HASHTABLE_BLOOM_FILTER
+
+#ifdef HASHTABLE_BUCKET_HASH
+        if ((list->head == list->tail) && (list->head_hash != hash))
+        {
+            // Search will not read the pair
+            return;
+        }
+#endif // HASHTABLE_BUCKET_HASH
+
+        PREFETCH(LIST_HEAD(td, list));
+    }
+}
+
+
+/**
+ * Hash all keys for one chunk of a batch operation, and prefetch everything that will be
+ * read first when searching for each key. Prefetches for all keys are issued together, so
+ * that the cache misses for different keys overlap.
+ *
+ * @param table      Pointer to hashtable instance
+ * @param keys       Array of pointers to key data
+ * @param key_sizes  Array of key data sizes in bytes
+ * @param count      Number of keys, no more than BATCH_CHUNK_SIZE
+ * @param hashes     Array to store computed hash values in
+ */
+static void _hash_and_prefetch_batch(hashtable_t *table, const char *const keys[],
+                                     const hashtable_size_t key_sizes[], size_t count,
+                                     uint32_t hashes[])
+{
+    for (size_t i = 0u; i < count; i++)
+    {
+        hashes[i] = _hash_key(table, keys[i], key_sizes[i]);
+    }
+
+    // Hashing a key may migrate pairs for an incremental resize, so only start prefetching now
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    for (size_t i = 0u; i < count; i++)
+    {
+        _prefetch_table_entry(table, td, hashes[i]);
+    }
+
+    for (size_t i = 0u; i < count; i++)
+    {
+        _prefetch_first_pair(table, td, hashes[i]);
+    }
+}
+
+
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+/**
+ * Check the key array passed to a batch function
+ *
+ * @param keys       Array of pointers to key data
+ * @param key_sizes  Array of key data sizes in bytes
+ * @param count      Number of keys
+ *
+ * @return 0 if all keys are valid, -1 otherwise
+ */
+static int _check_batch_keys(const char *const keys[], const hashtable_size_t key_sizes[], size_t count)
+{
+    for (size_t i = 0u; i < count; i++)
+    {
+        if (NULL == keys[i])
+        {
+            ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+            return -1;
+        }
+
+        if (0u == key_sizes[i])
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+
+/**
+ * Find the first table array slot (or open addressing slot) holding at least one key/value
+ * pair, starting from a specific slot. 32 table array slots are checked at a time using the
+ * occupancy bitmap, or HASHTABLE_SLOT_GROUP_SIZE open addressing slots using the control bytes.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section
+ * @param index  First slot to check
+ * @param end    Slot to stop at, must not be larger than the number of slots
+ *
+ * @return Index of first slot holding a key/value pair, or 'end' if there is none before 'end'
+ */
+static uint32_t _next_used_index(hashtable_t *table, _keyval_pair_table_data_t *td, uint32_t index, uint32_t end)
+{
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint8_t *ctrl = SLOT_CTRL(SLOT_TABLE(td));
+
+        while (index < end)
+        {
+            uint32_t group_start = index & ~(HASHTABLE_SLOT_GROUP_SIZE - 1u);
+            uint32_t mask = ~_group_match_empty_or_deleted(ctrl + group_start) & ((1u << HASHTABLE_SLOT_GROUP_SIZE) - 1u);
+
+            // Ignore slots before 'index' in the same group
+            mask &= ~((1u << (index - group_start)) - 1u);
+            if (0u != mask)
+            {
+                index = group_start + _ctz32(mask);
+                return (index < end) ? index : end;
+            }
+
+            index = group_start + HASHTABLE_SLOT_GROUP_SIZE;
+        }
+
+        return end;
+    }
+
+    uint32_t *bitmap = _occupancy_bitmap(LIST_TABLE(td));
+
+    while (index < end)
+    {
+        // Ignore slots before 'index' in the same word
+        uint32_t word = BITS_LOAD(bitmap[index / 32u]) & (UINT32_MAX << (index % 32u));
+        if (0u != word)
+        {
+            index = (index & ~31u) + _ctz32(word);
+            return (index < end) ? index : end;
+        }
+
+        index = (index & ~31u) + 32u;
+    }
+
+    return end;
+}
+
+
+/**
+ * Advance the iteration cursor for a table data section to the next stored key/value pair
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section
+ *
+ * @return Pointer to next key/value pair, or NULL if all items have been iterated over
+ */
+static _keyval_pair_t *_cursor_next_pair(hashtable_t *table, _keyval_pair_table_data_t *td)
+{
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+
+        if (td->cursor_items_traversed >= table->entry_count)
+        {
+            return NULL;
+        }
+
+        uint32_t slot = _next_used_index(table, td, td->cursor_array_index, slot_table->slot_count);
+        if (slot >= slot_table->slot_count)
+        {
+            td->cursor_array_index = slot_table->slot_count;
+            return NULL;
+        }
+
+        td->cursor_array_index = slot + 1u;
+        return SLOT_PAIR(td, slot_table, slot);
+    }
+
+    _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+
+    // Look through lists until the last index, or until we've traversed all stored items
+    while ((td->cursor_array_index < list_table->array_count) &&
+           (td->cursor_items_traversed < table->entry_count))
+    {
+        if (NULL == CURSOR_ITEM(td))
+        {
+            /* If item pointer is null, we just moved to a new slot, so skip any
+             * empty slots and set to the head of the next list */
+            td->cursor_array_index = _next_used_index(table, td, td->cursor_array_index, list_table->array_count);
+            if (td->cursor_array_index >= list_table->array_count)
+            {
+                break;
+            }
+
+            td->cursor_item = list_table->table[td->cursor_array_index].head;
+        }
+
+        // Return the next non-NULL item in the list
+        if (NULL != CURSOR_ITEM(td))
+        {
+            _keyval_pair_t *pair = CURSOR_ITEM(td);
+
+            td->cursor_item = pair->next;
+            if (NULL == CURSOR_ITEM(td))
+            {
+                td->cursor_array_index += 1u;
+            }
+
+            return pair;
+        }
+
+        td->cursor_array_index += 1u;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Check that a link followed while attaching to an existing table buffer points to a
+ * key/value pair that lies entirely within the used part of the data block
+ *
+ * @param block   Pointer to data block
+ * @param pair    Pointer to key/value pair
+ * @param stored  1 if the pair is expected to be stored in the table, 0 if it is a freed pair
+ *
+ * @return 1 if the key/value pair is valid, 0 otherwise
+ */
+static int _attach_pair_valid(_keyval_pair_data_block_t *block, _keyval_pair_t *pair, int stored)
+{
+    uintptr_t start = (uintptr_t) block->data;
+    uintptr_t addr = (uintptr_t) pair;
+
+    if ((addr < start) || ((addr - start) >= block->bytes_used))
+    {
+        return 0;
+    }
+
+    size_t offset = (size_t) (addr - start);
+    size_t size_available = block->bytes_used - offset;
+
+    if ((offset != ROUND_UP_PTRSIZE(offset)) || (size_available < sizeof(_keyval_pair_t)))
+    {
+        return 0;
+    }
+
+    if ((stored && (0u == pair->key_size)) || (pair->key_size > size_available) ||
+        (pair->value_size > size_available) || (stored == PAIR_IS_FREED(pair)))
+    {
+        return 0;
+    }
+
+    return _pair_size(pair) <= size_available;
+}
+
+
+/**
+ * Check all lists (or slots, for open addressing) of a table buffer being attached to,
+ * and count the stored key/value pairs
+ *
+ * @param td           Pointer to table data section
+ * @param engine       Hashtable engine
+ * @param entry_count  Pointer to location to store number of stored key/value pairs
+ *
+ * @return 0 if successful, -1 if an invalid link or list was found
+ */
+static int _attach_check_table(_keyval_pair_table_data_t *td, hashtable_engine_t engine, uint32_t *entry_count)
+{
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    size_t max_pairs = block->bytes_used / FREELIST_MIN_PAIR_SIZE;
+    size_t count = 0u;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+        uint8_t *ctrl = SLOT_CTRL(slot_table);
+        uint32_t deleted_count = 0u;
+
+        for (uint32_t i = 0u; i < slot_table->slot_count; i++)
+        {
+            if (CTRL_DELETED == ctrl[i])
+            {
+                deleted_count += 1u;
+            }
+            else if (CTRL_IS_FULL(ctrl[i]))
+            {
+                if (!_attach_pair_valid(block, SLOT_PAIR(td, slot_table, i), 1))
+                {
+                    return -1;
+                }
+
+                count += 1u;
+            }
+            else if (CTRL_EMPTY != ctrl[i])
+            {
+                return -1;
+            }
+        }
+
+        if ((count != slot_table->used_count) || (deleted_count != slot_table->deleted_count) ||
+            (count >= (slot_table->slot_count - (slot_table->slot_count / 8u))))
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+
+        for (uint32_t i = 0u; i < list_table->array_count; i++)
+        {
+            _keyval_pair_list_t *list = &list_table->table[i];
+            _keyval_pair_t *last = NULL;
+
+            for (_keyval_pair_t *curr = LIST_HEAD(td, list); NULL != curr; curr = PAIR_NEXT(td, curr))
+            {
+                // Also catches a list that loops back on itself
+                if ((!_attach_pair_valid(block, curr, 1)) || (count >= max_pairs))
+                {
+                    return -1;
+                }
+
+                last = curr;
+                count += 1u;
+            }
+
+#ifdef HASHTABLE_NO_LIST_TAIL
+            (void) last;
+#else
+            if (LIST_TAIL(td, list) != last)
+            {
+                return -1;
+            }
+#endif // HASHTABLE_NO_LIST_TAIL
+
+            // Occupancy bitmap must match, or iteration would skip (or stop at) this list
+            uint32_t occupied = (_occupancy_bitmap(list_table)[i / 32u] >> (i % 32u)) & 1u;
+            if (occupied != (uint32_t) (NULL != last))
+            {
+                return -1;
+            }
+        }
+    }
+
+    if (count > UINT32_MAX)
+    {
+        return -1;
+    }
+
+    *entry_count = (uint32_t) count;
+    return 0;
+}
+
+
+/**
+ * Check the free lists of a table buffer being attached to
+ *
+ * @param td  Pointer to table data section
+ *
+ * @return 0 if successful, -1 if an invalid link or list was found
+ */
+static int _attach_check_freelists(_keyval_pair_table_data_t *td)
+{
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    size_t max_pairs = block->bytes_used / FREELIST_MIN_PAIR_SIZE;
+    size_t count = 0u;
+    size_t bytes_free = 0u;
+
+    for (uint32_t i = 0u; i < _HASHTABLE_FREELIST_CLASSES; i++)
+    {
+        _keyval_pair_t *curr = FREELIST_HEAD(td, block, i);
+
+        if ((NULL != curr) != (0u != (block->freelist_bitmap & (1u << i))))
+        {
+            return -1;
+        }
+
+        for (; NULL != curr; curr = FREED_NEXT(td, curr))
+        {
+            if ((!_attach_pair_valid(block, curr, 0)) || (count >= max_pairs) ||
+                (_freelist_class(_pair_size(curr)) != i))
+            {
+                return -1;
+            }
+
+            count += 1u;
+            bytes_free += _pair_size(curr);
+        }
+    }
+
+    if ((count != block->free_count) || (bytes_free != block->bytes_free))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Encode a 32-bit value as 4 little-endian bytes, for a snapshot
+ *
+ * @param dest   Pointer to location to store encoded bytes
+ * @param value  Value to encode
+ */
+static void _snapshot_encode_u32(uint8_t *dest, uint32_t value)
+{
+    dest[0] = (uint8_t) (value & 0xffu);
+    dest[1] = (uint8_t) ((value >> 8u) & 0xffu);
+    dest[2] = (uint8_t) ((value >> 16u) & 0xffu);
+    dest[3] = (uint8_t) ((value >> 24u) & 0xffu);
+}
+
+
+/**
+ * Decode a 32-bit value from 4 little-endian bytes in a snapshot
+ *
+ * @param src  Pointer to encoded bytes
+ *
+ * @return Decoded value
+ */
+static uint32_t _snapshot_decode_u32(const uint8_t *src)
+{
+    return ((uint32_t) src[0]) | (((uint32_t) src[1]) << 8u) |
+           (((uint32_t) src[2]) << 16u) | (((uint32_t) src[3]) << 24u);
+}
+
+
+/**
+ * Write data to a snapshot, and add it to the running snapshot checksum
+ *
+ * @param write     Function to call to write snapshot data
+ * @param ctx       Context pointer to pass to the write function
+ * @param checksum  Pointer to running snapshot checksum
+ * @param data      Pointer to data to write
+ * @param size      Number of bytes to write
+ *
+ * @return 0 if successful, -1 if the write function failed
+ */
+static int _snapshot_write(hashtable_write_func_t write, void *ctx, uint32_t *checksum,
+                           const void *data, size_t size)
+{
+    if (0u == size)
+    {
+        return 0;
+    }
+
+    if (0 != write(ctx, data, size))
+    {
+        ERROR(HASHTABLE_ERROR_IO, "Write function failed");
+        return -1;
+    }
+
+    *checksum = _fnv1a_update(*checksum, (const char *) data, size);
+    return 0;
+}
+
+
+/**
+ * Read data from a snapshot, and add it to the running snapshot checksum
+ *
+ * @param read      Function to call to read snapshot data
+ * @param ctx       Context pointer to pass to the read function
+ * @param checksum  Pointer to running snapshot checksum
+ * @param data      Pointer to location to store data that was read
+ * @param size      Number of bytes to read
+ *
+ * @return 0 if successful, -1 if the read function failed
+ */
+static int _snapshot_read(hashtable_read_func_t read, void *ctx, uint32_t *checksum,
+                          void *data, size_t size)
+{
+    if (0u == size)
+    {
+        return 0;
+    }
+
+    if (0 != read(ctx, data, size))
+    {
+        ERROR(HASHTABLE_ERROR_IO, "Read function failed");
+        return -1;
+    }
+
+    *checksum = _fnv1a_update(*checksum, (const char *) data, size);
+    return 0;
+}
+
+
+/**
+ * Write all stored key/value pairs to a snapshot, by iterating over the table with
+ * the iteration cursor
+ *
+ * @param table     Pointer to hashtable instance
+ * @param td        Pointer to table data section, cursor must be reset
+ * @param write     Function to call to write snapshot data
+ * @param ctx       Context pointer to pass to the write function
+ * @param checksum  Pointer to running snapshot checksum
+ *
+ * @return 0 if successful, -1 if an error occurred
+ */
+static int _snapshot_write_pairs(hashtable_t *table, _keyval_pair_table_data_t *td,
+                                 hashtable_write_func_t write, void *ctx, uint32_t *checksum)
+{
+    _keyval_pair_t *pair;
+
+    while (NULL != (pair = _cursor_next_pair(table, td)))
+    {
+        td->cursor_items_traversed += 1u;
+
+#if defined(HASHTABLE_SIZE_T_SYS) && (SIZE_MAX > UINT32_MAX)
+        if ((pair->key_size > UINT32_MAX) || (pair->value_size > UINT32_MAX))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Key or value too large for snapshot");
+            return -1;
+        }
+#endif // HASHTABLE_SIZE_T_SYS
+
+        uint8_t header[SNAPSHOT_PAIR_HEADER_SIZE];
+        _snapshot_encode_u32(header, (uint32_t) pair->key_size);
+        _snapshot_encode_u32(header + 4u, (uint32_t) pair->value_size);
+
+        if ((0 != _snapshot_write(write, ctx, checksum, header, sizeof(header))) ||
+            (0 != _snapshot_write(write, ctx, checksum, pair->data, ((size_t) pair->key_size) + pair->value_size)))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * Read key/value pairs from a snapshot, and add them to an empty table. Pairs are
+ * read straight into newly allocated space in the data block, and added to the table
+ * without searching for existing pairs with the same key.
+ *
+ * @param table        Pointer to hashtable instance, must be empty
+ * @param read         Function to call to read snapshot data
+ * @param ctx          Context pointer to pass to the read function
+ * @param checksum     Pointer to running snapshot checksum
+ * @param entry_count  Number of key/value pairs in the snapshot
+ *
+ * @return 0 if successful, 1 if there is not enough space for all key/value pairs,
+ *         -1 if an error occurred
+ */
+static int _snapshot_read_pairs(hashtable_t *table, hashtable_read_func_t read, void *ctx,
+                                uint32_t *checksum, uint32_t entry_count)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    size_t total_bytes = DATA_BLOCK(td)->total_bytes;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot_count = SLOT_TABLE(td)->slot_count;
+        if (entry_count >= (slot_count - (slot_count / 8u)))
+        {
+            return 1;
+        }
+    }
+
+    for (uint32_t i = 0u; i < entry_count; i++)
+    {
+        uint8_t header[SNAPSHOT_PAIR_HEADER_SIZE];
+        if (0 != _snapshot_read(read, ctx, checksum, header, sizeof(header)))
+        {
+            return -1;
+        }
+
+        uint32_t key_size = _snapshot_decode_u32(header);
+        uint32_t value_size = _snapshot_decode_u32(header + 4u);
+
+        if (0u == key_size)
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_SNAPSHOT, "Invalid key size in snapshot");
+            return -1;
+        }
+
+        if ((key_size > total_bytes) || (value_size > (total_bytes - key_size)) ||
+            (key_size != (hashtable_size_t) key_size) || (value_size != (hashtable_size_t) value_size))
+        {
+            // Can never fit in this table
+            return 1;
+        }
+
+        _keyval_pair_t *pair = _alloc_keyval_pair(td, 0u, (hashtable_size_t) key_size, (hashtable_size_t) value_size);
+        if (NULL == pair)
+        {
+            return 1;
+        }
+
+        if (0 != _snapshot_read(read, ctx, checksum, pair->data, ((size_t) key_size) + value_size))
+        {
+            return -1;
+        }
+
+        uint32_t hash = _config_hash(&table->config, (char *) pair->data, (hashtable_size_t) key_size);
+#ifdef HASHTABLE_STORE_HASH
+        pair->hash = hash;
+#endif // HASHTABLE_STORE_HASH
+
+        if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+        {
+            _slot_table_place(td, hash, pair);
+        }
+        else
+        {
+            _list_append(td, _get_table_list_by_hash(td, hash), pair, hash);
+        }
+
+        table->entry_count += 1u;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_create(hashtable_t *table, const hashtable_config_t *config,
+                     void *buffer, size_t buffer_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL == config)
+    {
+        // No config provided, use default config
+        if (0 > hashtable_default_config(&table->config, buffer_size))
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        if ((NULL == config->hash) && (NULL == config->seeded_hash))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "NULL function pointer in hashtable_config_t");
+            return -1;
+        }
+
+        if (0u == config->array_count)
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Zero array count in hashtable_config_t");
+            return -1;
+        }
+
+        if ((HASHTABLE_ENGINE_CHAINING != config->engine) &&
+            (HASHTABLE_ENGINE_OPEN_ADDRESSING != config->engine))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid engine in hashtable_config_t");
+            return -1;
+        }
+
+        if ((NULL != config->allocator) && ((NULL == config->allocator->alloc) || (NULL == config->allocator->free)))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "NULL function pointer in hashtable_allocator_t");
+            return -1;
+        }
+
+        (void) memcpy(&table->config, config, sizeof(table->config));
+    }
+
+    if ((NULL == buffer) && (NULL == table->config.allocator))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        if (table->config.array_count > (UINT32_MAX - HASHTABLE_SLOT_GROUP_SIZE))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Array count too large in hashtable_config_t");
+            return -1;
+        }
+
+        table->config.array_count = ROUND_UP_GROUP_SIZE(table->config.array_count);
+    }
+
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+    if (table->config.array_count > MAX_POW2_ARRAY_COUNT)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Array count too large in hashtable_config_t");
+        return -1;
+    }
+
+    table->config.array_count = _round_up_pow2(table->config.array_count);
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+    uint8_t buffer_allocated = 0u;
+    if (NULL == buffer)
+    {
+        if (buffer_size < _min_buffer_size(table->config.engine, table->config.array_count))
+        {
+            return 1;
+        }
+
+        buffer = table->config.allocator->alloc(table->config.allocator->ctx, buffer_size);
+        if (NULL == buffer)
+        {
+            return 1;
+        }
+
+        buffer_allocated = 1u;
+    }
+
+    int ret = _setup_new_table(&table->config, table->config.array_count, buffer, buffer_size);
+    if (0 != ret)
+    {
+        if (buffer_allocated)
+        {
+            table->config.allocator->free(table->config.allocator->ctx, buffer);
+        }
+
+        return ret;
+    }
+
+    table->entry_count = 0u;
+    table->table_data = buffer;
+    table->data_size = buffer_size;
+    table->resize_table_data = NULL;
+    table->resize_bytes_pending = 0u;
+    table->resize_array_index = 0u;
+    table->buffer_allocated = buffer_allocated;
+    table->resize_buffer_allocated = 0u;
+    table->reserved_pair = NULL;
+#ifdef HASHTABLE_CACHE_EVICTION
+    table->cache_time = 0u;
+#endif // HASHTABLE_CACHE_EVICTION
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_attach(hashtable_t *table, const hashtable_config_t *config,
+                     void *buffer, size_t buffer_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == buffer))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    // Only the hash function (and seed) is taken from the config, everything else is in the buffer
+    hashtable_config_t hash_config;
+    (void) memset(&hash_config, 0, sizeof(hash_config));
+    hash_config.hash = HASHTABLE_DEFAULT_HASH;
+    if (NULL != config)
+    {
+        if ((NULL == config->hash) && (NULL == config->seeded_hash))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "NULL function pointer in hashtable_config_t");
+            return -1;
+        }
+
+        if ((NULL != config->allocator) && ((NULL == config->allocator->alloc) || (NULL == config->allocator->free)))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_PARAM, "NULL function pointer in hashtable_allocator_t");
+            return -1;
+        }
+
+        hash_config.hash = config->hash;
+        hash_config.seeded_hash = config->seeded_hash;
+        hash_config.seed = config->seed;
+        hash_config.allocator = config->allocator;
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) buffer;
+    uint8_t *u8_buf = (uint8_t *) buffer;
+
+    if ((buffer_size < sizeof(_keyval_pair_table_data_t)) || (BUFFER_MAGIC != td->magic))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Buffer does not contain a hashtable");
+        return -1;
+    }
+
+    if (_buffer_layout() != td->layout)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Buffer was created with different build options");
+        return -1;
+    }
+
+    if (_hash_check_value(&hash_config) != td->hash_check)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Buffer was created with a different hash function");
+        return -1;
+    }
+
+    hashtable_engine_t engine = (hashtable_engine_t) td->engine;
+    uint32_t array_count = 0u;
+    void *expected_table = u8_buf + sizeof(_keyval_pair_table_data_t);
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == engine)
+    {
+        if ((LINK_GET(td, td->slot_table) != expected_table) || (NULL != LINK_GET(td, td->list_table)))
+        {
+            // Absolute addresses only match if the buffer is at the same address
+            ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Invalid table location in buffer, build with HASHTABLE_OFFSET_POINTERS "
+                  "to attach at a different address");
+            return -1;
+        }
+
+        if ((buffer_size - sizeof(_keyval_pair_table_data_t)) < sizeof(_keyval_pair_slot_table_t))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Buffer is too small for the table it contains");
+            return -1;
+        }
+
+        array_count = SLOT_TABLE(td)->slot_count;
+        if ((0u == array_count) || (0u != (array_count % HASHTABLE_SLOT_GROUP_SIZE)) ||
+            (array_count > (buffer_size / (sizeof(_HASHTABLE_LINK(_keyval_pair_t)) + 1u))))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Invalid slot count in buffer");
+            return -1;
+        }
+    }
+    else if (HASHTABLE_ENGINE_CHAINING == engine)
+    {
+        if ((LINK_GET(td, td->list_table) != expected_table) || (NULL != LINK_GET(td, td->slot_table)))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Invalid table location in buffer, build with HASHTABLE_OFFSET_POINTERS "
+                  "to attach at a different address");
+            return -1;
+        }
+
+        if ((buffer_size - sizeof(_keyval_pair_table_data_t)) < sizeof(_keyval_pair_list_table_t))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Buffer is too small for the table it contains");
+            return -1;
+        }
+
+        array_count = LIST_TABLE(td)->array_count;
+        if ((0u == array_count) || (array_count > (buffer_size / sizeof(_keyval_pair_list_t))))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Invalid array count in buffer");
+            return -1;
+        }
+    }
+    else
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Invalid engine in buffer");
+        return -1;
+    }
+
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+    if (0u != (array_count & (array_count - 1u)))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Array count in buffer is not a power of 2");
+        return -1;
+    }
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+    size_t min_required_size = _min_buffer_size(engine, array_count);
+    if (buffer_size < min_required_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Buffer is too small for the table it contains");
+        return -1;
+    }
+
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    if ((uint8_t *) block != (u8_buf + (min_required_size - sizeof(_keyval_pair_data_block_t))))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Invalid data block location in buffer");
+        return -1;
+    }
+
+    if ((block->total_bytes > (buffer_size - min_required_size)) || (block->bytes_used > block->total_bytes))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Buffer is too small for the table it contains");
+        return -1;
+    }
+
+    if (td->compact_in_progress && ((td->compact_read_offset > block->bytes_used) ||
+                                    (td->compact_write_offset > td->compact_read_offset)))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Invalid compaction state in buffer");
+        return -1;
+    }
+
+    if (td->clear_in_progress)
+    {
+        if ((HASHTABLE_ENGINE_CHAINING != engine) || (td->clear_index > array_count))
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Invalid clear state in buffer");
+            return -1;
+        }
+
+        // Stale lists left by hashtable_clear can't be checked, zero them first
+        _clear_finish(td);
+    }
+
+    uint32_t entry_count = 0u;
+    if ((0 != _attach_check_table(td, engine, &entry_count)) || (0 != _attach_check_freelists(td)))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_BUFFER, "Corrupt key/value pair data in buffer");
+        return -1;
+    }
+
+    table->config.hash = hash_config.hash;
+    table->config.seeded_hash = hash_config.seeded_hash;
+    table->config.seed = hash_config.seed;
+    table->config.allocator = hash_config.allocator;
+    table->config.array_count = array_count;
+    table->config.engine = engine;
+    table->entry_count = entry_count;
+    table->table_data = buffer;
+    table->data_size = min_required_size + block->total_bytes;
+    table->resize_table_data = NULL;
+    table->resize_bytes_pending = 0u;
+    table->resize_array_index = 0u;
+    table->buffer_allocated = 0u;
+    table->resize_buffer_allocated = 0u;
+    table->reserved_pair = NULL;
+#ifdef HASHTABLE_CACHE_EVICTION
+    table->cache_time = 0u;
+    td->clock_hand = 0u;
+#endif // HASHTABLE_CACHE_EVICTION
+
+    _reset_cursor(td);
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_insert(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                     const char *value, const hashtable_size_t value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    return _insert_hashed(table, _hash_key(table, key, key_size), key, key_size, value, value_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_insert_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size,
+                            const char *value, const hashtable_size_t value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    return _insert_hashed(table, _prepare_hash(table, hash, key, key_size), key, key_size, value, value_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_reserve(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                      const hashtable_size_t value_size, char **value)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key) || (NULL == value))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->reserved_pair)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_STATE, "A key/value pair is already reserved");
+        return -1;
+    }
+
+    uint32_t hash = _hash_key(table, key, key_size);
+
+    for (;;)
+    {
+        _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+        _keyval_pair_t *pair = NULL;
+
+        /* An open addressing table also needs a free slot for the pair when it is committed,
+         * unless it replaces a stored pair */
+        if ((HASHTABLE_ENGINE_CHAINING == table->config.engine) ||
+            (SLOT_NOT_FOUND != _slot_table_search(td, hash, key, key_size)) ||
+            _slot_table_has_space(table, td))
+        {
+            pair = _store_keyval_pair(td, table->resize_bytes_pending, hash, key, key_size, NULL, value_size);
+        }
+
+        if (NULL != pair)
+        {
+            table->reserved_pair = pair;
+            table->reserved_hash = hash;
+            *value = (0u < value_size) ? ((char *) pair->data + key_size) : NULL;
+            return 0;
+        }
+
+        int ret = _grow_for_pair(table, &hash, key, key_size, value_size);
+        if (0 != ret)
+        {
+            return ret;
+        }
+    }
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_commit(hashtable_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL == table->reserved_pair)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_STATE, "No key/value pair is reserved");
+        return -1;
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_t *pair = (_keyval_pair_t *) table->reserved_pair;
+    const char *key = (const char *) pair->data;
+    uint32_t hash = table->reserved_hash;
+
+    table->reserved_pair = NULL;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot = _slot_table_search(td, hash, key, pair->key_size);
+        if (SLOT_NOT_FOUND != slot)
+        {
+            // Replace the stored pair in its slot
+            _release_pair(td, SLOT_PAIR(td, SLOT_TABLE(td), slot));
+            SLOT_TABLE(td)->slots[slot] = LINK_SET(td, pair);
+            return 0;
+        }
+
+        // Space for a slot was checked by hashtable_reserve
+        _slot_table_place(td, hash, pair);
+        table->entry_count += 1u;
+        return 0;
+    }
+
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+    _keyval_pair_t *prev = NULL;
+    _keyval_pair_t *stored = _search_list_by_key(td, list, hash, key, pair->key_size, &prev);
+
+    if ((NULL != stored) && (_remove_from_table(table, list, stored, prev) < 0))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_STATE, "Item removal failed");
+        return -1;
+    }
+
+    _list_append(td, list, pair, hash);
+    table->entry_count += 1u;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_abort(hashtable_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL == table->reserved_pair)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_STATE, "No key/value pair is reserved");
+        return -1;
+    }
+
+    _release_pair((_keyval_pair_table_data_t *) table->table_data, (_keyval_pair_t *) table->reserved_pair);
+    table->reserved_pair = NULL;
+
+    return 0;
+}
+
+
+/**
+ * Remove a stored key/value pair, with an already computed and prepared (see _prepare_hash)
+ * hash for the key data
+ *
+ * @param table     Pointer to hashtable instance
+ * @param hash      Hash value computed for key data
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return 0 if successful, 1 if the key does not exist
+ */
+static int _remove_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot = _slot_table_search(td, hash, key, key_size);
+        if (SLOT_NOT_FOUND == slot)
+        {
+            // Item does not exist
+            return 1;
+        }
+
+        // Add item to free list
+        _release_pair(td, SLOT_PAIR(td, SLOT_TABLE(td), slot));
+        _slot_table_release(td, slot);
+        table->entry_count -= 1u;
+
+        return 0;
+    }
+
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+
+    _keyval_pair_t *prev = NULL;
+    _keyval_pair_t *pair = _search_list_by_key(td, list, hash, key, key_size, &prev);
+    if (NULL == pair)
+    {
+        // Item does not exist
+        return 1;
+    }
+
+    return _remove_from_table(table, list, pair, prev);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_remove(hashtable_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    return _remove_hashed(table, _hash_key(table, key, key_size), key, key_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_remove_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    return _remove_hashed(table, _prepare_hash(table, hash, key, key_size), key, key_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_retrieve(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                       char **value, hashtable_size_t *value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_t *pair = _find_keyval_pair(table, _hash_key(table, key, key_size), key, key_size);
+    if (NULL == pair)
+    {
+        // Item does not exist
+        return 1;
+    }
+
+    _get_pair_value(pair, value, value_size);
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_retrieve_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size,
+                              char **value, hashtable_size_t *value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_t *pair = _find_keyval_pair(table, _prepare_hash(table, hash, key, key_size), key, key_size);
+    if (NULL == pair)
+    {
+        // Item does not exist
+        return 1;
+    }
+
+    _get_pair_value(pair, value, value_size);
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_has_key(hashtable_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_t *pair = _find_keyval_pair(table, _hash_key(table, key, key_size), key, key_size);
+    if (NULL == pair)
+    {
+        // Item does not exist
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_has_key_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_t *pair = _find_keyval_pair(table, _prepare_hash(table, hash, key, key_size), key, key_size);
+    if (NULL == pair)
+    {
+        // Item does not exist
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/**
+ * Find a stored key/value pair, or store a new one if none exists, with an already
+ * computed and prepared (see _prepare_hash) hash for the key data. The table is only
+ * searched once for both.
+ *
+ * @param table        Pointer to hashtable instance
+ * @param hash         Hash value computed for key data
+ * @param key          Pointer to key data
+ * @param key_size     Key data size in bytes
+ * @param value        Pointer to value data to store if key does not exist, may be NULL
+ * @param value_size   Value data size in bytes
+ * @param stored       Pointer to location to store pointer to stored or new pair
+ *
+ * @return 0 if a new pair was stored, 1 if there is not enough space, 2 if the key exists
+ */
+static int _get_or_insert_keyval_pair(hashtable_t *table, uint32_t hash,
+                                      const char *key, const hashtable_size_t key_size,
+                                      const char *value, const hashtable_size_t value_size,
+                                      _keyval_pair_t **stored)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot = _slot_table_search(td, hash, key, key_size);
+        if (SLOT_NOT_FOUND != slot)
+        {
+            *stored = SLOT_PAIR(td, SLOT_TABLE(td), slot);
+            return 2;
+        }
+
+        if (!_slot_table_has_space(table, td))
+        {
+            return 1;
+        }
+
+        *stored = _store_keyval_pair(td, table->resize_bytes_pending, hash, key, key_size, value, value_size);
+        if (NULL == *stored)
+        {
+            return 1;
+        }
+
+        _slot_table_place(td, hash, *stored);
+        table->entry_count += 1u;
+
+        return 0;
+    }
+
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+
+    *stored = _search_list_by_key(td, list, hash, key, key_size, NULL);
+    if (NULL != *stored)
+    {
+        return 2;
+    }
+
+    *stored = _store_keyval_pair(td, table->resize_bytes_pending, hash, key, key_size, value, value_size);
+    if (NULL == *stored)
+    {
+        return 1;
+    }
+
+    _list_append(td, list, *stored, hash);
+    table->entry_count += 1u;
+
+    return 0;
+}
+
+
+/**
+ * Shared implementation of hashtable_get_or_insert and hashtable_get_or_insert_hashed
+ *
+ * @param table              Pointer to hashtable instance
+ * @param hash               Hash value computed for key data by _hash_key
+ * @param key                Pointer to key data
+ * @param key_size           Key data size in bytes
+ * @param value              Pointer to value data to store if key does not exist, may be NULL
+ * @param value_size         Value data size in bytes
+ * @param stored_value       Pointer to location to store value pointer, may be NULL
+ * @param stored_value_size  Pointer to location to store value size, may be NULL
+ *
+ * @return 0 if a new pair was stored, 1 if there is not enough space, 2 if the key exists,
+ *         -1 if an error occurred
+ */
+static int _get_or_insert_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size,
+                                 const char *value, const hashtable_size_t value_size,
+                                 char **stored_value, hashtable_size_t *stored_value_size)
+{
+#ifdef HASHTABLE_CACHE_EVICTION
+    // Drops a stored pair for the key if it has expired, and marks it as referenced otherwise
+    (void) _find_keyval_pair(table, hash, key, key_size);
+#endif // HASHTABLE_CACHE_EVICTION
+
+    for (;;)
+    {
+        _keyval_pair_t *pair = NULL;
+        int ret = _get_or_insert_keyval_pair(table, hash, key, key_size, value, value_size, &pair);
+
+        if (1 != ret)
+        {
+            _get_pair_value(pair, stored_value, stored_value_size);
+            return ret;
+        }
+
+        ret = _grow_for_pair(table, &hash, key, key_size, value_size);
+        if (0 != ret)
+        {
+            return ret;
+        }
+    }
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_get_or_insert(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                            const char *value, const hashtable_size_t value_size,
+                            char **stored_value, hashtable_size_t *stored_value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    return _get_or_insert_hashed(table, _hash_key(table, key, key_size), key, key_size, value, value_size,
+                                 stored_value, stored_value_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_get_or_insert_hashed(hashtable_t *table, uint32_t hash, const char *key,
+                                   const hashtable_size_t key_size, const char *value,
+                                   const hashtable_size_t value_size, char **stored_value,
+                                   hashtable_size_t *stored_value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    return _get_or_insert_hashed(table, _prepare_hash(table, hash, key, key_size), key, key_size, value,
+                                 value_size, stored_value, stored_value_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+uint32_t hashtable_hash(hashtable_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return 0u;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    return _config_hash(&table->config, key, key_size);
+}
+
+
+#ifdef HASHTABLE_BLOOM_FILTER
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_bloom_check(hashtable_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (HASHTABLE_ENGINE_CHAINING != table->config.engine)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Bloom filter is only used by HASHTABLE_ENGINE_CHAINING");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    // Key data must be migrated first if a resize is in progress, so the filter is up to date for it
+    uint32_t hash = _hash_key(table, key, key_size);
+
+    return _bloom_may_contain((_keyval_pair_table_data_t *) table->table_data, hash);
+}
+#endif // HASHTABLE_BLOOM_FILTER
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_retrieve_batch(hashtable_t *table, const char *const keys[], const hashtable_size_t key_sizes[],
+                             size_t count, char *values[], hashtable_size_t value_sizes[], int results[])
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == keys) || (NULL == key_sizes) || (NULL == results))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0 != _check_batch_keys(keys, key_sizes, count))
+    {
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    uint32_t hashes[BATCH_CHUNK_SIZE];
+
+    for (size_t start = 0u; start < count; start += BATCH_CHUNK_SIZE)
+    {
+        size_t chunk = ((count - start) < BATCH_CHUNK_SIZE) ? (count - start) : BATCH_CHUNK_SIZE;
+        _hash_and_prefetch_batch(table, keys + start, key_sizes + start, chunk, hashes);
+
+        for (size_t i = 0u; i < chunk; i++)
+        {
+            size_t index = start + i;
+            _keyval_pair_t *pair = _find_keyval_pair(table, hashes[i], keys[index], key_sizes[index]);
+
+            if (NULL == pair)
+            {
+                // Item does not exist
+                results[index] = 1;
+                continue;
+            }
+
+            if ((NULL != values) && (0u < pair->value_size))
+            {
+                values[index] = (char *) (pair->data + pair->key_size);
+            }
+
+            if (NULL != value_sizes)
+            {
+                value_sizes[index] = pair->value_size;
+            }
+
+            results[index] = 0;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_has_key_batch(hashtable_t *table, const char *const keys[], const hashtable_size_t key_sizes[],
+                            size_t count, int results[])
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == keys) || (NULL == key_sizes) || (NULL == results))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0 != _check_batch_keys(keys, key_sizes, count))
+    {
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    uint32_t hashes[BATCH_CHUNK_SIZE];
+
+    for (size_t start = 0u; start < count; start += BATCH_CHUNK_SIZE)
+    {
+        size_t chunk = ((count - start) < BATCH_CHUNK_SIZE) ? (count - start) : BATCH_CHUNK_SIZE;
+        _hash_and_prefetch_batch(table, keys + start, key_sizes + start, chunk, hashes);
+
+        for (size_t i = 0u; i < chunk; i++)
+        {
+            size_t index = start + i;
+            results[index] = (NULL == _find_keyval_pair(table, hashes[i], keys[index], key_sizes[index])) ? 0 : 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_insert_batch(hashtable_t *table, const char *const keys[], const hashtable_size_t key_sizes[],
+                           const char *const values[], const hashtable_size_t value_sizes[],
+                           size_t count, int results[])
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == keys) || (NULL == key_sizes) || (NULL == results))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0 != _check_batch_keys(keys, key_sizes, count))
+    {
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    uint32_t hashes[BATCH_CHUNK_SIZE];
+    int ret = 0;
+
+    for (size_t start = 0u; start < count; start += BATCH_CHUNK_SIZE)
+    {
+        size_t chunk = ((count - start) < BATCH_CHUNK_SIZE) ? (count - start) : BATCH_CHUNK_SIZE;
+        _hash_and_prefetch_batch(table, keys + start, key_sizes + start, chunk, hashes);
+        void *chunk_table_data = table->table_data;
+
+        for (size_t i = 0u; i < chunk; i++)
+        {
+            size_t index = start + i;
+            const char *value = (NULL == values) ? NULL : values[index];
+            hashtable_size_t value_size = (NULL == value_sizes) ? 0u : value_sizes[index];
+            uint32_t hash = hashes[i];
+
+            if (table->table_data != chunk_table_data)
+            {
+                // The table grew into a new buffer after this chunk was hashed
+                hash = _prepare_hash(table, hash, keys[index], key_sizes[index]);
+            }
+
+            results[index] = _insert_hashed(table, hash, keys[index], key_sizes[index], value, value_size);
+            if (0 > results[index])
+            {
+                return -1;
+            }
+
+            if (0 != results[index])
+            {
+                ret = 1;
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+/**
+ * Get the index of the table array slot (or open addressing group) that hashtable_bulk_load
+ * sorts a key/value pair into. For open addressing, this is the first group in the probe
+ * sequence, which is where the pair will usually be placed.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param td     Pointer to table data section
+ * @param hash   Hash value computed for key data
+ *
+ * @return Table array slot index, or group index for open addressing
+ */
+static uint32_t _bulk_load_bucket(hashtable_t *table, _keyval_pair_table_data_t *td, uint32_t hash)
+{
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        return _slot_table_first_group(SLOT_TABLE(td), hash);
+    }
+
+    return _get_table_index(td, hash);
+}
+
+
+/**
+ * Check if a table has enough space to store a specific number of new key/value pairs, with
+ * a specific total size, for hashtable_bulk_load. No incremental resize may be in progress.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param count       Number of new key/value pairs
+ * @param pair_bytes  Total size of new key/value pairs in bytes
+ *
+ * @return 1 if all pairs can be stored, 0 otherwise
+ */
+static int _bulk_load_has_space(hashtable_t *table, size_t count, size_t pair_bytes)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+
+    if (pair_bytes > (block->total_bytes - block->bytes_used))
+    {
+        return 0;
+    }
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        uint32_t slot_count = SLOT_TABLE(td)->slot_count;
+        size_t max_used = (size_t) (slot_count - (slot_count / 8u));
+
+        // Every pair must fit without going over the max. load (see _slot_table_has_space)
+        return (count <= (max_used - table->entry_count)) ? 1 : 0;
+    }
+
+    return 1;
+}
+
+
+/**
+ * Insert one key/value pair for hashtable_bulk_load, using the insertion function for the
+ * table's engine. Space for the pairs not yet stored is held back from the pair (so that
+ * no padding is added in front of it that later pairs need, see _alloc_keyval_pair).
+ *
+ * @param table        Pointer to hashtable instance
+ * @param scratch      Number of bytes at the end of data_block->data used for scratch space
+ * @param pending      Pointer to total size of the pairs not yet stored, including this one
+ * @param hash         Hash value computed for key data
+ * @param keys         Array of pointers to key data
+ * @param key_sizes    Array of key data sizes in bytes
+ * @param values       Array of pointers to value data, may be NULL
+ * @param value_sizes  Array of value data sizes in bytes, may be NULL
+ * @param index        Index of key/value pair in arrays
+ *
+ * @return 0 if successful, 1 if enough space was not available
+ */
+static int _bulk_load_insert(hashtable_t *table, size_t scratch, size_t *pending, uint32_t hash,
+                             const char *const keys[], const hashtable_size_t key_sizes[],
+                             const char *const values[], const hashtable_size_t value_sizes[], size_t index)
+{
+    const char *value = (NULL == values) ? NULL : values[index];
+    hashtable_size_t value_size = (NULL == value_sizes) ? 0u : value_sizes[index];
+
+    *pending -= ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + key_sizes[index] + value_size);
+    size_t reserved = scratch + *pending;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        return _slot_table_insert_keyval_pair(table, reserved, hash, keys[index], key_sizes[index],
+                                              value, value_size);
+    }
+
+    return _insert_keyval_pair(table, reserved, hash, keys[index], key_sizes[index], value, value_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_bulk_load(hashtable_t *table, const char *const keys[], const hashtable_size_t key_sizes[],
+                        const char *const values[], const hashtable_size_t value_sizes[],
+                        const uint32_t hashes[], size_t count)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == keys) || (NULL == key_sizes))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0 != _check_batch_keys(keys, key_sizes, count))
+    {
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (count >= UINT32_MAX)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Too many key/value pairs");
+        return -1;
+    }
+
+    size_t pair_bytes = 0u;
+    for (size_t i = 0u; i < count; i++)
+    {
+        hashtable_size_t value_size = (NULL == value_sizes) ? 0u : value_sizes[i];
+        pair_bytes += ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + key_sizes[i] + value_size);
+    }
+
+    // Pairs are stored without an incremental resize in progress, so keys need no migration
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    while (!_bulk_load_has_space(table, count, pair_bytes))
+    {
+        if (NULL == table->config.allocator)
+        {
+            return 1;
+        }
+
+        int ret = _grow_table(table, pair_bytes);
+        if (0 != ret)
+        {
+            return ret;
+        }
+
+        if (NULL != table->resize_table_data)
+        {
+            _resize_migrate_lists(table, UINT32_MAX);
+        }
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    uint32_t bucket_count = (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine) ?
+                            (SLOT_TABLE(td)->slot_count / HASHTABLE_SLOT_GROUP_SIZE) : LIST_TABLE(td)->array_count;
+
+    /* Scratch space for the sort is taken from the end of the data block, after the space
+     * needed for the new pairs: one hash value and one sorted position per pair, and the
+     * start position of each bucket */
+    size_t scratch_size = ROUND_UP_PTRSIZE(((2u * count) + bucket_count + 1u) * sizeof(uint32_t));
+    size_t bytes_free = block->total_bytes - block->bytes_used;
+
+    if ((scratch_size > bytes_free) || (pair_bytes > (bytes_free - scratch_size)))
+    {
+        // No room to sort the pairs, store them in the order given instead
+        size_t pending = pair_bytes;
+        for (size_t i = 0u; i < count; i++)
+        {
+            uint32_t hash = (NULL == hashes) ? _config_hash(&table->config, keys[i], key_sizes[i]) : hashes[i];
+            if (0 != _bulk_load_insert(table, 0u, &pending, hash, keys, key_sizes, values, value_sizes, i))
+            {
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    uint32_t *pair_hashes = (uint32_t *) (block->data + block->total_bytes - scratch_size);
+    uint32_t *order = pair_hashes + count;
+    uint32_t *starts = order + count;
+
+    (void) memset(starts, 0, (bucket_count + 1u) * sizeof(uint32_t));
+
+    // Count the pairs sorted into each bucket
+    for (size_t i = 0u; i < count; i++)
+    {
+        pair_hashes[i] = (NULL == hashes) ? _config_hash(&table->config, keys[i], key_sizes[i]) : hashes[i];
+        starts[_bulk_load_bucket(table, td, pair_hashes[i]) + 1u] += 1u;
+    }
+
+    for (uint32_t i = 1u; i <= bucket_count; i++)
+    {
+        starts[i] += starts[i - 1u];
+    }
+
+    for (size_t i = 0u; i < count; i++)
+    {
+        order[starts[_bulk_load_bucket(table, td, pair_hashes[i])]++] = (uint32_t) i;
+    }
+
+    /* Pairs for each bucket are stored one after the other, so each list ends up laid out
+     * contiguously in the data block, and the list being searched for duplicates is always
+     * the one that was just written to */
+    size_t pending = pair_bytes;
+    for (size_t i = 0u; i < count; i++)
+    {
+        uint32_t index = order[i];
+        if (0 != _bulk_load_insert(table, scratch_size, &pending, pair_hashes[index], keys, key_sizes, values,
+                                   value_sizes, index))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_bytes_remaining(hashtable_t *table, size_t *bytes_remaining)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == bytes_remaining))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    *bytes_remaining = DATA_BLOCK(td)->total_bytes - DATA_BLOCK(td)->bytes_used - table->resize_bytes_pending;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_fragmentation(hashtable_t *table, hashtable_fragmentation_t *info)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == info))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+
+    info->free_bytes = block->bytes_free;
+    info->free_blocks = block->free_count;
+    info->largest_free_block = 0u;
+
+    // Largest freed pair is in the largest non-empty size class
+    for (uint32_t i = _HASHTABLE_FREELIST_CLASSES; i > 0u; i--)
+    {
+        if (0u != (block->freelist_bitmap & (1u << (i - 1u))))
+        {
+            for (_keyval_pair_t *curr = FREELIST_HEAD(td, block, i - 1u); NULL != curr; curr = FREED_NEXT(td, curr))
+            {
+                size_t size = _pair_size(curr);
+                if (size > info->largest_free_block)
+                {
+                    info->largest_free_block = size;
+                }
+            }
+
+            break;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_get_stats(hashtable_t *table, hashtable_stats_t *stats)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == stats))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    size_t stored_bytes = 0u;
+
+    // Every list is walked, so none can be left by hashtable_clear
+    _clear_finish(td);
+    (void) memset(stats, 0, sizeof(*stats));
+
+#ifdef HASHTABLE_ENABLE_STATS
+    stats->lookups = STATS_LOAD(td, lookups);
+    stats->lookup_probes = STATS_LOAD(td, lookup_probes);
+    stats->freelist_searches = STATS_LOAD(td, freelist_searches);
+    stats->freelist_search_steps = STATS_LOAD(td, freelist_search_steps);
+#endif // HASHTABLE_ENABLE_STATS
+
+    stats->entry_count = table->entry_count;
+    stats->bucket_count = _array_count(table, td);
+    stats->freelist_length = block->free_count;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+        uint32_t group_count = slot_table->slot_count / HASHTABLE_SLOT_GROUP_SIZE;
+
+        for (uint32_t slot = 0u; slot < slot_table->slot_count; slot++)
+        {
+            if (!CTRL_IS_FULL(SLOT_CTRL(slot_table)[slot]))
+            {
+                continue;
+            }
+
+            _keyval_pair_t *pair = SLOT_PAIR(td, slot_table, slot);
+            uint32_t first = _slot_table_first_group(slot_table, _pair_hash(table, pair));
+            uint32_t group = slot / HASHTABLE_SLOT_GROUP_SIZE;
+
+            // Number of groups probed from the first group in the pair's probe sequence
+            uint32_t length = ((group >= first) ? (group - first) : ((group + group_count) - first)) + 1u;
+            if (length > stats->max_chain_length)
+            {
+                stats->max_chain_length = length;
+            }
+
+            stats->buckets_used += 1u;
+            stored_bytes += _pair_size(pair);
+        }
+    }
+    else
+    {
+        _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+
+        for (uint32_t i = 0u; i < list_table->array_count; i++)
+        {
+            uint32_t length = 0u;
+
+            for (_keyval_pair_t *curr = LIST_HEAD(td, &list_table->table[i]); NULL != curr; curr = PAIR_NEXT(td, curr))
+            {
+                length += 1u;
+                stored_bytes += _pair_size(curr);
+            }
+
+            if (length > stats->max_chain_length)
+            {
+                stats->max_chain_length = length;
+            }
+
+            stats->buckets_used += (0u < length) ? 1u : 0u;
+        }
+    }
+
+    stats->wasted_bytes = block->bytes_used - stored_bytes;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_analyze(hashtable_t *table, hashtable_analysis_t *analysis)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == analysis))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        // Only table->table_data is analyzed, so finish migrating everything first
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    const uint32_t last_bin = HASHTABLE_ANALYSIS_HISTOGRAM_BINS - 1u;
+    uint64_t sum_squares = 0u;
+
+    // Every list is walked, so none can be left by hashtable_clear
+    _clear_finish(td);
+    (void) memset(analysis, 0, sizeof(*analysis));
+    analysis->entry_count = table->entry_count;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+        uint32_t group_count = slot_table->slot_count / HASHTABLE_SLOT_GROUP_SIZE;
+
+        for (uint32_t group = 0u; group < group_count; group++)
+        {
+            uint32_t length = 0u;
+
+            for (uint32_t i = 0u; i < HASHTABLE_SLOT_GROUP_SIZE; i++)
+            {
+                uint32_t slot = (group * HASHTABLE_SLOT_GROUP_SIZE) + i;
+                if (!CTRL_IS_FULL(SLOT_CTRL(slot_table)[slot]))
+                {
+                    continue;
+                }
+
+                _keyval_pair_t *pair = SLOT_PAIR(td, slot_table, slot);
+                uint32_t first = _slot_table_first_group(slot_table, _pair_hash(table, pair));
+
+                // Number of groups between the first group in the pair's probe sequence and this one
+                uint32_t distance = (group >= first) ? (group - first) : ((group + group_count) - first);
+                analysis->histogram[(distance < last_bin) ? distance : last_bin] += 1u;
+                length += 1u;
+            }
+
+            sum_squares += ((uint64_t) length) * length;
+        }
+
+        analysis->bucket_count = group_count;
+
+        // Slots for a 7/8 load, rounded up to a whole group
+        uint64_t slots = ((uint64_t) table->entry_count * 8u) / 7u;
+        slots = ROUND_UP_GROUP_SIZE(slots) + ((0u == slots) ? HASHTABLE_SLOT_GROUP_SIZE : 0u);
+        analysis->recommended_array_count = (slots > (UINT32_MAX - HASHTABLE_SLOT_GROUP_SIZE)) ?
+                                            (UINT32_MAX - HASHTABLE_SLOT_GROUP_SIZE) : (uint32_t) slots;
+    }
+    else
+    {
+        _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+
+        for (uint32_t i = 0u; i < list_table->array_count; i++)
+        {
+            uint32_t length = 0u;
+
+            for (_keyval_pair_t *curr = LIST_HEAD(td, &list_table->table[i]); NULL != curr; curr = PAIR_NEXT(td, curr))
+            {
+                length += 1u;
+            }
+
+            analysis->histogram[(length < last_bin) ? length : last_bin] += 1u;
+            sum_squares += ((uint64_t) length) * length;
+        }
+
+        analysis->bucket_count = list_table->array_count;
+
+        analysis->recommended_array_count = table->entry_count;
+    }
+
+    if (HASHTABLE_MIN_ARRAY_COUNT > analysis->recommended_array_count)
+    {
+        analysis->recommended_array_count = HASHTABLE_MIN_ARRAY_COUNT;
+    }
+
+    if (0u < analysis->entry_count)
+    {
+        /* Sum of (count - mean)^2 / mean over all buckets, with mean = entries / buckets,
+         * is (buckets * sum(count^2) / entries) - entries. Split the division so the
+         * multiplication can not overflow. */
+        uint64_t entries = analysis->entry_count;
+        uint64_t buckets = analysis->bucket_count;
+        uint64_t scaled = ((sum_squares / entries) * buckets) + (((sum_squares % entries) * buckets) / entries);
+
+        analysis->chi_squared = scaled - entries;
+    }
+
+    analysis->chi_squared_expected = (0u < analysis->bucket_count) ? (analysis->bucket_count - 1u) : 0u;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_next_item(hashtable_t *table, char **key, hashtable_size_t *key_size,
+                        char **value, hashtable_size_t *value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        // Iteration only covers table->table_data, so finish migrating everything first
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    if (td->cursor_limit)
+    {
+        // Cursor limit reached
+        return 1;
+    }
+
+    _keyval_pair_t *pair = _cursor_next_pair(table, td);
+    if (NULL == pair)
+    {
+        td->cursor_limit = 1u;
+        return 1;
+    }
+
+    // Copy out pointers to the next item
+    *key = (char *) pair->data;
+
+    if (0u < pair->value_size)
+    {
+        *value = (char *) pair->data + pair->key_size;
+    }
+
+    if (NULL != key_size)
+    {
+        *key_size = pair->key_size;
+    }
+
+    if (NULL != value_size)
+    {
+        *value_size = pair->value_size;
+    }
+
+    td->cursor_items_traversed += 1u;
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_reset_cursor(hashtable_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    _reset_cursor((_keyval_pair_table_data_t *) table->table_data);
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_cursor_init(hashtable_t *table, hashtable_cursor_t *cursor, uint32_t begin, uint32_t end)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == cursor))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (begin > end)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid range passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        // Cursors only cover table->table_data, so finish migrating everything first
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    uint32_t array_count = _array_count(table, (_keyval_pair_table_data_t *) table->table_data);
+
+    cursor->end = (end < array_count) ? end : array_count;
+    cursor->index = (begin < cursor->end) ? begin : cursor->end;
+    cursor->item = NULL;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_cursor_next(hashtable_t *table, hashtable_cursor_t *cursor, char **key, hashtable_size_t *key_size,
+                          char **value, hashtable_size_t *value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == cursor) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_t *pair = (_keyval_pair_t *) cursor->item;
+
+    if (NULL == pair)
+    {
+        cursor->index = _next_used_index(table, td, cursor->index, cursor->end);
+        if (cursor->index >= cursor->end)
+        {
+            return 1;
+        }
+
+        if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+        {
+            pair = SLOT_PAIR(td, SLOT_TABLE(td), cursor->index);
+        }
+        else
+        {
+            pair = LIST_HEAD(td, &LIST_TABLE(td)->table[cursor->index]);
+        }
+    }
+
+    // Move to the next pair in the same list, or to the next slot at the end of the list
+    cursor->item = (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine) ? NULL : PAIR_NEXT(td, pair);
+    if (NULL == cursor->item)
+    {
+        cursor->index += 1u;
+    }
+
+    *key = (char *) pair->data;
+
+    if ((NULL != value) && (0u < pair->value_size))
+    {
+        *value = (char *) pair->data + pair->key_size;
+    }
+
+    if (NULL != key_size)
+    {
+        *key_size = pair->key_size;
+    }
+
+    if (NULL != value_size)
+    {
+        *value_size = pair->value_size;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_for_each_range(hashtable_t *table, uint32_t begin, uint32_t end,
+                             hashtable_item_func_t func, void *ctx)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == func)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    hashtable_cursor_t cursor;
+    if (0 != hashtable_cursor_init(table, &cursor, begin, end))
+    {
+        return -1;
+    }
+
+    char *key;
+    char *value;
+    hashtable_size_t key_size;
+    hashtable_size_t value_size;
+
+    while (0 == hashtable_cursor_next(table, &cursor, &key, &key_size, &value, &value_size))
+    {
+        if (0 != func(ctx, key, key_size, (0u < value_size) ? value : NULL, value_size))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * Call a function for each stored key/value pair in a range of offsets in the data block
+ *
+ * @param td     Pointer to table data section
+ * @param start  Data block offset of first pair (or gap) to visit
+ * @param end    Data block offset to stop at
+ * @param func   Function to call for each stored key/value pair
+ * @param ctx    Context pointer to pass to func
+ *
+ * @return 0 if func was called for all stored pairs, 1 if func returned a non-zero value
+ */
+static int _scan_data_block(_keyval_pair_table_data_t *td, size_t start, size_t end,
+                            hashtable_item_func_t func, void *ctx)
+{
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    size_t offset = start;
+
+    while (offset < end)
+    {
+        uint8_t *pos = block->data + offset;
+        size_t size = _gap_size(pos);
+
+        if (0u == size)
+        {
+            _keyval_pair_t *pair = (_keyval_pair_t *) pos;
+
+            // Size is read first, since func may remove the pair
+            size = _pair_size(pair);
+
+            if (!PAIR_IS_FREED(pair))
+            {
+                const char *value = (0u < pair->value_size) ? ((const char *) pair->data + pair->key_size) : NULL;
+                if (0 != func(ctx, (const char *) pair->data, pair->key_size, value, pair->value_size))
+                {
+                    return 1;
+                }
+            }
+        }
+
+        offset += size;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_scan_arena(hashtable_t *table, hashtable_item_func_t func, void *ctx)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == func))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        // Only table->table_data is scanned, so finish migrating everything first
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+
+    if (!td->compact_in_progress)
+    {
+        return _scan_data_block(td, 0u, block->bytes_used, func, ctx);
+    }
+
+    /* Pairs already compacted end at the write offset, and pairs not yet visited by the
+     * compaction start at the read offset; the space in between is not in use */
+    if (0 != _scan_data_block(td, 0u, td->compact_write_offset, func, ctx))
+    {
+        return 1;
+    }
+
+    return _scan_data_block(td, td->compact_read_offset, block->bytes_used, func, ctx);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+ int hashtable_clear(hashtable_t *table)
+ {
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    // Abandon any incremental resize, nothing left in the old buffer is needed
+    if (NULL != table->resize_table_data)
+    {
+        _resize_end(table);
+    }
+
+    table->entry_count = 0u;
+    table->reserved_pair = NULL;
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+
+        // Mark all slots as empty
+        (void) memset(SLOT_CTRL(slot_table), CTRL_EMPTY, slot_table->slot_count);
+        slot_table->used_count = 0u;
+        slot_table->deleted_count = 0u;
+    }
+    else
+    {
+        /* Only empty the occupancy bitmap and bloom filter; array entries are treated as empty
+         * while their occupancy bit is clear, and are NULL-ified later (see _clear_lists) */
+        _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+        (void) memset(_occupancy_bitmap(list_table), 0, _HASHTABLE_OCCUPANCY_BITMAP_SIZE(list_table->array_count) +
+                      _HASHTABLE_BLOOM_FILTER_SIZE(list_table->array_count));
+        td->clear_in_progress = 1u;
+        td->clear_index = 0u;
+    }
+
+    // Reset cursor values
+    _reset_cursor(td);
+
+    // Reset key/pair value data block
+    _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+    _freelist_reset(block);
+    td->compact_in_progress = 0u;
+#ifdef HASHTABLE_CACHE_EVICTION
+    td->clock_hand = 0u;
+#endif // HASHTABLE_CACHE_EVICTION
+    block->total_bytes = table->data_size - _min_buffer_size(table->config.engine, _array_count(table, td));
+    block->bytes_used = 0u;
+
+    return 0;
+ }
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_destroy(hashtable_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        _resize_end(table);
+    }
+
+    if (table->buffer_allocated)
+    {
+        table->config.allocator->free(table->config.allocator->ctx, table->table_data);
+        table->buffer_allocated = 0u;
+    }
+
+    table->table_data = NULL;
+    table->data_size = 0u;
+    table->entry_count = 0u;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_resize(hashtable_t *table, void *buffer, size_t buffer_size, uint32_t array_count)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || ((NULL == buffer) && (NULL == table->config.allocator)))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    // Count exactly how much space is needed for all stored pairs
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    size_t bytes_needed = 0u;
+
+    _clear_finish(td);
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine)
+    {
+        _keyval_pair_slot_table_t *slot_table = SLOT_TABLE(td);
+
+        for (uint32_t i = 0u; i < slot_table->slot_count; i++)
+        {
+            if (CTRL_IS_FULL(SLOT_CTRL(slot_table)[i]))
+            {
+                _keyval_pair_t *curr = SLOT_PAIR(td, slot_table, i);
+                bytes_needed += _pair_size(curr);
+            }
+        }
+    }
+    else
+    {
+        _keyval_pair_list_table_t *list_table = LIST_TABLE(td);
+
+        for (uint32_t i = 0u; i < list_table->array_count; i++)
+        {
+            for (_keyval_pair_t *curr = LIST_HEAD(td, &list_table->table[i]); NULL != curr; curr = PAIR_NEXT(td, curr))
+            {
+                bytes_needed += _pair_size(curr);
+            }
+        }
+    }
+
+    int ret = (NULL == buffer) ? _resize_start_allocated(table, buffer_size, array_count, bytes_needed) :
+                                 _resize_start(table, buffer, buffer_size, array_count, bytes_needed);
+    if (0 != ret)
+    {
+        return ret;
+    }
+
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_resize_incremental(hashtable_t *table, void *buffer, size_t buffer_size, uint32_t array_count)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || ((NULL == buffer) && (NULL == table->config.allocator)))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    /* Counting the exact space needed would mean walking the whole table, so instead
+     * reserve enough for all space used in the old data block, including freed pairs */
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    size_t bytes_needed = DATA_BLOCK(td)->bytes_used;
+
+    if (NULL == buffer)
+    {
+        return _resize_start_allocated(table, buffer_size, array_count, bytes_needed);
+    }
+
+    return _resize_start(table, buffer, buffer_size, array_count, bytes_needed);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_resize_step(hashtable_t *table, uint32_t max_lists)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        _resize_migrate_lists(table, max_lists);
+    }
+
+    return (NULL == table->resize_table_data) ? 0 : 1;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_clear_step(hashtable_t *table, uint32_t max_lists)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    if (td->clear_in_progress && (0u < max_lists))
+    {
+        _clear_lists(td, max_lists);
+    }
+
+    return td->clear_in_progress ? 1 : 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_compact(hashtable_t *table)
+{
+    int ret = hashtable_compact_incremental(table);
+    if (0 != ret)
+    {
+        return ret;
+    }
+
+    _compact_pairs(table, SIZE_MAX);
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_compact_incremental(hashtable_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_STATE, "Incremental resize in progress");
+        return -1;
+    }
+
+    _compact_start((_keyval_pair_table_data_t *) table->table_data);
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_compact_step(hashtable_t *table, size_t max_bytes)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+
+    if (td->compact_in_progress && (0u < max_bytes))
+    {
+        _compact_pairs(table, max_bytes);
+    }
+
+    return td->compact_in_progress ? 1 : 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_save(hashtable_t *table, hashtable_write_func_t write, void *ctx)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == write))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    if (NULL != table->resize_table_data)
+    {
+        // Iteration only covers table->table_data, so finish migrating everything first
+        _resize_migrate_lists(table, UINT32_MAX);
+    }
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    uint32_t checksum = FNV1A_OFFSET_BASIS;
+
+    uint8_t header[SNAPSHOT_HEADER_SIZE];
+    _snapshot_encode_u32(header, SNAPSHOT_MAGIC);
+    _snapshot_encode_u32(header + 4u, SNAPSHOT_VERSION);
+    _snapshot_encode_u32(header + 8u, table->entry_count);
+    _snapshot_encode_u32(header + 12u, 0u);
+
+    if (0 != _snapshot_write(write, ctx, &checksum, header, sizeof(header)))
+    {
+        return -1;
+    }
+
+    // Save the caller's iteration cursor position, the cursor is used to walk the table
+    uint32_t cursor_array_index = td->cursor_array_index;
+    uint32_t cursor_items_traversed = td->cursor_items_traversed;
+    _HASHTABLE_LINK(_keyval_pair_t) cursor_item = td->cursor_item;
+    uint8_t cursor_limit = td->cursor_limit;
+
+    _reset_cursor(td);
+    int ret = _snapshot_write_pairs(table, td, write, ctx, &checksum);
+
+    td->cursor_array_index = cursor_array_index;
+    td->cursor_items_traversed = cursor_items_traversed;
+    td->cursor_item = cursor_item;
+    td->cursor_limit = cursor_limit;
+
+    if (0 != ret)
+    {
+        return ret;
+    }
+
+    uint8_t trailer[4];
+    _snapshot_encode_u32(trailer, checksum);
+
+    if (0 != write(ctx, trailer, sizeof(trailer)))
+    {
+        ERROR(HASHTABLE_ERROR_IO, "Write function failed");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_load(hashtable_t *table, hashtable_read_func_t read, void *ctx)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == read))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    (void) hashtable_clear(table);
+
+    uint32_t checksum = FNV1A_OFFSET_BASIS;
+    uint8_t header[SNAPSHOT_HEADER_SIZE];
+
+    if (0 != _snapshot_read(read, ctx, &checksum, header, sizeof(header)))
+    {
+        return -1;
+    }
+
+    if (SNAPSHOT_MAGIC != _snapshot_decode_u32(header))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_SNAPSHOT, "Invalid snapshot header");
+        return -1;
+    }
+
+    if (SNAPSHOT_VERSION != _snapshot_decode_u32(header + 4u))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_SNAPSHOT, "Unsupported snapshot version");
+        return -1;
+    }
+
+    int ret = _snapshot_read_pairs(table, read, ctx, &checksum, _snapshot_decode_u32(header + 8u));
+    if (0 == ret)
+    {
+        uint8_t trailer[4];
+
+        if (0 != read(ctx, trailer, sizeof(trailer)))
+        {
+            ERROR(HASHTABLE_ERROR_IO, "Read function failed");
+            ret = -1;
+        }
+        else if (_snapshot_decode_u32(trailer) != checksum)
+        {
+            ERROR(HASHTABLE_ERROR_INVALID_SNAPSHOT, "Snapshot checksum mismatch");
+            ret = -1;
+        }
+    }
+
+    if (0 != ret)
+    {
+        (void) hashtable_clear(table);
+    }
+
+    return ret;
+}
+
+
+/**
+ * Find the shard that a hash value belongs to
+ *
+ * @param table  Pointer to sharded hashtable instance
+ * @param hash   Hash value computed for key data
+ *
+ * @return Pointer to hashtable instance for the shard
+ */
+static hashtable_t *_shard_for_hash(hashtable_sharded_t *table, uint32_t hash)
+{
+    // Upper bits are used, since the lower bits select the table array slot within the shard
+    return &table->shards[(1u == table->shard_count) ? 0u : (hash >> table->shard_shift)];
+}
+
+
+/**
+ * Calculate a hash for the given key data, and find the shard it belongs to. The shard is
+ * prepared for accessing the key data (see _prepare_hash).
+ *
+ * @param table     Pointer to sharded hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ * @param hash_out  Pointer to location to store computed hash value
+ *
+ * @return Pointer to hashtable instance for the shard
+ */
+static hashtable_t *_shard_for_key(hashtable_sharded_t *table, const char *key,
+                                   const hashtable_size_t key_size, uint32_t *hash_out)
+{
+    // All shards have the same config, so any shard's hash function will do
+    uint32_t hash = _config_hash(&table->shards[0].config, key, key_size);
+    hashtable_t *shard = _shard_for_hash(table, hash);
+
+    *hash_out = _prepare_hash(shard, hash, key, key_size);
+
+    return shard;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_create(hashtable_sharded_t *table, const hashtable_config_t *config,
+                             uint32_t shard_count, void *const buffers[], const size_t buffer_sizes[])
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == buffers) || (NULL == buffer_sizes))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if ((0u == shard_count) || (HASHTABLE_MAX_SHARDS < shard_count) || (0u != (shard_count & (shard_count - 1u))))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Shard count must be a power of 2, up to HASHTABLE_MAX_SHARDS");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    table->shard_count = shard_count;
+    table->shard_shift = 32u - _ctz32(shard_count);
+    table->cursor_shard = 0u;
+
+    int ret = 0;
+
+    for (uint32_t i = 0u; i < shard_count; i++)
+    {
+        int shard_ret = hashtable_create(&table->shards[i], config, buffers[i], buffer_sizes[i]);
+        if (-1 == shard_ret)
+        {
+            return -1;
+        }
+
+        if (0 != shard_ret)
+        {
+            ret = shard_ret;
+        }
+    }
+
+    return ret;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+hashtable_t *hashtable_sharded_shard(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return NULL;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    return _shard_for_hash(table, _config_hash(&table->shards[0].config, key, key_size));
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_insert(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size,
+                             const char *value, const hashtable_size_t value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    uint32_t hash = 0u;
+    hashtable_t *shard = _shard_for_key(table, key, key_size, &hash);
+
+    return _insert_hashed(shard, hash, key, key_size, value, value_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_remove(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    uint32_t hash = 0u;
+    hashtable_t *shard = _shard_for_key(table, key, key_size, &hash);
+
+    return _remove_hashed(shard, hash, key, key_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_retrieve(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size,
+                               char **value, hashtable_size_t *value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    uint32_t hash = 0u;
+    hashtable_t *shard = _shard_for_key(table, key, key_size, &hash);
+
+    _keyval_pair_t *pair = _find_keyval_pair(shard, hash, key, key_size);
+    if (NULL == pair)
+    {
+        // Item does not exist
+        return 1;
+    }
+
+    if ((NULL != value) && (0u < pair->value_size))
+    {
+        *value = (char *) (pair->data + pair->key_size);
+    }
+
+    if (NULL != value_size)
+    {
+        *value_size = pair->value_size;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_has_key(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    uint32_t hash = 0u;
+    hashtable_t *shard = _shard_for_key(table, key, key_size, &hash);
+
+    return (NULL == _find_keyval_pair(shard, hash, key, key_size)) ? 0 : 1;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_entry_count(hashtable_sharded_t *table, uint32_t *entry_count)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == entry_count))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    *entry_count = 0u;
+
+    for (uint32_t i = 0u; i < table->shard_count; i++)
+    {
+        *entry_count += table->shards[i].entry_count;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_bytes_remaining(hashtable_sharded_t *table, size_t *bytes_remaining)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == bytes_remaining))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    *bytes_remaining = 0u;
+
+    for (uint32_t i = 0u; i < table->shard_count; i++)
+    {
+        size_t shard_bytes = 0u;
+        (void) hashtable_bytes_remaining(&table->shards[i], &shard_bytes);
+        *bytes_remaining += shard_bytes;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_next_item(hashtable_sharded_t *table, char **key, hashtable_size_t *key_size,
+                                char **value, hashtable_size_t *value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    while (table->cursor_shard < table->shard_count)
+    {
+        int ret = hashtable_next_item(&table->shards[table->cursor_shard], key, key_size, value, value_size);
+        if (1 != ret)
+        {
+            return ret;
+        }
+
+        // No more items in this shard
+        table->cursor_shard += 1u;
+    }
+
+    return 1;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_reset_cursor(hashtable_sharded_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    for (uint32_t i = 0u; i < table->shard_count; i++)
+    {
+        (void) hashtable_reset_cursor(&table->shards[i]);
+    }
+
+    table->cursor_shard = 0u;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_clear(hashtable_sharded_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    for (uint32_t i = 0u; i < table->shard_count; i++)
+    {
+        (void) hashtable_clear(&table->shards[i]);
+    }
+
+    table->cursor_shard = 0u;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_sharded_destroy(hashtable_sharded_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    for (uint32_t i = 0u; i < table->shard_count; i++)
+    {
+        (void) hashtable_destroy(&table->shards[i]);
+    }
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_default_config(hashtable_config_t *config, size_t buffer_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == config)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    config->hash = HASHTABLE_DEFAULT_HASH;
+    config->engine = HASHTABLE_ENGINE_CHAINING;
+    config->seeded_hash = NULL;
+    config->seed = 0u;
+    config->allocator = NULL;
+
+    /* We either want an array count that results in a table that takes up
+     * roughly 10% of the buffer size, or an array count of at least 10-- whichever
+     * takes up the most bytes in the buffer. */
+    size_t buf_min_size = (buffer_size * IDEAL_BUFFER_TABLE_PERCENT) / 100u; // Ideal % of buffer size
+    size_t array_min_size = ARRAY_SIZE_BYTES(HASHTABLE_MIN_ARRAY_COUNT);               // Size of an array with min. elements
+
+    if (buf_min_size > array_min_size)
+    {
+        // Figure out the array count that is closest to the ideal % of the buffer size
+        // (each table array slot also takes up ARRAY_SLOT_EXTRA_BITS bits after the table array)
+        config->array_count = (uint32_t) (((buf_min_size - sizeof(_keyval_pair_list_table_t)) * 8u) /
+                                          ((sizeof(_keyval_pair_list_t) * 8u) + ARRAY_SLOT_EXTRA_BITS)) + 1u;
+    }
+    else
+    {
+        // Best array size is HASHTABLE_MIN_ARRAY_COUNT
+        config->array_count = HASHTABLE_MIN_ARRAY_COUNT;
+    }
+
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+    /* Round down to a power of 2 so the table does not take up more than the ideal %
+     * of the buffer, unless that would go below HASHTABLE_MIN_ARRAY_COUNT */
+    if (config->array_count > MAX_POW2_ARRAY_COUNT)
+    {
+        config->array_count = MAX_POW2_ARRAY_COUNT;
+    }
+
+    uint32_t pow2_count = _round_up_pow2(config->array_count);
+    if ((pow2_count != config->array_count) && ((pow2_count / 2u) >= HASHTABLE_MIN_ARRAY_COUNT))
+    {
+        pow2_count /= 2u;
+    }
+
+    config->array_count = pow2_count;
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+char *hashtable_error_message(void)
+{
+    return (char *) _last_error.message;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+hashtable_error_t hashtable_last_error(void)
+{
+    return _last_error.code;
+}
+
+
+#if defined(HASHTABLE_CONCURRENT) || defined(HASHTABLE_RCU)
+
+// CPU hint for loops waiting on another thread
+#if defined(__x86_64__) || defined(__i386__)
+#define SPIN_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define SPIN_PAUSE() __asm__ __volatile__("yield")
+#else
+#define SPIN_PAUSE() ((void) 0)
+#endif // __x86_64__
+
+#endif // HASHTABLE_CONCURRENT || HASHTABLE_RCU
+
+
+#ifdef HASHTABLE_CONCURRENT
+
+
+/**
+ * Take a spinlock, waiting until it is released if it is already held
+ *
+ * @param lock  Pointer to lock word
+ */
+static void _spin_lock(uint32_t *lock)
+{
+    while (0u != __atomic_exchange_n(lock, 1u, __ATOMIC_ACQUIRE))
+    {
+        // Wait without writing, so the cache line is not bounced between waiting threads
+        while (0u != __atomic_load_n(lock, __ATOMIC_RELAXED))
+        {
+            SPIN_PAUSE();
+        }
+    }
+}
+
+
+/**
+ * Release a spinlock
+ *
+ * @param lock  Pointer to lock word
+ */
+static void _spin_unlock(uint32_t *lock)
+{
+    __atomic_store_n(lock, 0u, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * Get the lock stripe protecting the table array slot for a hash value
+ *
+ * @param table  Pointer to concurrent hashtable instance
+ * @param hash   Hash value computed for key data
+ *
+ * @return Pointer to lock stripe state
+ */
+static _hashtable_stripe_state_t *_concurrent_stripe(hashtable_concurrent_t *table, uint32_t hash)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    return &table->stripes[_get_table_index(td, hash) % HASHTABLE_LOCK_STRIPES].state;
+}
+
+
+/**
+ * Return any space left in the allocation chunk of a lock stripe to the free lists.
+ * The allocator lock must be held.
+ *
+ * @param td      Pointer to table data section
+ * @param stripe  Pointer to lock stripe state
+ */
+static void _concurrent_retire_chunk(_keyval_pair_table_data_t *td, _hashtable_stripe_state_t *stripe)
+{
+    if (0u < stripe->chunk_remaining)
+    {
+        _release_unused(td, stripe->chunk, stripe->chunk_remaining);
+        stripe->chunk_remaining = 0u;
+    }
+}
+
+
+/**
+ * Allocate space for a new key/value pair in a concurrent hashtable. The lock for the
+ * stripe must be held.
+ *
+ * The pair is carved out of the stripe's allocation chunk if there is space, without
+ * taking the allocator lock. Otherwise, the allocator lock is taken, and the free lists
+ * are searched (in the same way as _alloc_keyval_pair). If there is no suitable pair in
+ * the free lists, the rest of the stripe's chunk is released to the free lists, and a new
+ * chunk of HASHTABLE_ALLOC_CHUNK_SIZE bytes (or less, if there is not that much space left)
+ * is reserved from the unused end of data_block->data.
+ *
+ * @param table       Pointer to concurrent hashtable instance
+ * @param stripe      Pointer to lock stripe state
+ * @param key_size    Key data size in bytes
+ * @param value_size  Value data size in bytes
+ *
+ * @return Pointer to new key/value pair, or NULL if there was not sufficient space
+ */
+static _keyval_pair_t *_concurrent_alloc(hashtable_concurrent_t *table, _hashtable_stripe_state_t *stripe,
+                                         const hashtable_size_t key_size, const hashtable_size_t value_size)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    size_t size_required = ROUND_UP_PTRSIZE(sizeof(_keyval_pair_t) + key_size + value_size);
+    _keyval_pair_t *ret = NULL;
+
+    if (size_required > stripe->chunk_remaining)
+    {
+        _spin_lock(&table->alloc_lock.state.locked);
+
+        ret = _search_free_list(td, size_required);
+        if (NULL == ret)
+        {
+            _keyval_pair_data_block_t *block = DATA_BLOCK(td);
+            size_t size_remaining = block->total_bytes - block->bytes_used;
+
+            if (size_required > size_remaining)
+            {
+                // Not enough space
+                _spin_unlock(&table->alloc_lock.state.locked);
+                return NULL;
+            }
+
+            size_t chunk_size = (size_required > HASHTABLE_ALLOC_CHUNK_SIZE) ?
+                                size_required : HASHTABLE_ALLOC_CHUNK_SIZE;
+            if (chunk_size > size_remaining)
+            {
+                chunk_size = size_remaining & ~(sizeof(int *) - 1u);
+            }
+
+            _concurrent_retire_chunk(td, stripe);
+            stripe->chunk = block->data + block->bytes_used;
+            stripe->chunk_remaining = chunk_size;
+            block->bytes_used += chunk_size;
+        }
+
+        _spin_unlock(&table->alloc_lock.state.locked);
+    }
+
+    if (NULL == ret)
+    {
+        size_t padding = _cache_align_padding(stripe->chunk, key_size);
+        if ((0u < padding) && (padding <= (stripe->chunk_remaining - size_required)))
+        {
+            _write_gap(stripe->chunk, padding);
+            stripe->chunk += padding;
+            stripe->chunk_remaining -= padding;
+        }
+
+        ret = (_keyval_pair_t *) stripe->chunk;
+        stripe->chunk += size_required;
+        stripe->chunk_remaining -= size_required;
+    }
+
+    // Populate new entry
+    ret->next = LINK_SET(td, NULL);
+    ret->key_size = key_size;
+    ret->value_size = value_size;
+
+    return ret;
+}
+
+
+/**
+ * Unlink a stored key/value pair from a list in a concurrent hashtable, and add it to
+ * the free lists. The lock for the stripe must be held.
+ *
+ * @param table   Pointer to concurrent hashtable instance
+ * @param stripe  Pointer to lock stripe state
+ * @param list    Pointer to list to remove key/val pair from
+ * @param pair    Pointer to key/val pair to remove
+ * @param prev    Pointer to item before the key/val pair to be removed
+ */
+static void _concurrent_remove_pair(hashtable_concurrent_t *table, _hashtable_stripe_state_t *stripe,
+                                    _keyval_pair_list_t *list, _keyval_pair_t *pair, _keyval_pair_t *prev)
+{
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+
+    _list_remove(td, list, pair, prev);
+    _list_update_head_hash(&table->table, td, list, prev);
+
+    _spin_lock(&table->alloc_lock.state.locked);
+    _release_pair(td, pair);
+    _spin_unlock(&table->alloc_lock.state.locked);
+
+    (void) __atomic_sub_fetch(&stripe->entry_delta, 1, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_concurrent_create(hashtable_concurrent_t *table, const hashtable_config_t *config,
+                                void *buffer, size_t buffer_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if ((NULL != config) && (HASHTABLE_ENGINE_CHAINING != config->engine))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Concurrent tables only support HASHTABLE_ENGINE_CHAINING");
+        return -1;
+    }
+
+    if ((NULL != config) && (NULL != config->allocator))
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Concurrent tables can not use an allocator");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    (void) memset(&table->alloc_lock, 0, sizeof(table->alloc_lock));
+    (void) memset(table->stripes, 0, sizeof(table->stripes));
+
+    return hashtable_create(&table->table, config, buffer, buffer_size);
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_concurrent_insert(hashtable_concurrent_t *table, const char *key, const hashtable_size_t key_size,
+                                const char *value, const hashtable_size_t value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    uint32_t hash = _config_hash(&table->table.config, key, key_size);
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+    _hashtable_stripe_state_t *stripe = _concurrent_stripe(table, hash);
+
+    _spin_lock(&stripe->locked);
+
+    _keyval_pair_t *prev = NULL;
+    _keyval_pair_t *pair = _search_list_by_key(td, list, hash, key, key_size, &prev);
+    if (NULL != pair)
+    {
+        if (pair->value_size >= value_size)
+        {
+            // Existing pair is large enough, overwrite the value in-place
+            _spin_lock(&table->alloc_lock.state.locked);
+            _overwrite_value(td, pair, value, value_size);
+            _spin_unlock(&table->alloc_lock.state.locked);
+            _spin_unlock(&stripe->locked);
+            return 0;
+        }
+
+        _concurrent_remove_pair(table, stripe, list, pair, prev);
+    }
+
+    pair = _concurrent_alloc(table, stripe, key_size, value_size);
+    if (NULL == pair)
+    {
+        _spin_unlock(&stripe->locked);
+        return 1;
+    }
+
+#ifdef HASHTABLE_STORE_HASH
+    pair->hash = hash;
+#endif // HASHTABLE_STORE_HASH
+    (void) memcpy(pair->data, key, key_size);
+
+    if ((0u < value_size) && (NULL != value))
+    {
+        (void) memcpy(pair->data + key_size, value, value_size);
+    }
+
+    _list_append(td, list, pair, hash);
+    (void) __atomic_add_fetch(&stripe->entry_delta, 1, __ATOMIC_RELAXED);
+
+    _spin_unlock(&stripe->locked);
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_concurrent_remove(hashtable_concurrent_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    uint32_t hash = _config_hash(&table->table.config, key, key_size);
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+    _hashtable_stripe_state_t *stripe = _concurrent_stripe(table, hash);
+    int ret = 1;
+
+    _spin_lock(&stripe->locked);
+
+    _keyval_pair_t *prev = NULL;
+    _keyval_pair_t *pair = _search_list_by_key(td, list, hash, key, key_size, &prev);
+    if (NULL != pair)
+    {
+        _concurrent_remove_pair(table, stripe, list, pair, prev);
+        ret = 0;
+    }
+
+    _spin_unlock(&stripe->locked);
+
+    return ret;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_concurrent_retrieve(hashtable_concurrent_t *table, const char *key, const hashtable_size_t key_size,
+                                  char *value, hashtable_size_t value_buf_size, hashtable_size_t *value_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key) || ((NULL == value) && (0u < value_buf_size)))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    uint32_t hash = _config_hash(&table->table.config, key, key_size);
+    _hashtable_stripe_state_t *stripe = _concurrent_stripe(table, hash);
+    int ret = 1;
+
+    _spin_lock(&stripe->locked);
+
+    _keyval_pair_t *pair = _search_list_by_key(td, _get_table_list_by_hash(td, hash),
+                                               hash, key, key_size, NULL);
+    if (NULL != pair)
+    {
+        hashtable_size_t copy_size = (pair->value_size < value_buf_size) ? pair->value_size : value_buf_size;
+        if (0u < copy_size)
+        {
+            (void) memcpy(value, pair->data + pair->key_size, copy_size);
+        }
+
+        if (NULL != value_size)
+        {
+            *value_size = pair->value_size;
+        }
+
+        ret = 0;
+    }
+
+    _spin_unlock(&stripe->locked);
+
+    return ret;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_concurrent_has_key(hashtable_concurrent_t *table, const char *key, const hashtable_size_t key_size)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    uint32_t hash = _config_hash(&table->table.config, key, key_size);
+    _hashtable_stripe_state_t *stripe = _concurrent_stripe(table, hash);
+
+    _spin_lock(&stripe->locked);
+    _keyval_pair_t *pair = _search_list_by_key(td, _get_table_list_by_hash(td, hash),
+                                               hash, key, key_size, NULL);
+    _spin_unlock(&stripe->locked);
+
+    return (NULL == pair) ? 0 : 1;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_concurrent_entry_count(hashtable_concurrent_t *table, uint32_t *entry_count)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if ((NULL == table) || (NULL == entry_count))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    // table.entry_count only changes while all stripes are locked, so just add the stripe counts
+    int64_t count = (int64_t) __atomic_load_n(&table->table.entry_count, __ATOMIC_RELAXED);
+
+    for (uint32_t i = 0u; i < HASHTABLE_LOCK_STRIPES; i++)
+    {
+        count += __atomic_load_n(&table->stripes[i].state.entry_delta, __ATOMIC_RELAXED);
+    }
+
+    *entry_count = (count < 0) ? 0u : (uint32_t) count;
+
+    return 0;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+hashtable_t *hashtable_concurrent_exclusive_begin(hashtable_concurrent_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return NULL;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    // Always taken in the same order, so two threads doing this can't deadlock
+    for (uint32_t i = 0u; i < HASHTABLE_LOCK_STRIPES; i++)
+    {
+        _spin_lock(&table->stripes[i].state.locked);
+    }
+
+    // The allocator lock is only taken while holding a stripe lock, so no need to take it here
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    int64_t count = (int64_t) table->table.entry_count;
+
+    for (uint32_t i = 0u; i < HASHTABLE_LOCK_STRIPES; i++)
+    {
+        _hashtable_stripe_state_t *stripe = &table->stripes[i].state;
+
+        _concurrent_retire_chunk(td, stripe);
+        count += stripe->entry_delta;
+        __atomic_store_n(&stripe->entry_delta, 0, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&table->table.entry_count, (uint32_t) count, __ATOMIC_RELAXED);
+
+    return &table->table;
+}
+
+
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_concurrent_exclusive_end(hashtable_concurrent_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+    // The stripe functions don't know about incremental resize/compaction/clear, so finish them now
+    if (NULL != table->table.resize_table_data)
+    {
+        _resize_migrate_lists(&table->table, UINT32_MAX);
+    }
+
+    if (0 != hashtable_compact_step(&table->table, SIZE_MAX))
+    {
+        return -1;
+    }
+
+    _clear_finish((_keyval_pair_table_data_t *) table->table.table_data);
+
+    for (uint32_t i = HASHTABLE_LOCK_STRIPES; i > 0u; i--)
+    {
+        _spin_unlock(&table->stripes[i - 1u].state.locked);
+    }
+
+    return 0;
+}
+
+#endif // HASHTABLE_CONCURRENT
+
+
+#ifdef HASHTABLE_RCU
+
+// Link loads/stores that may happen while reader threads are following the same links.
+// LINK_GET may evaluate its argument more than once, so loaded links must be stored in a
+// local variable before LINK_GET is used on them.
+#define LINK_LOAD_ACQUIRE(link) __atomic_load_n(&(link), __ATOMIC_ACQUIRE)
+#define LINK_STORE_RELEASE(td, link, ptr) __atomic_store_n(&(link), LINK_SET(td, ptr), __ATOMIC_RELEASE)
+
+
+/**
+ * Search a list for a key/value pair with matching key data, from a reader thread.
+ * Same as _search_list_by_key, but links are loaded with acquire ordering, so that
+ * the contents of pairs published by the writer are visible.
  *
- * 2. If the previous step failed, invoke _store_keyval_pair to find storage (either
- *    from the free list, or by allocating new space in the data block) for the new
- *    key/val pair.
+ * @param td        Pointer to table data section
+ * @param list      Pointer to list to search
+ * @param hash      Hash value computed for key data
+ * @param key       Pointer to key data
+ * @param key_size  Size of key data in bytes
  *
- * @param table       Pointer to hashtable instance
- * @param key         Pointer to key data
- * @param key_size    Key data size in bytes
- * @param value       Pointer to value data
- * @param value_size  Value data size in bytes
+ * @return Pointer to key/val pair with matching key data, or NULL if none was found
+ */
+static _keyval_pair_t *_rcu_search_list(_keyval_pair_table_data_t *td, _keyval_pair_list_t *list,
+                                        uint32_t hash, const char *key, const hashtable_size_t key_size)
+{
+    STATS_ADD(td, lookups, 1u);
+
+#ifdef HASHTABLE_BLOOM_FILTER
+    if (!_bloom_may_contain(td, hash))
+    {
+        return NULL;
+    }
+#endif // HASHTABLE_BLOOM_FILTER
+
+    _HASHTABLE_LINK(_keyval_pair_t) link = LINK_LOAD_ACQUIRE(list->head);
+    _keyval_pair_t *curr = (_keyval_pair_t *) LINK_GET(td, link);
+
+    while (NULL != curr)
+    {
+        STATS_ADD(td, lookup_probes, 1u);
+
+        if (_pair_has_key(curr, hash, key, key_size))
+        {
+            return curr;
+        }
+
+        link = LINK_LOAD_ACQUIRE(curr->next);
+        curr = (_keyval_pair_t *) LINK_GET(td, link);
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Free removed key/value pairs that no read section can still be using. A pair removed in
+ * epoch E can be freed once every reader slot is either idle, or holds an epoch later than E
+ * (that read section started after the pair was unlinked).
  *
- * @return 0 if successful, -1 if enough space was not available
+ * @param table  Pointer to RCU hashtable instance
+ * @param wait   If non-zero, wait for read sections to end until all removed pairs are freed
  */
-static int _insert_keyval_pair(hashtable_t *table, const char *key, const hashtable_size_t key_size,
-                               const char *value, const hashtable_size_t value_size)
+static void _rcu_reclaim(hashtable_rcu_t *table, int wait)
 {
-    _keyval_pair_list_t *list = _get_table_list_by_key(table, key, key_size);
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
 
-    _keyval_pair_t *prev = NULL;
-    _keyval_pair_t *pair = _search_list_by_key(list, key, key_size, &prev);
-    if (NULL != pair)
+    if (0u == table->retired_count)
     {
-        // Item with this key already exists, check if new item can fit in existing slot
-        if (value_size <= pair->value_size)
+        return;
+    }
+
+    // Pairs were unlinked before this, make sure reader slots are read afterwards
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    while (0u < table->retired_count)
+    {
+        _hashtable_rcu_retired_t *retired = &table->retired[table->retired_head];
+        uint32_t reader = 0u;
+
+        while (reader < HASHTABLE_RCU_READERS)
         {
-            // New value is the same size or smaller than existing, easy/quick update
-            if ((0u < value_size) && (NULL != value))
+            uint64_t epoch = __atomic_load_n(&table->readers[reader].epoch, __ATOMIC_ACQUIRE);
+            if ((0u == epoch) || (epoch > retired->epoch))
             {
-                (void) memcpy(pair->data + pair->key_size, value, value_size);
+                reader += 1u;
             }
-
-            pair->value_size = value_size;
-            return 0;
-        }
-        else
-        {
-            // Existing item is too small, need to remove it and insert a new item
-            if (_remove_from_table(table, list, pair, prev) < 0)
+            else if (wait)
             {
-                ERROR("Item removal failed");
-                return -1;
+                SPIN_PAUSE();
+            }
+            else
+            {
+                // Oldest pair is still in use, so all newer ones are too
+                return;
             }
         }
+
+        _release_pair(td, (_keyval_pair_t *) retired->pair);
+        table->retired_head = (table->retired_head + 1u) % HASHTABLE_RCU_RETIRED_MAX;
+        table->retired_count -= 1u;
     }
+}
 
-    // No item with this key exists, try to allocate new space
-    pair = _store_keyval_pair(table, key, key_size, value, value_size);
-    if (NULL == pair)
+
+/**
+ * Add an unlinked key/value pair to the list of removed pairs waiting for readers. If the
+ * list is full, waits for readers to free all removed pairs first.
+ *
+ * @param table  Pointer to RCU hashtable instance
+ * @param pair   Pointer to unlinked key/value pair
+ */
+static void _rcu_retire(hashtable_rcu_t *table, _keyval_pair_t *pair)
+{
+    if (HASHTABLE_RCU_RETIRED_MAX == table->retired_count)
     {
-        return 1;
+        _rcu_reclaim(table, 1);
     }
 
-    _list_append(list, pair);
-    table->entry_count += 1u;
+    uint32_t index = (table->retired_head + table->retired_count) % HASHTABLE_RCU_RETIRED_MAX;
+    table->retired[index].pair = pair;
+    table->retired[index].epoch = table->epoch;
+    table->retired_count += 1u;
 
-    return 0;
+    // Read sections starting from now can't reach the pair
+    (void) __atomic_add_fetch(&table->epoch, 1u, __ATOMIC_SEQ_CST);
 }
 
 
 /**
  * @see hashtable_api.h
  */
-int hashtable_create(hashtable_t *table, const hashtable_config_t *config,
-                     void *buffer, size_t buffer_size)
+int hashtable_rcu_create(hashtable_rcu_t *table, const hashtable_config_t *config,
+                         void *buffer, size_t buffer_size)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
     if (NULL == table)
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
         return -1;
     }
-#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    if (NULL == config)
-    {
-        // No config provided, use default config
-        if (0 > hashtable_default_config(&table->config, buffer_size))
-        {
-            return -1;
-        }
-    }
-    else
+    if ((NULL != config) && (HASHTABLE_ENGINE_CHAINING != config->engine))
     {
-        if (NULL == config->hash)
-        {
-            ERROR("NULL function pointer in hashtable_config_t");
-            return -1;
-        }
-
-        if (0u == config->array_count)
-        {
-            ERROR("Zero array count in hashtable_config_t");
-            return -1;
-        }
-
-        (void) memcpy(&table->config, config, sizeof(table->config));
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "RCU tables only support HASHTABLE_ENGINE_CHAINING");
+        return -1;
     }
 
-    int ret = _setup_new_table(table->config.array_count, buffer, buffer_size);
-    if (0 != ret)
+    if ((NULL != config) && (NULL != config->allocator))
     {
-        return ret;
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "RCU tables can not use an allocator");
+        return -1;
     }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    table->entry_count = 0u;
-    table->table_data = buffer;
-    table->data_size = buffer_size;
+    (void) memset(table->readers, 0, sizeof(table->readers));
+    table->epoch = 1u;
+    table->retired_head = 0u;
+    table->retired_count = 0u;
 
-    return 0;
+    return hashtable_create(&table->table, config, buffer, buffer_size);
 }
 
 
 /**
  * @see hashtable_api.h
  */
-int hashtable_insert(hashtable_t *table, const char *key, const hashtable_size_t key_size,
-                     const char *value, const hashtable_size_t value_size)
+int hashtable_rcu_read_begin(hashtable_rcu_t *table, uint32_t reader)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
-    if ((NULL == table) || (NULL == key))
+    if (NULL == table)
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
         return -1;
     }
 
-    if (0u == key_size)
+    if (HASHTABLE_RCU_READERS <= reader)
     {
-        ERROR("Invalid size value passed to function");
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid reader slot passed to function");
         return -1;
     }
 #endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    return _insert_keyval_pair(table, key, key_size, value, value_size);
+    __atomic_store_n(&table->readers[reader].epoch, __atomic_load_n(&table->epoch, __ATOMIC_SEQ_CST),
+                     __ATOMIC_RELAXED);
+
+    // Either the writer sees this slot, or this reader sees links changed before the writer looked
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    return 0;
 }
 
 
 /**
  * @see hashtable_api.h
  */
-int hashtable_remove(hashtable_t *table, const char *key, const hashtable_size_t key_size)
+int hashtable_rcu_read_end(hashtable_rcu_t *table, uint32_t reader)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
-    if ((NULL == table) || (NULL == key))
+    if (NULL == table)
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
         return -1;
     }
 
-    if (0u == key_size)
+    if (HASHTABLE_RCU_READERS <= reader)
     {
-        ERROR("Invalid size value passed to function");
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid reader slot passed to function");
         return -1;
     }
 #endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    _keyval_pair_list_t *list = _get_table_list_by_key(table, key, key_size);
-
-    _keyval_pair_t *prev = NULL;
-    _keyval_pair_t *pair = _search_list_by_key(list, key, key_size, &prev);
-    if (NULL == pair)
-    {
-        // Item does not exist
-        return 1;
-    }
+    __atomic_store_n(&table->readers[reader].epoch, 0u, __ATOMIC_RELEASE);
 
-    return _remove_from_table(table, list, pair, prev);
+    return 0;
 }
 
 
 /**
  * @see hashtable_api.h
  */
-int hashtable_retrieve(hashtable_t *table, const char *key, const hashtable_size_t key_size,
-                       char **value, hashtable_size_t *value_size)
+int hashtable_rcu_retrieve(hashtable_rcu_t *table, const char *key, const hashtable_size_t key_size,
+                           char **value, hashtable_size_t *value_size)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
     if ((NULL == table) || (NULL == key))
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
         return -1;
     }
 #endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    _keyval_pair_list_t *list = _get_table_list_by_key(table, key, key_size);
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    uint32_t hash = _config_hash(&table->table.config, key, key_size);
 
-    _keyval_pair_t *pair = _search_list_by_key(list, key, key_size, NULL);
+    _keyval_pair_t *pair = _rcu_search_list(td, _get_table_list_by_hash(td, hash), hash, key, key_size);
     if (NULL == pair)
     {
         // Item does not exist
@@ -570,44 +7393,125 @@ int hashtable_retrieve(hashtable_t *table, const char *key, const hashtable_size
 /**
  * @see hashtable_api.h
  */
-int hashtable_has_key(hashtable_t *table, const char *key, const hashtable_size_t key_size)
+int hashtable_rcu_has_key(hashtable_rcu_t *table, const char *key, const hashtable_size_t key_size)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
     if ((NULL == table) || (NULL == key))
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
         return -1;
     }
 #endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    _keyval_pair_list_t *list = _get_table_list_by_key(table, key, key_size);
-
-    _keyval_pair_t *pair = _search_list_by_key(list, key, key_size, NULL);
-    if (NULL == pair)
-    {
-        // Item does not exist
-        return 0;
-    }
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    uint32_t hash = _config_hash(&table->table.config, key, key_size);
 
-    return 1;
+    return (NULL == _rcu_search_list(td, _get_table_list_by_hash(td, hash), hash, key, key_size)) ? 0 : 1;
 }
 
 
 /**
  * @see hashtable_api.h
  */
-int hashtable_bytes_remaining(hashtable_t *table, size_t *bytes_remaining)
+int hashtable_rcu_insert(hashtable_rcu_t *table, const char *key, const hashtable_size_t key_size,
+                         const char *value, const hashtable_size_t value_size)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
-    if ((NULL == table) || (NULL == bytes_remaining))
+    if ((NULL == table) || (NULL == key))
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
         return -1;
     }
 #endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
-    *bytes_remaining = td->data_block->total_bytes - td->data_block->bytes_used;
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    uint32_t hash = _config_hash(&table->table.config, key, key_size);
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
+
+    _rcu_reclaim(table, 0);
+
+    // Only the writer modifies links, so the writer can read them without atomics
+    _keyval_pair_t *prev = NULL;
+    _keyval_pair_t *old = _search_list_by_key(td, list, hash, key, key_size, &prev);
+
+    _keyval_pair_t *pair = _store_keyval_pair(td, 0u, hash, key, key_size, value, value_size);
+    if ((NULL == pair) && (0u < table->retired_count))
+    {
+        // Wait for space held by removed pairs
+        _rcu_reclaim(table, 1);
+        pair = _store_keyval_pair(td, 0u, hash, key, key_size, value, value_size);
+    }
+
+    if (NULL == pair)
+    {
+        return 1;
+    }
+
+    // The new pair is fully written before it is published
+    if (NULL != old)
+    {
+        // Take the place of the old pair, readers already on the old pair still see the rest of the list
+        pair->next = old->next;
+
+        if (NULL == prev)
+        {
+            LINK_STORE_RELEASE(td, list->head, pair);
+        }
+        else
+        {
+            LINK_STORE_RELEASE(td, prev->next, pair);
+        }
+
+#ifndef HASHTABLE_NO_LIST_TAIL
+        if (old == LIST_TAIL(td, list))
+        {
+            list->tail = LINK_SET(td, pair);
+        }
+#endif // HASHTABLE_NO_LIST_TAIL
+
+        _rcu_retire(table, old);
+    }
+    else
+    {
+#ifdef HASHTABLE_BLOOM_FILTER
+        // Readers that find the new pair must not be turned away by the filter
+        _bloom_add(td, hash);
+#endif // HASHTABLE_BLOOM_FILTER
+
+#ifdef HASHTABLE_NO_LIST_TAIL
+        if (NULL == LIST_HEAD(td, list))
+        {
+            _occupancy_update(td, list, 1);
+        }
+
+        pair->next = list->head;
+        LINK_STORE_RELEASE(td, list->head, pair);
+#else
+        pair->next = LINK_SET(td, NULL);
+
+        if (NULL == LIST_HEAD(td, list))
+        {
+            _occupancy_update(td, list, 1);
+#ifdef HASHTABLE_BUCKET_HASH
+            list->head_hash = hash;
+#endif // HASHTABLE_BUCKET_HASH
+            LINK_STORE_RELEASE(td, list->head, pair);
+        }
+        else
+        {
+            LINK_STORE_RELEASE(td, LIST_TAIL(td, list)->next, pair);
+        }
+
+        list->tail = LINK_SET(td, pair);
+#endif // HASHTABLE_NO_LIST_TAIL
+        table->table.entry_count += 1u;
+    }
 
     return 0;
 }
@@ -616,174 +7520,172 @@ int hashtable_bytes_remaining(hashtable_t *table, size_t *bytes_remaining)
 /**
  * @see hashtable_api.h
  */
-int hashtable_next_item(hashtable_t *table, char **key, hashtable_size_t *key_size,
-                        char **value, hashtable_size_t *value_size)
+int hashtable_rcu_remove(hashtable_rcu_t *table, const char *key, const hashtable_size_t key_size)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
     if ((NULL == table) || (NULL == key))
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
+    }
+
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
         return -1;
     }
 #endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
+    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table.table_data;
+    uint32_t hash = _config_hash(&table->table.config, key, key_size);
+    _keyval_pair_list_t *list = _get_table_list_by_hash(td, hash);
 
-    if (td->cursor_limit)
+    _rcu_reclaim(table, 0);
+
+    _keyval_pair_t *prev = NULL;
+    _keyval_pair_t *pair = _search_list_by_key(td, list, hash, key, key_size, &prev);
+    if (NULL == pair)
     {
-        // Cursor limit reached
+        // Item does not exist
         return 1;
     }
 
-    // Look through lists until the last index, or until we've traversed all stored items
-    while ((td->cursor_array_index < td->list_table->array_count) &&
-           (td->cursor_items_traversed < table->entry_count))
+    // Unlike _list_remove, pair->next is left alone for readers that are on the pair
+    if (NULL == prev)
     {
-        _keyval_pair_list_t *list = &td->list_table->table[td->cursor_array_index];
+        LINK_STORE_RELEASE(td, list->head, PAIR_NEXT(td, pair));
 
-        if (NULL == td->cursor_item)
+        if (NULL == LIST_HEAD(td, list))
         {
-            /* If item pointer is null, we just moved to a new slot, so
-             * set to the head of the current list */
-            td->cursor_item = list->head;
+            _occupancy_update(td, list, 0);
         }
+    }
+    else
+    {
+        LINK_STORE_RELEASE(td, prev->next, PAIR_NEXT(td, pair));
+    }
 
-        // Copy out pointers to the next non-NULL item in the list
-        if (NULL != td->cursor_item)
-        {
-            *key = (char *) td->cursor_item->data;
-
-            if (0u < td->cursor_item->value_size)
-            {
-                *value = (char *) td->cursor_item->data + td->cursor_item->key_size;
-            }
-
-            if (NULL != key_size)
-            {
-                *key_size = td->cursor_item->key_size;
-            }
+#ifndef HASHTABLE_NO_LIST_TAIL
+    if (pair == LIST_TAIL(td, list))
+    {
+        list->tail = LINK_SET(td, prev);
+    }
+#endif // HASHTABLE_NO_LIST_TAIL
 
-            if (NULL != value_size)
-            {
-                *value_size = td->cursor_item->value_size;
-            }
+    _list_update_head_hash(&table->table, td, list, prev);
+    _rcu_retire(table, pair);
+    table->table.entry_count -= 1u;
 
-            td->cursor_item = td->cursor_item->next;
-            if (NULL == td->cursor_item)
-            {
-                td->cursor_array_index += 1u;
-            }
+    return 0;
+}
 
-            td->cursor_items_traversed += 1u;
-            return 0;
-        }
 
-        td->cursor_array_index += 1u;
+/**
+ * @see hashtable_api.h
+ */
+int hashtable_rcu_reclaim(hashtable_rcu_t *table)
+{
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+    if (NULL == table)
+    {
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
+        return -1;
     }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    td->cursor_limit = 1u;
-    ERROR("Cursor limit reached");
-    return 1;
+    _rcu_reclaim(table, 0);
+
+    return (0u == table->retired_count) ? 0 : 1;
 }
 
 
 /**
  * @see hashtable_api.h
  */
-int hashtable_reset_cursor(hashtable_t *table)
+int hashtable_rcu_synchronize(hashtable_rcu_t *table)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
     if (NULL == table)
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
         return -1;
     }
 #endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
-    td->cursor_array_index = 0u;
-    td->cursor_items_traversed = 0u;
-    td->cursor_item = td->list_table->table[0].head;
-    td->cursor_limit = 0u;
+    _rcu_reclaim(table, 1);
 
     return 0;
 }
 
+#endif // HASHTABLE_RCU
+
+
+#ifdef HASHTABLE_CACHE_EVICTION
 
 /**
  * @see hashtable_api.h
  */
- int hashtable_clear(hashtable_t *table)
- {
+int hashtable_set_time(hashtable_t *table, uint32_t now)
+{
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
     if (NULL == table)
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
         return -1;
     }
 #endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    _keyval_pair_table_data_t *td = (_keyval_pair_table_data_t *) table->table_data;
-
-    // NULL-ify all the array entries
-    (void) memset(td->list_table->table, 0, td->list_table->array_count * sizeof(_keyval_pair_list_t));
-
-    // Reset cursor values
-    td->cursor_array_index = 0u;
-    td->cursor_items_traversed = 0u;
-    td->cursor_item = td->list_table->table[0].head;
-    td->cursor_limit = 0u;
-
-    // Reset key/pair value data block
-    td->data_block->freelist.head = NULL;
-    td->data_block->freelist.tail = NULL;
-    td->data_block->total_bytes = table->data_size - HASHTABLE_MIN_BUFFER_SIZE(td->list_table->array_count);
-    td->data_block->bytes_used = 0u;
+    table->cache_time = now;
 
     return 0;
- }
+}
 
 
 /**
  * @see hashtable_api.h
  */
-int hashtable_default_config(hashtable_config_t *config, size_t buffer_size)
+int hashtable_insert_ttl(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                         const char *value, const hashtable_size_t value_size, uint32_t ttl)
 {
 #ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
-    if (NULL == config)
+    if ((NULL == table) || (NULL == key))
     {
-        ERROR("NULL pointer passed to function");
+        ERROR(HASHTABLE_ERROR_NULL_POINTER, "NULL pointer passed to function");
         return -1;
     }
-#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    config->hash = _fnv1a_hash;
+    if (0u == key_size)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Invalid size value passed to function");
+        return -1;
+    }
 
-    /* We either want an array count that results in a table that takes up
-     * roughly 10% of the buffer size, or an array count of at least 10-- whichever
-     * takes up the most bytes in the buffer. */
-    size_t buf_min_size = (buffer_size * IDEAL_BUFFER_TABLE_PERCENT) / 100u; // Ideal % of buffer size
-    size_t array_min_size = ARRAY_SIZE_BYTES(HASHTABLE_MIN_ARRAY_COUNT);               // Size of an array with min. elements
+    if (0x80000000u <= ttl)
+    {
+        ERROR(HASHTABLE_ERROR_INVALID_PARAM, "Time-to-live must be less than 2^31");
+        return -1;
+    }
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
 
-    if (buf_min_size > array_min_size)
+    uint32_t hash = _hash_key(table, key, key_size);
+
+    int ret = _insert_hashed(table, hash, key, key_size, value, value_size);
+    if ((0 != ret) || (0u == ttl))
     {
-        // Figure out the array count that is closest to the ideal % of the buffer size
-        config->array_count = ((buf_min_size - sizeof(_keyval_pair_list_table_t)) / sizeof(_keyval_pair_list_t)) + 1u;
+        return ret;
     }
-    else
+
+    // Search again without the cache checks, to set the expiry time of the pair just stored
+    _keyval_pair_t *pair = _search_keyval_pair(table, hash, key, key_size);
+    pair->expiry = table->cache_time + ttl;
+
+    if (0u == pair->expiry)
     {
-        // Best array size is HASHTABLE_MIN_ARRAY_COUNT
-        config->array_count = HASHTABLE_MIN_ARRAY_COUNT;
+        // 0 means never, expire one time unit later instead
+        pair->expiry = 1u;
     }
 
     return 0;
 }
 
-
-/**
- * @see hashtable_api.h
- */
-char *hashtable_error_message(void)
-{
-    return _error_msg;
-}
+#endif // HASHTABLE_CACHE_EVICTION
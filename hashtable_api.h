@@ -4,7 +4,8 @@
  *
  * See \link hashtable_api.h API documentation for hashtable_api.h \endlink .
  *
- * This module implements a lightweight hashtable that uses separate chaining to resolve collisions.
+ * This module implements a lightweight hashtable that uses separate chaining to resolve collisions,
+ * or optionally open addressing with SIMD-probed control bytes (see #hashtable_engine_t).
  *
  * This hashtable is designed to be flexible enough for use on embedded systems that have
  * no dynamic memory, and/or limited memory in general.
@@ -51,13 +52,58 @@
  *
  * - Implemented in pure C99, and requires only `stdint.h` and `string.h`.
  * - Uses <a href="https://en.wikipedia.org/wiki/Hash_table#Separate_chaining">separate chaining</a> to resolve collisions.
+ * - Optionally uses <a href="https://en.wikipedia.org/wiki/Open_addressing">open addressing</a>
+ *   instead, with one control byte per slot holding 7 bits of the key's hash, probed 16 slots
+ *   at a time (#HASHTABLE_ENGINE_OPEN_ADDRESSING).
  * - Keys and values are byte streams of arbitrary length/contents, so keys and values can
  *   be any data type.
- * - No dynamic memory allocation, and no table re-sizing. All table data is stored
- *   in a buffer that must be provided by the caller on hashtable creation,
- *   and when there is not enough space remaining in that buffer, insertion of new
- *   items will fail.
- * - Provide/write your own hash function (FNV-1a is used by default if you don't provide one).
+ * - No dynamic memory allocation. All table data is stored in a buffer that must be
+ *   provided by the caller on hashtable creation, and when there is not enough space
+ *   remaining in that buffer, insertion of new items will fail. Optionally, allocation
+ *   functions can be provided instead (#hashtable_allocator_t), and a table that runs out of
+ *   space moves itself into a buffer twice the size, so it only takes as much memory as
+ *   its stored items need.
+ * - Values can be written straight into the table's buffer, instead of being copied in from
+ *   a separate buffer, with #hashtable_reserve and #hashtable_commit.
+ * - Tables can be moved into a larger (or smaller) buffer with a different array count,
+ *   either all at once or incrementally while the table is in use, with #hashtable_resize
+ *   and #hashtable_resize_incremental.
+ * - Stored items can be compacted towards the start of the buffer, returning the space held
+ *   by removed items to the unused end of the buffer, either all at once or a few bytes at a
+ *   time with #hashtable_compact and #hashtable_compact_incremental.
+ * - Space freed by removed items is kept in size-class free lists, so it can be re-used by
+ *   new items without searching, and can be inspected with #hashtable_fragmentation.
+ * - List lengths, free list length and wasted space can be inspected with #hashtable_get_stats,
+ *   which also reports lookup and free list search costs with #HASHTABLE_ENABLE_STATS.
+ * - A chain length histogram, a chi-squared score for the spread of keys over the table array,
+ *   and a recommended array count can be computed with #hashtable_analyze (see also
+ *   perf_test/hash_analyzer.c, which does this for a file of keys).
+ * - Provide/write your own hash function (FNV-1a is used by default if you don't provide one),
+ *   or use one of the built-in word-at-a-time hash functions (#hashtable_hash_wyhash,
+ *   #hashtable_hash_crc32c), optionally with a secret seed (#hashtable_config_t::seeded_hash).
+ * - Keys with a hash value that is already known (e.g. from #hashtable_hash) can be looked
+ *   up, inserted and removed without hashing them again (#hashtable_insert_hashed and
+ *   friends), and #hashtable_get_or_insert finds or stores a key with a single search.
+ * - Large tables can be built with #hashtable_bulk_load, which sorts the new key/value pairs
+ *   so that the pairs of each list are stored next to each other.
+ * - Tables can be used as a fixed-size cache, with per-pair expiry times and CLOCK eviction
+ *   of cold pairs when the buffer is full (#HASHTABLE_CACHE_EVICTION).
+ * - A buffer holding a table can be saved and re-used later (or by another process) with
+ *   #hashtable_attach. With #HASHTABLE_OFFSET_POINTERS, the buffer can be at any address.
+ * - Stored items can also be written to a compact, checksummed snapshot stream with
+ *   #hashtable_save, and loaded into any table with #hashtable_load.
+ * - Stored items can be iterated over with any number of independent cursors, each covering
+ *   a range of table array slots, skipping empty slots with an occupancy bitmap
+ *   (#hashtable_cursor_init, #hashtable_for_each_range).
+ * - Stored items can also be visited in insertion order with one sequential pass over the
+ *   buffer (#hashtable_scan_arena).
+ * - One logical table can be split into independent shards, each with its own buffer, with
+ *   #hashtable_sharded_create.
+ * - Tables specialized for one key size and one value size can be generated with
+ *   #HASHTABLE_DEFINE_FIXED (see hashtable_fixed.h). Entries are stored inline with no size
+ *   fields or links, and keys are compared with a single integer comparison.
+ * - Optional lock-striped concurrent access from many threads (see #HASHTABLE_CONCURRENT).
+ * - Optional lock-free reads for single-writer, read-mostly tables (see #HASHTABLE_RCU).
  *
  * \section buildopts_sec Build/compile options
  *
@@ -97,253 +143,2115 @@
  *  --------------------------|-----------------------------------------------------
  *  `HASHTABLE_PACKED_STRUCT` | Key/value pair struct uses `__attribute__((packed))`
  *
+ * \subsection store_hash_sec Store hash values with key/value pairs
+ *
+ *  Store the 32-bit hash of each key alongside the key/value pair data. When searching
+ *  a list for a key, the stored hash and key size are compared before any key data is
+ *  compared, so pairs that cannot match are skipped without reading the key bytes. This
+ *  costs 4 extra bytes (plus any alignment padding) per stored key/value pair:
+ *
+ *  Symbol name             | Effect
+ *  ------------------------|-----------------------------------------------------
+ *  `HASHTABLE_STORE_HASH`  | Key/value pair struct holds the hash of the key data
+ *
+ *  When `HASHTABLE_STORE_HASH` is defined, #hashtable_resize and #hashtable_resize_incremental
+ *  use the stored hash values, and do not need to call the hash function for each stored pair.
+ *
+ * \subsection bloom_filter_sec Bloom filter for keys that do not exist
+ *
+ *  Define the following option to store a blocked bloom filter after the table array, with
+ *  `HASHTABLE_BLOOM_BITS_PER_SLOT` bits (16 by default) for each table array slot. Every
+ *  stored key sets 3 bits in one 32-bit word of the filter, and a search for a key only
+ *  reads the key's list if all 3 bits are set, so most searches for keys that do not exist
+ *  return without reading any key/value pairs. Removed keys stay in the filter (making it
+ *  less effective, but never wrong) until the filter is rebuilt by #hashtable_clear, a
+ *  compaction (#hashtable_compact, #hashtable_compact_step), or a resize. Only used by
+ *  #HASHTABLE_ENGINE_CHAINING. See also #hashtable_bloom_check:
+ *
+ *  Symbol name                      | Effect
+ *  ---------------------------------|---------------------------------------------------
+ *  `HASHTABLE_BLOOM_FILTER`         | Bloom filter stored after the table array
+ *  `HASHTABLE_BLOOM_BITS_PER_SLOT`  | Bloom filter bits per table array slot, <b>16 by default</b>
+ *
+ * \subsection no_list_tail_sec Table array slots without a tail link
+ *
+ *  By default, each table array slot holds links to the first and last key/value pairs of
+ *  its list, so new pairs can be added at the end of the list. Define the following option
+ *  to store only the link to the first pair, and add new pairs at the start of the list
+ *  instead. This halves the size of each table array slot, so #hashtable_default_config
+ *  chooses twice as many slots for the same buffer size (or, with a fixed array count, twice
+ *  as much of the buffer is left for key/value pairs). Recently inserted pairs are found
+ *  first when searching a list, and items are read by #hashtable_next_item in a different
+ *  order. Cannot be used with `HASHTABLE_BUCKET_HASH`:
+ *
+ *  Symbol name                 | Effect
+ *  ----------------------------|---------------------------------------------------
+ *  `HASHTABLE_NO_LIST_TAIL`    | Table array slots only hold a link to the first key/value pair
+ *
+ * \subsection bucket_hash_sec Store hash values in table array slots
+ *
+ *  Define the following option to store the hash value of the first key/value pair of each
+ *  list in the table array slot, next to the list head and tail. A search of a list holding
+ *  a single key/value pair (the usual case when there are fewer items than array slots) for
+ *  a key with a different hash value then fails without reading the key/value pair, so most
+ *  searches for keys that do not exist never touch the data block. Each table array slot
+ *  is 4 bytes larger (plus any padding), and removing the first key/value pair from a list
+ *  computes the hash value of the next key/value pair, unless it is stored with the pair
+ *  (`HASHTABLE_STORE_HASH`). Only used by #HASHTABLE_ENGINE_CHAINING.
+ *
+ *  Symbol name                 | Effect
+ *  ----------------------------|---------------------------------------------------
+ *  `HASHTABLE_BUCKET_HASH`     | Hash value of first key/value pair stored in each table array slot
+ *
+ * \subsection cache_align_sec Cache line aware key/value pair placement
+ *
+ *  A search for a key reads the header of each key/value pair it visits (the link to the
+ *  next pair, the sizes, and the hash if `HASHTABLE_STORE_HASH` is defined), and the key
+ *  data, but never the value data, which is stored after the key data. Define the following
+ *  option to place each new key/value pair so that its header and key data do not straddle
+ *  a 64-byte cache line boundary (pairs where the header and key data are larger than a
+ *  cache line start on a cache line boundary instead), so a search touches one cache line per
+ *  pair visited, no matter how large the values are. Padding is added in front of a pair when
+ *  it is carved out of unused space, or moved by a compaction, and costs less than one cache
+ *  line per pair. Pairs that re-use the space of removed pairs are not moved, and no padding
+ *  is added if it would not leave enough space for an incremental resize in progress. Table
+ *  buffers are not affected otherwise, and can be attached to by builds without this option:
+ *
+ *  Symbol name                    | Effect
+ *  -------------------------------|---------------------------------------------------
+ *  `HASHTABLE_CACHE_ALIGN_PAIRS`  | Key/value pair header and key data kept in one cache line
+ *
+ * \subsection cache_eviction_sec Cache mode (expiry and eviction)
+ *
+ *  Define the following option to use tables as a fixed-size cache. Each key/value pair holds
+ *  an expiry time and a reference bit (8 extra bytes per pair, plus any alignment padding).
+ *  Times are given by the caller with #hashtable_set_time, in any unit (seconds, ticks), and
+ *  may wrap around as long as no time-to-live is longer than 2^31 units. Pairs stored by
+ *  #hashtable_insert_ttl expire after the given time-to-live; a search that finds an expired
+ *  pair removes it, and reports the key as not existing. Pairs stored by any other function
+ *  never expire.
+ *
+ *  When an insertion finds no space left, instead of returning 1 it evicts stored pairs,
+ *  picked by a CLOCK hand that walks the data block in address order: expired pairs, and pairs
+ *  that have not been found by a search since the hand last passed them, are evicted, and the
+ *  reference bit of other pairs is cleared. If enough space is free in total but the new pair
+ *  does not fit in any of it, the table is compacted (see #hashtable_compact) first. A table
+ *  with an allocator (#hashtable_config_t::allocator) only grows into a larger buffer if the
+ *  new pair does not fit even after evicting everything. Pointers returned by searches are
+ *  only valid until the next insertion, since any insertion may evict or move stored pairs.
+ *
+ *  Expired pairs are still visited by #hashtable_next_item, cursors and
+ *  #hashtable_scan_arena until they are evicted or searched for, and are kept (without their
+ *  expiry times) by #hashtable_save. #hashtable_bulk_load does not evict. Cannot be used with
+ *  `HASHTABLE_CONCURRENT` or `HASHTABLE_RCU`:
+ *
+ *  Symbol name                    | Effect
+ *  -------------------------------|---------------------------------------------------
+ *  `HASHTABLE_CACHE_EVICTION`     | Pairs have expiry times, and full tables evict pairs
+ *
+ *  Tables created by a build with this option can only be attached to by a build
+ *  with the same option (see #hashtable_attach).
+ *
+ * \subsection resize_step_sec Incremental resize step size
+ *
+ *  Number of table array slots migrated by each #hashtable_insert, #hashtable_remove,
+ *  #hashtable_retrieve and #hashtable_has_key call while an incremental resize is in
+ *  progress, in addition to the slot for the key being accessed:
+ *
+ *  Symbol name                          | Effect
+ *  -------------------------------------|---------------------------------------------------
+ *  `HASHTABLE_RESIZE_LISTS_PER_OP`      | Slots migrated per call, <b>8 by default</b>
+ *
+ * \subsection clear_step_sec Deferred clear step size
+ *
+ *  Number of table array slots zeroed by each #hashtable_insert, #hashtable_remove,
+ *  #hashtable_retrieve and #hashtable_has_key call after #hashtable_clear, until all slots
+ *  left by the clear have been zeroed (see #hashtable_clear_step):
+ *
+ *  Symbol name                          | Effect
+ *  -------------------------------------|---------------------------------------------------
+ *  `HASHTABLE_CLEAR_LISTS_PER_OP`       | Slots zeroed per call, <b>32 by default</b>
+ *
+ * \subsection disable_simd_sec Disable SIMD control byte probing
+ *
+ *  By default, the open addressing engine uses SSE2 (x86) or NEON (AArch64) instructions
+ *  to compare a group of control bytes at once, when the compiler supports them. Define the
+ *  following option to always use the portable (one byte at a time) implementation instead:
+ *
+ *  Symbol name                 | Effect
+ *  ----------------------------|---------------------------------------------------
+ *  `HASHTABLE_DISABLE_SIMD`    | Control bytes are compared without SIMD instructions
+ *
+ * \subsection thread_local_sec Storage class for the last error
+ *
+ *  The last error code and message (see #hashtable_last_error and #hashtable_error_message)
+ *  are stored in a thread-local variable, so that functions called from different threads
+ *  (for different tables) do not write to the same memory. `_Thread_local` is used for C11,
+ *  and `__thread` for GCC/clang in C99 mode. Define the following option to use a different
+ *  storage class specifier (define it as empty if the compiler has no thread-local storage):
+ *
+ *  Symbol name                   | Effect
+ *  ------------------------------|---------------------------------------------------
+ *  `HASHTABLE_THREAD_LOCAL`      | Storage class specifier used for the last error
+ *
+ * \subsection offset_pointers_sec Position-independent table buffers
+ *
+ *  By default, links between key/value pairs (and the other structures in a table buffer)
+ *  are stored as pointers, so a buffer only holds a valid table at the address it was created
+ *  at. Define the following option to store links as 32-bit offsets from the start of the
+ *  buffer instead, so a buffer can be copied, or mapped at a different address, and used
+ *  with #hashtable_attach. Buffers must be 4GB or smaller when this option is defined:
+ *
+ *  Symbol name                   | Effect
+ *  ------------------------------|---------------------------------------------------
+ *  `HASHTABLE_OFFSET_POINTERS`   | Links in table buffers are 32-bit offsets
+ *
+ * \subsection default_hash_sec Default hash function
+ *
+ *  The hash function used by #hashtable_default_config, and by #hashtable_attach when no
+ *  configuration is given, is #hashtable_hash_fnv1a by default. Define the following option
+ *  as the name of any function matching #hashtable_hashfunc_t (for example
+ *  #hashtable_hash_wyhash or #hashtable_hash_crc32c) to use a different default:
+ *
+ *  Symbol name                   | Effect
+ *  ------------------------------|---------------------------------------------------
+ *  `HASHTABLE_DEFAULT_HASH`      | Default hash function, <b>hashtable_hash_fnv1a by default</b>
+ *
+ * \subsection index_reduction_sec Table index calculation
+ *
+ *  By default, the table array index for a key is the key's hash value modulo the array
+ *  count, which costs a 32-bit division on every operation (slow on most CPUs, and
+ *  implemented in software on some microcontrollers). Define one of the following options
+ *  to avoid the division. Both multiply the hash value by a fibonacci hashing constant
+ *  first, so hash functions with weak low or high bits still use the whole array:
+ *
+ *  Symbol name                    | Effect
+ *  -------------------------------|---------------------------------------------------
+ *  `HASHTABLE_POW2_ARRAY_COUNT`   | Array counts are rounded up to a power of 2 (and #hashtable_default_config picks a power of 2), and indices are taken with a bit mask
+ *  `HASHTABLE_FAST_RANGE`         | Array counts are not changed, and indices are taken with a multiply and shift (Lemire's fast range reduction)
+ *
+ *  Tables created by a build with one of these options can only be attached to by a build
+ *  with the same option (see #hashtable_attach).
+ *
+ * \subsection stats_sec Runtime statistics
+ *
+ *  #hashtable_get_stats reports the current shape of a table (used table array slots, longest
+ *  list, free list length, wasted bytes) in any build. Define the following option to also
+ *  count key searches, the probes made by each search, and free list searches, so the average
+ *  cost of a lookup in a running table can be seen. Counters are updated with relaxed atomic
+ *  additions with #HASHTABLE_CONCURRENT or #HASHTABLE_RCU, and are compiled out otherwise:
+ *
+ *  Symbol name                   | Effect
+ *  ------------------------------|---------------------------------------------------
+ *  `HASHTABLE_ENABLE_STATS`      | Table buffers hold counters for #hashtable_get_stats
+ *
+ *  Tables created by a build with this option can only be attached to by a build
+ *  with the same option (see #hashtable_attach).
+ *
+ * \subsection max_shards_sec Max. shards in a sharded table
+ *
+ *  Maximum number of shards in a #hashtable_sharded_t instance (see #hashtable_sharded_create).
+ *  Each #hashtable_sharded_t holds one #hashtable_t for each possible shard:
+ *
+ *  Symbol name                   | Effect
+ *  ------------------------------|---------------------------------------------------
+ *  `HASHTABLE_MAX_SHARDS`        | Max. shards per sharded table, <b>16 by default</b>
+ *
+ * \subsection concurrent_sec Concurrent access
+ *
+ *  Define the following option to enable the `hashtable_concurrent_` functions (see
+ *  #hashtable_concurrent_create), which can be called for the same table from many threads
+ *  at once. Table array slots are protected by a fixed number of spinlocks ("lock stripes"),
+ *  so threads accessing keys in different stripes do not wait for each other. Each stripe
+ *  also reserves a chunk of the unused data space at a time for new key/value pairs, so
+ *  insertions through different stripes do not all update the same allocation counter.
+ *  Requires a compiler with GCC-style `__atomic` builtins:
+ *
+ *  Symbol name                   | Effect
+ *  ------------------------------|---------------------------------------------------
+ *  `HASHTABLE_CONCURRENT`        | Enables the `hashtable_concurrent_` functions
+ *  `HASHTABLE_LOCK_STRIPES`      | Number of lock stripes per table, <b>64 by default</b>
+ *  `HASHTABLE_ALLOC_CHUNK_SIZE`  | Bytes reserved by a stripe at a time, <b>4096 by default</b>
+ *
+ * \subsection rcu_sec Lock-free reads
+ *
+ *  Define the following option to enable the `hashtable_rcu_` functions (see
+ *  #hashtable_rcu_create), for read-mostly tables with a single writer thread. Readers look
+ *  up keys without taking a lock or writing to any shared memory (other than their own
+ *  reader slot), and new key/value pairs are published to readers with release/acquire atomics.
+ *  Removed pairs are only re-used once all read sections active at the time of removal have
+ *  ended (epoch-based reclamation). Requires a compiler with GCC-style `__atomic` builtins:
+ *
+ *  Symbol name                   | Effect
+ *  ------------------------------|---------------------------------------------------
+ *  `HASHTABLE_RCU`               | Enables the `hashtable_rcu_` functions
+ *  `HASHTABLE_RCU_READERS`       | Number of reader slots per table, <b>16 by default</b>
+ *  `HASHTABLE_RCU_RETIRED_MAX`   | Removed pairs held before the writer waits, <b>64 by default</b>
+ *
+ */
+
+
+/**
+ * @file hashtable_api.h
+ *
+ * @author Erik K. Nyquist
+ *
+ * @brief Implements a lightweight separate-chaining hashtable designed to be flexible
+ *        enough for embedded systems.
+ */
+
+#ifndef HASHTABLE_API_H
+#define HASHTABLE_API_H
+
+#include <stdint.h>
+
+
+#define HASHTABLE_LIB_VERSION "v0.1.1"
+
+
+#if !defined(HASHTABLE_SIZE_T_UINT16) && !defined(HASHTABLE_SIZE_T_UINT32) && !defined(HASHTABLE_SIZE_T_SYS)
+#define HASHTABLE_SIZE_T_SYS
+#endif // if !defined..
+
+
+/**
+ * @brief Defines the type used to represent the size of keys and values stored in the hashtable
+ */
+#if defined(HASHTABLE_SIZE_T_UINT16)
+typedef uint16_t hashtable_size_t;
+#elif defined(HASHTABLE_SIZE_T_UINT32)
+typedef uint32_t hashtable_size_t;
+#elif defined(HASHTABLE_SIZE_T_SYS)
+typedef size_t hashtable_size_t;
+#else
+#error("HASHTABLE_SIZE_T option not defined")
+#endif // if defined....
+
+
+/**
+ * @brief Minimum number of slots in the table array
+ */
+#define HASHTABLE_MIN_ARRAY_COUNT (10u)
+
+
+/**
+ * @brief Helper macro, gets the min. required buffer size for a specific array count.
+ *        When creating a hashtable with a specific array count, this macro will tell
+ *        you how much memory is required at a minimum to hold the 'housekeeping' data
+ *        for that table. Any remaining space is used for key/value pair data storage.
+ *        With #HASHTABLE_POW2_ARRAY_COUNT, the array count is rounded up to a power of 2.
+ */
+#define HASHTABLE_MIN_BUFFER_SIZE(array_count)                                 \
+    (sizeof(_keyval_pair_table_data_t) +                                       \
+    _HASHTABLE_ROUND_UP_PTRSIZE(sizeof(_keyval_pair_list_table_t) +            \
+        (_HASHTABLE_ARRAY_COUNT(array_count) * sizeof(_keyval_pair_list_t)) +  \
+        _HASHTABLE_OCCUPANCY_BITMAP_SIZE(_HASHTABLE_ARRAY_COUNT(array_count)) + \
+        _HASHTABLE_BLOOM_FILTER_SIZE(_HASHTABLE_ARRAY_COUNT(array_count))) +   \
+    sizeof(_keyval_pair_data_block_t))
+
+
+/**
+ * @brief Number of open addressing slots whose control bytes are probed together.
+ *        The number of slots in an open addressing table is always a multiple of this.
+ */
+#define HASHTABLE_SLOT_GROUP_SIZE (16u)
+
+
+/**
+ * @brief Helper macro, gets the min. required buffer size for a specific slot count,
+ *        when using #HASHTABLE_ENGINE_OPEN_ADDRESSING. The slot count is rounded
+ *        up to a multiple of #HASHTABLE_SLOT_GROUP_SIZE (and to a power of 2 first,
+ *        with #HASHTABLE_POW2_ARRAY_COUNT).
+ */
+#define HASHTABLE_MIN_BUFFER_SIZE_OPEN_ADDRESSING(slot_count)                   \
+    (sizeof(_keyval_pair_table_data_t) +                                       \
+    _HASHTABLE_ROUND_UP_PTRSIZE(sizeof(_keyval_pair_slot_table_t) +            \
+        (((_HASHTABLE_ARRAY_COUNT(slot_count) + (HASHTABLE_SLOT_GROUP_SIZE - 1u)) & \
+          ~(HASHTABLE_SLOT_GROUP_SIZE - 1u)) *                                 \
+         (sizeof(_HASHTABLE_LINK(_keyval_pair_t)) + 1u))) +                    \
+    sizeof(_keyval_pair_data_block_t))
+
+
+/**
+ * Hash function used for hashing key data
+ *
+ * @param data   Pointer to key data
+ * @param size   Key data size in bytes
+ *
+ * @return  Computed hash value
+ */
+typedef uint32_t (*hashtable_hashfunc_t)(const char *data, const hashtable_size_t size);
+
+
+/**
+ * Defines a hash function that takes a seed value, see #hashtable_config_t
+ *
+ * @param data   Pointer to key data
+ * @param size   Key data size in bytes
+ * @param seed   Seed value from the table configuration
+ *
+ * @return  Computed hash value
+ */
+typedef uint32_t (*hashtable_seeded_hashfunc_t)(const char *data, const hashtable_size_t size, uint64_t seed);
+
+
+/**
+ * @brief Method used to store key/value pairs and resolve collisions
+ */
+typedef enum
+{
+    /**
+     * Separate chaining; each table array slot holds a linked list of key/value pairs.
+     * This is the default.
+     */
+    HASHTABLE_ENGINE_CHAINING = 0,
+
+    /**
+     * Open addressing; each slot holds a pointer to a single key/value pair, and one control
+     * byte per slot holds 7 bits of the key's hash value. Control bytes are probed in groups of
+     * #HASHTABLE_SLOT_GROUP_SIZE, using SSE2 or NEON instructions if available, so most lookups
+     * only read the matching key/value pair. At most 7/8ths of the slots can be used.
+     */
+    HASHTABLE_ENGINE_OPEN_ADDRESSING = 1
+} hashtable_engine_t;
+
+
+/**
+ * @brief Kinds of error reported by hashtable functions that return -1, see #hashtable_last_error
+ */
+typedef enum
+{
+    HASHTABLE_ERROR_NONE = 0,          ///< No error has occurred
+    HASHTABLE_ERROR_NULL_POINTER,      ///< NULL pointer passed to function
+    HASHTABLE_ERROR_INVALID_PARAM,     ///< Invalid size, configuration or buffer passed to function
+    HASHTABLE_ERROR_INVALID_STATE,     ///< Operation not possible in the current table state
+    HASHTABLE_ERROR_INVALID_BUFFER,    ///< Buffer passed to #hashtable_attach does not hold a valid table
+    HASHTABLE_ERROR_INVALID_SNAPSHOT,  ///< Data read by #hashtable_load is not a valid snapshot
+    HASHTABLE_ERROR_IO                 ///< Read or write function failed
+} hashtable_error_t;
+
+
+/**
+ * @brief Memory allocation functions, used by tables that grow into larger buffers on
+ *        demand (see #hashtable_config_t::allocator)
+ */
+typedef struct
+{
+    void *(*alloc)(void *ctx, size_t size); ///< Allocate 'size' bytes, suitably aligned for any type
+                                  ///  (like malloc). Returns NULL if the allocation failed.
+    void (*free)(void *ctx, void *ptr); ///< Free memory returned by 'alloc'
+    void *ctx;                    ///< Context pointer passed to 'alloc' and 'free'
+} hashtable_allocator_t;
+
+
+/**
+ * @brief Configuration data for a single hashtable instance
+ */
+typedef struct
+{
+    hashtable_hashfunc_t hash;    ///< Hash function to use, must not be NULL unless 'seeded_hash' is set
+    uint32_t array_count;         ///< Number of table array slots, must not be 0. For open
+                                  ///  addressing, this is rounded up to a multiple of
+                                  ///  #HASHTABLE_SLOT_GROUP_SIZE. With #HASHTABLE_POW2_ARRAY_COUNT,
+                                  ///  this is rounded up to a power of 2.
+    hashtable_engine_t engine;    ///< Method used to store key/value pairs
+    hashtable_seeded_hashfunc_t seeded_hash; ///< Seeded hash function to use instead of 'hash',
+                                  ///  or NULL to use 'hash'
+    uint64_t seed;                ///< Seed value passed to 'seeded_hash'. Should be random, and
+                                  ///  secret from anyone supplying keys, to prevent them from
+                                  ///  choosing keys that collide.
+    const hashtable_allocator_t *allocator; ///< If not NULL, when an insertion finds no space
+                                  ///  left, a buffer twice the size (with twice the array
+                                  ///  count) is allocated, and the table is incrementally
+                                  ///  resized into it (see #hashtable_resize_incremental).
+                                  ///  NULL to never allocate memory.
+} hashtable_config_t;
+
+
+/**
+ * @brief All data for a single hashtable instance
+ */
+typedef struct
+{
+    hashtable_config_t config;    ///< Hashtable config data
+    uint32_t entry_count;         ///< Number of entries in the table
+    size_t data_size;             ///< Size of data section
+    void *table_data;             ///< Pointer to buffer for data section
+    void *resize_table_data;      ///< Pointer to buffer being migrated from by an incremental resize, NULL if none
+    size_t resize_bytes_pending;  ///< Bytes held back in data section for pairs not yet migrated
+    uint32_t resize_array_index;  ///< Next table array index to be migrated
+    uint8_t buffer_allocated;     ///< 1 if table_data was allocated with config.allocator
+    uint8_t resize_buffer_allocated; ///< 1 if resize_table_data was allocated with config.allocator
+    void *reserved_pair;          ///< Key/value pair reserved by #hashtable_reserve, NULL if none
+    uint32_t reserved_hash;       ///< Hash value computed for the reserved pair's key data
+#ifdef HASHTABLE_CACHE_EVICTION
+    uint32_t cache_time;          ///< Current time, set by #hashtable_set_time
+#endif // HASHTABLE_CACHE_EVICTION
+} hashtable_t;
+
+
+/**
+ * @brief Information about space held by removed key/value pairs, see #hashtable_fragmentation
+ */
+typedef struct
+{
+    size_t free_bytes;            ///< Total bytes held by removed key/value pairs
+    uint32_t free_blocks;         ///< Number of removed key/value pairs available for re-use
+    size_t largest_free_block;    ///< Size in bytes of the largest removed key/value pair
+} hashtable_fragmentation_t;
+
+
+/**
+ * @brief Runtime statistics for a table, see #hashtable_get_stats. The average number of
+ *        probes per lookup is lookup_probes / lookups, and the average list length (for
+ *        #HASHTABLE_ENGINE_CHAINING) is entry_count / buckets_used.
+ */
+typedef struct
+{
+    uint64_t lookups;             ///< Key searches made, 0 unless #HASHTABLE_ENABLE_STATS is defined
+    uint64_t lookup_probes;       ///< Key/value pairs visited (chaining) or control byte groups
+                                  ///  probed (open addressing) by those key searches
+    uint64_t freelist_searches;   ///< Searches of the free lists for space for a new pair,
+                                  ///  0 unless #HASHTABLE_ENABLE_STATS is defined
+    uint64_t freelist_search_steps; ///< Freed pairs looked at by those free list searches
+    uint32_t entry_count;         ///< Number of stored key/value pairs
+    uint32_t bucket_count;        ///< Number of table array slots (or open addressing slots)
+    uint32_t buckets_used;        ///< Number of table array slots holding at least one key/value
+                                  ///  pair (or open addressing slots holding a pair)
+    uint32_t max_chain_length;    ///< Most key/value pairs in one list (chaining), or most control
+                                  ///  byte groups probed to find a stored pair (open addressing)
+    uint32_t freelist_length;     ///< Number of removed key/value pairs in the free lists
+    size_t wasted_bytes;          ///< Bytes in the used part of the data section that are not
+                                  ///  held by a stored key/value pair
+} hashtable_stats_t;
+
+
+/**
+ * @brief Number of bins in the chain length histogram reported by #hashtable_analyze
+ */
+#define HASHTABLE_ANALYSIS_HISTOGRAM_BINS (16u)
+
+
+/**
+ * @brief Chain length histogram and hash distribution score for a table, see #hashtable_analyze.
+ *        For a hash function that spreads keys uniformly at random, chi_squared is close to
+ *        chi_squared_expected, within a few multiples of the square root of
+ *        (2 * chi_squared_expected). A much larger value means keys are not spread evenly
+ *        over the table array, either because of the hash function or because of the
+ *        array count (e.g. hash values that share a common factor with the array count).
+ */
+typedef struct
+{
+    uint32_t histogram[HASHTABLE_ANALYSIS_HISTOGRAM_BINS]; ///< For #HASHTABLE_ENGINE_CHAINING,
+                                  ///  histogram[i] is the number of table array slots holding i
+                                  ///  key/value pairs. For #HASHTABLE_ENGINE_OPEN_ADDRESSING,
+                                  ///  histogram[i] is the number of key/value pairs stored i
+                                  ///  control byte groups past the first group probed for them.
+                                  ///  The last bin also counts everything larger.
+    uint32_t entry_count;         ///< Number of stored key/value pairs
+    uint32_t bucket_count;        ///< Number of buckets the distribution score is computed over;
+                                  ///  table array slots (chaining), or groups of
+                                  ///  #HASHTABLE_SLOT_GROUP_SIZE slots (open addressing)
+    uint64_t chi_squared;         ///< Pearson's chi-squared statistic for the number of key/value
+                                  ///  pairs in each bucket, against an even spread of entry_count
+                                  ///  over bucket_count buckets (rounded down)
+    uint32_t chi_squared_expected; ///< Expected chi_squared value for a uniform hash function,
+                                  ///  which is the number of degrees of freedom, bucket_count - 1
+    uint32_t recommended_array_count; ///< Array count to pass to #hashtable_resize (or to use in
+                                  ///  #hashtable_config_t) for the current number of entries;
+                                  ///  one table array slot per entry (chaining), or slots for a
+                                  ///  7/8 load (open addressing), and never lower than
+                                  ///  #HASHTABLE_MIN_ARRAY_COUNT
+} hashtable_analysis_t;
+
+
+/**
+ * Function used by #hashtable_save to write table snapshot data
+ *
+ * @param ctx    Context pointer passed to #hashtable_save
+ * @param data   Pointer to data to write
+ * @param size   Number of bytes to write
+ *
+ * @return  0 if all data was written, any other value if an error occurred
+ */
+typedef int (*hashtable_write_func_t)(void *ctx, const void *data, size_t size);
+
+
+/**
+ * Function used by #hashtable_load to read table snapshot data
+ *
+ * @param ctx    Context pointer passed to #hashtable_load
+ * @param data   Pointer to location to store data that was read
+ * @param size   Number of bytes to read
+ *
+ * @return  0 if exactly 'size' bytes were read, any other value if an error occurred
+ */
+typedef int (*hashtable_read_func_t)(void *ctx, void *data, size_t size);
+
+
+/**
+ * Function called by #hashtable_for_each_range for each key/value pair
+ *
+ * @param ctx         Context pointer passed to #hashtable_for_each_range
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data, NULL if value data size is 0
+ * @param value_size  Value data size in bytes
+ *
+ * @return  0 to continue iterating, any other value to stop
+ */
+typedef int (*hashtable_item_func_t)(void *ctx, const char *key, hashtable_size_t key_size,
+                                     const char *value, hashtable_size_t value_size);
+
+
+/**
+ * @brief Iteration cursor for #hashtable_cursor_next. Unlike the cursor used by
+ *        #hashtable_next_item, which is stored in the table, any number of these can be
+ *        used at once, each covering its own range of table array slots.
+ */
+typedef struct
+{
+    uint32_t index;               ///< Next table array slot to visit
+    uint32_t end;                 ///< Table array slot to stop at (not visited)
+    void *item;                   ///< Next key/value pair in the list at 'index', chaining only
+} hashtable_cursor_t;
+
+
+#ifndef HASHTABLE_MAX_SHARDS
+#define HASHTABLE_MAX_SHARDS (16u)
+#endif // HASHTABLE_MAX_SHARDS
+
+
+/**
+ * @brief All data for a single sharded hashtable instance, see #hashtable_sharded_create
+ */
+typedef struct
+{
+    hashtable_t shards[HASHTABLE_MAX_SHARDS];  ///< Sub-tables, one per shard
+    uint32_t shard_count;                      ///< Number of shards in use, a power of 2
+    uint32_t shard_shift;                      ///< Right shift of hash values giving the shard index
+    uint32_t cursor_shard;                     ///< Shard being iterated by #hashtable_sharded_next_item
+} hashtable_sharded_t;
+
+
+/**
+ * Size in bytes that per-thread state (lock stripes, RCU reader slots) is padded to, so
+ * that different threads do not write to the same cache line
+ */
+#define _HASHTABLE_CACHE_LINE_SIZE (64u)
+
+
+#ifdef HASHTABLE_CONCURRENT
+
+#ifndef HASHTABLE_LOCK_STRIPES
+#define HASHTABLE_LOCK_STRIPES (64u)
+#endif // HASHTABLE_LOCK_STRIPES
+
+#ifndef HASHTABLE_ALLOC_CHUNK_SIZE
+#define HASHTABLE_ALLOC_CHUNK_SIZE (4096u)
+#endif // HASHTABLE_ALLOC_CHUNK_SIZE
+
+
+/**
+ * @brief State for a single lock stripe of a concurrent hashtable (private)
+ */
+typedef struct
+{
+    uint32_t locked;              ///< Spinlock, 1 if held and 0 otherwise
+    uint8_t *chunk;               ///< Next unused byte in the stripe's allocation chunk
+    size_t chunk_remaining;       ///< Bytes remaining in the stripe's allocation chunk
+    int64_t entry_delta;          ///< Entries added (or removed, if negative) through this stripe
+} _hashtable_stripe_state_t;
+
+
+/**
+ * @brief A lock stripe of a concurrent hashtable, padded to a cache line (private)
+ */
+typedef union
+{
+    _hashtable_stripe_state_t state;
+    uint8_t padding[_HASHTABLE_CACHE_LINE_SIZE];
+} _hashtable_lock_stripe_t;
+
+
+/**
+ * @brief All data for a single concurrent hashtable instance, see #hashtable_concurrent_create
+ */
+typedef struct
+{
+    hashtable_t table;                                     ///< Hashtable protected by the locks
+    _hashtable_lock_stripe_t alloc_lock;                   ///< Lock for the free lists and unused data space
+    _hashtable_lock_stripe_t stripes[HASHTABLE_LOCK_STRIPES]; ///< Locks for table array slots
+} hashtable_concurrent_t;
+
+#endif // HASHTABLE_CONCURRENT
+
+
+#ifdef HASHTABLE_BLOOM_FILTER
+
+#ifndef HASHTABLE_BLOOM_BITS_PER_SLOT
+#define HASHTABLE_BLOOM_BITS_PER_SLOT (16u)
+#endif // HASHTABLE_BLOOM_BITS_PER_SLOT
+
+#endif // HASHTABLE_BLOOM_FILTER
+
+
+#ifdef HASHTABLE_RCU
+
+#ifndef HASHTABLE_RCU_READERS
+#define HASHTABLE_RCU_READERS (16u)
+#endif // HASHTABLE_RCU_READERS
+
+#ifndef HASHTABLE_RCU_RETIRED_MAX
+#define HASHTABLE_RCU_RETIRED_MAX (64u)
+#endif // HASHTABLE_RCU_RETIRED_MAX
+
+
+/**
+ * @brief Reader slot of an RCU hashtable, padded to a cache line (private)
+ */
+typedef union
+{
+    uint64_t epoch;               ///< Epoch at the start of the current read section, 0 if none
+    uint8_t padding[_HASHTABLE_CACHE_LINE_SIZE];
+} _hashtable_rcu_reader_t;
+
+
+/**
+ * @brief Key/value pair removed from an RCU hashtable, waiting for readers (private)
+ */
+typedef struct
+{
+    void *pair;                   ///< Pointer to removed key/value pair
+    uint64_t epoch;               ///< Epoch when the pair was removed
+} _hashtable_rcu_retired_t;
+
+
+/**
+ * @brief All data for a single RCU hashtable instance, see #hashtable_rcu_create
+ */
+typedef struct
+{
+    hashtable_t table;                                        ///< Hashtable written by the writer thread
+    uint64_t epoch;                                           ///< Current epoch, starts at 1
+    _hashtable_rcu_reader_t readers[HASHTABLE_RCU_READERS];   ///< Reader slots
+    _hashtable_rcu_retired_t retired[HASHTABLE_RCU_RETIRED_MAX]; ///< Removed pairs, oldest first
+    uint32_t retired_head;                                    ///< Index of oldest removed pair
+    uint32_t retired_count;                                   ///< Number of removed pairs not yet freed
+} hashtable_rcu_t;
+
+#endif // HASHTABLE_RCU
+
+
+/**
+ * Initialize a new hashtable instance
+ *
+ * @param table        Pointer to hashtable instance
+ * @param config       Pointer to hashtable configuration data. May be NULL.
+ *                     If NULL, a default general-purpose configuration will be used.
+ * @param buffer       Pointer to buffer to use for hashtable data. May be NULL if
+ *                     config->allocator is set, in which case a buffer of 'buffer_size'
+ *                     bytes is allocated.
+ * @param buffer_size  Size of buffer in bytes
+ *
+ * @return   0 if successful, 1 if buffer size is not large enough (or the buffer could
+ *           not be allocated), and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message if -1 is returned.
+ */
+int hashtable_create(hashtable_t *table, const hashtable_config_t *config,
+                     void *buffer, size_t buffer_size);
+
+
+/**
+ * Free all buffers that a table allocated with #hashtable_config_t::allocator. Buffers provided
+ * by the caller are not touched. The table must not be used again until it is re-created with
+ * #hashtable_create or #hashtable_attach.
+ *
+ * @param table  Pointer to hashtable instance
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_destroy(hashtable_t *table);
+
+
+/**
+ * Initialize a hashtable instance from a buffer that already holds a table, for example
+ * a buffer that was written to a file and mapped back into memory. The buffer is checked
+ * for the same build options and hash function that it was created with, and all links
+ * between key/value pairs in the buffer are checked before the table is used.
+ *
+ * Unless #HASHTABLE_OFFSET_POINTERS is defined, the buffer must be at the same address
+ * it was created at. The buffer must not hold a table that was in the middle of an
+ * incremental resize (see #hashtable_resize_incremental).
+ *
+ * @param table        Pointer to hashtable instance
+ * @param config       Pointer to hashtable configuration data. May be NULL. Only the hash
+ *                     function and allocator are used, and the hash function must be the same
+ *                     one the table was created with. If NULL, the default hash function
+ *                     will be used.
+ * @param buffer       Pointer to buffer holding table data
+ * @param buffer_size  Size of buffer in bytes
+ *
+ * @return   0 if successful, and -1 if an error occurred, or the buffer does not hold a
+ *           valid table. Use #hashtable_error_message to get an error message if -1
+ *           is returned.
+ */
+int hashtable_attach(hashtable_t *table, const hashtable_config_t *config,
+                     void *buffer, size_t buffer_size);
+
+
+/**
+ * Insert a new key/value pair into a table. If a key/value pair with the
+ * given key already exists, then it will be over-written with the new value.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data, may be NULL
+ * @param value_size  Value data size in bytes, may be 0
+ *
+ * @return   0 if successful, 1 if there is not enough space left in the buffer for
+             key/value pair data, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message if -1 is returned.
+ */
+int hashtable_insert(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                     const char *value, const hashtable_size_t value_size);
+
+
+/**
+ * Reserve space for a new key/value pair, so the value data can be written straight into
+ * the table instead of being copied in by #hashtable_insert. The key data is copied, and a
+ * pointer to 'value_size' bytes of uninitialized value data space is returned. The pair is
+ * not visible to any other function until #hashtable_commit is called, and is released
+ * again by #hashtable_abort. If a key/value pair with the given key already exists, it is
+ * replaced when the reserved pair is committed, and is unchanged if the reserved pair is
+ * aborted.
+ *
+ * Only one pair can be reserved at a time, and no other function that modifies the table
+ * may be called until the reserved pair is committed or aborted.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value_size  Value data size in bytes, may be 0
+ * @param value       Pointer to location to store pointer to value data space. NULL is
+ *                    stored if value_size is 0.
+ *
+ * @return   0 if successful, 1 if there is not enough space left in the buffer for
+ *           key/value pair data, and -1 if an error occurred (including if a pair is
+ *           already reserved). Use #hashtable_error_message to get an error message if
+ *           -1 is returned.
+ */
+int hashtable_reserve(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                      const hashtable_size_t value_size, char **value);
+
+
+/**
+ * Store the key/value pair reserved by #hashtable_reserve, replacing any stored pair with
+ * the same key
+ *
+ * @param table  Pointer to hashtable instance
+ *
+ * @return   0 if successful, and -1 if an error occurred (including if no pair is reserved).
+ *           Use #hashtable_error_message to get an error message.
+ */
+int hashtable_commit(hashtable_t *table);
+
+
+/**
+ * Release the key/value pair reserved by #hashtable_reserve without storing it
+ *
+ * @param table  Pointer to hashtable instance
+ *
+ * @return   0 if successful, and -1 if an error occurred (including if no pair is reserved).
+ *           Use #hashtable_error_message to get an error message.
+ */
+int hashtable_abort(hashtable_t *table);
+
+
+/**
+ * Remove a stored value from a table by key. If the given key does not exist in
+ * the table, then the return value will indicate success.
+ *
+ * @param table     Pointer to hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_remove(hashtable_t *table, const char *key, const hashtable_size_t key_size);
+
+
+/**
+ * Retrieve a pointer to a value stored in a table by key.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to location to store value pointer, may be NULL
+ * @param value_size  Pointer to location to store value size, may be NULL
+ *
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_retrieve(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                       char **value, hashtable_size_t *value_size);
+
+
+/**
+ * Check if a key exists in a table.
+ *
+ * @param table     Pointer to hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   1 if key exists, 0 if key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message.
+ */
+int hashtable_has_key(hashtable_t *table, const char *key, const hashtable_size_t key_size);
+
+
+/**
+ * Retrieve the value stored for a key, or store a new key/value pair if the key does not
+ * exist. Unlike a call to #hashtable_retrieve followed by a call to #hashtable_insert, the
+ * table is only searched once. A value stored for the key is never over-written.
+ *
+ * @param table              Pointer to hashtable instance
+ * @param key                Pointer to key data
+ * @param key_size           Key data size in bytes
+ * @param value              Pointer to value data to store if the key does not exist, may be NULL
+ * @param value_size         Value data size in bytes, may be 0
+ * @param stored_value       Pointer to location to store pointer to the stored value (either the
+ *                           existing value, or the new value), may be NULL
+ * @param stored_value_size  Pointer to location to store the stored value size, may be NULL
+ *
+ * @return   0 if a new key/value pair was stored, 1 if the key does not exist and there
+ *           is not enough space left in the buffer for key/value pair data, 2 if the key
+ *           already exists, and -1 if an error occurred. Use #hashtable_error_message to
+ *           get an error message if -1 is returned.
+ */
+int hashtable_get_or_insert(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                            const char *value, const hashtable_size_t value_size,
+                            char **stored_value, hashtable_size_t *stored_value_size);
+
+
+/**
+ * Compute the hash value that a table uses for a key, with the table's configured hash
+ * function (and seed, if #hashtable_config_t::seeded_hash is set). The hash value can be
+ * passed to the _hashed variants of table functions, such as #hashtable_insert_hashed,
+ * to avoid computing it again for every call with the same key.
+ *
+ * @param table     Pointer to hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   Hash value for key data. 0 is returned if an error occurred, use
+ *           #hashtable_error_message to get an error message.
+ */
+uint32_t hashtable_hash(hashtable_t *table, const char *key, const hashtable_size_t key_size);
+
+
+/**
+ * Same as #hashtable_insert, with an already computed hash value for the key data.
+ *
+ * The hash value must be the value that the table's configured hash function computes for
+ * the key data (see #hashtable_hash), since stored pairs are found again by it, and it may
+ * be computed again from the stored key data when the table is resized. The same hash
+ * function can be called outside of the table, e.g. when the hash value is also needed
+ * for another purpose.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param hash        Hash value computed for key data
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data, may be NULL
+ * @param value_size  Value data size in bytes, may be 0
+ *
+ * @return   0 if successful, 1 if there is not enough space left in the buffer for
+ *           key/value pair data, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message if -1 is returned.
+ */
+int hashtable_insert_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size,
+                            const char *value, const hashtable_size_t value_size);
+
+
+/**
+ * Same as #hashtable_remove, with an already computed hash value for the key data
+ * (see #hashtable_insert_hashed).
+ *
+ * @param table     Pointer to hashtable instance
+ * @param hash      Hash value computed for key data
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_remove_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size);
+
+
+/**
+ * Same as #hashtable_retrieve, with an already computed hash value for the key data
+ * (see #hashtable_insert_hashed).
+ *
+ * @param table       Pointer to hashtable instance
+ * @param hash        Hash value computed for key data
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to location to store value pointer, may be NULL
+ * @param value_size  Pointer to location to store value size, may be NULL
+ *
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_retrieve_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size,
+                              char **value, hashtable_size_t *value_size);
+
+
+/**
+ * Same as #hashtable_has_key, with an already computed hash value for the key data
+ * (see #hashtable_insert_hashed).
+ *
+ * @param table     Pointer to hashtable instance
+ * @param hash      Hash value computed for key data
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   1 if key exists, 0 if key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message.
+ */
+int hashtable_has_key_hashed(hashtable_t *table, uint32_t hash, const char *key, const hashtable_size_t key_size);
+
+
+/**
+ * Same as #hashtable_get_or_insert, with an already computed hash value for the key data
+ * (see #hashtable_insert_hashed).
+ *
+ * @param table              Pointer to hashtable instance
+ * @param hash               Hash value computed for key data
+ * @param key                Pointer to key data
+ * @param key_size           Key data size in bytes
+ * @param value              Pointer to value data to store if the key does not exist, may be NULL
+ * @param value_size         Value data size in bytes, may be 0
+ * @param stored_value       Pointer to location to store pointer to the stored value, may be NULL
+ * @param stored_value_size  Pointer to location to store the stored value size, may be NULL
+ *
+ * @return   0 if a new key/value pair was stored, 1 if the key does not exist and there
+ *           is not enough space left in the buffer for key/value pair data, 2 if the key
+ *           already exists, and -1 if an error occurred. Use #hashtable_error_message to
+ *           get an error message if -1 is returned.
+ */
+int hashtable_get_or_insert_hashed(hashtable_t *table, uint32_t hash, const char *key,
+                                   const hashtable_size_t key_size, const char *value,
+                                   const hashtable_size_t value_size, char **stored_value,
+                                   hashtable_size_t *stored_value_size);
+
+
+#ifdef HASHTABLE_BLOOM_FILTER
+/**
+ * Check if a key might exist in a table, using only the table's bloom filter (see
+ * #HASHTABLE_BLOOM_FILTER). #hashtable_has_key and the other functions that search for
+ * keys already check the filter first; this function shows how often the filter alone
+ * is enough to rule out a key.
+ *
+ * @param table     Pointer to hashtable instance, must use #HASHTABLE_ENGINE_CHAINING
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   1 if the key might exist, 0 if the key does not exist, and -1 if an error
+ *           occurred. Use #hashtable_error_message to get an error message.
+ */
+int hashtable_bloom_check(hashtable_t *table, const char *key, const hashtable_size_t key_size);
+#endif // HASHTABLE_BLOOM_FILTER
+
+
+/**
+ * Retrieve pointers to the values stored for several keys at once. Works the same way as
+ * calling #hashtable_retrieve for each key, but all keys in a group are hashed first,
+ * and the table memory that will be searched for each key is prefetched before any key
+ * is searched for, so that cache misses for different keys overlap.
+ *
+ * @param table        Pointer to hashtable instance
+ * @param keys         Array of pointers to key data
+ * @param key_sizes    Array of key data sizes in bytes
+ * @param count        Number of keys
+ * @param values       Array of locations to store value pointers, may be NULL
+ * @param value_sizes  Array of locations to store value sizes, may be NULL
+ * @param results      Array of locations to store the result for each key: 0 if the key
+ *                     exists, and 1 if the key does not exist
+ *
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message if -1 is returned.
+ */
+int hashtable_retrieve_batch(hashtable_t *table, const char *const keys[], const hashtable_size_t key_sizes[],
+                             size_t count, char *values[], hashtable_size_t value_sizes[], int results[]);
+
+
+/**
+ * Check if several keys exist in a table at once. Works the same way as calling
+ * #hashtable_has_key for each key, with the same prefetching as #hashtable_retrieve_batch.
+ *
+ * @param table        Pointer to hashtable instance
+ * @param keys         Array of pointers to key data
+ * @param key_sizes    Array of key data sizes in bytes
+ * @param count        Number of keys
+ * @param results      Array of locations to store the result for each key: 1 if the key
+ *                     exists, and 0 if the key does not exist
+ *
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message if -1 is returned.
+ */
+int hashtable_has_key_batch(hashtable_t *table, const char *const keys[], const hashtable_size_t key_sizes[],
+                            size_t count, int results[]);
+
+
+/**
+ * Insert several key/value pairs at once. Works the same way as calling #hashtable_insert
+ * for each key/value pair, in order, with the same prefetching as #hashtable_retrieve_batch.
+ *
+ * @param table        Pointer to hashtable instance
+ * @param keys         Array of pointers to key data
+ * @param key_sizes    Array of key data sizes in bytes
+ * @param values       Array of pointers to value data. May be NULL, if all values are empty.
+ * @param value_sizes  Array of value data sizes in bytes. May be NULL, if all values are empty.
+ * @param count        Number of key/value pairs
+ * @param results      Array of locations to store the result for each key/value pair: 0
+ *                     if the pair was inserted, and 1 if there was not enough space left
+ *                     in the buffer
+ *
+ * @return   0 if all key/value pairs were inserted, 1 if there was not enough space left
+ *           for one or more key/value pairs, and -1 if an error occurred. Use
+ *           #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_insert_batch(hashtable_t *table, const char *const keys[], const hashtable_size_t key_sizes[],
+                           const char *const values[], const hashtable_size_t value_sizes[],
+                           size_t count, int results[]);
+
+
+/**
+ * Store many key/value pairs at once, e.g. when building a table from scratch. The result is
+ * the same as calling #hashtable_insert for each key/value pair, in order (if a key appears
+ * more than once, the last value given for it is stored), but the pairs are first sorted by
+ * table array slot (or by first probed group, for #HASHTABLE_ENGINE_OPEN_ADDRESSING), and
+ * stored in that order. The pairs for each table array slot are laid out one after the
+ * other in the buffer, so later searches read fewer cache lines, and the search for an
+ * existing pair with the same key made for each new pair only reads recently written data.
+ *
+ * The sort uses ((2 * count) + array count + 1) * 4 bytes of unused space at the end of the
+ * table buffer, after the space needed for the new pairs. If there is not that much space
+ * left, the pairs are stored in the order given instead. If the table has an allocator
+ * (see #hashtable_config_t::allocator), it is moved into a larger buffer first if needed.
+ *
+ * @param table        Pointer to hashtable instance
+ * @param keys         Array of pointers to key data
+ * @param key_sizes    Array of key data sizes in bytes
+ * @param values       Array of pointers to value data. May be NULL, if all values are empty.
+ * @param value_sizes  Array of value data sizes in bytes. May be NULL, if all values are empty.
+ * @param hashes       Array of hash values already computed for key data (see
+ *                     #hashtable_insert_hashed), e.g. by several threads at once. May be
+ *                     NULL, in which case hash values are computed for all keys first.
+ * @param count        Number of key/value pairs
+ *
+ * @return   0 if all key/value pairs were stored, 1 if there is not enough space left in
+ *           the buffer for all key/value pairs (in which case none of them are stored), and
+ *           -1 if an error occurred. Use #hashtable_error_message to get an error message
+ *           if -1 is returned.
+ */
+int hashtable_bulk_load(hashtable_t *table, const char *const keys[], const hashtable_size_t key_sizes[],
+                        const char *const values[], const hashtable_size_t value_sizes[],
+                        const uint32_t hashes[], size_t count);
+
+
+/**
+ * Number of bytes remaining for key/value pair data storage
+ *
+ * @param table            Pointer to hashtable instance
+ * @param bytes_remaining  Pointer to location to store number of bytes remaining
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_bytes_remaining(hashtable_t *table, size_t *bytes_remaining);
+
+
+/**
+ * Retrieve pointers to the next key/value pair in the table. This function can
+ * be used to iterate over all key/value pairs stored in the table.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param key         Pointer to location to store key pointer
+ * @param key_size    Pointer to location to store key data size in bytes
+ * @param value       Pointer to location to store value pointer, may be NULL
+ * @param value_size  Pointer to location to store value data size in bytes, may be NULL
+ *
+ * @return   0 if next item was read successfully, 1 if no item was read because
+ *           all items in the table have been iterated over (in this case you can
+             use hashtable_reset_cursor to reset for another iteration if you need to),
+             and -1 if an error occurred. Use #hashtable_error_message to get an error
+             message.
+ */
+int hashtable_next_item(hashtable_t *table, char **key, hashtable_size_t *key_size,
+                        char **value, hashtable_size_t *value_size);
+
+
+/**
+ * Reset the key/value pair cursor, which is used for iteration via #hashtable_next_item.
+ * This allows iterating through a table again after #hashtable_next_item has already iterated
+ * over the whole table and returned a value of 1.
+ *
+ * @param table   Pointer to hashtable instance
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_reset_cursor(hashtable_t *table);
+
+
+/**
+ * Initialize a cursor for iterating over the key/value pairs stored in a range of table
+ * array slots (or open addressing slots) with #hashtable_cursor_next. Slots with no key/value
+ * pairs are skipped using the table's occupancy bitmap (or open addressing control bytes), so
+ * iterating over a sparse table does not cost one step for every slot. Cursors covering
+ * disjoint ranges visit disjoint sets of key/value pairs, and can be used from several
+ * threads at once, as long as the table is not modified while any of them are in use.
+ *
+ * If an incremental resize (see #hashtable_resize_incremental) is in progress, it will be
+ * completed before this function returns.
+ *
+ * @param table   Pointer to hashtable instance
+ * @param cursor  Pointer to cursor to initialize
+ * @param begin   First table array slot to visit
+ * @param end     Table array slot to stop at (not visited). Values larger than
+ *                table->config.array_count are treated as table->config.array_count,
+ *                so UINT32_MAX covers the rest of the table.
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_cursor_init(hashtable_t *table, hashtable_cursor_t *cursor, uint32_t begin, uint32_t end);
+
+
+/**
+ * Retrieve pointers to the next key/value pair in the range covered by a cursor, see
+ * #hashtable_cursor_init. The cursor is no longer valid if the table is modified.
+ *
+ * @param table       Pointer to hashtable instance
+ * @param cursor      Pointer to cursor
+ * @param key         Pointer to location to store key pointer
+ * @param key_size    Pointer to location to store key data size in bytes, may be NULL
+ * @param value       Pointer to location to store value pointer, may be NULL
+ * @param value_size  Pointer to location to store value data size in bytes, may be NULL
+ *
+ * @return   0 if next item was read successfully, 1 if no item was read because all
+ *           items in the cursor's range have been iterated over, and -1 if an error
+ *           occurred. Use #hashtable_error_message to get an error message.
+ */
+int hashtable_cursor_next(hashtable_t *table, hashtable_cursor_t *cursor, char **key, hashtable_size_t *key_size,
+                          char **value, hashtable_size_t *value_size);
+
+
+/**
+ * Call a function for each key/value pair stored in a range of table array slots (or open
+ * addressing slots), see #hashtable_cursor_init. Calls covering disjoint ranges can be made
+ * from several threads at once, as long as the table is not modified and no incremental
+ * resize is in progress, e.g. each of N threads can cover 1/Nth of table->config.array_count.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param begin  First table array slot to visit
+ * @param end    Table array slot to stop at (not visited), see #hashtable_cursor_init
+ * @param func   Function to call for each key/value pair
+ * @param ctx    Context pointer to pass to func, may be NULL
+ *
+ * @return   0 if func was called for all key/value pairs in the range, 1 if func returned
+ *           a non-zero value to stop iterating, and -1 if an error occurred. Use
+ *           #hashtable_error_message to get an error message.
+ */
+int hashtable_for_each_range(hashtable_t *table, uint32_t begin, uint32_t end,
+                             hashtable_item_func_t func, void *ctx);
+
+
+/**
+ * Call a function for each key/value pair stored in a table, in the order that the pairs are
+ * stored in the buffer. This is one sequential pass over the key/value data, without following
+ * any links between pairs, so it is usually faster than #hashtable_next_item or
+ * #hashtable_for_each_range for visiting every pair in a large table.
+ *
+ * Key/value pairs are visited in the order they were inserted, except that a pair stored in
+ * space freed by a removed pair is visited at that position instead (#hashtable_compact does
+ * not change the order). func may remove the key/value pair it was called for, e.g. to evict
+ * the oldest pairs, but must not modify the table in any other way.
+ *
+ * If an incremental resize (see #hashtable_resize_incremental) is in progress, it will be
+ * completed first. With #HASHTABLE_RCU, pairs removed by #hashtable_rcu_remove are still
+ * visited until they are freed (see #hashtable_rcu_synchronize).
+ *
+ * @param table  Pointer to hashtable instance
+ * @param func   Function to call for each key/value pair
+ * @param ctx    Context pointer to pass to func, may be NULL
+ *
+ * @return   0 if func was called for all key/value pairs, 1 if func returned a non-zero
+ *           value to stop iterating, and -1 if an error occurred. Use
+ *           #hashtable_error_message to get an error message.
+ */
+int hashtable_scan_arena(hashtable_t *table, hashtable_item_func_t func, void *ctx);
+
+
+/**
+ * Clear all stored data from a hashtable instance.
+ *
+ * For #HASHTABLE_ENGINE_CHAINING, only the occupancy bitmap (one bit per table array slot)
+ * and the bloom filter are zeroed, and the table array itself is not written to. A table
+ * array slot with its occupancy bit clear is treated as empty, and is zeroed the first time a
+ * key that maps to it is accessed. The remaining slots are zeroed
+ * `HASHTABLE_CLEAR_LISTS_PER_OP` at a time by each later #hashtable_insert, #hashtable_remove,
+ * #hashtable_retrieve and #hashtable_has_key call, or by #hashtable_clear_step. Functions that
+ * walk the whole table array (#hashtable_get_stats, #hashtable_analyze, resizes,
+ * #hashtable_attach, and compactions with `HASHTABLE_BLOOM_FILTER`) zero all remaining slots first.
+ * For #HASHTABLE_ENGINE_OPEN_ADDRESSING, only the control bytes (one byte per slot) are written.
+ *
+ * @param table  Pointer to hashtable instance
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_clear(hashtable_t *table);
+
+
+/**
+ * Zero more of the table array slots left by #hashtable_clear, so the work can be done
+ * at a convenient time rather than by later table functions. Does nothing if all slots
+ * have been zeroed.
+ *
+ * @param table      Pointer to hashtable instance
+ * @param max_lists  Maximum number of table array slots to zero. Pass 0 to just check
+ *                   whether any slots are left.
+ *
+ * @return   0 if all slots have been zeroed, 1 if some slots are still left, and -1 if an
+ *           error occurred. Use #hashtable_error_message to get an error message if -1
+ *           is returned.
+ */
+int hashtable_clear_step(hashtable_t *table, uint32_t max_lists);
+
+
+/**
+ * Move all stored key/value pairs into a new buffer, with a new table array count.
+ * All stored pairs are migrated before this function returns. Once this function
+ * returns successfully, the hashtable no longer uses the old buffer, and it may be re-used
+ * or freed by the caller (or is freed by the table, if it was allocated by the table). Any key/value pointers obtained from the table before the resize are
+ * invalid after the resize.
+ *
+ * If an incremental resize (see #hashtable_resize_incremental) is already in progress,
+ * it will be completed before the new resize is started.
+ *
+ * @param table        Pointer to hashtable instance
+ * @param buffer       Pointer to new buffer to use for hashtable data. Must not overlap with
+ *                     the buffer currently in use. May be NULL if the table has an allocator
+ *                     (see #hashtable_config_t::allocator), in which case a buffer of
+ *                     'buffer_size' bytes is allocated.
+ * @param buffer_size  Size of new buffer in bytes
+ * @param array_count  Number of table array slots to use in the new buffer. If 0, an array
+ *                     count will be chosen in the same way as #hashtable_default_config.
+ *
+ * @return   0 if successful, 1 if the new buffer is not large enough to hold all stored
+ *           key/value pairs (in this case the table is unchanged), and -1 if an error
+ *           occurred. Use #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_resize(hashtable_t *table, void *buffer, size_t buffer_size, uint32_t array_count);
+
+
+/**
+ * Start moving all stored key/value pairs into a new buffer, with a new table array count.
+ * Unlike #hashtable_resize, pairs are migrated a few table array slots at a time; every
+ * call to #hashtable_insert, #hashtable_remove, #hashtable_retrieve or #hashtable_has_key
+ * migrates the slot for the given key, plus `HASHTABLE_RESIZE_LISTS_PER_OP` more slots.
+ * #hashtable_resize_step can be used to migrate more slots, e.g. from an idle loop, and to check
+ * whether the resize is complete. The table can be used normally while the resize is in progress.
+ *
+ * The old buffer must not be modified or freed until the resize is complete (if it was
+ * allocated by the table, it is freed when the resize is complete). Any key/value
+ * pointers obtained from the table before the resize started are invalid once the resize has
+ * started. #hashtable_next_item, #hashtable_reset_cursor and #hashtable_resize will complete
+ * the resize before doing anything else, and #hashtable_clear abandons the resize.
+ *
+ * Since the exact amount of space needed for all stored pairs is not known until they are
+ * migrated, the new buffer must have enough key/value pair data space to hold all space used in
+ * the old buffer (including freed pairs), and that much space is held back from new insertions
+ * until the resize is complete.
+ *
+ * @param table        Pointer to hashtable instance
+ * @param buffer       Pointer to new buffer to use for hashtable data. Must not overlap with
+ *                     the buffer currently in use. May be NULL if the table has an allocator
+ *                     (see #hashtable_config_t::allocator), in which case a buffer of
+ *                     'buffer_size' bytes is allocated.
+ * @param buffer_size  Size of new buffer in bytes
+ * @param array_count  Number of table array slots to use in the new buffer. If 0, an array
+ *                     count will be chosen in the same way as #hashtable_default_config.
+ *
+ * @return   0 if successful, 1 if the new buffer is not large enough (in this case the table
+ *           is unchanged), and -1 if an error occurred. Use #hashtable_error_message to get an
+ *           error message if -1 is returned.
+ */
+int hashtable_resize_incremental(hashtable_t *table, void *buffer, size_t buffer_size, uint32_t array_count);
+
+
+/**
+ * Migrate more table array slots for an incremental resize started by
+ * #hashtable_resize_incremental. Does nothing if no resize is in progress.
+ *
+ * @param table      Pointer to hashtable instance
+ * @param max_lists  Maximum number of table array slots to migrate. Pass 0 to just check
+ *                   whether a resize is in progress.
+ *
+ * @return   0 if no resize is in progress (the old buffer is no longer used by the table),
+ *           1 if a resize is still in progress, and -1 if an error occurred. Use
+ *           #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_resize_step(hashtable_t *table, uint32_t max_lists);
+
+
+/**
+ * Compact the data section of a table, by moving all stored key/value pairs towards the
+ * start of the data section, so that all space held by removed key/value pairs (see
+ * #hashtable_fragmentation) is returned to the unused end of the data section, and is
+ * counted by #hashtable_bytes_remaining again. If an incremental compaction (see
+ * #hashtable_compact_incremental) is already in progress, it will be completed.
+ *
+ * Pointers to key/value data previously returned by #hashtable_retrieve or
+ * #hashtable_next_item are not valid after compaction.
+ *
+ * @param table  Pointer to hashtable instance
+ *
+ * @return   0 if successful, and -1 if an error occurred (including if an incremental resize
+ *           is in progress). Use #hashtable_error_message to get an error message.
+ */
+int hashtable_compact(hashtable_t *table);
+
+
+/**
+ * Start compacting the data section of a table incrementally. Unlike #hashtable_compact,
+ * no key/value pairs are moved until #hashtable_compact_step is called, which can be done
+ * e.g. from an idle loop, and the table can be used as normal in between calls. Space
+ * held by removed key/value pairs is not re-used until the compaction is complete.
+ * Does nothing if an incremental compaction is already in progress.
+ *
+ * Pointers to key/value data previously returned by #hashtable_retrieve or
+ * #hashtable_next_item are not valid after any call to #hashtable_compact_step.
+ *
+ * @param table  Pointer to hashtable instance
+ *
+ * @return   0 if successful, and -1 if an error occurred (including if an incremental resize
+ *           is in progress). Use #hashtable_error_message to get an error message.
+ */
+int hashtable_compact_incremental(hashtable_t *table);
+
+
+/**
+ * Continue an incremental compaction started by #hashtable_compact_incremental.
+ * Does nothing if no compaction is in progress.
+ *
+ * @param table      Pointer to hashtable instance
+ * @param max_bytes  Maximum number of data section bytes to visit. At least one key/value
+ *                   pair is visited, unless this is 0. Pass 0 to just check whether a
+ *                   compaction is in progress.
+ *
+ * @return   0 if no compaction is in progress (the compaction is complete), 1 if a
+ *           compaction is still in progress, and -1 if an error occurred. Use
+ *           #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_compact_step(hashtable_t *table, size_t max_bytes);
+
+
+/**
+ * Write a snapshot of all key/value pairs stored in a table. Only stored key/value pairs
+ * are written (space held by removed pairs is not), followed by a checksum. The snapshot
+ * format does not depend on build options, buffer sizes, array counts or the engine, so a
+ * snapshot can be loaded into any table with #hashtable_load.
+ *
+ * The write function is called once or more for each key/value pair, mostly with small
+ * sizes, so a buffered stream (for example, a stdio FILE) is recommended.
+ *
+ * This function uses the same iteration cursor as #hashtable_next_item, but the cursor
+ * position is restored before returning.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param write  Function to call to write snapshot data
+ * @param ctx    Context pointer to pass to the write function
+ *
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message if -1 is returned.
+ */
+int hashtable_save(hashtable_t *table, hashtable_write_func_t write, void *ctx);
+
+
+/**
+ * Replace the contents of a table with all key/value pairs from a snapshot written by
+ * #hashtable_save. The table is cleared first (see #hashtable_clear), and key/value pairs
+ * are added without checking for existing pairs with the same key. If anything other than
+ * 0 is returned, the table is left empty.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param read   Function to call to read snapshot data
+ * @param ctx    Context pointer to pass to the read function
+ *
+ * @return   0 if successful, 1 if there is not enough space in the table buffer for all
+ *           key/value pairs in the snapshot, and -1 if an error occurred, or the snapshot
+ *           is not valid. Use #hashtable_error_message to get an error message if -1 is
+ *           returned.
+ */
+int hashtable_load(hashtable_t *table, hashtable_read_func_t read, void *ctx);
+
+
+/**
+ * Populate a configuration structure with the default hash function (FNV-1a, unless
+ * #HASHTABLE_DEFAULT_HASH is defined), no seeded hash function, and an array count
+ * optimized for the given buffer size.
+ *
+ * @param config       Pointer to configuration data structure to populate
+ * @param buffer_size  Buffer size to generate configuration for
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_default_config(hashtable_config_t *config, size_t buffer_size);
+
+
+/**
+ * FNV-1a hash function. Processes one byte at a time, and is the default hash function
+ * (unless #HASHTABLE_DEFAULT_HASH is defined).
+ *
+ * @param data   Pointer to key data
+ * @param size   Key data size in bytes
+ *
+ * @return  Computed hash value
+ */
+uint32_t hashtable_hash_fnv1a(const char *data, const hashtable_size_t size);
+
+
+/**
+ * Hash function based on wyhash, which processes 8 or 16 bytes at a time, and produces
+ * well distributed hash values for keys of any length. Much faster than FNV-1a for keys
+ * longer than a few bytes.
+ *
+ * @param data   Pointer to key data
+ * @param size   Key data size in bytes
+ *
+ * @return  Computed hash value
+ */
+uint32_t hashtable_hash_wyhash(const char *data, const hashtable_size_t size);
+
+
+/**
+ * Seeded version of #hashtable_hash_wyhash, for use as #hashtable_config_t::seeded_hash.
+ * Recommended for tables holding keys supplied by untrusted sources.
+ *
+ * @param data   Pointer to key data
+ * @param size   Key data size in bytes
+ * @param seed   Seed value
+ *
+ * @return  Computed hash value
+ */
+uint32_t hashtable_hash_wyhash_seeded(const char *data, const hashtable_size_t size, uint64_t seed);
+
+
+/**
+ * CRC-32C (Castagnoli) hash function. Uses the SSE4.2 CRC32 instruction, or the ARMv8 CRC32
+ * extension, if enabled for the compiler (e.g. `-msse4.2` or `-march=armv8-a+crc`) and
+ * #HASHTABLE_DISABLE_SIMD is not defined, processing 8 bytes per instruction. Otherwise, a
+ * portable implementation is used, which is much slower. The upper bits of the result are
+ * mixed, so that they are as well distributed as the lower bits.
+ *
+ * @param data   Pointer to key data
+ * @param size   Key data size in bytes
+ *
+ * @return  Computed hash value
+ */
+uint32_t hashtable_hash_crc32c(const char *data, const hashtable_size_t size);
+
+
+/**
+ * Seeded version of #hashtable_hash_crc32c, for use as #hashtable_config_t::seeded_hash.
+ * CRC values are easy to collide on purpose even with an unknown seed, so prefer
+ * #hashtable_hash_wyhash_seeded for keys supplied by untrusted sources.
+ *
+ * @param data   Pointer to key data
+ * @param size   Key data size in bytes
+ * @param seed   Seed value
+ *
+ * @return  Computed hash value
+ */
+uint32_t hashtable_hash_crc32c_seeded(const char *data, const hashtable_size_t size, uint64_t seed);
+
+
+/**
+ * Get information about the space held by removed key/value pairs, which is kept for
+ * re-use by new key/value pairs (and is not counted by #hashtable_bytes_remaining).
+ *
+ * @param table  Pointer to hashtable instance
+ * @param info   Pointer to location to store fragmentation information
+ *
+ * @return 0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_fragmentation(hashtable_t *table, hashtable_fragmentation_t *info);
+
+
+/**
+ * Get runtime statistics for a table. All stored key/value pairs are visited, so this takes
+ * time in proportion to the size of the table. If an incremental resize is in progress, only
+ * the buffer being migrated to is covered.
+ *
+ * @param table  Pointer to hashtable instance
+ * @param stats  Pointer to location to store statistics
+ *
+ * @return 0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_get_stats(hashtable_t *table, hashtable_stats_t *stats);
+
+
+/**
+ * Analyze how the stored key/value pairs are spread over the table array, to judge the
+ * quality of the configured hash function and array count. All stored key/value pairs are
+ * visited, so this takes time in proportion to the size of the table. If an incremental
+ * resize is in progress, it will be completed first.
+ *
+ * @param table     Pointer to hashtable instance
+ * @param analysis  Pointer to location to store analysis results
+ *
+ * @return 0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_analyze(hashtable_t *table, hashtable_analysis_t *analysis);
+
+
+/**
+ * Return a pointer to the last stored error message. When any hashtable function
+ * returns -1 to indicate an error, you can call this function to get a pointer to
+ * the corresponding error message string. If no error has occurred then this
+ * function will return a pointer to an empty string.
+ *
+ * The last error is stored separately for each thread (see #HASHTABLE_THREAD_LOCAL),
+ * and the returned string must not be modified.
+ *
+ * @return  Pointer to error message string
+ */
+char *hashtable_error_message(void);
+
+
+/**
+ * Return the kind of the last error. When any hashtable function returns -1 to indicate
+ * an error, you can call this function to get the corresponding error code. The last
+ * error is stored separately for each thread, like the error message.
+ *
+ * @return  Last error code, or #HASHTABLE_ERROR_NONE if no error has occurred
+ */
+hashtable_error_t hashtable_last_error(void);
+
+
+/**
+ * Initialize a new sharded hashtable instance. A sharded table is made up of a number of
+ * independent hashtable instances (shards), each with its own buffer. Each key belongs to
+ * exactly one shard, selected by the upper bits of the hash of the key data, so writes to
+ * keys in different shards never touch the same memory, and one shard running out of
+ * space has no effect on the other shards.
+ *
+ * The buffer for each shard is provided separately, so that (for example) each shard can
+ * use memory local to the CPU or NUMA node of the thread that mostly uses it.
+ *
+ * @param table         Pointer to sharded hashtable instance
+ * @param config        Pointer to hashtable configuration data, used for all shards. May be
+ *                      NULL. If NULL, a default general-purpose configuration will be used
+ *                      for each shard, chosen according to the size of the shard's buffer.
+ * @param shard_count   Number of shards, must be a power of 2 no larger than
+ *                      #HASHTABLE_MAX_SHARDS
+ * @param buffers       Array of 'shard_count' pointers to buffers to use for shard data
+ * @param buffer_sizes  Array of 'shard_count' buffer sizes in bytes
+ *
+ * @return   0 if successful, 1 if any buffer size is not large enough, and -1 if an
+ *           error occurred. Use #hashtable_error_message to get an error message if -1
+ *           is returned.
+ */
+int hashtable_sharded_create(hashtable_sharded_t *table, const hashtable_config_t *config,
+                             uint32_t shard_count, void *const buffers[], const size_t buffer_sizes[]);
+
+
+/**
+ * Get the shard that a key belongs to. All hashtable functions can be used directly on the
+ * returned shard, for example to take a per-shard lock, and then insert into or iterate
+ * over just that shard.
+ *
+ * @param table     Pointer to sharded hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   Pointer to hashtable instance for the shard, or NULL if an error occurred.
+ *           Use #hashtable_error_message to get an error message if NULL is returned.
+ */
+hashtable_t *hashtable_sharded_shard(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size);
+
+
+/**
+ * Insert a new key/value pair into the shard for the key, see #hashtable_insert
+ *
+ * @param table       Pointer to sharded hashtable instance
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data, may be NULL
+ * @param value_size  Value data size in bytes, may be 0
+ *
+ * @return   0 if successful, 1 if there is not enough space left in the shard's buffer for
+ *           key/value pair data, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message if -1 is returned.
+ */
+int hashtable_sharded_insert(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size,
+                             const char *value, const hashtable_size_t value_size);
+
+
+/**
+ * Remove a stored key/value pair from the shard for the key, see #hashtable_remove
+ *
+ * @param table     Pointer to sharded hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_sharded_remove(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size);
+
+
+/**
+ * Retrieve a value from the shard for the key, see #hashtable_retrieve
+ *
+ * @param table       Pointer to sharded hashtable instance
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to location to store value pointer
+ * @param value_size  Pointer to location to store value size. May be NULL.
+ *
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_sharded_retrieve(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size,
+                               char **value, hashtable_size_t *value_size);
+
+
+/**
+ * Check if a key exists in the shard for the key, see #hashtable_has_key
+ *
+ * @param table     Pointer to sharded hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   1 if the key exists, 0 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
+ */
+int hashtable_sharded_has_key(hashtable_sharded_t *table, const char *key, const hashtable_size_t key_size);
+
+
+/**
+ * Get the total number of key/value pairs stored in all shards
+ *
+ * @param table        Pointer to sharded hashtable instance
+ * @param entry_count  Pointer to location to store number of entries
+ *
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
  */
+int hashtable_sharded_entry_count(hashtable_sharded_t *table, uint32_t *entry_count);
 
 
 /**
- * @file hashtable_api.h
+ * Get the total number of unused bytes in the buffers of all shards, see
+ * #hashtable_bytes_remaining. Note that a key/value pair can only be stored if the buffer
+ * of its own shard has enough space.
  *
- * @author Erik K. Nyquist
+ * @param table            Pointer to sharded hashtable instance
+ * @param bytes_remaining  Pointer to location to store total unused bytes
  *
- * @brief Implements a lightweight separate-chaining hashtable designed to be flexible
- *        enough for embedded systems.
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
  */
+int hashtable_sharded_bytes_remaining(hashtable_sharded_t *table, size_t *bytes_remaining);
 
-#ifndef HASHTABLE_API_H
-#define HASHTABLE_API_H
 
-#include <stdint.h>
+/**
+ * Iterate over all key/value pairs stored in all shards, one shard after another, in the
+ * same way as #hashtable_next_item.
+ *
+ * @param table       Pointer to sharded hashtable instance
+ * @param key         Pointer to location to store key pointer
+ * @param key_size    Pointer to location to store key size. May be NULL.
+ * @param value       Pointer to location to store value pointer
+ * @param value_size  Pointer to location to store value size. May be NULL.
+ *
+ * @return   0 if successful, 1 if there are no more items to iterate over, and -1 if an
+ *           error occurred. Use #hashtable_error_message to get an error message if -1
+ *           is returned.
+ */
+int hashtable_sharded_next_item(hashtable_sharded_t *table, char **key, hashtable_size_t *key_size,
+                                char **value, hashtable_size_t *value_size);
 
 
-#define HASHTABLE_LIB_VERSION "v0.1.1"
+/**
+ * Reset the iteration cursors of all shards, see #hashtable_reset_cursor
+ *
+ * @param table   Pointer to sharded hashtable instance
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_sharded_reset_cursor(hashtable_sharded_t *table);
 
 
-#if !defined(HASHTABLE_SIZE_T_UINT16) && !defined(HASHTABLE_SIZE_T_UINT32) && !defined(HASHTABLE_SIZE_T_SYS)
-#define HASHTABLE_SIZE_T_SYS
-#endif // if !defined..
+/**
+ * Clear all stored data from all shards, see #hashtable_clear
+ *
+ * @param table  Pointer to sharded hashtable instance
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_sharded_clear(hashtable_sharded_t *table);
 
 
 /**
- * @brief Defines the type used to represent the size of keys and values stored in the hashtable
+ * Free all buffers that any shard allocated with #hashtable_config_t::allocator,
+ * see #hashtable_destroy
+ *
+ * @param table  Pointer to sharded hashtable instance
+ *
+ * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
  */
-#if defined(HASHTABLE_SIZE_T_UINT16)
-typedef uint16_t hashtable_size_t;
-#elif defined(HASHTABLE_SIZE_T_UINT32)
-typedef uint32_t hashtable_size_t;
-#elif defined(HASHTABLE_SIZE_T_SYS)
-typedef size_t hashtable_size_t;
-#else
-#error("HASHTABLE_SIZE_T option not defined")
-#endif // if defined....
+int hashtable_sharded_destroy(hashtable_sharded_t *table);
+
 
+#ifdef HASHTABLE_CONCURRENT
 
 /**
- * @brief Minimum number of slots in the table array
+ * Initialize a new concurrent hashtable instance. The functions with the
+ * `hashtable_concurrent_` prefix can be called for the same instance from any number of
+ * threads at the same time. Only the #HASHTABLE_ENGINE_CHAINING engine is supported, and
+ * #hashtable_config_t::allocator must be NULL.
+ *
+ * @param table        Pointer to concurrent hashtable instance
+ * @param config       Pointer to hashtable configuration data. May be NULL.
+ *                     If NULL, a default general-purpose configuration will be used.
+ * @param buffer       Pointer to buffer to use for hashtable data
+ * @param buffer_size  Size of buffer in bytes
+ *
+ * @return   0 if successful, 1 if buffer size is not large enough, and -1 if an
+ *           error occurred. Use #hashtable_error_message to get an error message if -1
+ *           is returned.
  */
-#define HASHTABLE_MIN_ARRAY_COUNT (10u)
+int hashtable_concurrent_create(hashtable_concurrent_t *table, const hashtable_config_t *config,
+                                void *buffer, size_t buffer_size);
 
 
 /**
- * @brief Helper macro, gets the min. required buffer size for a specific array count.
- *        When creating a hashtable with a specific array count, this macro will tell
- *        you how much memory is required at a minimum to hold the 'housekeeping' data
- *        for that table. Any remaining space is used for key/value pair data storage.
+ * Insert a new key/value pair into a concurrent hashtable, or overwrite the value of
+ * an existing key, in the same way as #hashtable_insert.
+ *
+ * @param table       Pointer to concurrent hashtable instance
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data
+ * @param value_size  Value data size in bytes
+ *
+ * @return   0 if successful, 1 if there was not enough space left in the table buffer,
+ *           and -1 if an error occurred. Use #hashtable_error_message to get an error
+ *           message if -1 is returned.
  */
-#define HASHTABLE_MIN_BUFFER_SIZE(array_count)                                 \
-    (sizeof(_keyval_pair_table_data_t) + sizeof(_keyval_pair_list_table_t) +   \
-    ((array_count) * sizeof(_keyval_pair_list_t)) +                            \
-    sizeof(_keyval_pair_data_block_t))
+int hashtable_concurrent_insert(hashtable_concurrent_t *table, const char *key, const hashtable_size_t key_size,
+                                const char *value, const hashtable_size_t value_size);
 
 
 /**
- * Hash function used for hashing key data
+ * Remove a stored key/value pair from a concurrent hashtable
  *
- * @param data   Pointer to key data
- * @param size   Key data size in bytes
+ * @param table     Pointer to concurrent hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
  *
- * @return  Computed hash value
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
  */
-typedef uint32_t (*hashtable_hashfunc_t)(const char *data, const hashtable_size_t size);
+int hashtable_concurrent_remove(hashtable_concurrent_t *table, const char *key, const hashtable_size_t key_size);
 
 
 /**
- * @brief Configuration data for a single hashtable instance
+ * Copy the value stored for a key in a concurrent hashtable. Unlike #hashtable_retrieve,
+ * the value data is copied while the key's lock is held, since a pointer to the stored
+ * value could be invalidated by another thread at any time.
+ *
+ * @param table        Pointer to concurrent hashtable instance
+ * @param key          Pointer to key data
+ * @param key_size     Key data size in bytes
+ * @param value        Pointer to location to copy value data. May be NULL if
+ *                     'value_buf_size' is 0.
+ * @param value_buf_size  Size of value buffer in bytes. If the value is larger, only the
+ *                     first 'value_buf_size' bytes are copied.
+ * @param value_size   Pointer to location to store the full size of the stored value.
+ *                     May be NULL.
+ *
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
  */
-typedef struct
-{
-    hashtable_hashfunc_t hash;    ///< Hash function to use, must not be NULL
-    uint32_t array_count;         ///< Number of table array slots, must not be 0
-} hashtable_config_t;
+int hashtable_concurrent_retrieve(hashtable_concurrent_t *table, const char *key, const hashtable_size_t key_size,
+                                  char *value, hashtable_size_t value_buf_size, hashtable_size_t *value_size);
 
 
 /**
- * @brief All data for a single hashtable instance
+ * Check if a key exists in a concurrent hashtable
+ *
+ * @param table     Pointer to concurrent hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
+ *
+ * @return   1 if the key exists, 0 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
  */
-typedef struct
-{
-    hashtable_config_t config;    ///< Hashtable config data
-    uint32_t entry_count;         ///< Number of entries in the table
-    size_t data_size;             ///< Size of data section
-    void *table_data;             ///< Pointer to buffer for data section
-} hashtable_t;
+int hashtable_concurrent_has_key(hashtable_concurrent_t *table, const char *key, const hashtable_size_t key_size);
 
 
 /**
- * Initialize a new hashtable instance
+ * Get the number of key/value pairs stored in a concurrent hashtable. If other threads
+ * are inserting or removing key/value pairs, the count may already be out of date when
+ * it is returned.
  *
- * @param table        Pointer to hashtable instance
+ * @param table        Pointer to concurrent hashtable instance
+ * @param entry_count  Pointer to location to store number of entries
+ *
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_concurrent_entry_count(hashtable_concurrent_t *table, uint32_t *entry_count);
+
+
+/**
+ * Take all locks of a concurrent hashtable, and return a pointer to the underlying
+ * hashtable instance, which can then be passed to any other hashtable function (e.g.
+ * #hashtable_next_item, #hashtable_compact or #hashtable_resize) until
+ * #hashtable_concurrent_exclusive_end is called. Calls to all other `hashtable_concurrent_`
+ * functions for the same instance will wait until then.
+ *
+ * Space still held for new key/value pairs by each lock stripe is released to the free
+ * lists, and the entry count of the returned hashtable instance is brought up to date.
+ *
+ * @param table  Pointer to concurrent hashtable instance
+ *
+ * @return   Pointer to underlying hashtable instance, or NULL if an error occurred.
+ *           Use #hashtable_error_message to get an error message if NULL is returned.
+ */
+hashtable_t *hashtable_concurrent_exclusive_begin(hashtable_concurrent_t *table);
+
+
+/**
+ * Release all locks taken by #hashtable_concurrent_exclusive_begin. Any incremental
+ * resize or compaction started on the underlying hashtable instance is completed first.
+ *
+ * @param table  Pointer to concurrent hashtable instance
+ *
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
+ */
+int hashtable_concurrent_exclusive_end(hashtable_concurrent_t *table);
+
+#endif // HASHTABLE_CONCURRENT
+
+
+#ifdef HASHTABLE_RCU
+
+/**
+ * Initialize a new RCU hashtable instance, for one writer thread and up to
+ * #HASHTABLE_RCU_READERS reader threads. Only one thread at a time may call
+ * #hashtable_rcu_insert, #hashtable_rcu_remove, #hashtable_rcu_reclaim or
+ * #hashtable_rcu_synchronize (the writer), while any number of other threads look up
+ * keys with #hashtable_rcu_retrieve or #hashtable_rcu_has_key, without taking any locks.
+ * Only the #HASHTABLE_ENGINE_CHAINING engine is supported, and #hashtable_config_t::allocator
+ * must be NULL.
+ *
+ * @param table        Pointer to RCU hashtable instance
  * @param config       Pointer to hashtable configuration data. May be NULL.
  *                     If NULL, a default general-purpose configuration will be used.
  * @param buffer       Pointer to buffer to use for hashtable data
  * @param buffer_size  Size of buffer in bytes
  *
  * @return   0 if successful, 1 if buffer size is not large enough, and -1 if an
- *           error occurred. Use #hashtable_error_message to get an error message
- *           if -1 is returned.
+ *           error occurred. Use #hashtable_error_message to get an error message if -1
+ *           is returned.
  */
-int hashtable_create(hashtable_t *table, const hashtable_config_t *config,
-                     void *buffer, size_t buffer_size);
+int hashtable_rcu_create(hashtable_rcu_t *table, const hashtable_config_t *config,
+                         void *buffer, size_t buffer_size);
 
 
 /**
- * Insert a new key/value pair into a table. If a key/value pair with the
- * given key already exists, then it will be over-written with the new value.
+ * Start a read section. #hashtable_rcu_retrieve and #hashtable_rcu_has_key may only be
+ * called between #hashtable_rcu_read_begin and #hashtable_rcu_read_end, and key/value
+ * pairs removed by the writer during a read section are not re-used until the read
+ * section has ended. Read sections cannot be nested, and should be kept short, since the
+ * writer may have to wait for them to end.
  *
- * @param table       Pointer to hashtable instance
- * @param key         Pointer to key data
- * @param key_size    Key data size in bytes
- * @param value       Pointer to value data, may be NULL
- * @param value_size  Value data size in bytes, may be 0
+ * @param table   Pointer to RCU hashtable instance
+ * @param reader  Reader slot index, less than #HASHTABLE_RCU_READERS. Each slot must only
+ *                be used by one thread at a time.
  *
- * @return   0 if successful, 1 if there is not enough space left in the buffer for
-             key/value pair data, and -1 if an error occurred. Use #hashtable_error_message
- *           to get an error message if -1 is returned.
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
  */
-int hashtable_insert(hashtable_t *table, const char *key, const hashtable_size_t key_size,
-                     const char *value, const hashtable_size_t value_size);
+int hashtable_rcu_read_begin(hashtable_rcu_t *table, uint32_t reader);
 
 
 /**
- * Remove a stored value from a table by key. If the given key does not exist in
- * the table, then the return value will indicate success.
+ * End a read section started by #hashtable_rcu_read_begin. Value pointers returned by
+ * #hashtable_rcu_retrieve during the read section must not be used after this.
  *
- * @param table     Pointer to hashtable instance
- * @param key       Pointer to key data
- * @param key_size  Key data size in bytes
+ * @param table   Pointer to RCU hashtable instance
+ * @param reader  Reader slot index passed to #hashtable_rcu_read_begin
  *
- * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
- *           Use #hashtable_error_message to get an error message if -1 is returned.
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
+ *           to get an error message.
  */
-int hashtable_remove(hashtable_t *table, const char *key, const hashtable_size_t key_size);
+int hashtable_rcu_read_end(hashtable_rcu_t *table, uint32_t reader);
 
 
 /**
- * Retrieve a pointer to a value stored in a table by key.
+ * Retrieve a pointer to the value stored for a key, from inside a read section. The value
+ * data is never modified in-place by the writer, so it stays valid until the read section
+ * ends, even if the key is removed or given a new value in the meantime.
  *
- * @param table       Pointer to hashtable instance
+ * @param table       Pointer to RCU hashtable instance
  * @param key         Pointer to key data
  * @param key_size    Key data size in bytes
- * @param value       Pointer to location to store value pointer, may be NULL
- * @param value_size  Pointer to location to store value size, may be NULL
+ * @param value       Pointer to location to store value pointer. May be NULL.
+ * @param value_size  Pointer to location to store value size. May be NULL.
  *
  * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
  *           Use #hashtable_error_message to get an error message if -1 is returned.
  */
-int hashtable_retrieve(hashtable_t *table, const char *key, const hashtable_size_t key_size,
-                       char **value, hashtable_size_t *value_size);
+int hashtable_rcu_retrieve(hashtable_rcu_t *table, const char *key, const hashtable_size_t key_size,
+                           char **value, hashtable_size_t *value_size);
 
 
 /**
- * Check if a key exists in a table.
+ * Check if a key exists, from inside a read section
  *
- * @param table     Pointer to hashtable instance
+ * @param table     Pointer to RCU hashtable instance
  * @param key       Pointer to key data
  * @param key_size  Key data size in bytes
  *
- * @return   1 if key exists, 0 if key does not exist, and -1 if an error occurred.
- *           Use #hashtable_error_message to get an error message.
+ * @return   1 if the key exists, 0 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
  */
-int hashtable_has_key(hashtable_t *table, const char *key, const hashtable_size_t key_size);
+int hashtable_rcu_has_key(hashtable_rcu_t *table, const char *key, const hashtable_size_t key_size);
 
 
 /**
- * Number of bytes remaining for key/value pair data storage
+ * Insert a new key/value pair, or replace the value of an existing key (writer only).
+ * A new key/value pair is always stored and published, and a replaced pair is removed in
+ * the same way as #hashtable_rcu_remove, so readers see either the old or the new value.
+ * If there is not enough space, waits for readers (see #hashtable_rcu_synchronize) to
+ * free removed pairs before giving up.
  *
- * @param table            Pointer to hashtable instance
- * @param bytes_remaining  Pointer to location to store number of bytes remaining
+ * @param table       Pointer to RCU hashtable instance
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data
+ * @param value_size  Value data size in bytes
  *
- * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
- *           to get an error message.
+ * @return   0 if successful, 1 if there was not enough space left in the table buffer (in
+ *           this case any existing value for the key is unchanged), and -1 if an error
+ *           occurred. Use #hashtable_error_message to get an error message if -1 is returned.
  */
-int hashtable_bytes_remaining(hashtable_t *table, size_t *bytes_remaining);
+int hashtable_rcu_insert(hashtable_rcu_t *table, const char *key, const hashtable_size_t key_size,
+                         const char *value, const hashtable_size_t value_size);
 
 
 /**
- * Retrieve pointers to the next key/value pair in the table. This function can
- * be used to iterate over all key/value pairs stored in the table.
+ * Remove a stored key/value pair (writer only). The pair is unlinked straight away, but
+ * its space is only added to the free lists once all read sections that were active at
+ * the time have ended. If #HASHTABLE_RCU_RETIRED_MAX removed pairs are already waiting,
+ * waits for readers first (see #hashtable_rcu_synchronize).
  *
- * @param table       Pointer to hashtable instance
- * @param key         Pointer to location to store key pointer
- * @param key_size    Pointer to location to store key data size in bytes
- * @param value       Pointer to location to store value pointer, may be NULL
- * @param value_size  Pointer to location to store value data size in bytes, may be NULL
+ * @param table     Pointer to RCU hashtable instance
+ * @param key       Pointer to key data
+ * @param key_size  Key data size in bytes
  *
- * @return   0 if next item was read successfully, 1 if no item was read because
- *           all items in the table have been iterated over (in this case you can
-             use hashtable_reset_cursor to reset for another iteration if you need to),
-             and -1 if an error occurred. Use #hashtable_error_message to get an error
-             message.
+ * @return   0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ *           Use #hashtable_error_message to get an error message if -1 is returned.
  */
-int hashtable_next_item(hashtable_t *table, char **key, hashtable_size_t *key_size,
-                        char **value, hashtable_size_t *value_size);
+int hashtable_rcu_remove(hashtable_rcu_t *table, const char *key, const hashtable_size_t key_size);
 
 
 /**
- * Reset the key/value pair cursor, which is used for iteration via #hashtable_next_item.
- * This allows iterating through a table again after #hashtable_next_item has already iterated
- * over the whole table and returned a value of 1.
+ * Free all removed key/value pairs that no read section can still be using, without
+ * waiting (writer only). This is also done by every #hashtable_rcu_insert and
+ * #hashtable_rcu_remove call.
  *
- * @param table   Pointer to hashtable instance
+ * @param table  Pointer to RCU hashtable instance
  *
- * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
- *           to get an error message.
+ * @return   0 if all removed pairs have been freed, 1 if some removed pairs are still
+ *           waiting for read sections to end, and -1 if an error occurred. Use
+ *           #hashtable_error_message to get an error message if -1 is returned.
  */
-int hashtable_reset_cursor(hashtable_t *table);
+int hashtable_rcu_reclaim(hashtable_rcu_t *table);
 
 
 /**
- * Clear all stored data from a hashtable instance
+ * Wait until all read sections that are active have ended, and then free all removed
+ * key/value pairs (writer only).
  *
- * @param table  Pointer to hashtable instance
+ * @param table  Pointer to RCU hashtable instance
  *
- * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
  *           to get an error message.
  */
-int hashtable_clear(hashtable_t *table);
+int hashtable_rcu_synchronize(hashtable_rcu_t *table);
+
+#endif // HASHTABLE_RCU
 
 
+#ifdef HASHTABLE_CACHE_EVICTION
+
 /**
- * Populate a configuration structure with the default hash function (FNV-1a), and
- * an array count optimized for the given buffer size.
+ * Set the current time of a table, used to decide which stored key/value pairs have
+ * expired (see #hashtable_insert_ttl). Times are in any unit chosen by the caller, and
+ * should never go backwards.
  *
- * @param config       Pointer to configuration data structure to populate
- * @param buffer_size  Buffer size to generate configuration for
+ * @param table  Pointer to hashtable instance
+ * @param now    Current time
  *
- * @return   0 if successful, -1 if an error occurred. Use #hashtable_error_message
+ * @return   0 if successful, and -1 if an error occurred. Use #hashtable_error_message
  *           to get an error message.
  */
-int hashtable_default_config(hashtable_config_t *config, size_t buffer_size);
+int hashtable_set_time(hashtable_t *table, uint32_t now);
 
 
 /**
- * Return a pointer to the last stored error message. When any hashtable function
- * returns -1 to indicate an error, you can call this function to get a pointer to
- * the corresponding error message string. If no error has occurred then this
- * function will return a pointer to an empty string.
+ * Insert a new key/value pair into a table, the same way as #hashtable_insert, with a
+ * time-to-live. The pair expires when the time set by #hashtable_set_time reaches the
+ * current time plus 'ttl', and is then treated as not existing by searches, and evicted
+ * before any pair that has not expired when the table is full.
  *
- * @return  Pointer to error message string
+ * @param table       Pointer to hashtable instance
+ * @param key         Pointer to key data
+ * @param key_size    Key data size in bytes
+ * @param value       Pointer to value data, may be NULL
+ * @param value_size  Value data size in bytes, may be 0
+ * @param ttl         Time-to-live, in the same unit as #hashtable_set_time. Must be less
+ *                    than 2^31, 0 means the pair never expires.
+ *
+ * @return   0 if successful, 1 if there is not enough space left in the buffer for the
+ *           key/value pair, even after evicting all other pairs, and -1 if an error
+ *           occurred. Use #hashtable_error_message to get an error message if -1 is returned.
  */
-char *hashtable_error_message(void);
+int hashtable_insert_ttl(hashtable_t *table, const char *key, const hashtable_size_t key_size,
+                         const char *value, const hashtable_size_t value_size, uint32_t ttl);
+
+#endif // HASHTABLE_CACHE_EVICTION
 
 
 /**
@@ -357,13 +2265,83 @@ char *hashtable_error_message(void);
 #endif // HASHTABLE_PACKED_STRUCT
 
 
+/**
+ * Number of free list size classes. The first _HASHTABLE_FREELIST_EXACT_CLASSES classes
+ * each hold freed key/value pairs of one exact size (in multiples of pointer size), and
+ * the remaining classes each cover sizes from one power of two up to the next.
+ */
+#define _HASHTABLE_FREELIST_CLASSES (32u)
+#define _HASHTABLE_FREELIST_EXACT_CLASSES (16u)
+
+
+/**
+ * Size of the occupancy bitmap stored after the table array, one bit per table array
+ * slot (set when the slot's list is not empty), made of 32-bit words
+ */
+#define _HASHTABLE_OCCUPANCY_BITMAP_SIZE(array_count) \
+    (((((size_t) (array_count)) + 31u) / 32u) * sizeof(uint32_t))
+
+
+/**
+ * Size of the bloom filter stored after the occupancy bitmap (see HASHTABLE_BLOOM_FILTER),
+ * made of 32-bit words
+ */
+#ifdef HASHTABLE_BLOOM_FILTER
+#define _HASHTABLE_BLOOM_FILTER_SIZE(array_count) \
+    ((((((size_t) (array_count)) * HASHTABLE_BLOOM_BITS_PER_SLOT) + 31u) / 32u) * sizeof(uint32_t))
+#else
+#define _HASHTABLE_BLOOM_FILTER_SIZE(array_count) (0u)
+#endif // HASHTABLE_BLOOM_FILTER
+
+
+/**
+ * Array count used by #hashtable_create for a requested array count. With
+ * HASHTABLE_POW2_ARRAY_COUNT, this is the requested count rounded up to a power of 2.
+ */
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+#define _HASHTABLE_OR_SHIFT(value, shift) ((value) | ((value) >> (shift)))
+#define _HASHTABLE_ARRAY_COUNT(array_count)                                    \
+    (_HASHTABLE_OR_SHIFT(_HASHTABLE_OR_SHIFT(_HASHTABLE_OR_SHIFT(              \
+     _HASHTABLE_OR_SHIFT(_HASHTABLE_OR_SHIFT(((uint32_t) (array_count)) - 1u,  \
+     1u), 2u), 4u), 8u), 16u) + 1u)
+#else
+#define _HASHTABLE_ARRAY_COUNT(array_count) (array_count)
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+
+/**
+ * Round a size up to the nearest multiple of the size of a pointer
+ */
+#define _HASHTABLE_ROUND_UP_PTRSIZE(size) (((size) + (sizeof(int *) - 1u)) & ~(sizeof(int *) - 1u))
+
+
+/**
+ * Type of a link from one structure in a table buffer to another. Normally this is just a
+ * pointer, but if HASHTABLE_OFFSET_POINTERS is defined, links are stored as a 32-bit offset
+ * from the start of the buffer (0 means NULL), so that buffer contents do not depend on
+ * where the buffer is located.
+ */
+#ifdef HASHTABLE_OFFSET_POINTERS
+#define _HASHTABLE_LINK(type) uint32_t
+#else
+#define _HASHTABLE_LINK(type) type *
+#endif // HASHTABLE_OFFSET_POINTERS
+
+
 /**
  * Represents a single key/value pair stored in the data block area of a table instance.
  * Also represents a single node in a singly-linked list of key/value pairs.
  */
 typedef struct _keyval_pair
 {
-    struct _keyval_pair *next;    ///< Pointer to next key/val pair in the list
+    _HASHTABLE_LINK(struct _keyval_pair) next;  ///< Link to next key/val pair in the list
+#ifdef HASHTABLE_STORE_HASH
+    uint32_t hash;                ///< Hash value computed for key data
+#endif // HASHTABLE_STORE_HASH
+#ifdef HASHTABLE_CACHE_EVICTION
+    uint32_t expiry;              ///< Time (see hashtable_set_time) when the pair expires, 0 for never
+    uint8_t referenced;           ///< Set when the pair is found by a search, cleared by the CLOCK hand
+#endif // HASHTABLE_CACHE_EVICTION
     hashtable_size_t key_size;    ///< Size of key data in bytes
     hashtable_size_t value_size;  ///< Size of value data in bytes
     uint8_t data[];               ///< Start of key + value data packed together
@@ -375,23 +2353,57 @@ typedef struct _keyval_pair
  */
 typedef struct
 {
-    _keyval_pair_t *head;  ///< Head (first) item
-    _keyval_pair_t *tail;  ///< Tail (last) item
+    _HASHTABLE_LINK(_keyval_pair_t) head;  ///< Head (first) item
+#ifndef HASHTABLE_NO_LIST_TAIL
+    _HASHTABLE_LINK(_keyval_pair_t) tail;  ///< Tail (last) item
+#endif // HASHTABLE_NO_LIST_TAIL
+#ifdef HASHTABLE_BUCKET_HASH
+    uint32_t head_hash;                    ///< Hash value computed for key data of head item
+#endif // HASHTABLE_BUCKET_HASH
 } _keyval_pair_list_t;
 
 
+/**
+ * Represents a table of open addressing slots
+ */
+typedef struct
+{
+    uint32_t slot_count;          ///< Number of slots, always a multiple of HASHTABLE_SLOT_GROUP_SIZE
+    uint32_t used_count;          ///< Number of slots holding a key/value pair
+    uint32_t deleted_count;       ///< Number of slots marked as deleted
+    _HASHTABLE_LINK(_keyval_pair_t) slots[];  ///< First slot in table, followed by one control byte per slot
+} _keyval_pair_slot_table_t;
+
+
 /**
  * Represents the area where key/val pair data is stored
  */
 typedef struct
 {
-    _keyval_pair_list_t freelist;  ///< List of freed key/value pairs
+    _HASHTABLE_LINK(_keyval_pair_t) freelists[_HASHTABLE_FREELIST_CLASSES];  ///< Freed key/value pairs, one list per size class
+    uint32_t freelist_bitmap;      ///< Bit N is set when freelists[N] is not empty
+    uint32_t free_count;           ///< Number of freed key/value pairs in all free lists
+    size_t bytes_free;             ///< Total size of freed key/value pairs in all free lists
     size_t total_bytes;            ///< Total bytes available for key/value pair data
     size_t bytes_used;             ///< Total bytes used (including freed) by key/value pair data
     uint8_t data[];                ///< Pointer to key/value data section, size not known at compile time
 } _keyval_pair_data_block_t;
 
 
+#ifdef HASHTABLE_ENABLE_STATS
+/**
+ * Counters kept in the table data section for #hashtable_get_stats
+ */
+typedef struct
+{
+    uint64_t lookups;               ///< Key searches made
+    uint64_t lookup_probes;         ///< Pairs visited (or groups probed) by key searches
+    uint64_t freelist_searches;     ///< Free list searches made
+    uint64_t freelist_search_steps; ///< Freed pairs looked at by free list searches
+} _keyval_pair_stats_t;
+#endif // HASHTABLE_ENABLE_STATS
+
+
 /**
  * Represents a table of singly-linked lists of key-value pair
  */
@@ -432,15 +2444,38 @@ typedef struct
  *  | data block data[] section   |
  *  |                             |
  *  +-----------------------------+
+ *
+ * The table[] array items are followed by the occupancy bitmap (one bit per array item,
+ * set when its list is not empty), and the bloom filter if HASHTABLE_BLOOM_FILTER is defined.
+ *
+ * For #HASHTABLE_ENGINE_OPEN_ADDRESSING, the _keyval_pair_list_table_t and table[] sections
+ * are replaced with a _keyval_pair_slot_table_t, followed by the slots[] array, followed by
+ * one control byte per slot (padded up to pointer size).
  */
 typedef struct
 {
-    _keyval_pair_list_table_t *list_table;  ///< Convenience pointer to table array
-    _keyval_pair_data_block_t *data_block;  ///< Convenience pointer to key/val data block
+    uint32_t magic;                         ///< Identifies an initialized table buffer
+    uint32_t layout;                        ///< Build options that the buffer layout depends on
+    uint32_t hash_check;                    ///< Hash function output for a fixed test key
+    uint32_t engine;                        ///< Engine used by the table (#hashtable_engine_t)
+    _HASHTABLE_LINK(_keyval_pair_list_table_t) list_table;  ///< Link to table array (chaining only)
+    _HASHTABLE_LINK(_keyval_pair_slot_table_t) slot_table;  ///< Link to slot table (open addressing only)
+    _HASHTABLE_LINK(_keyval_pair_data_block_t) data_block;  ///< Link to key/val data block
     uint32_t cursor_array_index;            ///< Cursor current table index for iteration
     uint32_t cursor_items_traversed;        ///< Number of items traversed by cursor
-    _keyval_pair_t *cursor_item;            ///< Cursor current item pointer for iteration
+    _HASHTABLE_LINK(_keyval_pair_t) cursor_item;  ///< Cursor current item for iteration
     uint8_t cursor_limit;                   ///< Set to 1 when all items have been iterated through
+    uint8_t compact_in_progress;            ///< Set to 1 while an incremental compaction is in progress
+    size_t compact_read_offset;             ///< Data block offset of next pair to be visited by compaction
+    size_t compact_write_offset;            ///< Data block offset that next visited pair will be moved to
+    uint8_t clear_in_progress;              ///< Set to 1 while table array slots left by #hashtable_clear are not all zeroed
+    uint32_t clear_index;                   ///< Next table array index to be zeroed after #hashtable_clear
+#ifdef HASHTABLE_CACHE_EVICTION
+    size_t clock_hand;                      ///< Data block offset of next pair looked at by eviction
+#endif // HASHTABLE_CACHE_EVICTION
+#ifdef HASHTABLE_ENABLE_STATS
+    _keyval_pair_stats_t stats;             ///< Counters for hashtable_get_stats
+#endif // HASHTABLE_ENABLE_STATS
 } _keyval_pair_table_data_t;
 
 #endif // HASHTABLE_API_H
@@ -0,0 +1,344 @@
+/**
+ * @file hashtable_fixed.h
+ *
+ * @brief Generates hashtable types specialized for keys and values of one fixed size
+ *
+ * Tables generated with #HASHTABLE_DEFINE_FIXED store each entry inline, as a control byte
+ * plus the key and value data, with no key/value size fields and no links between entries.
+ * Keys are compared with a single integer comparison when they are 4 or 8 bytes, and keys
+ * and values are copied with fixed-size copies, which compilers turn into plain loads and
+ * stores. Entries are placed with linear probing, and removal shifts later entries back
+ * into the freed slot, so there are no tombstones and lookups never slow down over time.
+ *
+ * Like tables created with #hashtable_create, all table data is stored in a buffer provided
+ * by the caller, and no dynamic memory is used. Functions for fixed-size tables return
+ * -1 if an error occurred, but do not change the error returned by #hashtable_last_error.
+ */
+
+#ifndef HASHTABLE_FIXED_H
+#define HASHTABLE_FIXED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "hashtable_api.h"
+
+
+/**
+ * @brief Control byte value for an unused slot in a fixed-size table. Slots that are
+ * in use hold the lowest 7 bits of the hash value for the stored key.
+ */
+#define HASHTABLE_FIXED_CTRL_EMPTY (0x80u)
+
+
+/**
+ * @brief Helper macro, gets the buffer size needed for a fixed-size table generated by
+ *        #HASHTABLE_DEFINE_FIXED with a specific number of slots. At most 7/8ths of the
+ *        slots can be used.
+ *
+ * @param name        Name passed to #HASHTABLE_DEFINE_FIXED
+ * @param slot_count  Number of slots
+ */
+#define HASHTABLE_FIXED_BUFFER_SIZE(name, slot_count) ((slot_count) * (1u + sizeof(name##_entry_t)))
+
+
+/**
+ * @brief Helper macro used by generated functions, returns -1 if a condition describing
+ * invalid parameters is true (unless HASHTABLE_DISABLE_PARAM_VALIDATION is defined)
+ */
+#ifndef HASHTABLE_DISABLE_PARAM_VALIDATION
+#define HASHTABLE_FIXED_CHECK_PARAMS(invalid) do { if (invalid) { return -1; } } while (0)
+#else
+#define HASHTABLE_FIXED_CHECK_PARAMS(invalid) do { } while (0)
+#endif // HASHTABLE_DISABLE_PARAM_VALIDATION
+
+
+/**
+ * Compare two fixed-size keys. 'size' is always a constant, so only one of the
+ * comparisons is left after inlining.
+ *
+ * @param a     Pointer to first key
+ * @param b     Pointer to second key
+ * @param size  Key size in bytes
+ *
+ * @return 1 if the keys are equal, 0 otherwise
+ */
+static inline int _hashtable_fixed_key_equal(const void *a, const void *b, size_t size)
+{
+    if (sizeof(uint32_t) == size)
+    {
+        uint32_t a32;
+        uint32_t b32;
+        (void) memcpy(&a32, a, sizeof(a32));
+        (void) memcpy(&b32, b, sizeof(b32));
+        return a32 == b32;
+    }
+
+    if (sizeof(uint64_t) == size)
+    {
+        uint64_t a64;
+        uint64_t b64;
+        (void) memcpy(&a64, a, sizeof(a64));
+        (void) memcpy(&b64, b, sizeof(b64));
+        return a64 == b64;
+    }
+
+    return 0 == memcmp(a, b, size);
+}
+
+
+/**
+ * Reduce a hash value to a slot index in a fixed-size table, without a division
+ * (Lemire's fast range reduction, after multiplying by 2^32 divided by the golden ratio)
+ *
+ * @param hash        Hash value computed for key data
+ * @param slot_count  Number of slots in the table
+ *
+ * @return Slot index
+ */
+static inline uint32_t _hashtable_fixed_index(uint32_t hash, uint32_t slot_count)
+{
+    return (uint32_t) ((((uint64_t) (hash * 0x9e3779b9u)) * slot_count) >> 32u);
+}
+
+
+/**
+ * Generates a hashtable type for keys of exactly 'key_bytes' bytes and values of exactly
+ * 'value_bytes' bytes, along with the functions that operate on it. Use this macro once
+ * (in a .c file, or in a header shared by several .c files) for each combination of key
+ * and value size. For example, HASHTABLE_DEFINE_FIXED(u32_table, 4, 8) generates the
+ * following types and static inline functions:
+ *
+ * - <code>u32_table_entry_t</code>: one stored entry, holding 'key' and 'value' byte arrays
+ * - <code>u32_table_t</code>: one table instance
+ * - <code>int u32_table_create(u32_table_t *table, hashtable_hashfunc_t hash, void *buffer, size_t buffer_size)</code>:
+ *   create a table in a buffer. 'hash' may be NULL to use #hashtable_hash_wyhash. Returns
+ *   0 if successful, 1 if the buffer has space for less than 2 slots, and -1 if an error occurred.
+ * - <code>int u32_table_insert(u32_table_t *table, const void *key, const void *value)</code>:
+ *   insert or overwrite an entry. Returns 0 if successful, 1 if the table is full, and -1 if
+ *   an error occurred.
+ * - <code>int u32_table_remove(u32_table_t *table, const void *key)</code>: remove an entry.
+ *   Returns 0 if successful, 1 if the key does not exist, and -1 if an error occurred.
+ * - <code>int u32_table_retrieve(u32_table_t *table, const void *key, void *value)</code>:
+ *   copy a stored value to 'value' (may be NULL). Returns 0 if successful, 1 if the key does
+ *   not exist, and -1 if an error occurred.
+ * - <code>int u32_table_has_key(u32_table_t *table, const void *key)</code>: returns 1 if the
+ *   key exists, 0 if the key does not exist, and -1 if an error occurred.
+ * - <code>int u32_table_next_item(u32_table_t *table, void *key, void *value)</code>: copy
+ *   the key and value of the next entry (either may be NULL). Returns 0 if successful, 1 if
+ *   all entries have been read, and -1 if an error occurred. Entries must not be removed
+ *   while iterating, since later entries may be moved to slots that were already read.
+ * - <code>int u32_table_reset_cursor(u32_table_t *table)</code>: restart iteration from the
+ *   first entry. Returns 0 if successful, and -1 if an error occurred.
+ * - <code>int u32_table_clear(u32_table_t *table)</code>: remove all entries. Returns 0 if
+ *   successful, and -1 if an error occurred.
+ *
+ * @param name         Prefix for generated type and function names
+ * @param key_bytes    Size of each key in bytes, must not be 0
+ * @param value_bytes  Size of each value in bytes, must not be 0
+ */
+#define HASHTABLE_DEFINE_FIXED(name, key_bytes, value_bytes)                                       \
+                                                                                                   \
+typedef struct                                                                                     \
+{                                                                                                  \
+    uint8_t key[key_bytes];                                                                        \
+    uint8_t value[value_bytes];                                                                    \
+} name##_entry_t;                                                                                  \
+                                                                                                   \
+typedef struct                                                                                     \
+{                                                                                                  \
+    hashtable_hashfunc_t hash;    /* Hash function to use */                                       \
+    uint8_t *ctrl;                /* Control byte for each slot */                                 \
+    name##_entry_t *entries;      /* Entry for each slot */                                        \
+    uint32_t slot_count;          /* Number of slots */                                            \
+    uint32_t entry_count;         /* Number of entries in the table */                             \
+    uint32_t cursor;              /* Next slot to read with next_item */                           \
+} name##_t;                                                                                        \
+                                                                                                   \
+/* Find the slot holding a key, or the empty slot where it would be placed */                     \
+static inline uint32_t _##name##_find(name##_t *table, const void *key, uint32_t hash, int *found) \
+{                                                                                                  \
+    uint8_t tag = (uint8_t) (hash & 0x7fu);                                                        \
+    uint32_t slot = _hashtable_fixed_index(hash, table->slot_count);                               \
+                                                                                                   \
+    while (HASHTABLE_FIXED_CTRL_EMPTY != table->ctrl[slot])                                        \
+    {                                                                                              \
+        if ((tag == table->ctrl[slot]) &&                                                          \
+            _hashtable_fixed_key_equal(table->entries[slot].key, key, (key_bytes)))                \
+        {                                                                                          \
+            *found = 1;                                                                            \
+            return slot;                                                                           \
+        }                                                                                          \
+                                                                                                   \
+        slot = ((slot + 1u) == table->slot_count) ? 0u : (slot + 1u);                              \
+    }                                                                                              \
+                                                                                                   \
+    *found = 0;                                                                                    \
+    return slot;                                                                                   \
+}                                                                                                  \
+                                                                                                   \
+static inline int name##_create(name##_t *table, hashtable_hashfunc_t hash,                        \
+                                void *buffer, size_t buffer_size)                                  \
+{                                                                                                  \
+    HASHTABLE_FIXED_CHECK_PARAMS((NULL == table) || (NULL == buffer));                             \
+                                                                                                   \
+    size_t slot_count = buffer_size / (1u + sizeof(name##_entry_t));                               \
+    if (slot_count < 2u)                                                                           \
+    {                                                                                              \
+        return 1;                                                                                  \
+    }                                                                                              \
+                                                                                                   \
+    table->hash = (NULL == hash) ? hashtable_hash_wyhash : hash;                                   \
+    table->slot_count = (slot_count > UINT32_MAX) ? UINT32_MAX : (uint32_t) slot_count;            \
+    table->ctrl = (uint8_t *) buffer;                                                              \
+    table->entries = (name##_entry_t *) (table->ctrl + table->slot_count);                         \
+    table->entry_count = 0u;                                                                       \
+    table->cursor = 0u;                                                                            \
+    (void) memset(table->ctrl, HASHTABLE_FIXED_CTRL_EMPTY, table->slot_count);                     \
+                                                                                                   \
+    return 0;                                                                                      \
+}                                                                                                  \
+                                                                                                   \
+static inline int name##_insert(name##_t *table, const void *key, const void *value)              \
+{                                                                                                  \
+    HASHTABLE_FIXED_CHECK_PARAMS((NULL == table) || (NULL == key) || (NULL == value));             \
+                                                                                                   \
+    int found;                                                                                     \
+    uint32_t hash = table->hash((const char *) key, (hashtable_size_t) (key_bytes));               \
+    uint32_t slot = _##name##_find(table, key, hash, &found);                                      \
+                                                                                                   \
+    if (!found)                                                                                    \
+    {                                                                                              \
+        /* At least one slot must stay empty, so that probing always ends */                      \
+        if (table->entry_count >= (table->slot_count - 1u - (table->slot_count / 8u)))             \
+        {                                                                                          \
+            return 1;                                                                              \
+        }                                                                                          \
+                                                                                                   \
+        table->ctrl[slot] = (uint8_t) (hash & 0x7fu);                                              \
+        (void) memcpy(table->entries[slot].key, key, (key_bytes));                                 \
+        table->entry_count += 1u;                                                                  \
+    }                                                                                              \
+                                                                                                   \
+    (void) memcpy(table->entries[slot].value, value, (value_bytes));                               \
+    return 0;                                                                                      \
+}                                                                                                  \
+                                                                                                   \
+static inline int name##_remove(name##_t *table, const void *key)                                 \
+{                                                                                                  \
+    HASHTABLE_FIXED_CHECK_PARAMS((NULL == table) || (NULL == key));                                \
+                                                                                                   \
+    int found;                                                                                     \
+    uint32_t hash = table->hash((const char *) key, (hashtable_size_t) (key_bytes));               \
+    uint32_t slot = _##name##_find(table, key, hash, &found);                                      \
+    if (!found)                                                                                    \
+    {                                                                                              \
+        return 1;                                                                                  \
+    }                                                                                              \
+                                                                                                   \
+    /* Shift back any later entries in the same run that may be placed in the freed slot */       \
+    uint32_t next = slot;                                                                          \
+    while (1)                                                                                      \
+    {                                                                                              \
+        next = ((next + 1u) == table->slot_count) ? 0u : (next + 1u);                              \
+        if (HASHTABLE_FIXED_CTRL_EMPTY == table->ctrl[next])                                       \
+        {                                                                                          \
+            break;                                                                                 \
+        }                                                                                          \
+                                                                                                   \
+        uint32_t home = _hashtable_fixed_index(                                                    \
+            table->hash((const char *) table->entries[next].key, (hashtable_size_t) (key_bytes)),  \
+            table->slot_count);                                                                    \
+        uint32_t from_home = (next >= home) ? (next - home) : (next + table->slot_count - home);   \
+        uint32_t from_slot = (next >= slot) ? (next - slot) : (next + table->slot_count - slot);   \
+                                                                                                   \
+        if (from_home >= from_slot)                                                                \
+        {                                                                                          \
+            table->ctrl[slot] = table->ctrl[next];                                                 \
+            (void) memcpy(&table->entries[slot], &table->entries[next], sizeof(name##_entry_t));   \
+            slot = next;                                                                           \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    table->ctrl[slot] = HASHTABLE_FIXED_CTRL_EMPTY;                                                \
+    table->entry_count -= 1u;                                                                      \
+    return 0;                                                                                      \
+}                                                                                                  \
+                                                                                                   \
+static inline int name##_retrieve(name##_t *table, const void *key, void *value)                  \
+{                                                                                                  \
+    HASHTABLE_FIXED_CHECK_PARAMS((NULL == table) || (NULL == key));                                \
+                                                                                                   \
+    int found;                                                                                     \
+    uint32_t hash = table->hash((const char *) key, (hashtable_size_t) (key_bytes));               \
+    uint32_t slot = _##name##_find(table, key, hash, &found);                                      \
+    if (!found)                                                                                    \
+    {                                                                                              \
+        return 1;                                                                                  \
+    }                                                                                              \
+                                                                                                   \
+    if (NULL != value)                                                                             \
+    {                                                                                              \
+        (void) memcpy(value, table->entries[slot].value, (value_bytes));                           \
+    }                                                                                              \
+                                                                                                   \
+    return 0;                                                                                      \
+}                                                                                                  \
+                                                                                                   \
+static inline int name##_has_key(name##_t *table, const void *key)                                \
+{                                                                                                  \
+    HASHTABLE_FIXED_CHECK_PARAMS((NULL == table) || (NULL == key));                                \
+                                                                                                   \
+    int found;                                                                                     \
+    uint32_t hash = table->hash((const char *) key, (hashtable_size_t) (key_bytes));               \
+    (void) _##name##_find(table, key, hash, &found);                                               \
+    return found;                                                                                  \
+}                                                                                                  \
+                                                                                                   \
+static inline int name##_next_item(name##_t *table, void *key, void *value)                       \
+{                                                                                                  \
+    HASHTABLE_FIXED_CHECK_PARAMS(NULL == table);                                                   \
+                                                                                                   \
+    while (table->cursor < table->slot_count)                                                      \
+    {                                                                                              \
+        uint32_t slot = table->cursor;                                                             \
+        table->cursor += 1u;                                                                       \
+                                                                                                   \
+        if (HASHTABLE_FIXED_CTRL_EMPTY != table->ctrl[slot])                                       \
+        {                                                                                          \
+            if (NULL != key)                                                                       \
+            {                                                                                      \
+                (void) memcpy(key, table->entries[slot].key, (key_bytes));                         \
+            }                                                                                      \
+                                                                                                   \
+            if (NULL != value)                                                                     \
+            {                                                                                      \
+                (void) memcpy(value, table->entries[slot].value, (value_bytes));                   \
+            }                                                                                      \
+                                                                                                   \
+            return 0;                                                                              \
+        }                                                                                          \
+    }                                                                                              \
+                                                                                                   \
+    return 1;                                                                                      \
+}                                                                                                  \
+                                                                                                   \
+static inline int name##_reset_cursor(name##_t *table)                                            \
+{                                                                                                  \
+    HASHTABLE_FIXED_CHECK_PARAMS(NULL == table);                                                   \
+                                                                                                   \
+    table->cursor = 0u;                                                                            \
+    return 0;                                                                                      \
+}                                                                                                  \
+                                                                                                   \
+static inline int name##_clear(name##_t *table)                                                   \
+{                                                                                                  \
+    HASHTABLE_FIXED_CHECK_PARAMS(NULL == table);                                                   \
+                                                                                                   \
+    (void) memset(table->ctrl, HASHTABLE_FIXED_CTRL_EMPTY, table->slot_count);                     \
+    table->entry_count = 0u;                                                                       \
+    table->cursor = 0u;                                                                            \
+    return 0;                                                                                      \
+}
+
+#endif // HASHTABLE_FIXED_H
@@ -0,0 +1,730 @@
+#if defined(__linux__)
+// For syscall() and perf_event_open
+#define _GNU_SOURCE
+#endif // __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "testing_utils.h"
+#include "hashtable_api.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif // __linux__
+
+/* Runs a reproducible mix of retrieve/insert/remove operations against a table
+ * holding a fixed key space, timing each operation with a nanosecond clock, and
+ * reports p50/p99/p999 latency per operation type. Keys are picked with a uniform
+ * or Zipfian distribution from a seeded generator, so the same options always
+ * produce the same sequence of operations. On Linux, hardware counters can also be
+ * read with perf_event_open, and all results can be written as JSON. */
+
+// Default size of buffer passed to hashtable_create, in MiB
+#define DEFAULT_BUFFER_MIB (256u)
+
+// Default number of distinct keys
+#define DEFAULT_KEY_COUNT (1000000u)
+
+// Default number of timed operations
+#define DEFAULT_OP_COUNT (2000000u)
+
+// Max. key or value size
+#define MAX_DATA_SIZE (256u)
+
+// Number of back-to-back clock reads used to measure timer overhead
+#define TIMER_CALIBRATION_READS (10000u)
+
+
+typedef enum
+{
+    OP_RETRIEVE = 0,
+    OP_INSERT,
+    OP_REMOVE,
+    OP_TYPE_COUNT
+} _op_type_t;
+
+
+static const char *_op_names[OP_TYPE_COUNT] = {"retrieve", "insert", "remove"};
+
+
+typedef struct
+{
+    uint32_t key_count;           // Number of distinct keys
+    uint32_t op_count;            // Number of timed operations
+    uint32_t mix[OP_TYPE_COUNT];  // Percentage of operations of each type
+    double zipf_theta;            // Zipfian skew, 0 for a uniform key distribution
+    uint32_t key_min;             // Min. key size in bytes
+    uint32_t key_max;             // Max. key size in bytes
+    uint32_t value_size;          // Value size in bytes
+    uint64_t seed;                // Seed for key and operation generation
+    size_t buffer_size;           // Table buffer size in bytes
+    hashtable_engine_t engine;
+    const char *hash_name;
+    hashtable_hashfunc_t hash;
+    bool json;                    // Print results as JSON
+    bool counters;                // Read hardware counters
+} _bench_config_t;
+
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t hits;                // Operations that found the key
+    uint64_t total_ns;
+    uint32_t p50_ns;
+    uint32_t p99_ns;
+    uint32_t p999_ns;
+    uint32_t max_ns;
+} _op_result_t;
+
+
+typedef struct
+{
+    const char *name;
+    hashtable_hashfunc_t hash;
+} _hash_option_t;
+
+
+static const _hash_option_t _hash_options[] =
+{
+    {"fnv1a", hashtable_hash_fnv1a},
+    {"wyhash", hashtable_hash_wyhash},
+    {"crc32c", hashtable_hash_crc32c}
+};
+
+
+typedef struct
+{
+    const char *name;
+#if defined(__linux__)
+    uint64_t config;
+    int fd;
+#endif // __linux__
+    bool valid;
+    uint64_t value;
+} _counter_t;
+
+
+static _counter_t _counters[] =
+{
+#if defined(__linux__)
+    {"cycles", PERF_COUNT_HW_CPU_CYCLES, -1, false, 0u},
+    {"instructions", PERF_COUNT_HW_INSTRUCTIONS, -1, false, 0u},
+    {"cache_misses", PERF_COUNT_HW_CACHE_MISSES, -1, false, 0u},
+    {"branch_misses", PERF_COUNT_HW_BRANCH_MISSES, -1, false, 0u}
+#else
+    {"cycles", false, 0u},
+    {"instructions", false, 0u},
+    {"cache_misses", false, 0u},
+    {"branch_misses", false, 0u}
+#endif // __linux__
+};
+
+#define COUNTER_COUNT (sizeof(_counters) / sizeof(_counters[0]))
+
+
+static uint64_t _rng_state;
+
+// Values of the Zipfian generator that only depend on key_count and zipf_theta
+static double _zipf_zetan;
+static double _zipf_alpha;
+static double _zipf_eta;
+
+
+// splitmix64 finalizer, used to derive key contents and to scatter Zipfian ranks
+static uint64_t _mix64(uint64_t x)
+{
+    x ^= x >> 30u;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27u;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31u;
+    return x;
+}
+
+
+// xorshift64* generator, so runs are reproducible on any platform
+static uint64_t _rng_next(void)
+{
+    _rng_state ^= _rng_state >> 12u;
+    _rng_state ^= _rng_state << 25u;
+    _rng_state ^= _rng_state >> 27u;
+    return _rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+
+// Uniform random value in [0, 1)
+static double _rng_unit(void)
+{
+    return (double) (_rng_next() >> 11u) * (1.0 / 9007199254740992.0);
+}
+
+
+static void _zipf_init(const _bench_config_t *cfg)
+{
+    double n = (double) cfg->key_count;
+    double theta = cfg->zipf_theta;
+    double zeta2 = 1.0 + pow(0.5, theta);
+
+    _zipf_zetan = 0.0;
+    for (uint32_t i = 1u; i <= cfg->key_count; i++)
+    {
+        _zipf_zetan += 1.0 / pow((double) i, theta);
+    }
+
+    _zipf_alpha = 1.0 / (1.0 - theta);
+    _zipf_eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - (zeta2 / _zipf_zetan));
+}
+
+
+/* Pick a key index. Zipfian ranks are generated as described in Gray et al., "Quickly
+ * generating billion-record synthetic databases", then scattered over the key space
+ * so the most popular keys are not all next to each other. */
+static uint32_t _next_key(const _bench_config_t *cfg)
+{
+    if (0.0 == cfg->zipf_theta)
+    {
+        return (uint32_t) (_rng_next() % cfg->key_count);
+    }
+
+    double u = _rng_unit();
+    double uz = u * _zipf_zetan;
+    uint64_t rank;
+
+    if (uz < 1.0)
+    {
+        rank = 0u;
+    }
+    else if (uz < (1.0 + pow(0.5, cfg->zipf_theta)))
+    {
+        rank = 1u;
+    }
+    else
+    {
+        rank = (uint64_t) ((double) cfg->key_count * pow((_zipf_eta * u) - _zipf_eta + 1.0, _zipf_alpha));
+    }
+
+    if (rank >= cfg->key_count)
+    {
+        rank = cfg->key_count - 1u;
+    }
+
+    return (uint32_t) (_mix64(rank) % cfg->key_count);
+}
+
+
+// Write the key data for a key index, and return its size
+static hashtable_size_t _make_key(const _bench_config_t *cfg, uint32_t index, char *key)
+{
+    uint64_t fill = _mix64(index);
+    uint32_t size = cfg->key_min;
+
+    if (cfg->key_max > cfg->key_min)
+    {
+        size += (uint32_t) (fill % ((cfg->key_max - cfg->key_min) + 1u));
+    }
+
+    (void) memcpy(key, &index, sizeof(index));
+    for (uint32_t i = sizeof(index); i < size; i++)
+    {
+        key[i] = (char) (fill >> ((i % 8u) * 8u));
+    }
+
+    return (hashtable_size_t) size;
+}
+
+
+static void _counters_open(void)
+{
+#if defined(__linux__)
+    for (size_t i = 0u; i < COUNTER_COUNT; i++)
+    {
+        struct perf_event_attr attr;
+        (void) memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = _counters[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        _counters[i].fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        _counters[i].valid = (0 <= _counters[i].fd);
+    }
+#endif // __linux__
+}
+
+
+static void _counters_enable(bool enable)
+{
+#if defined(__linux__)
+    for (size_t i = 0u; i < COUNTER_COUNT; i++)
+    {
+        if (_counters[i].valid)
+        {
+            if (enable)
+            {
+                (void) ioctl(_counters[i].fd, PERF_EVENT_IOC_RESET, 0);
+            }
+
+            (void) ioctl(_counters[i].fd, enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#else
+    (void) enable;
+#endif // __linux__
+}
+
+
+static void _counters_read(void)
+{
+#if defined(__linux__)
+    for (size_t i = 0u; i < COUNTER_COUNT; i++)
+    {
+        if (_counters[i].valid)
+        {
+            _counters[i].valid = (sizeof(_counters[i].value) ==
+                                  read(_counters[i].fd, &_counters[i].value, sizeof(_counters[i].value)));
+            (void) close(_counters[i].fd);
+        }
+    }
+#endif // __linux__
+}
+
+
+// Smallest time between two back-to-back clock reads, subtracted from each operation time
+static uint64_t _timer_overhead_ns(void)
+{
+    uint64_t overhead = UINT64_MAX;
+
+    for (uint32_t i = 0u; i < TIMER_CALIBRATION_READS; i++)
+    {
+        uint64_t start = timing_nsecs_elapsed();
+        uint64_t elapsed = timing_nsecs_elapsed() - start;
+        if (elapsed < overhead)
+        {
+            overhead = elapsed;
+        }
+    }
+
+    return overhead;
+}
+
+
+static int _compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+
+// Nearest-rank percentile of sorted latencies, 'per100k' is the percentile * 1000
+static uint32_t _percentile(const uint32_t *sorted, uint32_t count, uint32_t per100k)
+{
+    uint64_t rank = (((uint64_t) count * per100k) + 99999u) / 100000u;
+    return sorted[(0u < rank) ? (rank - 1u) : 0u];
+}
+
+
+static void _summarize(_op_result_t *result, uint32_t *latencies)
+{
+    if (0u == result->count)
+    {
+        return;
+    }
+
+    qsort(latencies, result->count, sizeof(uint32_t), _compare_u32);
+    result->p50_ns = _percentile(latencies, result->count, 50000u);
+    result->p99_ns = _percentile(latencies, result->count, 99000u);
+    result->p999_ns = _percentile(latencies, result->count, 99900u);
+    result->max_ns = latencies[result->count - 1u];
+}
+
+
+static int _parse_args(int argc, char *argv[], _bench_config_t *cfg)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+
+        if (0 == strcmp(arg, "-j"))
+        {
+            cfg->json = true;
+            continue;
+        }
+
+        if (0 == strcmp(arg, "-c"))
+        {
+            cfg->counters = true;
+            continue;
+        }
+
+        if ((i + 1) >= argc)
+        {
+            return -1;
+        }
+
+        const char *val = argv[++i];
+
+        if (0 == strcmp(arg, "-n"))
+        {
+            cfg->key_count = (uint32_t) strtoul(val, NULL, 0);
+        }
+        else if (0 == strcmp(arg, "-o"))
+        {
+            cfg->op_count = (uint32_t) strtoul(val, NULL, 0);
+        }
+        else if (0 == strcmp(arg, "-x"))
+        {
+            if (3 != sscanf(val, "%" SCNu32 "/%" SCNu32 "/%" SCNu32, &cfg->mix[OP_RETRIEVE],
+                            &cfg->mix[OP_INSERT], &cfg->mix[OP_REMOVE]))
+            {
+                return -1;
+            }
+        }
+        else if (0 == strcmp(arg, "-z"))
+        {
+            cfg->zipf_theta = strtod(val, NULL);
+        }
+        else if (0 == strcmp(arg, "-k"))
+        {
+            int fields = sscanf(val, "%" SCNu32 "-%" SCNu32, &cfg->key_min, &cfg->key_max);
+            if (1 == fields)
+            {
+                cfg->key_max = cfg->key_min;
+            }
+            else if (2 != fields)
+            {
+                return -1;
+            }
+        }
+        else if (0 == strcmp(arg, "-v"))
+        {
+            cfg->value_size = (uint32_t) strtoul(val, NULL, 0);
+        }
+        else if (0 == strcmp(arg, "-s"))
+        {
+            cfg->seed = (uint64_t) strtoull(val, NULL, 0);
+        }
+        else if (0 == strcmp(arg, "-m"))
+        {
+            cfg->buffer_size = (size_t) strtoul(val, NULL, 0) * 1024u * 1024u;
+        }
+        else if ((0 == strcmp(arg, "-e")) && (0 == strcmp(val, "chaining")))
+        {
+            cfg->engine = HASHTABLE_ENGINE_CHAINING;
+        }
+        else if ((0 == strcmp(arg, "-e")) && (0 == strcmp(val, "open")))
+        {
+            cfg->engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+        }
+        else if (0 == strcmp(arg, "-f"))
+        {
+            cfg->hash = NULL;
+            for (size_t j = 0u; j < (sizeof(_hash_options) / sizeof(_hash_options[0])); j++)
+            {
+                if (0 == strcmp(val, _hash_options[j].name))
+                {
+                    cfg->hash_name = _hash_options[j].name;
+                    cfg->hash = _hash_options[j].hash;
+                }
+            }
+
+            if (NULL == cfg->hash)
+            {
+                return -1;
+            }
+        }
+        else
+        {
+            return -1;
+        }
+    }
+
+    if ((0u == cfg->key_count) || (100u != (cfg->mix[OP_RETRIEVE] + cfg->mix[OP_INSERT] + cfg->mix[OP_REMOVE])) ||
+        (0.0 > cfg->zipf_theta) || (1.0 <= cfg->zipf_theta) || (sizeof(uint32_t) > cfg->key_min) ||
+        (cfg->key_min > cfg->key_max) || (MAX_DATA_SIZE < cfg->key_max) || (MAX_DATA_SIZE < cfg->value_size))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static void _usage(const char *prog)
+{
+    printf("Usage: %s [options]\n\n", prog);
+    printf("Options:\n");
+    printf("  -n <count>    Number of distinct keys, all inserted before timing (default: %u)\n", DEFAULT_KEY_COUNT);
+    printf("  -o <count>    Number of timed operations (default: %u)\n", DEFAULT_OP_COUNT);
+    printf("  -x <r/i/d>    Percentage of retrieve/insert/remove operations (default: 90/5/5)\n");
+    printf("  -z <theta>    Zipfian key distribution with skew 0 < theta < 1 (default: 0, uniform)\n");
+    printf("  -k <min[-max]> Key size in bytes, 4 to %u (default: 4)\n", MAX_DATA_SIZE);
+    printf("  -v <size>     Value size in bytes, 0 to %u (default: 8)\n", MAX_DATA_SIZE);
+    printf("  -s <seed>     Seed for key and operation generation (default: 1)\n");
+    printf("  -e <engine>   'chaining' or 'open' (default: chaining)\n");
+    printf("  -f <hash>     'fnv1a', 'wyhash' or 'crc32c' (default: fnv1a)\n");
+    printf("  -m <MiB>      Table buffer size in MiB (default: %u)\n", DEFAULT_BUFFER_MIB);
+    printf("  -c            Read hardware counters with perf_event_open (Linux only)\n");
+    printf("  -j            Print results as JSON\n");
+}
+
+
+static void _print_text(const _bench_config_t *cfg, const _op_result_t *results, uint64_t overhead_ns,
+                        uint64_t elapsed_ns)
+{
+    printf("engine=%s hash=%s keys=%" PRIu32 " ops=%" PRIu32 " mix=%" PRIu32 "/%" PRIu32 "/%" PRIu32
+           " zipf=%.2f key_size=%" PRIu32 "-%" PRIu32 " value_size=%" PRIu32 " seed=%" PRIu64 "\n",
+           (HASHTABLE_ENGINE_OPEN_ADDRESSING == cfg->engine) ? "open" : "chaining", cfg->hash_name,
+           cfg->key_count, cfg->op_count, cfg->mix[OP_RETRIEVE], cfg->mix[OP_INSERT], cfg->mix[OP_REMOVE],
+           cfg->zipf_theta, cfg->key_min, cfg->key_max, cfg->value_size, cfg->seed);
+    printf("timer overhead: %" PRIu64 " ns (subtracted from each operation)\n\n", overhead_ns);
+
+    printf("%-10s %10s %7s %8s %8s %8s %8s %10s\n", "op", "count", "hit%", "mean_ns", "p50_ns", "p99_ns",
+           "p999_ns", "max_ns");
+
+    for (int i = 0; i < OP_TYPE_COUNT; i++)
+    {
+        const _op_result_t *r = &results[i];
+        if (0u == r->count)
+        {
+            continue;
+        }
+
+        printf("%-10s %10" PRIu32 " %7.2f %8" PRIu64 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %10" PRIu32 "\n",
+               _op_names[i], r->count, (100.0 * r->hits) / r->count, r->total_ns / r->count, r->p50_ns,
+               r->p99_ns, r->p999_ns, r->max_ns);
+    }
+
+    uint64_t total_ns = results[OP_RETRIEVE].total_ns + results[OP_INSERT].total_ns + results[OP_REMOVE].total_ns;
+    printf("\nthroughput: %.3f Mops/s from operation times, %.3f Mops/s including timing (%.3f s)\n",
+           (total_ns > 0u) ? ((1000.0 * cfg->op_count) / total_ns) : 0.0,
+           (elapsed_ns > 0u) ? ((1000.0 * cfg->op_count) / elapsed_ns) : 0.0, elapsed_ns / 1e9);
+
+    for (size_t i = 0u; cfg->counters && (i < COUNTER_COUNT); i++)
+    {
+        if (_counters[i].valid)
+        {
+            printf("%s/op: %.3f\n", _counters[i].name, (double) _counters[i].value / cfg->op_count);
+        }
+        else
+        {
+            printf("%s/op: unavailable\n", _counters[i].name);
+        }
+    }
+}
+
+
+static void _print_json(const _bench_config_t *cfg, const _op_result_t *results, uint64_t overhead_ns,
+                        uint64_t elapsed_ns)
+{
+    printf("{\n  \"config\": {\"engine\": \"%s\", \"hash\": \"%s\", \"keys\": %" PRIu32 ", \"ops\": %" PRIu32
+           ", \"mix\": [%" PRIu32 ", %" PRIu32 ", %" PRIu32 "], \"zipf_theta\": %.4f, \"key_min\": %" PRIu32
+           ", \"key_max\": %" PRIu32 ", \"value_size\": %" PRIu32 ", \"seed\": %" PRIu64 "},\n",
+           (HASHTABLE_ENGINE_OPEN_ADDRESSING == cfg->engine) ? "open" : "chaining", cfg->hash_name,
+           cfg->key_count, cfg->op_count, cfg->mix[OP_RETRIEVE], cfg->mix[OP_INSERT], cfg->mix[OP_REMOVE],
+           cfg->zipf_theta, cfg->key_min, cfg->key_max, cfg->value_size, cfg->seed);
+    printf("  \"timer_overhead_ns\": %" PRIu64 ",\n", overhead_ns);
+    printf("  \"elapsed_ns\": %" PRIu64 ",\n", elapsed_ns);
+    printf("  \"results\": {");
+
+    for (int i = 0; i < OP_TYPE_COUNT; i++)
+    {
+        const _op_result_t *r = &results[i];
+        printf("%s\n    \"%s\": {\"count\": %" PRIu32 ", \"hits\": %" PRIu32 ", \"mean_ns\": %" PRIu64
+               ", \"p50_ns\": %" PRIu32 ", \"p99_ns\": %" PRIu32 ", \"p999_ns\": %" PRIu32 ", \"max_ns\": %" PRIu32 "}",
+               (0 == i) ? "" : ",", _op_names[i], r->count, r->hits, (0u < r->count) ? (r->total_ns / r->count) : 0u,
+               r->p50_ns, r->p99_ns, r->p999_ns, r->max_ns);
+    }
+
+    printf("\n  },\n  \"counters\": {");
+
+    for (size_t i = 0u; i < COUNTER_COUNT; i++)
+    {
+        printf("%s\"%s\": ", (0u == i) ? "" : ", ", _counters[i].name);
+        if (cfg->counters && _counters[i].valid)
+        {
+            printf("%" PRIu64, _counters[i].value);
+        }
+        else
+        {
+            printf("null");
+        }
+    }
+
+    printf("}\n}\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+    _bench_config_t cfg = {DEFAULT_KEY_COUNT, DEFAULT_OP_COUNT, {90u, 5u, 5u}, 0.0, 4u, 4u, 8u, 1u,
+                           (size_t) DEFAULT_BUFFER_MIB * 1024u * 1024u, HASHTABLE_ENGINE_CHAINING,
+                           "fnv1a", hashtable_hash_fnv1a, false, false};
+
+    if (0 != _parse_args(argc, argv, &cfg))
+    {
+        _usage(argv[0]);
+        return 1;
+    }
+
+    void *buffer = malloc(cfg.buffer_size);
+    uint8_t *op_types = malloc(cfg.op_count);
+    uint32_t *op_keys = malloc(cfg.op_count * sizeof(uint32_t));
+    uint32_t *latencies = malloc(cfg.op_count * sizeof(uint32_t));
+    uint32_t *sorted = malloc(cfg.op_count * sizeof(uint32_t));
+
+    if ((NULL == buffer) || (NULL == op_types) || (NULL == op_keys) || (NULL == latencies) || (NULL == sorted))
+    {
+        printf("Unable to allocate memory\n");
+        return 1;
+    }
+
+    timing_init();
+    _rng_state = _mix64(cfg.seed) | 1u;
+
+    if (0.0 < cfg.zipf_theta)
+    {
+        _zipf_init(&cfg);
+    }
+
+    hashtable_config_t config;
+    hashtable_t table;
+    (void) hashtable_default_config(&config, cfg.buffer_size);
+    config.hash = cfg.hash;
+    config.engine = cfg.engine;
+
+    if (HASHTABLE_ENGINE_OPEN_ADDRESSING == cfg.engine)
+    {
+        // Slots for a 7/8 load with every key stored
+        config.array_count = (uint32_t) (((uint64_t) cfg.key_count * 8u) / 7u) + 1u;
+    }
+
+    if (0 != hashtable_create(&table, &config, buffer, cfg.buffer_size))
+    {
+        printf("hashtable_create failed: %s\n", hashtable_error_message());
+        return 1;
+    }
+
+    char key[MAX_DATA_SIZE];
+    char value[MAX_DATA_SIZE];
+    (void) memset(value, 0xa5, sizeof(value));
+
+    // Store every key, so retrieves hit until keys are removed
+    for (uint32_t i = 0u; i < cfg.key_count; i++)
+    {
+        hashtable_size_t key_size = _make_key(&cfg, i, key);
+        if (0 != hashtable_insert(&table, key, key_size, value, (hashtable_size_t) cfg.value_size))
+        {
+            printf("Unable to store %" PRIu32 " keys, use a larger buffer (-m)\n", cfg.key_count);
+            return 1;
+        }
+    }
+
+    // Generate the whole operation sequence up front, so it is not part of the timed loop
+    for (uint32_t i = 0u; i < cfg.op_count; i++)
+    {
+        uint32_t pick = (uint32_t) (_rng_next() % 100u);
+        op_types[i] = (pick < cfg.mix[OP_RETRIEVE]) ? OP_RETRIEVE :
+                      ((pick < (cfg.mix[OP_RETRIEVE] + cfg.mix[OP_INSERT])) ? OP_INSERT : OP_REMOVE);
+        op_keys[i] = _next_key(&cfg);
+    }
+
+    _op_result_t results[OP_TYPE_COUNT];
+    (void) memset(results, 0, sizeof(results));
+
+    uint64_t overhead_ns = _timer_overhead_ns();
+
+    if (cfg.counters)
+    {
+        _counters_open();
+        _counters_enable(true);
+    }
+
+    uint64_t run_start = timing_nsecs_elapsed();
+
+    for (uint32_t i = 0u; i < cfg.op_count; i++)
+    {
+        hashtable_size_t key_size = _make_key(&cfg, op_keys[i], key);
+        int ret;
+
+        uint64_t start = timing_nsecs_elapsed();
+        switch (op_types[i])
+        {
+            case OP_RETRIEVE:
+                ret = hashtable_retrieve(&table, key, key_size, NULL, NULL);
+                break;
+            case OP_INSERT:
+                ret = hashtable_insert(&table, key, key_size, value, (hashtable_size_t) cfg.value_size);
+                break;
+            default:
+                ret = hashtable_remove(&table, key, key_size);
+                break;
+        }
+        uint64_t elapsed = timing_nsecs_elapsed() - start;
+
+        if ((0 > ret) || ((OP_INSERT == op_types[i]) && (0 != ret)))
+        {
+            printf("Operation %" PRIu32 " failed, use a larger buffer (-m)\n", i);
+            return 1;
+        }
+
+        elapsed = (elapsed > overhead_ns) ? (elapsed - overhead_ns) : 0u;
+        latencies[i] = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t) elapsed;
+
+        _op_result_t *r = &results[op_types[i]];
+        r->count += 1u;
+        r->hits += (0 == ret) ? 1u : 0u;
+        r->total_ns += latencies[i];
+    }
+
+    uint64_t elapsed_ns = timing_nsecs_elapsed() - run_start;
+
+    if (cfg.counters)
+    {
+        _counters_enable(false);
+        _counters_read();
+    }
+
+    for (int type = 0; type < OP_TYPE_COUNT; type++)
+    {
+        uint32_t count = 0u;
+        for (uint32_t i = 0u; i < cfg.op_count; i++)
+        {
+            if (type == op_types[i])
+            {
+                sorted[count++] = latencies[i];
+            }
+        }
+
+        _summarize(&results[type], sorted);
+    }
+
+    if (cfg.json)
+    {
+        _print_json(&cfg, results, overhead_ns, elapsed_ns);
+    }
+    else
+    {
+        _print_text(&cfg, results, overhead_ns, elapsed_ns);
+    }
+
+    free(buffer);
+    free(op_types);
+    free(op_keys);
+    free(latencies);
+    free(sorted);
+
+    return 0;
+}
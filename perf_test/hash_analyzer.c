@@ -0,0 +1,285 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "testing_utils.h"
+#include "hashtable_api.h"
+
+/* Inserts a set of keys into a table and reports the chain length histogram,
+ * the chi-squared score for the spread of keys over the table array, and the
+ * recommended array count, from hashtable_analyze.
+ *
+ * Keys are read from a file, one key per line, or generated if no file is given. */
+
+// Default size of buffer passed to hashtable_create, in MiB
+#define DEFAULT_BUFFER_MIB (256u)
+
+// Default number of generated keys, when no key file is given
+#define DEFAULT_KEY_COUNT (1000000u)
+
+// Max. size of a key read from a key file
+#define MAX_KEY_LINE (1024u)
+
+
+typedef struct
+{
+    const char *name;
+    hashtable_hashfunc_t hash;
+} _hash_option_t;
+
+
+static const _hash_option_t _hash_options[] =
+{
+    {"fnv1a", hashtable_hash_fnv1a},
+    {"wyhash", hashtable_hash_wyhash},
+    {"crc32c", hashtable_hash_crc32c}
+};
+
+
+static void _usage(const char *prog)
+{
+    printf("Usage: %s [options] [key_file]\n\n", prog);
+    printf("Keys are read from key_file, one key per line. If no key file is given,\n");
+    printf("random string keys are generated instead.\n\n");
+    printf("Options:\n");
+    printf("  -a <count>    Table array count (default: chosen by hashtable_default_config)\n");
+    printf("  -e <engine>   'chaining' or 'open' (default: chaining)\n");
+    printf("  -f <hash>     'fnv1a', 'wyhash' or 'crc32c' (default: fnv1a)\n");
+    printf("  -m <MiB>      Table buffer size in MiB (default: %u)\n", DEFAULT_BUFFER_MIB);
+    printf("  -n <count>    Number of keys to generate (default: %u)\n", DEFAULT_KEY_COUNT);
+    printf("  -i            Generate sequential 32-bit integer keys instead of strings\n");
+}
+
+
+static int _insert_key(hashtable_t *table, const char *key, hashtable_size_t key_size)
+{
+    int ret = hashtable_insert(table, key, key_size, NULL, 0u);
+    if (1 == ret)
+    {
+        printf("Table buffer is full after %" PRIu32 " keys, use a larger buffer (-m)\n", table->entry_count);
+    }
+    else if (0 > ret)
+    {
+        printf("hashtable_insert failed: %s\n", hashtable_error_message());
+    }
+
+    return ret;
+}
+
+
+static int _insert_key_file(hashtable_t *table, const char *filename)
+{
+    char line[MAX_KEY_LINE];
+    FILE *fp = fopen(filename, "r");
+    if (NULL == fp)
+    {
+        printf("Unable to open key file '%s'\n", filename);
+        return -1;
+    }
+
+    int ret = 0;
+    while ((0 == ret) && (NULL != fgets(line, sizeof(line), fp)))
+    {
+        size_t len = strcspn(line, "\r\n");
+        if (0u < len)
+        {
+            ret = _insert_key(table, line, (hashtable_size_t) len);
+        }
+    }
+
+    (void) fclose(fp);
+    return ret;
+}
+
+
+static int _insert_generated_keys(hashtable_t *table, uint32_t count, bool int_keys)
+{
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        char key[MAX_STR_LEN + 1u];
+        hashtable_size_t key_size = sizeof(i);
+
+        if (int_keys)
+        {
+            (void) memcpy(key, &i, sizeof(i));
+        }
+        else
+        {
+            rand_str(key, &key_size, false);
+        }
+
+        int ret = _insert_key(table, key, key_size);
+        if (0 != ret)
+        {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+
+static void _print_analysis(hashtable_t *table, hashtable_analysis_t *analysis)
+{
+    const bool open = (HASHTABLE_ENGINE_OPEN_ADDRESSING == table->config.engine);
+    uint32_t max_count = 1u;
+
+    for (uint32_t i = 0u; i < HASHTABLE_ANALYSIS_HISTOGRAM_BINS; i++)
+    {
+        if (analysis->histogram[i] > max_count)
+        {
+            max_count = analysis->histogram[i];
+        }
+    }
+
+    printf("%" PRIu32 " keys, %" PRIu32 " %s, load factor %.3f\n\n", analysis->entry_count,
+           analysis->bucket_count, open ? "slot groups" : "table array slots",
+           (double) analysis->entry_count / (double) table->config.array_count);
+
+    printf("%s\n", open ? "Groups past first probed group: keys" : "Chain length: table array slots");
+
+    for (uint32_t i = 0u; i < HASHTABLE_ANALYSIS_HISTOGRAM_BINS; i++)
+    {
+        int bar = (int) (((uint64_t) analysis->histogram[i] * 50u) / max_count);
+        const char *more = ((HASHTABLE_ANALYSIS_HISTOGRAM_BINS - 1u) == i) ? "+" : " ";
+
+        printf("%5" PRIu32 "%s %10" PRIu32 " %.*s\n", i, more, analysis->histogram[i], bar,
+               "##################################################");
+    }
+
+    double ratio = (0u < analysis->chi_squared_expected) ?
+                   ((double) analysis->chi_squared / (double) analysis->chi_squared_expected) : 0.0;
+
+    printf("\nchi-squared: %" PRIu64 " (%" PRIu32 " expected for a uniform hash, ratio %.3f)\n",
+           analysis->chi_squared, analysis->chi_squared_expected, ratio);
+    printf("recommended array count: %" PRIu32 " (current: %" PRIu32 ")\n",
+           analysis->recommended_array_count, table->config.array_count);
+}
+
+
+int main(int argc, char *argv[])
+{
+    hashtable_config_t config;
+    hashtable_t table;
+    size_t buffer_size = (size_t) DEFAULT_BUFFER_MIB * 1024u * 1024u;
+    uint32_t array_count = 0u;
+    uint32_t key_count = DEFAULT_KEY_COUNT;
+    hashtable_engine_t engine = HASHTABLE_ENGINE_CHAINING;
+    hashtable_hashfunc_t hash = hashtable_hash_fnv1a;
+    const char *key_file = NULL;
+    bool int_keys = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *val = ((i + 1) < argc) ? argv[i + 1] : NULL;
+
+        if (0 == strcmp(arg, "-i"))
+        {
+            int_keys = true;
+            continue;
+        }
+
+        if (('-' != arg[0]) && (NULL == key_file))
+        {
+            key_file = arg;
+            continue;
+        }
+
+        if (NULL == val)
+        {
+            _usage(argv[0]);
+            return 1;
+        }
+
+        i++;
+
+        if (0 == strcmp(arg, "-a"))
+        {
+            array_count = (uint32_t) strtoul(val, NULL, 0);
+        }
+        else if (0 == strcmp(arg, "-n"))
+        {
+            key_count = (uint32_t) strtoul(val, NULL, 0);
+        }
+        else if (0 == strcmp(arg, "-m"))
+        {
+            buffer_size = (size_t) strtoul(val, NULL, 0) * 1024u * 1024u;
+        }
+        else if ((0 == strcmp(arg, "-e")) && (0 == strcmp(val, "chaining")))
+        {
+            engine = HASHTABLE_ENGINE_CHAINING;
+        }
+        else if ((0 == strcmp(arg, "-e")) && (0 == strcmp(val, "open")))
+        {
+            engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+        }
+        else if (0 == strcmp(arg, "-f"))
+        {
+            hash = NULL;
+            for (size_t j = 0u; j < (sizeof(_hash_options) / sizeof(_hash_options[0])); j++)
+            {
+                if (0 == strcmp(val, _hash_options[j].name))
+                {
+                    hash = _hash_options[j].hash;
+                }
+            }
+
+            if (NULL == hash)
+            {
+                _usage(argv[0]);
+                return 1;
+            }
+        }
+        else
+        {
+            _usage(argv[0]);
+            return 1;
+        }
+    }
+
+    void *buffer = malloc(buffer_size);
+    if (NULL == buffer)
+    {
+        printf("Unable to allocate %zu byte table buffer\n", buffer_size);
+        return 1;
+    }
+
+    (void) hashtable_default_config(&config, buffer_size);
+    config.hash = hash;
+    config.engine = engine;
+
+    if (0u < array_count)
+    {
+        config.array_count = array_count;
+    }
+
+    int ret = hashtable_create(&table, &config, buffer, buffer_size);
+    if (0 != ret)
+    {
+        printf("hashtable_create failed: %s\n", (0 > ret) ? hashtable_error_message() : "buffer too small");
+        free(buffer);
+        return 1;
+    }
+
+    srand((unsigned int) time(NULL));
+
+    ret = (NULL != key_file) ? _insert_key_file(&table, key_file) :
+                               _insert_generated_keys(&table, key_count, int_keys);
+
+    hashtable_analysis_t analysis;
+    if ((0 > ret) || (0 != hashtable_analyze(&table, &analysis)))
+    {
+        free(buffer);
+        return 1;
+    }
+
+    _print_analysis(&table, &analysis);
+    free(buffer);
+
+    return 0;
+}
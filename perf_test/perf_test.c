@@ -73,6 +73,19 @@ static void _fmt_int_with_commas(long x, char *output)
 }
 
 
+// Number of table array slots holding at least one key/value pair
+static long _array_slots_used(void)
+{
+    hashtable_stats_t stats;
+    if (0 != hashtable_get_stats(&_table, &stats))
+    {
+        return -1;
+    }
+
+    return (long) stats.buckets_used;
+}
+
+
 static void _fmt_bytes_as_hex(unsigned char *bytes, size_t num_bytes, char *output)
 {
     for (int i = 0; i < num_bytes; i++)
@@ -235,7 +248,7 @@ static int _run_perf_test(bool ascii_only)
 
     char slotsused_str[64u];
     char totalslots_str[64u];
-    _fmt_int_with_commas((long) _table.array_slots_used, slotsused_str);
+    _fmt_int_with_commas(_array_slots_used(), slotsused_str);
     _fmt_int_with_commas((long) _table.config.array_count, totalslots_str);
     test_log("All items inserted, %s remaining, %s/%s array slots used\n",
              rmsize_buf, slotsused_str, totalslots_str);
@@ -307,7 +320,7 @@ static int _run_perf_test(bool ascii_only)
 
     double avg_remove_us = ((double) total_remove_us) / ((double) ITEM_INSERT_COUNT);
 
-    _fmt_int_with_commas((long) _table.array_slots_used, slotsused_str);
+    _fmt_int_with_commas(_array_slots_used(), slotsused_str);
     test_log("All items removed via hashtable_remove, %s/%s array slots used\n", slotsused_str, totalslots_str);
 
     // Verify all remove items are indeed removed, according to hashtable_has_key
@@ -348,7 +361,7 @@ static int _run_perf_test(bool ascii_only)
 
     double avg_after_insert_us = ((double) total_after_insert_us) / ((double) ITEM_INSERT_COUNT);
 
-    _fmt_int_with_commas((long) _table.array_slots_used, slotsused_str);
+    _fmt_int_with_commas(_array_slots_used(), slotsused_str);
     test_log("All items re-inserted, %s/%s array slots used\n", slotsused_str, totalslots_str);
     test_log("Done\n");
 
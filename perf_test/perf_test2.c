@@ -25,6 +25,15 @@ static hashtable_t _table;
 static uint32_t _insert_counter = 0u;
 
 
+#ifdef HASHTABLE_BLOOM_FILTER
+// Fraction of bad keys ruled out by the bloom filter in the last check
+static float _bloom_hit_rate = 0.0f;
+
+// Average time saved for each bad key ruled out by the bloom filter in the last check
+static uint64_t _bloom_saved_ns = 0u;
+#endif // HASHTABLE_BLOOM_FILTER
+
+
 static float _load_factor(hashtable_t *table)
 {
     return ((float) table->entry_count) / ((float) table->config.array_count);
@@ -63,6 +72,52 @@ int _check_for_1k_bad_keys(hashtable_t *table, uint64_t *avg_badkey_ns)
     }
 
     *avg_badkey_ns = timing_usecs_elapsed() - start_us;
+
+#ifdef HASHTABLE_BLOOM_FILTER
+    /* Sort the same bad keys by whether the bloom filter rules them out, and time each group;
+     * keys that get past the filter take as long as all bad keys would without it */
+    static uint32_t rejected_keys[1000u];
+    static uint32_t passed_keys[1000u];
+    uint32_t rejected_count = 0u;
+    uint32_t passed_count = 0u;
+
+    for (uint32_t i = table->entry_count; i < (table->entry_count + 1000u); i++)
+    {
+        if (0 == hashtable_bloom_check(table, (char *) &i, sizeof(i)))
+        {
+            rejected_keys[rejected_count++] = i;
+        }
+        else
+        {
+            passed_keys[passed_count++] = i;
+        }
+    }
+
+    uint64_t rejected_start_us = timing_usecs_elapsed();
+    for (uint32_t i = 0u; i < rejected_count; i++)
+    {
+        (void) hashtable_has_key(table, (char *) &rejected_keys[i], sizeof(rejected_keys[i]));
+    }
+    uint64_t rejected_us = timing_usecs_elapsed() - rejected_start_us;
+
+    uint64_t passed_start_us = timing_usecs_elapsed();
+    for (uint32_t i = 0u; i < passed_count; i++)
+    {
+        (void) hashtable_has_key(table, (char *) &passed_keys[i], sizeof(passed_keys[i]));
+    }
+    uint64_t passed_us = timing_usecs_elapsed() - passed_start_us;
+
+    _bloom_hit_rate = ((float) rejected_count) / 1000.0f;
+    _bloom_saved_ns = 0u;
+
+    if ((0u < rejected_count) && (0u < passed_count))
+    {
+        uint64_t rejected_ns = (rejected_us * 1000u) / rejected_count;
+        uint64_t passed_ns = (passed_us * 1000u) / passed_count;
+        _bloom_saved_ns = (passed_ns > rejected_ns) ? (passed_ns - rejected_ns) : 0u;
+    }
+#endif // HASHTABLE_BLOOM_FILTER
+
     return 0;
 }
 
@@ -102,9 +157,15 @@ static int _insert_2k_items(hashtable_t *table)
         return ret;
     }
 
+#ifdef HASHTABLE_BLOOM_FILTER
+    test_log("entries=%u, lf=%.2f, insrtns=%u, rtrv_ns=%u, badkeyns=%u, bloomhit=%.3f, bloomsavedns=%" PRIu64 "\n",
+             table->entry_count, _load_factor(table), avg_insert_ns, avg_retrieve_ns,
+             avg_badkey_ns, _bloom_hit_rate, _bloom_saved_ns);
+#else
     test_log("entries=%u, lf=%.2f, insrtns=%u, rtrv_ns=%u, badkeyns=%u\n",
              table->entry_count, _load_factor(table), avg_insert_ns, avg_retrieve_ns,
              avg_badkey_ns);
+#endif // HASHTABLE_BLOOM_FILTER
 
     return 0;
 }
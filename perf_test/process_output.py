@@ -21,7 +21,8 @@ def main():
     with open(sys.argv[1], 'r') as fh:
         for line in fh.readlines():
             fields = line.split(']')[1].split()
-            if len(fields) != 5:
+            # 2 extra fields (bloom filter hit rate and time saved) with -DHASHTABLE_BLOOM_FILTER
+            if len(fields) not in [5, 7]:
                 raise ValueError("Malformed output file")
 
             entry_count = int(fields[0].split("=")[1].rstrip(','))
@@ -1,3 +1,8 @@
+#if defined(__linux__)
+// For clock_gettime
+#define _POSIX_C_SOURCE 199309L
+#endif // __linux__
+
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
@@ -10,6 +15,7 @@
 static uint64_t _perf_freq;
 #elif defined(__linux__)
 #include <sys/time.h>
+#include <time.h>
 #else
 #error "Platform not supported"
 #endif // _WIN32
@@ -101,6 +107,30 @@ uint64_t timing_usecs_elapsed(void)
 #endif // _WIN32
 }
 
+
+// Utility function for getting a monotonic timestamp in nanoseconds
+uint64_t timing_nsecs_elapsed(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER tcounter = {0};
+    uint64_t tick_value = 0u;
+    if (QueryPerformanceCounter(&tcounter) != 0)
+    {
+        tick_value = tcounter.QuadPart;
+    }
+
+    // Split the conversion so the multiplication can't overflow
+    return ((tick_value / _perf_freq) * 1000000000ULL) +
+           (((tick_value % _perf_freq) * 1000000000ULL) / _perf_freq);
+#elif defined(__linux__)
+    struct timespec timer = {.tv_sec=0, .tv_nsec=0};
+    (void) clock_gettime(CLOCK_MONOTONIC, &timer);
+    return (uint64_t) ((timer.tv_sec * 1000000000LL) + timer.tv_nsec);
+#else
+#error "Platform not supported"
+#endif // _WIN32
+}
+
 // Utility function to log a message to stdout with a timestamp
 void test_log(const char *fmt, ...)
 {
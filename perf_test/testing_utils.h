@@ -22,6 +22,8 @@ void timing_init(void);
 
 uint64_t timing_usecs_elapsed(void);
 
+uint64_t timing_nsecs_elapsed(void);
+
 void test_log(const char *fmt, ...);
 
 int rand_range(int lower, int upper);
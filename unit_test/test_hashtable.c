@@ -1,11 +1,17 @@
 #include "unity.h"
 #include "hashtable_api.h"
+#include "hashtable_fixed.h"
 
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
 
+#if defined(HASHTABLE_CONCURRENT) || defined(HASHTABLE_RCU)
+#include <pthread.h>
+#include <stdio.h>
+#endif // HASHTABLE_CONCURRENT || HASHTABLE_RCU
+
 
 // Min. size of a randomly-generated key or value
 #define MIN_STR_LEN (4u)
@@ -27,6 +33,9 @@ typedef struct
 
 static uint8_t _buffer[1024 * 1024];
 
+// Second buffer, used as the destination for resize tests
+static uint8_t _resize_buffer[1024 * 1024 * 2];
+
 
 static int _rand_range(int lower, int upper)
 {
@@ -179,7 +188,10 @@ void test_hashtable_create_null_table(void)
 void test_hashtable_create_null_hash_func(void)
 {
     hashtable_t table;
-    hashtable_config_t config = {NULL, 32u};
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = NULL;
+    config.array_count = 32u;
     TEST_ASSERT_EQUAL_INT(-1, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
 }
 
@@ -213,6 +225,32 @@ void test_hashtable_create_buffer_size_too_small(void)
 }
 
 
+// Tests that hashtable_fragmentation returns -1 when a NULL table pointer is passed
+void test_hashtable_fragmentation_null_table(void)
+{
+    hashtable_fragmentation_t info;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_fragmentation(NULL, &info));
+}
+
+
+// Tests that hashtable_compact returns -1 when a NULL table pointer is passed
+void test_hashtable_compact_null_table(void)
+{
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_compact(NULL));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_compact_incremental(NULL));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_compact_step(NULL, 0u));
+}
+
+
+// Tests that hashtable_attach returns -1 when a NULL table or buffer pointer is passed
+void test_hashtable_attach_null_table(void)
+{
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(NULL, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(&table, NULL, NULL, sizeof(_buffer)));
+}
+
+
 // Tests that hashtable_insert returns an error when a NULL table is passed
 void test_hashtable_insert_null_table(void)
 {
@@ -380,7 +418,7 @@ void test_hashtable_clear_null_table(void)
 // Tests that hashtable_insert returns 1 when no space is available in the buffer
 void test_hashtable_insert_buffer_full(void)
 {
-    uint8_t test_buf[512];
+    uint8_t test_buf[HASHTABLE_MIN_BUFFER_SIZE(1u) + 400u];
 
     hashtable_config_t config;
     TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
@@ -955,6 +993,3143 @@ void test_hashtable_insert_retrieve_clear_insertagain_clearagain(void)
 }
 
 
+// Hash function that returns the same value for all keys, forces every key into one list
+static uint32_t _constant_hash(const char *data, const hashtable_size_t size)
+{
+    (void) data;
+    (void) size;
+    return 0x1234u;
+}
+
+
+// Tests that items can be inserted, retrieved and removed when all keys have the same hash value
+void test_hashtable_insert_retrieve_remove_colliding_hashes(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _constant_hash;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 200;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items);
+    _verify_table_contents(&table, pairs, num_items);
+
+    _remove_random_items(&table, pairs, num_items, 100);
+    _verify_table_contents(&table, pairs, num_items);
+    _verify_iterated_table_contents(&table, pairs, num_items, 100);
+}
+
+
+// Tests that all items can be retrieved and iterated after a blocking resize into a larger
+// buffer, and that the table no longer uses the old buffer afterwards
+void test_hashtable_resize_all_items_migrated(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.array_count = 64u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items);
+    _remove_random_items(&table, pairs, num_items, 250);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize(&table, _resize_buffer, sizeof(_resize_buffer), 4096u));
+    TEST_ASSERT_EQUAL_INT(4096u, table.config.array_count);
+    TEST_ASSERT_EQUAL_INT(num_items - 250, table.entry_count);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize_step(&table, 0u));
+
+    // Trash the old buffer, table should not be using it anymore
+    (void) memset(_buffer, 0xff, sizeof(_buffer));
+
+    _verify_table_contents(&table, pairs, num_items);
+    _verify_iterated_table_contents(&table, pairs, num_items, 250);
+}
+
+
+// Tests that hashtable_resize returns 1 and leaves the table unchanged when the new buffer is too small
+void test_hashtable_resize_buffer_too_small(void)
+{
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, NULL, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 100;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items);
+
+    TEST_ASSERT_EQUAL_INT(1, hashtable_resize(&table, _resize_buffer, HASHTABLE_MIN_BUFFER_SIZE(10u) + 64u, 10u));
+    TEST_ASSERT_EQUAL_PTR(_buffer, table.table_data);
+
+    _verify_table_contents(&table, pairs, num_items);
+
+    // Overlapping buffers are not allowed
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_resize(&table, _buffer + 64, sizeof(_buffer) - 64, 0u));
+}
+
+
+// Tests that the table can be used normally while an incremental resize is in progress,
+// and that the old buffer is no longer used once the resize is complete
+void test_hashtable_resize_incremental(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.array_count = 64u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items - 200);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize_incremental(&table, _resize_buffer, sizeof(_resize_buffer), 2048u));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_resize_step(&table, 0u));
+
+    // Insert, remove and retrieve items while the resize is in progress
+    _generate_random_items_and_insert(&table, pairs + (num_items - 200), 200);
+    _remove_random_items(&table, pairs, num_items, 300);
+    _verify_table_contents(&table, pairs, num_items);
+
+    // Finish the resize, and trash the old buffer
+    while (1 == hashtable_resize_step(&table, 16u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize_step(&table, 0u));
+    (void) memset(_buffer, 0xff, sizeof(_buffer));
+
+    TEST_ASSERT_EQUAL_INT(num_items - 300, table.entry_count);
+    _verify_table_contents(&table, pairs, num_items);
+    _verify_iterated_table_contents(&table, pairs, num_items, 300);
+}
+
+// Tests that 1000 items can be inserted, retrieved, removed and iterated with the open addressing engine
+void test_hashtable_open_addressing_insert1000items_remove500(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    config.array_count = 2048u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items);
+    _verify_table_contents(&table, pairs, num_items);
+
+    _remove_random_items(&table, pairs, num_items, 500);
+    TEST_ASSERT_EQUAL_INT(num_items - 500, table.entry_count);
+    _verify_table_contents(&table, pairs, num_items);
+    _verify_iterated_table_contents(&table, pairs, num_items, 500);
+}
+
+
+// Tests that repeatedly filling and emptying a small open addressing table does not run out
+// of slots, i.e. that slots marked as deleted are re-used
+void test_hashtable_open_addressing_insert_remove_churn(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    config.hash = _constant_hash;
+    config.array_count = 64u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 48;
+    _test_keyval_pair_t pairs[num_items];
+
+    for (unsigned int i = 0u; i < 50u; i++)
+    {
+        _generate_random_items_and_insert(&table, pairs, num_items);
+        _verify_table_contents(&table, pairs, num_items);
+
+        _remove_random_items(&table, pairs, num_items, num_items);
+        TEST_ASSERT_EQUAL_INT(0, table.entry_count);
+    }
+}
+
+
+// Tests that inserting into an open addressing table with no more usable slots returns 1
+void test_hashtable_open_addressing_slots_full(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    config.array_count = 10u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    // Array count is rounded up to one group, 7/8ths of which can be used
+    TEST_ASSERT_EQUAL_INT(16u, table.config.array_count);
+
+    const unsigned int num_items = 14;
+    _test_keyval_pair_t pairs[num_items];
+    _generate_random_items_and_insert(&table, pairs, num_items);
+
+    TEST_ASSERT_EQUAL_INT(1, hashtable_insert(&table, "extra-key", 9u, "value", 5u));
+    _verify_table_contents(&table, pairs, num_items);
+}
+
+
+// Tests that open addressing tables can be resized incrementally while in use
+void test_hashtable_open_addressing_resize_incremental(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    config.array_count = 1024u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, 800);
+
+    // Not enough slots for the stored items
+    TEST_ASSERT_EQUAL_INT(1, hashtable_resize(&table, _resize_buffer, sizeof(_resize_buffer), 512u));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize_incremental(&table, _resize_buffer, sizeof(_resize_buffer), 4096u));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_resize_step(&table, 0u));
+
+    _generate_random_items_and_insert(&table, pairs + 800, 200);
+    _remove_random_items(&table, pairs, num_items, 300);
+    _verify_table_contents(&table, pairs, num_items);
+
+    while (1 == hashtable_resize_step(&table, 16u));
+    (void) memset(_buffer, 0xff, sizeof(_buffer));
+
+    TEST_ASSERT_EQUAL_INT(4096u, table.config.array_count);
+    TEST_ASSERT_EQUAL_INT(num_items - 300, table.entry_count);
+    _verify_table_contents(&table, pairs, num_items);
+    _verify_iterated_table_contents(&table, pairs, num_items, 300);
+}
+
+// Tests that space held by removed items is reported, and is re-used when the same items are re-inserted
+void test_hashtable_fragmentation_remove_reinsert(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    hashtable_fragmentation_t info;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table, &info));
+    TEST_ASSERT_EQUAL_INT(0u, info.free_bytes);
+    TEST_ASSERT_EQUAL_INT(0u, info.free_blocks);
+    TEST_ASSERT_EQUAL_INT(0u, info.largest_free_block);
+
+    const unsigned int num_items = 500;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items);
+
+    size_t bytes_remaining = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table, &bytes_remaining));
+
+    _remove_random_items(&table, pairs, num_items, 200);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table, &info));
+    TEST_ASSERT_EQUAL_INT(200u, info.free_blocks);
+    TEST_ASSERT_TRUE(info.free_bytes > 0u);
+    TEST_ASSERT_TRUE(info.largest_free_block <= info.free_bytes);
+
+    // Re-insert removed items, they should fit exactly in the freed space
+    for (unsigned int i = 0u; i < num_items; i++)
+    {
+        if (pairs[i].removed)
+        {
+            TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, pairs[i].key, pairs[i].key_size,
+                                                      pairs[i].value, pairs[i].value_size));
+            pairs[i].removed = false;
+        }
+    }
+
+    size_t bytes_remaining_after = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table, &bytes_remaining_after));
+    TEST_ASSERT_EQUAL_INT(bytes_remaining, bytes_remaining_after);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table, &info));
+    TEST_ASSERT_EQUAL_INT(0u, info.free_bytes);
+    TEST_ASSERT_EQUAL_INT(0u, info.free_blocks);
+    _verify_table_contents(&table, pairs, num_items);
+}
+
+
+// Tests that a large removed item is split up to store smaller items, without using more of the buffer
+void test_hashtable_fragmentation_split_large_free_block(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    char big_value[512];
+    (void) memset(big_value, 0xcc, sizeof(big_value));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, "big", 3u, big_value, sizeof(big_value)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, "big", 3u));
+
+    hashtable_fragmentation_t info;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table, &info));
+    TEST_ASSERT_EQUAL_INT(1u, info.free_blocks);
+    TEST_ASSERT_EQUAL_INT(info.free_bytes, info.largest_free_block);
+    size_t free_bytes = info.free_bytes;
+
+    size_t bytes_remaining = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table, &bytes_remaining));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, "small1", 6u, "value1", 6u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, "small2", 6u, "value2", 6u));
+
+    size_t bytes_remaining_after = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table, &bytes_remaining_after));
+    TEST_ASSERT_EQUAL_INT(bytes_remaining, bytes_remaining_after);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table, &info));
+    TEST_ASSERT_EQUAL_INT(1u, info.free_blocks);
+    TEST_ASSERT_TRUE(info.free_bytes < free_bytes);
+
+    char *value = NULL;
+    size_t value_size = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, "small1", 6u, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(value, "value1", 6u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, "small2", 6u, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(value, "value2", 6u));
+}
+
+// Overwrite some stored values with smaller values, so the table has some unused space that
+// is too small to be re-used by new items
+static void _shrink_random_values(hashtable_t *table, _test_keyval_pair_t *pairs, unsigned int num_items)
+{
+    for (unsigned int i = 0u; i < num_items; i += 7u)
+    {
+        if (!pairs[i].removed && (pairs[i].value_size > 1u))
+        {
+            pairs[i].value_size -= 1u;
+            TEST_ASSERT_EQUAL_INT(0, hashtable_insert(table, pairs[i].key, pairs[i].key_size,
+                                                      pairs[i].value, pairs[i].value_size));
+        }
+    }
+}
+
+
+// Insert items, remove some, and verify that compacting the table returns all the removed space
+static void _compact_and_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+    config.array_count = 2048u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    size_t bytes_remaining_empty = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table, &bytes_remaining_empty));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items);
+
+    size_t bytes_remaining_full = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table, &bytes_remaining_full));
+
+    _remove_random_items(&table, pairs, num_items, 500);
+    _shrink_random_values(&table, pairs, num_items);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact(&table));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact_step(&table, 0u));
+
+    size_t bytes_remaining = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table, &bytes_remaining));
+    TEST_ASSERT_TRUE(bytes_remaining > bytes_remaining_full);
+
+    hashtable_fragmentation_t info;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table, &info));
+    TEST_ASSERT_EQUAL_INT(0u, info.free_bytes);
+
+    TEST_ASSERT_EQUAL_INT(num_items - 500, table.entry_count);
+    _verify_table_contents(&table, pairs, num_items);
+    _verify_iterated_table_contents(&table, pairs, num_items, 500);
+
+    // Remove all remaining items, compacting should give back the whole data section
+    for (unsigned int i = 0u; i < num_items; i++)
+    {
+        if (!pairs[i].removed)
+        {
+            TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, pairs[i].key, pairs[i].key_size));
+            pairs[i].removed = true;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact(&table));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table, &bytes_remaining));
+    TEST_ASSERT_EQUAL_INT(bytes_remaining_empty, bytes_remaining);
+}
+
+
+// Tests that hashtable_compact returns space held by removed items, and that all remaining items
+// can be retrieved and iterated afterwards
+void test_hashtable_compact_reclaims_removed_space(void)
+{
+    _compact_and_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Same as test_hashtable_compact_reclaims_removed_space, but with the open addressing engine
+void test_hashtable_open_addressing_compact_reclaims_removed_space(void)
+{
+    _compact_and_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Tests that a table can be compacted incrementally while in use
+void test_hashtable_compact_incremental(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.array_count = 64u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items - 200);
+    _remove_random_items(&table, pairs, num_items - 200, 300);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact_step(&table, 1024u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact_incremental(&table));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_compact_step(&table, 1024u));
+
+    // Iteration cursor should survive pairs being moved
+    char *key = NULL;
+    char *value = NULL;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_reset_cursor(&table));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_next_item(&table, &key, NULL, &value, NULL));
+
+    // Insert, remove, overwrite and retrieve items while the compaction is in progress
+    _generate_random_items_and_insert(&table, pairs + (num_items - 200), 200);
+    TEST_ASSERT_EQUAL_INT(1, hashtable_compact_step(&table, 1024u));
+    _remove_random_items(&table, pairs, num_items, 100);
+    _shrink_random_values(&table, pairs, num_items);
+    _verify_table_contents(&table, pairs, num_items);
+
+    while (1 == hashtable_compact_step(&table, 1024u))
+    {
+        _verify_table_contents(&table, pairs, num_items);
+    }
+
+    TEST_ASSERT_EQUAL_INT(num_items - 400, table.entry_count);
+    _verify_table_contents(&table, pairs, num_items);
+    _verify_iterated_table_contents(&table, pairs, num_items, 400);
+}
+
+
+// Tests that compaction cannot be started while an incremental resize is in progress
+void test_hashtable_compact_during_resize(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.array_count = 64u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 100;
+    _test_keyval_pair_t pairs[num_items];
+    _generate_random_items_and_insert(&table, pairs, num_items);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize_incremental(&table, _resize_buffer, sizeof(_resize_buffer), 256u));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_compact(&table));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_compact_incremental(&table));
+
+    while (1 == hashtable_resize_step(&table, 16u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact(&table));
+    _verify_table_contents(&table, pairs, num_items);
+}
+
+
+// Creates a table with some removed items, attaches a second hashtable instance to the same
+// buffer (and, if HASHTABLE_OFFSET_POINTERS is defined, to a copy of the buffer), and verifies
+// that all remaining items can be retrieved and iterated through the second instance
+static void _attach_and_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+    config.array_count = 2048u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items - 200);
+    _remove_random_items(&table, pairs, num_items - 200, 400);
+
+    hashtable_fragmentation_t info;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table, &info));
+
+    hashtable_t attached;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_attach(&attached, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(num_items - 600, attached.entry_count);
+    TEST_ASSERT_EQUAL_INT(engine, attached.config.engine);
+    TEST_ASSERT_EQUAL_INT(table.config.array_count, attached.config.array_count);
+
+    hashtable_fragmentation_t attached_info;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&attached, &attached_info));
+    TEST_ASSERT_EQUAL_INT(info.free_bytes, attached_info.free_bytes);
+    TEST_ASSERT_EQUAL_INT(info.free_blocks, attached_info.free_blocks);
+
+    _verify_table_contents(&attached, pairs, num_items - 200);
+    _verify_iterated_table_contents(&attached, pairs, num_items - 200, 400);
+
+    // Copy the buffer somewhere else, and scribble over the original
+    (void) memcpy(_resize_buffer, _buffer, sizeof(_buffer));
+    (void) memset(_buffer, 0xff, sizeof(_buffer));
+
+#ifdef HASHTABLE_OFFSET_POINTERS
+    TEST_ASSERT_EQUAL_INT(0, hashtable_attach(&attached, NULL, _resize_buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(num_items - 600, attached.entry_count);
+
+    // Table in the copied buffer should be fully usable
+    _generate_random_items_and_insert(&attached, pairs + (num_items - 200), 200);
+    _verify_table_contents(&attached, pairs, num_items);
+    _verify_iterated_table_contents(&attached, pairs, num_items, 400);
+#else
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(&attached, NULL, _resize_buffer, sizeof(_buffer)));
+#endif // HASHTABLE_OFFSET_POINTERS
+}
+
+
+// Tests that hashtable_attach adopts a table created in an existing buffer
+void test_hashtable_attach_existing_buffer(void)
+{
+    _attach_and_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Tests that hashtable_attach adopts an open addressing table created in an existing buffer
+void test_hashtable_open_addressing_attach_existing_buffer(void)
+{
+    _attach_and_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Tests that hashtable_attach rejects buffers that do not hold a valid table
+void test_hashtable_attach_invalid_buffer(void)
+{
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, NULL, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 100;
+    _test_keyval_pair_t pairs[num_items];
+    _generate_random_items_and_insert(&table, pairs, num_items);
+
+    hashtable_t attached;
+
+    // Buffer is too small to hold the table
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(&attached, NULL, _buffer, HASHTABLE_MIN_BUFFER_SIZE(10u)));
+
+    // Table was not created with this hash function
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _constant_hash;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(&attached, &config, _buffer, sizeof(_buffer)));
+
+    // Corrupt the start of the buffer
+    _buffer[0] ^= 0xffu;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(&attached, NULL, _buffer, sizeof(_buffer)));
+    _buffer[0] ^= 0xffu;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_attach(&attached, NULL, _buffer, sizeof(_buffer)));
+
+    // Corrupt the link and size fields of a stored pair
+    char *key = NULL;
+    char *value = NULL;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_next_item(&table, &key, NULL, &value, NULL));
+    (void) memset(key - sizeof(_keyval_pair_t), 0xff, sizeof(_keyval_pair_t));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(&attached, NULL, _buffer, sizeof(_buffer)));
+}
+
+
+// In-memory stream used for snapshot tests
+typedef struct
+{
+    uint8_t *data;
+    size_t size;
+    size_t pos;
+} _test_stream_t;
+
+
+static uint8_t _snapshot_buffer[1024 * 128];
+
+
+static int _test_stream_write(void *ctx, const void *data, size_t size)
+{
+    _test_stream_t *stream = (_test_stream_t *) ctx;
+    if (size > (stream->size - stream->pos))
+    {
+        return -1;
+    }
+
+    (void) memcpy(stream->data + stream->pos, data, size);
+    stream->pos += size;
+    return 0;
+}
+
+
+static int _test_stream_read(void *ctx, void *data, size_t size)
+{
+    _test_stream_t *stream = (_test_stream_t *) ctx;
+    if (size > (stream->size - stream->pos))
+    {
+        return -1;
+    }
+
+    (void) memcpy(data, stream->data + stream->pos, size);
+    stream->pos += size;
+    return 0;
+}
+
+
+// Tests that hashtable_save and hashtable_load return -1 when NULL pointers are passed
+void test_hashtable_save_load_null_table(void)
+{
+    hashtable_t table;
+    _test_stream_t stream = {_snapshot_buffer, sizeof(_snapshot_buffer), 0u};
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_save(NULL, _test_stream_write, &stream));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_save(&table, NULL, &stream));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_load(NULL, _test_stream_read, &stream));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_load(&table, NULL, &stream));
+}
+
+
+// Tests that a snapshot saved from a table with removed items can be loaded into a table
+// using the other engine, and into a table in a smaller buffer
+void test_hashtable_save_load_all_items_restored(void)
+{
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, NULL, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    _generate_random_items_and_insert(&table, pairs, num_items);
+    _remove_random_items(&table, pairs, num_items, 500);
+
+    // Saving should not move the iteration cursor
+    char *key = NULL;
+    char *value = NULL;
+    char *next_key = NULL;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_reset_cursor(&table));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_next_item(&table, &key, NULL, &value, NULL));
+
+    _test_stream_t stream = {_snapshot_buffer, sizeof(_snapshot_buffer), 0u};
+    TEST_ASSERT_EQUAL_INT(0, hashtable_save(&table, _test_stream_write, &stream));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_next_item(&table, &next_key, NULL, &value, NULL));
+    TEST_ASSERT_TRUE(key != next_key);
+
+    // Load into an open addressing table
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_resize_buffer)));
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    config.array_count = 1024u;
+
+    hashtable_t loaded;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&loaded, &config, _resize_buffer, sizeof(_resize_buffer)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&loaded, "stale", 5u, "item", 4u));
+
+    size_t snapshot_size = stream.pos;
+    stream.size = snapshot_size;
+    stream.pos = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_load(&loaded, _test_stream_read, &stream));
+    TEST_ASSERT_EQUAL_INT(snapshot_size, stream.pos);
+
+    TEST_ASSERT_EQUAL_INT(num_items - 500, loaded.entry_count);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_has_key(&loaded, "stale", 5u));
+    _verify_table_contents(&loaded, pairs, num_items);
+    _verify_iterated_table_contents(&loaded, pairs, num_items, 500);
+
+    // Load back into the original buffer, with a smaller array count
+    config.engine = HASHTABLE_ENGINE_CHAINING;
+    config.array_count = 64u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    stream.pos = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_load(&table, _test_stream_read, &stream));
+    TEST_ASSERT_EQUAL_INT(num_items - 500, table.entry_count);
+    _verify_table_contents(&table, pairs, num_items);
+    _verify_iterated_table_contents(&table, pairs, num_items, 500);
+}
+
+
+// Tests that hashtable_load rejects corrupt or truncated snapshots, and leaves the table empty
+void test_hashtable_load_invalid_snapshot(void)
+{
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, NULL, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 100;
+    _test_keyval_pair_t pairs[num_items];
+    _generate_random_items_and_insert(&table, pairs, num_items);
+
+    _test_stream_t stream = {_snapshot_buffer, sizeof(_snapshot_buffer), 0u};
+    TEST_ASSERT_EQUAL_INT(0, hashtable_save(&table, _test_stream_write, &stream));
+    size_t snapshot_size = stream.pos;
+
+    // Flip one bit of key/value data (the last value byte before the checksum trailer)
+    _snapshot_buffer[snapshot_size - 5u] ^= 0x01u;
+    stream.size = snapshot_size;
+    stream.pos = 0u;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_load(&table, _test_stream_read, &stream));
+    TEST_ASSERT_EQUAL_INT(0, table.entry_count);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_has_key(&table, pairs[0].key, pairs[0].key_size));
+    _snapshot_buffer[snapshot_size - 5u] ^= 0x01u;
+
+    // Truncated snapshot
+    stream.size = snapshot_size - 1u;
+    stream.pos = 0u;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_load(&table, _test_stream_read, &stream));
+    TEST_ASSERT_EQUAL_INT(0, table.entry_count);
+
+    // Invalid header
+    _snapshot_buffer[0] ^= 0xffu;
+    stream.size = snapshot_size;
+    stream.pos = 0u;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_load(&table, _test_stream_read, &stream));
+    _snapshot_buffer[0] ^= 0xffu;
+
+    // Not enough space in table buffer
+    uint8_t small_buf[HASHTABLE_MIN_BUFFER_SIZE(10u) + 256u];
+    hashtable_t small_table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&small_table, NULL, small_buf, sizeof(small_buf)));
+    stream.pos = 0u;
+    TEST_ASSERT_EQUAL_INT(1, hashtable_load(&small_table, _test_stream_read, &stream));
+    TEST_ASSERT_EQUAL_INT(0, small_table.entry_count);
+
+    // Valid snapshot
+    stream.pos = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_load(&table, _test_stream_read, &stream));
+    _verify_table_contents(&table, pairs, num_items);
+}
+
+
+// Tests that the batch functions return -1 when NULL pointers or empty keys are passed
+void test_hashtable_batch_null_table(void)
+{
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, NULL, _buffer, sizeof(_buffer)));
+
+    const char *keys[2] = {"abc", NULL};
+    hashtable_size_t key_sizes[2] = {3u, 3u};
+    int results[2];
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_retrieve_batch(NULL, keys, key_sizes, 1u, NULL, NULL, results));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_retrieve_batch(&table, keys, key_sizes, 1u, NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_retrieve_batch(&table, keys, key_sizes, 2u, NULL, NULL, results));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_has_key_batch(NULL, keys, key_sizes, 1u, results));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_has_key_batch(&table, NULL, key_sizes, 1u, results));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_insert_batch(NULL, keys, key_sizes, NULL, NULL, 1u, results));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_insert_batch(&table, keys, NULL, NULL, NULL, 1u, results));
+
+    key_sizes[0] = 0u;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_insert_batch(&table, keys, key_sizes, NULL, NULL, 1u, results));
+}
+
+
+// Inserts items with hashtable_insert_batch, removes some, and verifies hashtable_retrieve_batch
+// and hashtable_has_key_batch give the same results as hashtable_retrieve and hashtable_has_key
+static void _batch_insert_retrieve_and_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+    config.array_count = 2048u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+    const char *keys[num_items];
+    const char *values[num_items];
+    hashtable_size_t key_sizes[num_items];
+    hashtable_size_t value_sizes[num_items];
+    int results[num_items];
+
+    for (unsigned int i = 0u; i < num_items; i++)
+    {
+        _rand_str(pairs[i].key, &pairs[i].key_size);
+        _rand_str(pairs[i].value, &pairs[i].value_size);
+        pairs[i].removed = false;
+
+        keys[i] = pairs[i].key;
+        key_sizes[i] = pairs[i].key_size;
+        values[i] = pairs[i].value;
+        value_sizes[i] = pairs[i].value_size;
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert_batch(&table, keys, key_sizes, values, value_sizes,
+                                                    num_items, results));
+    for (unsigned int i = 0u; i < num_items; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, results[i]);
+    }
+
+    TEST_ASSERT_EQUAL_INT(num_items, table.entry_count);
+    _remove_random_items(&table, pairs, num_items, 300);
+
+    // Look keys up while an incremental resize is in progress
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize_incremental(&table, _resize_buffer, sizeof(_resize_buffer), 4096u));
+
+    char *batch_values[num_items];
+    hashtable_size_t batch_value_sizes[num_items];
+    TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve_batch(&table, keys, key_sizes, num_items,
+                                                      batch_values, batch_value_sizes, results));
+
+    for (unsigned int i = 0u; i < num_items; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(pairs[i].removed ? 1 : 0, results[i]);
+        if (!pairs[i].removed)
+        {
+            TEST_ASSERT_EQUAL_INT(pairs[i].value_size, batch_value_sizes[i]);
+            TEST_ASSERT_EQUAL_INT(0, memcmp(pairs[i].value, batch_values[i], batch_value_sizes[i]));
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_has_key_batch(&table, keys, key_sizes, num_items, results));
+    for (unsigned int i = 0u; i < num_items; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(pairs[i].removed ? 0 : 1, results[i]);
+    }
+
+    _verify_table_contents(&table, pairs, num_items);
+}
+
+
+// Tests the batch functions with a separate chaining table
+void test_hashtable_batch_insert_retrieve(void)
+{
+    _batch_insert_retrieve_and_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Tests the batch functions with an open addressing table
+void test_hashtable_open_addressing_batch_insert_retrieve(void)
+{
+    _batch_insert_retrieve_and_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Tests that hashtable_insert_batch reports which items did not fit in the buffer
+void test_hashtable_insert_batch_buffer_full(void)
+{
+    uint8_t buf[HASHTABLE_MIN_BUFFER_SIZE(10u) + 256u];
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(buf)));
+    config.array_count = 10u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, buf, sizeof(buf)));
+
+    const char *keys[40];
+    hashtable_size_t key_sizes[40];
+    char key_data[40][4];
+    int results[40];
+
+    for (unsigned int i = 0u; i < 40u; i++)
+    {
+        key_data[i][0] = 'k';
+        key_data[i][1] = (char) ('a' + (i / 26u));
+        key_data[i][2] = (char) ('a' + (i % 26u));
+        key_data[i][3] = '\0';
+        keys[i] = key_data[i];
+        key_sizes[i] = 3u;
+    }
+
+    TEST_ASSERT_EQUAL_INT(1, hashtable_insert_batch(&table, keys, key_sizes, NULL, NULL, 40u, results));
+
+    unsigned int inserted = 0u;
+    for (unsigned int i = 0u; i < 40u; i++)
+    {
+        TEST_ASSERT_TRUE((0 == results[i]) || (1 == results[i]));
+        TEST_ASSERT_EQUAL_INT((0 == results[i]) ? 1 : 0, hashtable_has_key(&table, keys[i], key_sizes[i]));
+        inserted += (0 == results[i]) ? 1u : 0u;
+    }
+
+    TEST_ASSERT_TRUE((0u < inserted) && (40u > inserted));
+    TEST_ASSERT_EQUAL_INT(inserted, table.entry_count);
+}
+
+
+// Tests that the kind and message of the last error are reported, and that reaching
+// the end of an iteration is not recorded as an error
+void test_hashtable_last_error(void)
+{
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_create(NULL, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_NULL_POINTER, hashtable_last_error());
+    TEST_ASSERT_EQUAL_STRING("NULL pointer passed to function", hashtable_error_message());
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_insert(&table, "key", 0u, NULL, 0u));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_INVALID_PARAM, hashtable_last_error());
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, "key", 3u, "value", 5u));
+
+    char *key = NULL;
+    char *value = NULL;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_next_item(&table, &key, NULL, &value, NULL));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_next_item(&table, &key, NULL, &value, NULL));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_INVALID_PARAM, hashtable_last_error());
+    TEST_ASSERT_EQUAL_STRING("Invalid size value passed to function", hashtable_error_message());
+
+    hashtable_t attached;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(&attached, NULL, _resize_buffer, 16u));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_INVALID_BUFFER, hashtable_last_error());
+}
+
+
+// MurmurHash3 finalizer, applied by hashtable_hash_crc32c to the CRC value
+static uint32_t _fmix32(uint32_t hash)
+{
+    hash ^= hash >> 16u;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13u;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16u;
+    return hash;
+}
+
+
+static uint32_t _wyhash_seeded_test(const char *data, const hashtable_size_t size)
+{
+    return hashtable_hash_wyhash_seeded(data, size, 0x0123456789abcdefull);
+}
+
+
+// Tests the built-in hash functions give known values, and spread similar keys evenly
+void test_hashtable_builtin_hash_functions(void)
+{
+    hashtable_hashfunc_t funcs[] = {hashtable_hash_fnv1a, hashtable_hash_wyhash, hashtable_hash_crc32c,
+                                    _wyhash_seeded_test};
+    const uint32_t num_buckets = 64u;
+    const uint32_t num_keys = 6400u;
+
+    TEST_ASSERT_EQUAL_UINT32(0xbb86b11cu, hashtable_hash_fnv1a("123456789", 9u));
+    TEST_ASSERT_EQUAL_UINT32(_fmix32(0xe3069283u), hashtable_hash_crc32c("123456789", 9u));
+
+    // Seed 0 is the same as the unseeded function, and other seeds change the hash
+    TEST_ASSERT_EQUAL_UINT32(hashtable_hash_wyhash("123456789", 9u), hashtable_hash_wyhash_seeded("123456789", 9u, 0u));
+    TEST_ASSERT_TRUE(hashtable_hash_wyhash_seeded("123456789", 9u, 1u) != hashtable_hash_wyhash("123456789", 9u));
+    TEST_ASSERT_TRUE(hashtable_hash_crc32c_seeded("123456789", 9u, 1u) != hashtable_hash_crc32c("123456789", 9u));
+
+    for (unsigned int f = 0u; f < (sizeof(funcs) / sizeof(funcs[0])); f++)
+    {
+        uint32_t buckets[num_buckets];
+        (void) memset(buckets, 0, sizeof(buckets));
+
+        for (uint32_t i = 0u; i < num_keys; i++)
+        {
+            // Keys that only differ in a few bytes, with lengths covering all key length paths
+            char key[64];
+            (void) memset(key, 'k', sizeof(key));
+            (void) memcpy(key + (i % 8u), &i, sizeof(i));
+            buckets[funcs[f](key, sizeof(i) + (i % 8u) + (i % 53u)) % num_buckets] += 1u;
+        }
+
+        for (uint32_t i = 0u; i < num_buckets; i++)
+        {
+            TEST_ASSERT_TRUE(buckets[i] < ((num_keys / num_buckets) * 2u));
+        }
+    }
+}
+
+
+// Tests that a table with a seeded hash function works, and can only be attached with the same seed
+void test_hashtable_seeded_hash_config(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    TEST_ASSERT_TRUE(NULL == config.seeded_hash);
+
+    config.hash = NULL;
+    config.seeded_hash = hashtable_hash_wyhash_seeded;
+    config.seed = 0xfeedfacecafebeefull;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+    _generate_random_items_and_insert(&table, pairs, num_items);
+    _remove_random_items(&table, pairs, num_items, 100);
+    _verify_table_contents(&table, pairs, num_items);
+
+    hashtable_t attached;
+    config.seed += 1u;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_attach(&attached, &config, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_INVALID_BUFFER, hashtable_last_error());
+
+    config.seed -= 1u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_attach(&attached, &config, _buffer, sizeof(_buffer)));
+    _verify_table_contents(&attached, pairs, num_items);
+}
+
+
+// Tests that hashtable_sharded_create rejects invalid shard counts
+void test_hashtable_sharded_create_invalid(void)
+{
+    hashtable_sharded_t table;
+    void *buffers[3] = {_buffer, _buffer + 4096, _buffer + 8192};
+    size_t buffer_sizes[3] = {4096u, 4096u, 4096u};
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_sharded_create(NULL, NULL, 2u, buffers, buffer_sizes));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_NULL_POINTER, hashtable_last_error());
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_sharded_create(&table, NULL, 0u, buffers, buffer_sizes));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_sharded_create(&table, NULL, 3u, buffers, buffer_sizes));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_INVALID_PARAM, hashtable_last_error());
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_sharded_create(&table, NULL, HASHTABLE_MAX_SHARDS * 2u,
+                                                       buffers, buffer_sizes));
+}
+
+
+// Tests inserting, removing and iterating items spread over several shards
+void test_hashtable_sharded_insert_remove_iterate(void)
+{
+    const uint32_t shard_count = 4u;
+    const size_t shard_size = sizeof(_buffer) / shard_count;
+    void *buffers[shard_count];
+    size_t buffer_sizes[shard_count];
+
+    for (uint32_t i = 0u; i < shard_count; i++)
+    {
+        buffers[i] = _buffer + (i * shard_size);
+        buffer_sizes[i] = shard_size;
+    }
+
+    hashtable_sharded_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_create(&table, NULL, shard_count, buffers, buffer_sizes));
+
+    const unsigned int num_items = 1000;
+    _test_keyval_pair_t pairs[num_items];
+
+    for (unsigned int i = 0u; i < num_items; i++)
+    {
+        _rand_str(pairs[i].key, &pairs[i].key_size);
+        _rand_str(pairs[i].value, &pairs[i].value_size);
+        pairs[i].removed = false;
+
+        TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_insert(&table, pairs[i].key, pairs[i].key_size,
+                                                          pairs[i].value, pairs[i].value_size));
+    }
+
+    // Every shard should get some of the keys
+    for (uint32_t i = 0u; i < shard_count; i++)
+    {
+        TEST_ASSERT_TRUE(0u < table.shards[i].entry_count);
+    }
+
+    // Remove some items through the shard functions, and some directly from their shards
+    for (unsigned int i = 0u; i < num_items; i += 3u)
+    {
+        if (0u == (i % 2u))
+        {
+            TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_remove(&table, pairs[i].key, pairs[i].key_size));
+        }
+        else
+        {
+            hashtable_t *shard = hashtable_sharded_shard(&table, pairs[i].key, pairs[i].key_size);
+            TEST_ASSERT_EQUAL_INT(0, hashtable_remove(shard, pairs[i].key, pairs[i].key_size));
+        }
+
+        pairs[i].removed = true;
+    }
+
+    unsigned int num_removed = (num_items + 2u) / 3u;
+    uint32_t entry_count = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_entry_count(&table, &entry_count));
+    TEST_ASSERT_EQUAL_UINT32(num_items - num_removed, entry_count);
+
+    for (unsigned int i = 0u; i < num_items; i++)
+    {
+        char *value = NULL;
+        hashtable_size_t value_size = 0u;
+
+        TEST_ASSERT_EQUAL_INT(pairs[i].removed ? 0 : 1,
+                              hashtable_sharded_has_key(&table, pairs[i].key, pairs[i].key_size));
+
+        if (!pairs[i].removed)
+        {
+            TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_retrieve(&table, pairs[i].key, pairs[i].key_size,
+                                                                &value, &value_size));
+            TEST_ASSERT_EQUAL_INT(pairs[i].value_size, value_size);
+            TEST_ASSERT_EQUAL_INT(0, memcmp(pairs[i].value, value, value_size));
+        }
+    }
+
+    // Iterate twice, to check that the cursor reset covers all shards
+    for (unsigned int pass = 0u; pass < 2u; pass++)
+    {
+        char *key = NULL;
+        char *value = NULL;
+        hashtable_size_t key_size = 0u;
+        unsigned int items = 0u;
+
+        TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_reset_cursor(&table));
+        while (0 == hashtable_sharded_next_item(&table, &key, &key_size, &value, NULL))
+        {
+            TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(hashtable_sharded_shard(&table, key, key_size),
+                                                       key, key_size));
+            items += 1u;
+        }
+
+        TEST_ASSERT_EQUAL_UINT32(entry_count, items);
+    }
+
+    size_t bytes_remaining = 0u;
+    size_t expected_bytes = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_clear(&table));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_entry_count(&table, &entry_count));
+    TEST_ASSERT_EQUAL_UINT32(0u, entry_count);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_sharded_bytes_remaining(&table, &bytes_remaining));
+
+    for (uint32_t i = 0u; i < shard_count; i++)
+    {
+        size_t shard_bytes = 0u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_bytes_remaining(&table.shards[i], &shard_bytes));
+        expected_bytes += shard_bytes;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(expected_bytes, bytes_remaining);
+}
+
+
+// Weak hash function that returns the key data as a 32-bit value
+static uint32_t _identity_hash(const char *data, const hashtable_size_t size)
+{
+    uint32_t hash = 0u;
+    (void) memcpy(&hash, data, (size < sizeof(hash)) ? size : sizeof(hash));
+    return hash;
+}
+
+
+// Insert keys that are all multiples of the array count, hashed by a weak hash function,
+// and verify that they are all found
+static void _weak_hash_insert_and_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _identity_hash;
+    config.engine = engine;
+    config.array_count = 1024u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    for (uint32_t i = 0u; i < 800u; i++)
+    {
+        uint32_t key = i * 1024u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &i, sizeof(i)));
+    }
+
+    for (uint32_t i = 0u; i < 800u; i++)
+    {
+        uint32_t key = i * 1024u;
+        char *value = NULL;
+        size_t value_size = 0u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, (char *) &key, sizeof(key), &value, &value_size));
+        TEST_ASSERT_EQUAL_INT(sizeof(i), value_size);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(value, &i, sizeof(i)));
+    }
+
+    uint32_t missing = 1u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_has_key(&table, (char *) &missing, sizeof(missing)));
+}
+
+
+// Tests array count rounding, and that keys hashed by a weak hash function are all found
+void test_hashtable_array_count_rounding(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _identity_hash;
+    config.array_count = 100u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+    TEST_ASSERT_EQUAL_UINT32(128u, table.config.array_count);
+#else
+    TEST_ASSERT_EQUAL_UINT32(100u, table.config.array_count);
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+    const size_t buffer_sizes[] = {0u, 512u, 4096u, 0xffffu, sizeof(_buffer)};
+    for (unsigned int i = 0u; i < (sizeof(buffer_sizes) / sizeof(buffer_sizes[0])); i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, buffer_sizes[i]));
+        TEST_ASSERT_TRUE(config.array_count >= HASHTABLE_MIN_ARRAY_COUNT);
+        TEST_ASSERT_EQUAL_UINT32(0u, config.array_count & (config.array_count - 1u));
+    }
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+    _weak_hash_insert_and_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Same as test_hashtable_array_count_rounding, but with the open addressing engine
+void test_hashtable_open_addressing_array_count_rounding(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _identity_hash;
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    config.array_count = 1000u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+#ifdef HASHTABLE_POW2_ARRAY_COUNT
+    TEST_ASSERT_EQUAL_UINT32(1024u, table.config.array_count);
+#else
+    TEST_ASSERT_EQUAL_UINT32(1008u, table.config.array_count);
+#endif // HASHTABLE_POW2_ARRAY_COUNT
+
+    _weak_hash_insert_and_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Tests that keys are found after the first item of a list is removed, and lists with one item
+void test_hashtable_remove_list_head(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _identity_hash;
+    config.array_count = 1u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    // All keys are in the same list
+    uint32_t keys[] = {10u, 20u, 30u};
+    for (unsigned int i = 0u; i < 3u; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &keys[i], sizeof(keys[i]), NULL, 0u));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, (char *) &keys[0], sizeof(keys[0])));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_has_key(&table, (char *) &keys[0], sizeof(keys[0])));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &keys[1], sizeof(keys[1])));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &keys[2], sizeof(keys[2])));
+
+    // Only one item left
+    TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, (char *) &keys[2], sizeof(keys[2])));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &keys[1], sizeof(keys[1])));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_has_key(&table, (char *) &keys[2], sizeof(keys[2])));
+
+    // Re-inserted key is the new first item
+    TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, (char *) &keys[1], sizeof(keys[1])));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &keys[0], sizeof(keys[0]), NULL, 0u));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &keys[0], sizeof(keys[0])));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_has_key(&table, (char *) &keys[1], sizeof(keys[1])));
+}
+
+
+// Tests the order that items in one list are read in, and the table array slot size
+void test_hashtable_list_order(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _identity_hash;
+    config.array_count = 1u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    for (uint32_t i = 0u; i < 4u; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &i, sizeof(i), NULL, 0u));
+    }
+
+    for (uint32_t i = 0u; i < 4u; i++)
+    {
+        char *key = NULL;
+        hashtable_size_t key_size = 0u;
+        char *value = NULL;
+        uint32_t read_key = 0u;
+
+        TEST_ASSERT_EQUAL_INT(0, hashtable_next_item(&table, &key, &key_size, &value, NULL));
+        TEST_ASSERT_EQUAL_INT(sizeof(read_key), key_size);
+        (void) memcpy(&read_key, key, sizeof(read_key));
+
+#ifdef HASHTABLE_NO_LIST_TAIL
+        // Newest item first
+        TEST_ASSERT_EQUAL_UINT32(3u - i, read_key);
+#else
+        TEST_ASSERT_EQUAL_UINT32(i, read_key);
+#endif // HASHTABLE_NO_LIST_TAIL
+    }
+
+#ifdef HASHTABLE_NO_LIST_TAIL
+    TEST_ASSERT_EQUAL_INT(sizeof(_HASHTABLE_LINK(_keyval_pair_t)), sizeof(_keyval_pair_list_t));
+#endif // HASHTABLE_NO_LIST_TAIL
+}
+
+
+#ifdef HASHTABLE_BLOOM_FILTER
+// Tests that the bloom filter rules out most keys that do not exist, and is rebuilt by compaction
+void test_hashtable_bloom_filter(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.array_count = 1024u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    uint32_t key = 0u;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_bloom_check(NULL, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_bloom_check(&table, NULL, sizeof(key)));
+
+    for (key = 0u; key < 1000u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+    }
+
+    // No false negatives
+    for (key = 0u; key < 1000u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(1, hashtable_bloom_check(&table, (char *) &key, sizeof(key)));
+    }
+
+    uint32_t rejected = 0u;
+    for (key = 1000u; key < 11000u; key++)
+    {
+        int ret = hashtable_bloom_check(&table, (char *) &key, sizeof(key));
+        TEST_ASSERT_TRUE((0 == ret) || (1 == ret));
+        rejected += (0 == ret) ? 1u : 0u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_has_key(&table, (char *) &key, sizeof(key)));
+    }
+
+    TEST_ASSERT_TRUE(rejected > 9000u);
+
+    // Removed keys are still in the filter until it is rebuilt
+    for (key = 0u; key < 900u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, (char *) &key, sizeof(key)));
+    }
+
+    rejected = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact(&table));
+    for (key = 0u; key < 1000u; key++)
+    {
+        int ret = hashtable_bloom_check(&table, (char *) &key, sizeof(key));
+        if (key < 900u)
+        {
+            rejected += (0 == ret) ? 1u : 0u;
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL_INT(1, ret);
+            TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &key, sizeof(key)));
+        }
+    }
+
+    TEST_ASSERT_TRUE(rejected > 850u);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_clear(&table));
+    key = 999u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bloom_check(&table, (char *) &key, sizeof(key)));
+
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_bloom_check(&table, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_INVALID_PARAM, hashtable_last_error());
+}
+#endif // HASHTABLE_BLOOM_FILTER
+
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t limit;
+} _count_items_ctx_t;
+
+
+static int _count_items(void *ctx, const char *key, hashtable_size_t key_size,
+                        const char *value, hashtable_size_t value_size)
+{
+    _count_items_ctx_t *count_ctx = (_count_items_ctx_t *) ctx;
+
+    TEST_ASSERT_NOT_NULL(key);
+    TEST_ASSERT_NOT_NULL(value);
+    TEST_ASSERT_EQUAL_INT(sizeof(uint32_t), key_size);
+    TEST_ASSERT_EQUAL_INT(sizeof(uint32_t), value_size);
+
+    count_ctx->count += 1u;
+    return (count_ctx->count == count_ctx->limit) ? 1 : 0;
+}
+
+
+// Insert keys that leave runs of empty slots, and verify that cursors over disjoint index
+// ranges, and hashtable_for_each_range, visit every item exactly once
+static void _cursor_ranges_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _identity_hash;
+    config.engine = engine;
+    config.array_count = 4096u;
+
+    hashtable_cursor_t cursor;
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_cursor_init(&table, &cursor, 2u, 1u));
+
+    // Few enough keys to leave whole runs of slots empty, the last 100 colliding with the first 100
+    static uint8_t seen[300];
+    for (uint32_t i = 0u; i < 300u; i++)
+    {
+        uint32_t key = (i < 200u) ? (i * 37u) : (((i - 200u) * 37u) + 8192u);
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &i, sizeof(i)));
+    }
+
+    (void) memset(seen, 0, sizeof(seen));
+    const uint32_t bounds[] = {0u, 1000u, 1001u, 2500u, UINT32_MAX};
+    uint32_t visited = 0u;
+
+    for (unsigned int r = 0u; r < ((sizeof(bounds) / sizeof(bounds[0])) - 1u); r++)
+    {
+        char *key;
+        char *value;
+        hashtable_size_t key_size;
+        hashtable_size_t value_size;
+        int ret;
+
+        TEST_ASSERT_EQUAL_INT(0, hashtable_cursor_init(&table, &cursor, bounds[r], bounds[r + 1u]));
+        while (0 == (ret = hashtable_cursor_next(&table, &cursor, &key, &key_size, &value, &value_size)))
+        {
+            uint32_t index;
+            (void) memcpy(&index, value, sizeof(index));
+            TEST_ASSERT_EQUAL_INT(sizeof(index), key_size);
+            TEST_ASSERT_EQUAL_INT(sizeof(index), value_size);
+            TEST_ASSERT_TRUE(index < 300u);
+            TEST_ASSERT_EQUAL_UINT8(0u, seen[index]);
+            seen[index] = 1u;
+            visited += 1u;
+        }
+
+        TEST_ASSERT_EQUAL_INT(1, ret);
+        TEST_ASSERT_EQUAL_INT(1, hashtable_cursor_next(&table, &cursor, &key, &key_size, &value, &value_size));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(300u, visited);
+
+    _count_items_ctx_t ctx = {0u, 0u};
+    TEST_ASSERT_EQUAL_INT(0, hashtable_for_each_range(&table, 0u, 2000u, _count_items, &ctx));
+    uint32_t first_half = ctx.count;
+    ctx.count = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_for_each_range(&table, 2000u, UINT32_MAX, _count_items, &ctx));
+    TEST_ASSERT_EQUAL_UINT32(table.entry_count, first_half + ctx.count);
+
+    // Stopped by the callback
+    ctx.count = 0u;
+    ctx.limit = 10u;
+    TEST_ASSERT_EQUAL_INT(1, hashtable_for_each_range(&table, 0u, UINT32_MAX, _count_items, &ctx));
+    TEST_ASSERT_EQUAL_UINT32(10u, ctx.count);
+
+    // Emptied slots are skipped again
+    for (uint32_t i = 0u; i < 300u; i++)
+    {
+        uint32_t key = (i < 200u) ? (i * 37u) : (((i - 200u) * 37u) + 8192u);
+        TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, (char *) &key, sizeof(key)));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0u, table.entry_count);
+    ctx.count = 0u;
+    ctx.limit = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_for_each_range(&table, 0u, UINT32_MAX, _count_items, &ctx));
+    TEST_ASSERT_EQUAL_UINT32(0u, ctx.count);
+}
+
+
+// Tests that cursors covering disjoint ranges of a sparse table visit every item exactly once
+void test_hashtable_cursor_ranges(void)
+{
+    hashtable_cursor_t cursor;
+    hashtable_t table;
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_cursor_init(NULL, &cursor, 0u, UINT32_MAX));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_cursor_init(&table, NULL, 0u, UINT32_MAX));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_for_each_range(&table, 0u, UINT32_MAX, NULL, NULL));
+
+    _cursor_ranges_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Same as test_hashtable_cursor_ranges, but with the open addressing engine
+void test_hashtable_open_addressing_cursor_ranges(void)
+{
+    _cursor_ranges_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+typedef struct
+{
+    hashtable_t *table;
+    uint32_t count;
+    uint32_t last_index;
+    uint32_t evict_count;
+} _scan_ctx_t;
+
+
+static int _scan_item(void *ctx, const char *key, hashtable_size_t key_size,
+                      const char *value, hashtable_size_t value_size)
+{
+    _scan_ctx_t *scan_ctx = (_scan_ctx_t *) ctx;
+    uint32_t index;
+
+    TEST_ASSERT_EQUAL_INT(sizeof(index), value_size);
+    (void) memcpy(&index, value, sizeof(index));
+
+    // Pairs are visited in insertion order
+    TEST_ASSERT_TRUE((0u == scan_ctx->count) || (index > scan_ctx->last_index));
+    scan_ctx->last_index = index;
+    scan_ctx->count += 1u;
+
+    if (0u < scan_ctx->evict_count)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_remove(scan_ctx->table, key, key_size));
+        scan_ctx->evict_count -= 1u;
+        return (0u == scan_ctx->evict_count) ? 1 : 0;
+    }
+
+    return 0;
+}
+
+
+// Insert keys of different sizes, remove some, and verify that scanning the data block visits
+// the remaining pairs in insertion order, also during and after a compaction
+static void _scan_arena_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+
+    hashtable_t table;
+    _scan_ctx_t ctx = {&table, 0u, 0u, 0u};
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    // Keys of different sizes, so that removed pairs leave space of different sizes
+    char key[MAX_STR_LEN];
+    (void) memset(key, 'k', sizeof(key));
+    for (uint32_t i = 0u; i < 600u; i++)
+    {
+        (void) memcpy(key, &i, sizeof(i));
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, key, sizeof(i) + (i % 7u), (char *) &i, sizeof(i)));
+    }
+
+    for (uint32_t i = 0u; i < 600u; i += 3u)
+    {
+        (void) memcpy(key, &i, sizeof(i));
+        TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, key, sizeof(i) + (i % 7u)));
+    }
+
+    ctx.count = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_scan_arena(&table, _scan_item, &ctx));
+    TEST_ASSERT_EQUAL_UINT32(400u, ctx.count);
+
+    // Evict the 50 oldest pairs during the scan
+    ctx.count = 0u;
+    ctx.evict_count = 50u;
+    TEST_ASSERT_EQUAL_INT(1, hashtable_scan_arena(&table, _scan_item, &ctx));
+    TEST_ASSERT_EQUAL_UINT32(50u, ctx.count);
+    TEST_ASSERT_EQUAL_UINT32(350u, table.entry_count);
+
+    // Part way through a compaction, pairs on both sides of the compacted space are visited
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact_incremental(&table));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_compact_step(&table, 1024u));
+    ctx.count = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_scan_arena(&table, _scan_item, &ctx));
+    TEST_ASSERT_EQUAL_UINT32(350u, ctx.count);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact(&table));
+    ctx.count = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_scan_arena(&table, _scan_item, &ctx));
+    TEST_ASSERT_EQUAL_UINT32(350u, ctx.count);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_clear(&table));
+    ctx.count = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_scan_arena(&table, _scan_item, &ctx));
+    TEST_ASSERT_EQUAL_UINT32(0u, ctx.count);
+}
+
+
+// Tests that hashtable_scan_arena visits stored pairs in insertion order, and skips removed pairs
+void test_hashtable_scan_arena(void)
+{
+    hashtable_t table;
+    _scan_ctx_t ctx = {&table, 0u, 0u, 0u};
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_scan_arena(NULL, _scan_item, &ctx));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_scan_arena(&table, NULL, &ctx));
+
+    _scan_arena_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Same as test_hashtable_scan_arena, but with the open addressing engine
+void test_hashtable_open_addressing_scan_arena(void)
+{
+    _scan_arena_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Tests that hashtable_get_stats reports the shape of the table, and counts lookups with HASHTABLE_ENABLE_STATS
+void test_hashtable_get_stats(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _constant_hash;
+    config.array_count = 16u;
+
+    hashtable_stats_t stats;
+    hashtable_t table;
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_get_stats(NULL, &stats));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_get_stats(&table, NULL));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    // All keys in one list
+    for (uint32_t key = 0u; key < 64u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &key, sizeof(key)));
+    }
+
+    for (uint32_t key = 0u; key < 64u; key += 4u)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, (char *) &key, sizeof(key)));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_get_stats(&table, &stats));
+    TEST_ASSERT_EQUAL_UINT32(48u, stats.entry_count);
+    TEST_ASSERT_EQUAL_UINT32(table.config.array_count, stats.bucket_count);
+    TEST_ASSERT_EQUAL_UINT32(1u, stats.buckets_used);
+    TEST_ASSERT_EQUAL_UINT32(48u, stats.max_chain_length);
+    TEST_ASSERT_EQUAL_UINT32(16u, stats.freelist_length);
+
+    hashtable_fragmentation_t info;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table, &info));
+#ifdef HASHTABLE_CACHE_ALIGN_PAIRS
+    // Padding in front of pairs is wasted too
+    TEST_ASSERT_TRUE(stats.wasted_bytes >= info.free_bytes);
+#else
+    TEST_ASSERT_EQUAL_UINT32(info.free_bytes, stats.wasted_bytes);
+#endif // HASHTABLE_CACHE_ALIGN_PAIRS
+
+    uint32_t key = 1u;
+    hashtable_stats_t after;
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_get_stats(&table, &after));
+
+#ifdef HASHTABLE_ENABLE_STATS
+    TEST_ASSERT_EQUAL_UINT64(stats.lookups + 1u, after.lookups);
+    TEST_ASSERT_TRUE(after.lookup_probes > stats.lookup_probes);
+    TEST_ASSERT_TRUE(after.lookup_probes <= (stats.lookup_probes + 48u));
+
+    // Re-using a freed pair searches the free lists
+    key = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_get_stats(&table, &after));
+    TEST_ASSERT_EQUAL_UINT64(stats.freelist_searches + 1u, after.freelist_searches);
+    TEST_ASSERT_TRUE(after.freelist_search_steps > stats.freelist_search_steps);
+#else
+    TEST_ASSERT_EQUAL_UINT64(0u, after.lookups);
+    TEST_ASSERT_EQUAL_UINT64(0u, after.lookup_probes);
+    TEST_ASSERT_EQUAL_UINT64(0u, after.freelist_searches);
+#endif // HASHTABLE_ENABLE_STATS
+
+    config.hash = _identity_hash;
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    config.array_count = 256u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    for (key = 0u; key < 100u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_get_stats(&table, &stats));
+    TEST_ASSERT_EQUAL_UINT32(100u, stats.buckets_used);
+    TEST_ASSERT_TRUE(stats.max_chain_length >= 1u);
+#ifndef HASHTABLE_CACHE_ALIGN_PAIRS
+    TEST_ASSERT_EQUAL_UINT32(0u, stats.wasted_bytes);
+#endif // HASHTABLE_CACHE_ALIGN_PAIRS
+}
+
+
+
+// Tests that hashtable_analyze reports chain lengths and the spread of keys over the table array
+void test_hashtable_analyze(void)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = _constant_hash;
+    config.array_count = 16u;
+
+    hashtable_analysis_t analysis;
+    hashtable_t table;
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_analyze(NULL, &analysis));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_analyze(&table, NULL));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    // Empty table
+    TEST_ASSERT_EQUAL_INT(0, hashtable_analyze(&table, &analysis));
+    TEST_ASSERT_EQUAL_UINT32(16u, analysis.histogram[0]);
+    TEST_ASSERT_EQUAL_UINT64(0u, analysis.chi_squared);
+    TEST_ASSERT_EQUAL_UINT32(15u, analysis.chi_squared_expected);
+    TEST_ASSERT_EQUAL_UINT32(HASHTABLE_MIN_ARRAY_COUNT, analysis.recommended_array_count);
+
+    // All keys in one list
+    for (uint32_t key = 0u; key < 48u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_analyze(&table, &analysis));
+    TEST_ASSERT_EQUAL_UINT32(48u, analysis.entry_count);
+    TEST_ASSERT_EQUAL_UINT32(16u, analysis.bucket_count);
+    TEST_ASSERT_EQUAL_UINT32(15u, analysis.histogram[0]);
+    TEST_ASSERT_EQUAL_UINT32(1u, analysis.histogram[HASHTABLE_ANALYSIS_HISTOGRAM_BINS - 1u]);
+    TEST_ASSERT_EQUAL_UINT64((16u * 48u) - 48u, analysis.chi_squared);
+    TEST_ASSERT_EQUAL_UINT32(48u, analysis.recommended_array_count);
+
+    // A reasonable hash function spreads keys close to uniformly
+    config.hash = hashtable_hash_fnv1a;
+    config.array_count = 1024u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    for (uint32_t i = 0u; i < 4096u; i++)
+    {
+        uint32_t key = i * 7919u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_analyze(&table, &analysis));
+
+    uint32_t buckets = 0u;
+    for (uint32_t i = 0u; i < HASHTABLE_ANALYSIS_HISTOGRAM_BINS; i++)
+    {
+        buckets += analysis.histogram[i];
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1024u, buckets);
+    TEST_ASSERT_EQUAL_UINT32(1023u, analysis.chi_squared_expected);
+    TEST_ASSERT_TRUE(analysis.chi_squared < (2u * analysis.chi_squared_expected));
+    TEST_ASSERT_EQUAL_UINT32(4096u, analysis.recommended_array_count);
+
+    // Open addressing counts pairs by distance from their first probed group
+    config.hash = _identity_hash;
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    config.array_count = 256u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    for (uint32_t key = 0u; key < 100u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_analyze(&table, &analysis));
+
+    uint32_t pairs = 0u;
+    for (uint32_t i = 0u; i < HASHTABLE_ANALYSIS_HISTOGRAM_BINS; i++)
+    {
+        pairs += analysis.histogram[i];
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(100u, pairs);
+    TEST_ASSERT_EQUAL_UINT32(256u / HASHTABLE_SLOT_GROUP_SIZE, analysis.bucket_count);
+    TEST_ASSERT_EQUAL_UINT32(128u, analysis.recommended_array_count);
+}
+
+
+
+typedef struct
+{
+    uint32_t allocs;              // Number of successful allocations
+    uint32_t frees;               // Number of frees
+    uint32_t fail_after;          // Fail allocations once this many have been made
+} _alloc_ctx_t;
+
+
+static void *_test_alloc(void *ctx, size_t size)
+{
+    _alloc_ctx_t *alloc_ctx = (_alloc_ctx_t *) ctx;
+    if (alloc_ctx->allocs >= alloc_ctx->fail_after)
+    {
+        return NULL;
+    }
+
+    alloc_ctx->allocs += 1u;
+    return malloc(size);
+}
+
+
+static void _test_free(void *ctx, void *ptr)
+{
+    ((_alloc_ctx_t *) ctx)->frees += 1u;
+    free(ptr);
+}
+
+
+// Insert into a table with an allocator until it has grown several times, and verify that
+// buffers are freed once no longer used, and insertion fails once allocation fails
+static void _allocator_growth_verify(hashtable_engine_t engine)
+{
+    _alloc_ctx_t ctx = {0u, 0u, UINT32_MAX};
+    hashtable_allocator_t allocator = {_test_alloc, _test_free, &ctx};
+
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, 4096u));
+    config.engine = engine;
+    config.array_count = 16u;
+    config.allocator = &allocator;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, NULL, 4096u));
+    TEST_ASSERT_EQUAL_UINT32(1u, ctx.allocs);
+
+    for (uint32_t key = 0u; key < 5000u; key++)
+    {
+        uint32_t value = key * 3u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &value, sizeof(value)));
+    }
+
+    // Buffers no longer in use have been freed, apart from one an incremental resize may still use
+    TEST_ASSERT_TRUE(ctx.allocs > 5u);
+    TEST_ASSERT_TRUE((ctx.allocs - ctx.frees) <= 2u);
+    TEST_ASSERT_EQUAL_UINT32(5000u, table.entry_count);
+
+    // Overwriting with larger values also grows the table
+    for (uint32_t key = 0u; key < 5000u; key++)
+    {
+        uint64_t value = key * 5u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &value, sizeof(value)));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(5000u, table.entry_count);
+
+    for (uint32_t key = 0u; key < 5000u; key++)
+    {
+        char *value;
+        hashtable_size_t value_size;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, (char *) &key, sizeof(key), &value, &value_size));
+        TEST_ASSERT_EQUAL_UINT32(sizeof(uint64_t), value_size);
+
+        uint64_t stored;
+        (void) memcpy(&stored, value, sizeof(stored));
+        TEST_ASSERT_EQUAL_UINT64(key * 5u, stored);
+    }
+
+    // Moving into an allocated buffer with hashtable_resize frees the old one
+    uint32_t frees = ctx.frees;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize(&table, NULL, table.data_size * 2u, 0u));
+    TEST_ASSERT_TRUE(ctx.frees > frees);
+    TEST_ASSERT_EQUAL_UINT32(ctx.allocs - 1u, ctx.frees);
+
+    // Once allocation fails, insertion fails like any full table
+    ctx.fail_after = ctx.allocs;
+    int ret = 0;
+    for (uint32_t key = 5000u; (0 == ret) && (key < 200000u); key++)
+    {
+        ret = hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u);
+    }
+
+    TEST_ASSERT_EQUAL_INT(1, ret);
+    ctx.fail_after = UINT32_MAX;
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_destroy(&table));
+    TEST_ASSERT_EQUAL_UINT32(ctx.allocs, ctx.frees);
+}
+
+
+// Tests that tables with an allocator grow into larger buffers when full, and free them again
+void test_hashtable_allocator_growth(void)
+{
+    _alloc_ctx_t ctx = {0u, 0u, UINT32_MAX};
+    hashtable_allocator_t allocator = {_test_alloc, _test_free, &ctx};
+    hashtable_allocator_t bad_allocator = {_test_alloc, NULL, &ctx};
+
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, 4096u));
+    config.array_count = 16u;
+    config.allocator = &bad_allocator;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_create(&table, &config, NULL, 4096u));
+
+    config.allocator = NULL;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_create(&table, &config, NULL, 4096u));
+
+    _allocator_growth_verify(HASHTABLE_ENGINE_CHAINING);
+
+    // A caller-provided buffer is never freed, but the table can still grow out of it
+    config.allocator = &allocator;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, 4096u));
+
+    for (uint32_t key = 0u; key < 1000u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+    }
+
+    TEST_ASSERT_TRUE(0u < ctx.allocs);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_destroy(&table));
+    TEST_ASSERT_EQUAL_UINT32(ctx.allocs, ctx.frees);
+}
+
+
+// Same as test_hashtable_allocator_growth, but with the open addressing engine
+void test_hashtable_open_addressing_allocator_growth(void)
+{
+    _allocator_growth_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Reserve, commit and abort pairs, and verify the values written in place and the space
+// released by aborting
+static void _reserve_commit_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+    config.array_count = 512u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    char *value;
+    hashtable_size_t value_size;
+
+    // Nothing reserved yet
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_commit(&table));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_abort(&table));
+
+    // Value written in place is visible once committed
+    for (uint32_t key = 0u; key < 200u; key++)
+    {
+        uint32_t val = key * 7u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_reserve(&table, (char *) &key, sizeof(key), sizeof(val), &value));
+        TEST_ASSERT_EQUAL_INT(-1, hashtable_reserve(&table, (char *) &key, sizeof(key), sizeof(val), &value));
+        (void) memcpy(value, &val, sizeof(val));
+        TEST_ASSERT_EQUAL_INT(0, hashtable_commit(&table));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(200u, table.entry_count);
+
+    // Committing a reserved pair replaces the stored pair with the same key
+    uint32_t key = 5u;
+    uint64_t big = 0x1122334455667788u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_reserve(&table, (char *) &key, sizeof(key), sizeof(big), &value));
+    (void) memcpy(value, &big, sizeof(big));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_commit(&table));
+    TEST_ASSERT_EQUAL_UINT32(200u, table.entry_count);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, (char *) &key, sizeof(key), &value, &value_size));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(big), value_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(value, &big, sizeof(big)));
+
+    // Aborting leaves the stored pair untouched and releases the reserved space
+    key = 6u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_reserve(&table, (char *) &key, sizeof(key), 64u, &value));
+    char *reserved = value;
+    (void) memset(value, 0xaa, 64u);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_abort(&table));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_commit(&table));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_reserve(&table, (char *) &key, sizeof(key), 64u, &value));
+    TEST_ASSERT_EQUAL_PTR(reserved, value);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_abort(&table));
+
+    for (key = 0u; key < 200u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, (char *) &key, sizeof(key), &value, &value_size));
+        if (5u != key)
+        {
+            uint32_t stored;
+            TEST_ASSERT_EQUAL_UINT32(sizeof(stored), value_size);
+            (void) memcpy(&stored, value, sizeof(stored));
+            TEST_ASSERT_EQUAL_UINT32(key * 7u, stored);
+        }
+    }
+
+    // Zero-size values are reserved without value space
+    key = 1000u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_reserve(&table, (char *) &key, sizeof(key), 0u, &value));
+    TEST_ASSERT_NULL(value);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_commit(&table));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_UINT32(201u, table.entry_count);
+}
+
+
+// Tests that hashtable_reserve/commit/abort store values written in place, and release space on abort
+void test_hashtable_reserve_commit(void)
+{
+    _reserve_commit_verify(HASHTABLE_ENGINE_CHAINING);
+
+    // A reservation that does not fit reports a full table
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, 4096u));
+    config.array_count = 16u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, 4096u));
+
+    char *value;
+    uint32_t key = 1u;
+    TEST_ASSERT_EQUAL_INT(1, hashtable_reserve(&table, (char *) &key, sizeof(key), 8192u, &value));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_abort(&table));
+}
+
+
+// Same as test_hashtable_reserve_commit, but with the open addressing engine
+void test_hashtable_open_addressing_reserve_commit(void)
+{
+    _reserve_commit_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+#ifdef HASHTABLE_CACHE_ALIGN_PAIRS
+// Check that the header and key data of every stored pair sit in one cache line
+static void _check_pair_alignment(hashtable_t *table, uint32_t key_count)
+{
+    for (uint32_t key = 0u; key < key_count; key++)
+    {
+        char *value;
+        hashtable_size_t value_size;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(table, (char *) &key, sizeof(key), &value, &value_size));
+
+        uintptr_t pair = (uintptr_t) (value - sizeof(key) - sizeof(_keyval_pair_t));
+        TEST_ASSERT_TRUE(((pair % 64u) + sizeof(_keyval_pair_t) + sizeof(key)) <= 64u);
+    }
+}
+
+
+// Insert pairs with values of many sizes, and verify that the header and key of every pair
+// sit in one cache line, also after a compaction
+static void _cache_align_pairs_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+    config.array_count = 1024u;
+
+    hashtable_t table;
+    uint8_t value[100];
+
+    (void) memset(value, 0x5a, sizeof(value));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    // Values of many different sizes, so pairs would otherwise start anywhere in a cache line
+    for (uint32_t key = 0u; key < 400u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) value,
+                                                  (hashtable_size_t) (1u + ((key * 7u) % sizeof(value)))));
+    }
+
+    _check_pair_alignment(&table, 400u);
+
+    // Pairs moved by a compaction are placed in the same way
+    for (uint32_t key = 400u; key < 600u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) value, 13u));
+    }
+
+    for (uint32_t key = 400u; key < 600u; key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, (char *) &key, sizeof(key)));
+    }
+
+    for (uint32_t key = 0u; key < 400u; key += 3u)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_remove(&table, (char *) &key, sizeof(key)));
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) value, 3u));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact(&table));
+    _check_pair_alignment(&table, 400u);
+    TEST_ASSERT_EQUAL_UINT32(400u, table.entry_count);
+}
+
+
+// Tests that the header and key of small-key pairs never straddle a cache line, also after compaction
+void test_hashtable_cache_align_pairs(void)
+{
+    _cache_align_pairs_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Same as test_hashtable_cache_align_pairs, but with the open addressing engine
+void test_hashtable_open_addressing_cache_align_pairs(void)
+{
+    _cache_align_pairs_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+#endif // HASHTABLE_CACHE_ALIGN_PAIRS
+
+
+// Insert pairs with precomputed hashes, and verify that they are found by both the _hashed
+// and the regular functions, also during an incremental resize
+static void _hashed_variants_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.hash = hashtable_hash_fnv1a;
+    config.engine = engine;
+    config.array_count = 512u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    for (uint32_t key = 0u; key < 300u; key++)
+    {
+        uint32_t hash = hashtable_hash(&table, (char *) &key, sizeof(key));
+        TEST_ASSERT_EQUAL_UINT32(hashtable_hash_fnv1a((char *) &key, sizeof(key)), hash);
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert_hashed(&table, hash, (char *) &key, sizeof(key),
+                                                         (char *) &key, sizeof(key)));
+    }
+
+    // Pairs stored with a precomputed hash are found by the regular functions, and vice versa
+    uint32_t key = 1000u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &key, sizeof(key)));
+
+    // Precomputed hashes keep working while pairs are migrated into a new buffer
+    TEST_ASSERT_EQUAL_INT(0, hashtable_resize_incremental(&table, _resize_buffer, sizeof(_resize_buffer), 1024u));
+
+    for (key = 0u; key < 300u; key++)
+    {
+        char *value;
+        hashtable_size_t value_size;
+        uint32_t hash = hashtable_hash(&table, (char *) &key, sizeof(key));
+
+        TEST_ASSERT_EQUAL_INT(1, hashtable_has_key_hashed(&table, hash, (char *) &key, sizeof(key)));
+        TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &key, sizeof(key)));
+        TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve_hashed(&table, hash, (char *) &key, sizeof(key),
+                                                           &value, &value_size));
+        TEST_ASSERT_EQUAL_UINT32(sizeof(key), value_size);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(value, &key, sizeof(key)));
+    }
+
+    key = 1000u;
+    uint32_t hash = hashtable_hash(&table, (char *) &key, sizeof(key));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key_hashed(&table, hash, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_remove_hashed(&table, hash, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_remove_hashed(&table, hash, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_has_key(&table, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_retrieve_hashed(&table, hash, (char *) &key, sizeof(key), NULL, NULL));
+
+    TEST_ASSERT_EQUAL_UINT32(300u, table.entry_count);
+}
+
+
+// Tests that the _hashed variants find the same pairs as the regular functions, also during a resize
+void test_hashtable_hashed_variants(void)
+{
+    _hashed_variants_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Same as test_hashtable_hashed_variants, but with the open addressing engine
+void test_hashtable_open_addressing_hashed_variants(void)
+{
+    _hashed_variants_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Look up or insert keys with hashtable_get_or_insert, and verify that missing keys are
+// stored and existing values are returned without being over-written
+static void _get_or_insert_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+    config.array_count = 512u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    for (uint32_t key = 0u; key < 200u; key++)
+    {
+        char *value = NULL;
+        hashtable_size_t value_size = 0u;
+        uint32_t val = key + 1u;
+
+        TEST_ASSERT_EQUAL_INT(0, hashtable_get_or_insert(&table, (char *) &key, sizeof(key), (char *) &val,
+                                                         sizeof(val), &value, &value_size));
+
+        // New value data is returned straight away
+        TEST_ASSERT_EQUAL_UINT32(sizeof(val), value_size);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(value, &val, sizeof(val)));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(200u, table.entry_count);
+
+    // Existing values are returned and not over-written
+    for (uint32_t key = 0u; key < 200u; key++)
+    {
+        char *value = NULL;
+        hashtable_size_t value_size = 0u;
+        uint64_t other = 0u;
+        uint32_t expected = key + 1u;
+
+        TEST_ASSERT_EQUAL_INT(2, hashtable_get_or_insert(&table, (char *) &key, sizeof(key), (char *) &other,
+                                                         sizeof(other), &value, &value_size));
+        TEST_ASSERT_EQUAL_UINT32(sizeof(expected), value_size);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(value, &expected, sizeof(expected)));
+
+        uint32_t hash = hashtable_hash(&table, (char *) &key, sizeof(key));
+        TEST_ASSERT_EQUAL_INT(2, hashtable_get_or_insert_hashed(&table, hash, (char *) &key, sizeof(key),
+                                                                NULL, 0u, NULL, NULL));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(200u, table.entry_count);
+
+    uint32_t key = 5000u;
+    uint32_t hash = hashtable_hash(&table, (char *) &key, sizeof(key));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_get_or_insert_hashed(&table, hash, (char *) &key, sizeof(key),
+                                                            NULL, 0u, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &key, sizeof(key)));
+}
+
+
+// Tests that hashtable_get_or_insert stores missing keys and returns existing values without over-writing them
+void test_hashtable_get_or_insert(void)
+{
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_get_or_insert(NULL, "a", 1u, NULL, 0u, NULL, NULL));
+
+    _get_or_insert_verify(HASHTABLE_ENGINE_CHAINING);
+
+    // A missing key that does not fit reports a full table, an existing key is still found
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, 4096u));
+    config.array_count = 16u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, 4096u));
+
+    uint32_t key = 1u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+    TEST_ASSERT_EQUAL_INT(2, hashtable_get_or_insert(&table, (char *) &key, sizeof(key), (char *) _buffer,
+                                                     8192u, NULL, NULL));
+
+    key = 2u;
+    TEST_ASSERT_EQUAL_INT(1, hashtable_get_or_insert(&table, (char *) &key, sizeof(key), (char *) _resize_buffer,
+                                                     8192u, NULL, NULL));
+}
+
+
+// Same as test_hashtable_get_or_insert, but with the open addressing engine
+void test_hashtable_open_addressing_get_or_insert(void)
+{
+    _get_or_insert_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+#define BULK_KEY_COUNT (2000u)
+
+// Keys and values passed to hashtable_bulk_load, set up by _bulk_load_init_keys
+static uint32_t _bulk_keys[BULK_KEY_COUNT];
+static uint32_t _bulk_values[BULK_KEY_COUNT];
+static const char *_bulk_key_ptrs[BULK_KEY_COUNT];
+static const char *_bulk_value_ptrs[BULK_KEY_COUNT];
+static hashtable_size_t _bulk_key_sizes[BULK_KEY_COUNT];
+static hashtable_size_t _bulk_value_sizes[BULK_KEY_COUNT];
+
+
+static void _bulk_load_init_keys(void)
+{
+    // Last key is a duplicate of the first one, with a different value
+    for (uint32_t i = 0u; i < BULK_KEY_COUNT; i++)
+    {
+        _bulk_keys[i] = (i == (BULK_KEY_COUNT - 1u)) ? 0u : i;
+        _bulk_values[i] = i * 3u;
+        _bulk_key_ptrs[i] = (const char *) &_bulk_keys[i];
+        _bulk_value_ptrs[i] = (const char *) &_bulk_values[i];
+        _bulk_key_sizes[i] = sizeof(uint32_t);
+        _bulk_value_sizes[i] = sizeof(uint32_t);
+    }
+}
+
+
+#ifndef HASHTABLE_NO_LIST_TAIL
+typedef struct
+{
+    uint32_t keys[BULK_KEY_COUNT];
+    uint32_t count;
+} _arena_order_t;
+
+
+static int _record_arena_order(void *ctx, const char *key, hashtable_size_t key_size,
+                               const char *value, hashtable_size_t value_size)
+{
+    _arena_order_t *order = (_arena_order_t *) ctx;
+    (void) value;
+    (void) value_size;
+
+    TEST_ASSERT_EQUAL_UINT32(sizeof(uint32_t), key_size);
+    TEST_ASSERT_TRUE(order->count < BULK_KEY_COUNT);
+    (void) memcpy(&order->keys[order->count], key, sizeof(uint32_t));
+    order->count += 1u;
+
+    return 0;
+}
+#endif // HASHTABLE_NO_LIST_TAIL
+
+
+// Bulk load keys into a table that already holds some of them, and verify the stored values,
+// and that pairs are stored in the order they are found by iterating over the table
+static void _bulk_load_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+    config.array_count = 4096u;
+
+    static uint32_t hashes[BULK_KEY_COUNT];
+    hashtable_t table;
+    _bulk_load_init_keys();
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    // Stored pairs with the same keys are replaced
+    uint32_t key = 5u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+    key = BULK_KEY_COUNT + 1u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), NULL, 0u));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bulk_load(&table, _bulk_key_ptrs, _bulk_key_sizes, _bulk_value_ptrs,
+                                                 _bulk_value_sizes, NULL, BULK_KEY_COUNT));
+    TEST_ASSERT_EQUAL_UINT32(BULK_KEY_COUNT, table.entry_count);
+
+    for (uint32_t i = 0u; i < (BULK_KEY_COUNT - 1u); i++)
+    {
+        char *value;
+        hashtable_size_t value_size;
+        uint32_t expected = (0u == i) ? ((BULK_KEY_COUNT - 1u) * 3u) : (i * 3u);
+
+        TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, (char *) &_bulk_keys[i], sizeof(_bulk_keys[i]),
+                                                    &value, &value_size));
+        TEST_ASSERT_EQUAL_UINT32(sizeof(expected), value_size);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(value, &expected, sizeof(expected)));
+    }
+
+    // Precomputed hashes give the same result
+    for (uint32_t i = 0u; i < BULK_KEY_COUNT; i++)
+    {
+        hashes[i] = hashtable_hash(&table, _bulk_key_ptrs[i], _bulk_key_sizes[i]);
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bulk_load(&table, _bulk_key_ptrs, _bulk_key_sizes, _bulk_value_ptrs,
+                                                 _bulk_value_sizes, hashes, BULK_KEY_COUNT));
+    TEST_ASSERT_EQUAL_UINT32(BULK_KEY_COUNT - 1u, table.entry_count);
+
+    for (uint32_t i = 1u; i < (BULK_KEY_COUNT - 1u); i++)
+    {
+        TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &_bulk_keys[i], sizeof(_bulk_keys[i])));
+    }
+
+#ifndef HASHTABLE_NO_LIST_TAIL
+    if (HASHTABLE_ENGINE_CHAINING == engine)
+    {
+        // Pairs are stored in the same order as they are found by iterating over the table
+        static _arena_order_t order;
+        order.count = 0u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_scan_arena(&table, _record_arena_order, &order));
+        TEST_ASSERT_EQUAL_UINT32(BULK_KEY_COUNT - 1u, order.count);
+
+        for (uint32_t i = 0u; i < order.count; i++)
+        {
+            char *key_data;
+            char *value;
+            hashtable_size_t key_size;
+            hashtable_size_t value_size;
+            TEST_ASSERT_EQUAL_INT(0, hashtable_next_item(&table, &key_data, &key_size, &value, &value_size));
+            TEST_ASSERT_EQUAL_INT(0, memcmp(key_data, &order.keys[i], sizeof(uint32_t)));
+        }
+    }
+#endif // HASHTABLE_NO_LIST_TAIL
+}
+
+
+// Tests that hashtable_bulk_load stores pairs sorted by bucket, falls back to insertion order
+// when there is no scratch room to sort them, and stores nothing if the pairs do not fit
+void test_hashtable_bulk_load(void)
+{
+    hashtable_t table;
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_bulk_load(NULL, _bulk_key_ptrs, _bulk_key_sizes, NULL, NULL, NULL, 1u));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_bulk_load(&table, NULL, _bulk_key_sizes, NULL, NULL, NULL, 1u));
+
+    _bulk_load_verify(HASHTABLE_ENGINE_CHAINING);
+
+    // Nothing is stored if all pairs do not fit
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, 4096u));
+    config.array_count = 16u;
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, 4096u));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_bulk_load(&table, _bulk_key_ptrs, _bulk_key_sizes, _bulk_value_ptrs,
+                                                 _bulk_value_sizes, NULL, BULK_KEY_COUNT));
+    TEST_ASSERT_EQUAL_UINT32(0u, table.entry_count);
+
+    // A table with an allocator grows to fit them
+    _alloc_ctx_t ctx = {0u, 0u, UINT32_MAX};
+    hashtable_allocator_t allocator = {_test_alloc, _test_free, &ctx};
+    config.allocator = &allocator;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, NULL, 4096u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_bulk_load(&table, _bulk_key_ptrs, _bulk_key_sizes, _bulk_value_ptrs,
+                                                 _bulk_value_sizes, NULL, BULK_KEY_COUNT));
+    TEST_ASSERT_EQUAL_UINT32(BULK_KEY_COUNT - 1u, table.entry_count);
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &_bulk_keys[1000], sizeof(_bulk_keys[1000])));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_destroy(&table));
+    TEST_ASSERT_EQUAL_UINT32(ctx.allocs, ctx.frees);
+}
+
+
+// Same as test_hashtable_bulk_load, but with the open addressing engine
+void test_hashtable_open_addressing_bulk_load(void)
+{
+    _bulk_load_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Fixed-size tables with integer keys, and with keys that need a full compare
+HASHTABLE_DEFINE_FIXED(fixed_u32, 4, 4)
+HASHTABLE_DEFINE_FIXED(fixed_key12, 12, 8)
+
+
+#ifdef HASHTABLE_CACHE_EVICTION
+// Insert keys until the first eviction, retrieving 'hot_key' after every insertion, return the key count
+static uint32_t _fill_cache(hashtable_t *table, uint32_t hot_key)
+{
+    uint64_t value = 0u;
+
+    for (uint32_t key = 0u; key < 100000u; key++)
+    {
+        value = key * 3u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(table, (char *) &key, sizeof(key), (char *) &value, sizeof(value)));
+        TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(table, (char *) &hot_key, sizeof(hot_key)));
+
+        if (table->entry_count != (key + 1u))
+        {
+            return key + 1u;
+        }
+    }
+
+    TEST_FAIL_MESSAGE("Table never evicted a key/value pair");
+    return 0u;
+}
+
+
+// Store pairs with and without a time-to-live, and verify that they expire at the right
+// times, and that a full table evicts cold pairs instead of failing
+static void _cache_eviction_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, 8192u));
+    config.engine = engine;
+    config.array_count = 128u;
+
+    hashtable_t table;
+    uint64_t value = 0u;
+    char *stored;
+    hashtable_size_t stored_size;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, 8192u));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_insert_ttl(&table, "a", 1u, NULL, 0u, 0x80000000u));
+
+    // Pairs expire once the time reaches the time they were stored plus their time-to-live
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 100u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert_ttl(&table, "a", 1u, "1", 1u, 10u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert_ttl(&table, "b", 1u, "2", 1u, 0u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert_ttl(&table, "c", 1u, "3", 1u, 5u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, "c", 1u, "4", 1u));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 109u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, "a", 1u, &stored, &stored_size));
+    TEST_ASSERT_EQUAL_MEMORY("1", stored, 1u);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 110u));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_retrieve(&table, "a", 1u, &stored, &stored_size));
+    TEST_ASSERT_EQUAL_UINT32(2u, table.entry_count);
+
+    // Overwriting with hashtable_insert removed the expiry time
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 0x7fffffffu));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, "b", 1u));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, "c", 1u));
+
+    // Expiry times wrap around with the table time
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 0xfffffff0u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert_ttl(&table, "d", 1u, "5", 1u, 0x20u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 0x0fu));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, "d", 1u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 0x10u));
+    TEST_ASSERT_EQUAL_INT(2, hashtable_get_or_insert(&table, "b", 1u, "6", 1u, &stored, &stored_size));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_get_or_insert(&table, "d", 1u, "7", 1u, &stored, &stored_size));
+    TEST_ASSERT_EQUAL_MEMORY("7", stored, 1u);
+
+    // A full table evicts cold pairs instead of failing, and keeps a pair that is searched for often
+    TEST_ASSERT_EQUAL_INT(0, hashtable_clear(&table));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 0u));
+
+    uint32_t hot_key = 0u;
+    uint32_t key_count = _fill_cache(&table, hot_key);
+    for (uint32_t key = key_count; key < (key_count * 4u); key++)
+    {
+        value = key * 3u;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &value, sizeof(value)));
+        TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &hot_key, sizeof(hot_key)));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(key_count - 1u, table.entry_count);
+
+    // The most recently inserted pairs are still stored, with the right values
+    for (uint32_t key = (key_count * 4u) - 8u; key < (key_count * 4u); key++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, (char *) &key, sizeof(key), &stored, &stored_size));
+        (void) memcpy(&value, stored, sizeof(value));
+        TEST_ASSERT_EQUAL_UINT64(key * 3u, value);
+    }
+
+    // Once every stored pair is referenced, an expired pair is evicted before any of them
+    uint32_t stored_keys[1024];
+    uint32_t stored_count = 0u;
+    for (uint32_t key = 0u; key < (key_count * 4u); key++)
+    {
+        if (1 == hashtable_has_key(&table, (char *) &key, sizeof(key)))
+        {
+            stored_keys[stored_count++] = key;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(table.entry_count, stored_count);
+
+    uint32_t key = 1000000u;
+    value = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert_ttl(&table, (char *) &key, sizeof(key), (char *) &value,
+                                                  sizeof(value), 1u));
+    TEST_ASSERT_EQUAL_UINT32(stored_count, table.entry_count);
+
+    stored_count = 0u;
+    for (uint32_t i = 0u; i < table.entry_count; i++)
+    {
+        if (1 == hashtable_has_key(&table, (char *) &stored_keys[i], sizeof(stored_keys[i])))
+        {
+            stored_keys[stored_count++] = stored_keys[i];
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(table.entry_count - 1u, stored_count);
+    TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &key, sizeof(key)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_set_time(&table, 1u));
+
+    key += 1u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &key, sizeof(key), (char *) &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_UINT32(stored_count + 1u, table.entry_count);
+
+    for (uint32_t i = 0u; i < stored_count; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(1, hashtable_has_key(&table, (char *) &stored_keys[i], sizeof(stored_keys[i])));
+    }
+
+    // A pair larger than any freed pair is stored once enough pairs have been evicted
+    uint8_t large[1024];
+    (void) memset(large, 0xa5, sizeof(large));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, "large", 5u, (char *) large, sizeof(large)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_retrieve(&table, "large", 5u, &stored, &stored_size));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(large), stored_size);
+    TEST_ASSERT_EQUAL_MEMORY(large, stored, sizeof(large));
+
+    // Nothing is evicted for a pair that can never fit
+    uint32_t entry_count = table.entry_count;
+    TEST_ASSERT_EQUAL_INT(1, hashtable_insert(&table, "huge", 4u, (char *) _resize_buffer, 8192u));
+    TEST_ASSERT_EQUAL_UINT32(entry_count, table.entry_count);
+}
+
+
+// Tests that pairs expire after their time-to-live, and that a full table evicts cold pairs by CLOCK instead of failing
+void test_hashtable_cache_eviction(void)
+{
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_set_time(NULL, 0u));
+
+    _cache_eviction_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Same as test_hashtable_cache_eviction, but with the open addressing engine
+void test_hashtable_open_addressing_cache_eviction(void)
+{
+    _cache_eviction_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+#endif // HASHTABLE_CACHE_EVICTION
+
+
+// Number of keys inserted, and number of keys re-inserted after clearing, by test_hashtable_clear_incremental
+#define CLEAR_KEY_COUNT (1000u)
+#define CLEAR_REINSERT_COUNT (100u)
+
+
+// Clear a table holding many keys, re-insert some while table array slots are still being
+// zeroed, and verify that only the re-inserted keys are found and iterated
+static void _clear_incremental_verify(hashtable_engine_t engine)
+{
+    hashtable_config_t config;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = engine;
+    config.array_count = 16384u;
+
+    hashtable_t table;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_create(&table, &config, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_clear_step(&table, 1u));
+
+    for (uint32_t i = 0u; i < CLEAR_KEY_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &i, sizeof(i), (char *) &i, sizeof(i)));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_clear(&table));
+    TEST_ASSERT_EQUAL_UINT32(0u, table.entry_count);
+
+    // Only the chaining engine has table array slots left to zero
+    int expected_step = (HASHTABLE_ENGINE_CHAINING == engine) ? 1 : 0;
+    TEST_ASSERT_EQUAL_INT(expected_step, hashtable_clear_step(&table, 0u));
+
+    // Re-inserted keys are found, with their new values, while slots are still being zeroed
+    for (uint32_t i = 0u; i < CLEAR_REINSERT_COUNT; i++)
+    {
+        uint32_t value = i + CLEAR_KEY_COUNT;
+        TEST_ASSERT_EQUAL_INT(0, hashtable_insert(&table, (char *) &i, sizeof(i), (char *) &value, sizeof(value)));
+    }
+
+    TEST_ASSERT_EQUAL_INT(expected_step, hashtable_clear_step(&table, 1u));
+
+    // Iteration only yields the re-inserted pairs
+    char *key;
+    char *value;
+    hashtable_size_t key_size;
+    hashtable_size_t value_size;
+    uint32_t iterated = 0u;
+    int ret;
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_reset_cursor(&table));
+    while (0 == (ret = hashtable_next_item(&table, &key, &key_size, &value, &value_size)))
+    {
+        uint32_t k;
+        uint32_t v;
+        (void) memcpy(&k, key, sizeof(k));
+        (void) memcpy(&v, value, sizeof(v));
+        TEST_ASSERT_TRUE(k < CLEAR_REINSERT_COUNT);
+        TEST_ASSERT_EQUAL_UINT32(k + CLEAR_KEY_COUNT, v);
+        iterated += 1u;
+    }
+
+    TEST_ASSERT_EQUAL_INT(1, ret);
+    TEST_ASSERT_EQUAL_UINT32(CLEAR_REINSERT_COUNT, iterated);
+
+    // Removed keys stay removed once all slots are zeroed
+    TEST_ASSERT_EQUAL_INT(0, hashtable_clear_step(&table, UINT32_MAX));
+
+    for (uint32_t i = 0u; i < CLEAR_KEY_COUNT; i++)
+    {
+        int expected = (i < CLEAR_REINSERT_COUNT) ? 1 : 0;
+        TEST_ASSERT_EQUAL_INT(expected, hashtable_has_key(&table, (char *) &i, sizeof(i)));
+    }
+
+    hashtable_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_get_stats(&table, &stats));
+    TEST_ASSERT_EQUAL_UINT32(CLEAR_REINSERT_COUNT, stats.entry_count);
+
+    // Table statistics finish an unfinished clear
+    TEST_ASSERT_EQUAL_INT(0, hashtable_clear(&table));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_get_stats(&table, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0u, stats.entry_count);
+    TEST_ASSERT_EQUAL_UINT32(0u, stats.buckets_used);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_clear_step(&table, 0u));
+}
+
+
+// Tests that hashtable_clear leaves table array slots to be zeroed later, and that
+// the table behaves as an empty table while they are
+void test_hashtable_clear_incremental(void)
+{
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_clear_step(NULL, 1u));
+
+    _clear_incremental_verify(HASHTABLE_ENGINE_CHAINING);
+}
+
+
+// Same as test_hashtable_clear_incremental, but with the open addressing engine
+void test_hashtable_open_addressing_clear_incremental(void)
+{
+    _clear_incremental_verify(HASHTABLE_ENGINE_OPEN_ADDRESSING);
+}
+
+
+// Tests that fixed-size table functions fail when invalid parameters are passed
+void test_hashtable_fixed_invalid_params(void)
+{
+    fixed_u32_t table;
+    uint32_t key = 1u;
+
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_create(NULL, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_create(&table, NULL, NULL, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(1, fixed_u32_create(&table, NULL, _buffer, HASHTABLE_FIXED_BUFFER_SIZE(fixed_u32, 1u)));
+    TEST_ASSERT_EQUAL_INT(0, fixed_u32_create(&table, NULL, _buffer, HASHTABLE_FIXED_BUFFER_SIZE(fixed_u32, 2u)));
+
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_insert(NULL, &key, &key));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_insert(&table, NULL, &key));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_insert(&table, &key, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_remove(&table, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_retrieve(&table, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_has_key(&table, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_next_item(NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_reset_cursor(NULL));
+    TEST_ASSERT_EQUAL_INT(-1, fixed_u32_clear(NULL));
+
+    // 2 slots, only 1 can be used
+    TEST_ASSERT_EQUAL_INT(0, fixed_u32_insert(&table, &key, &key));
+    key = 2u;
+    TEST_ASSERT_EQUAL_INT(1, fixed_u32_insert(&table, &key, &key));
+}
+
+
+// Tests that fixed-size tables store, overwrite, remove and iterate entries
+void test_hashtable_fixed_insert_remove_iterate(void)
+{
+    const uint32_t slot_count = 1024u;
+    const uint32_t num_items = 896u - 1u;
+    fixed_u32_t table;
+
+    TEST_ASSERT_EQUAL_INT(0, fixed_u32_create(&table, NULL, _buffer, HASHTABLE_FIXED_BUFFER_SIZE(fixed_u32, slot_count)));
+    TEST_ASSERT_EQUAL_UINT32(slot_count, table.slot_count);
+
+    // Weak hash function, so that entries collide and are shifted back on removal
+    TEST_ASSERT_EQUAL_INT(0, fixed_u32_create(&table, _identity_hash, _buffer, HASHTABLE_FIXED_BUFFER_SIZE(fixed_u32, slot_count)));
+
+    for (uint32_t i = 0u; i < num_items; i++)
+    {
+        uint32_t key = i * 7u;
+        uint32_t value = i;
+        TEST_ASSERT_EQUAL_INT(0, fixed_u32_insert(&table, &key, &value));
+    }
+
+    uint32_t extra = 0xffffffffu;
+    TEST_ASSERT_EQUAL_INT(1, fixed_u32_insert(&table, &extra, &extra));
+    TEST_ASSERT_EQUAL_UINT32(num_items, table.entry_count);
+
+    // Overwrite existing values when the table is full
+    for (uint32_t i = 0u; i < num_items; i += 3u)
+    {
+        uint32_t key = i * 7u;
+        uint32_t value = i + 1000000u;
+        TEST_ASSERT_EQUAL_INT(0, fixed_u32_insert(&table, &key, &value));
+    }
+
+    // Remove every other entry
+    for (uint32_t i = 0u; i < num_items; i += 2u)
+    {
+        uint32_t key = i * 7u;
+        TEST_ASSERT_EQUAL_INT(0, fixed_u32_remove(&table, &key));
+        TEST_ASSERT_EQUAL_INT(1, fixed_u32_remove(&table, &key));
+    }
+
+    for (uint32_t i = 0u; i < num_items; i++)
+    {
+        uint32_t key = i * 7u;
+        uint32_t value = 0u;
+
+        if (0u == (i % 2u))
+        {
+            TEST_ASSERT_EQUAL_INT(0, fixed_u32_has_key(&table, &key));
+            TEST_ASSERT_EQUAL_INT(1, fixed_u32_retrieve(&table, &key, &value));
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL_INT(1, fixed_u32_has_key(&table, &key));
+            TEST_ASSERT_EQUAL_INT(0, fixed_u32_retrieve(&table, &key, &value));
+            TEST_ASSERT_EQUAL_UINT32((0u == (i % 3u)) ? (i + 1000000u) : i, value);
+        }
+    }
+
+    // Each remaining entry is read once
+    uint32_t seen = 0u;
+    uint32_t key;
+    uint32_t value;
+    TEST_ASSERT_EQUAL_INT(0, fixed_u32_reset_cursor(&table));
+    while (0 == fixed_u32_next_item(&table, &key, &value))
+    {
+        TEST_ASSERT_EQUAL_UINT32(0u, key % 7u);
+        TEST_ASSERT_EQUAL_UINT32(1u, (key / 7u) % 2u);
+        seen += 1u;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(table.entry_count, seen);
+    TEST_ASSERT_EQUAL_UINT32(num_items / 2u, seen);
+
+    TEST_ASSERT_EQUAL_INT(0, fixed_u32_clear(&table));
+    TEST_ASSERT_EQUAL_UINT32(0u, table.entry_count);
+    TEST_ASSERT_EQUAL_INT(1, fixed_u32_next_item(&table, NULL, NULL));
+
+    // Keys that are not 4 or 8 bytes
+    fixed_key12_t table12;
+    TEST_ASSERT_EQUAL_INT(0, fixed_key12_create(&table12, hashtable_hash_fnv1a, _buffer, sizeof(_buffer)));
+
+    for (uint32_t i = 0u; i < 1000u; i++)
+    {
+        uint8_t key12[12];
+        uint64_t value64 = ((uint64_t) i) << 32u;
+        (void) memset(key12, 0xaa, sizeof(key12));
+        (void) memcpy(key12 + 8u, &i, sizeof(i));
+        TEST_ASSERT_EQUAL_INT(0, fixed_key12_insert(&table12, key12, &value64));
+    }
+
+    for (uint32_t i = 0u; i < 1000u; i++)
+    {
+        uint8_t key12[12];
+        uint64_t value64 = 0u;
+        (void) memset(key12, 0xaa, sizeof(key12));
+        (void) memcpy(key12 + 8u, &i, sizeof(i));
+        TEST_ASSERT_EQUAL_INT(0, fixed_key12_retrieve(&table12, key12, &value64));
+        TEST_ASSERT_EQUAL_UINT64(((uint64_t) i) << 32u, value64);
+    }
+}
+
+#ifdef HASHTABLE_CONCURRENT
+
+#define CONCURRENT_THREADS (4u)
+#define CONCURRENT_ITEMS_PER_THREAD (2000u)
+
+
+// Tests that hashtable_concurrent_create rejects NULL tables and non-chaining engines
+void test_hashtable_concurrent_create_invalid(void)
+{
+    hashtable_concurrent_t table;
+    hashtable_config_t config;
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_concurrent_create(NULL, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_concurrent_create(&table, &config, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_INVALID_PARAM, hashtable_last_error());
+}
+
+
+static void *_concurrent_worker(void *arg)
+{
+    hashtable_concurrent_t *table = (hashtable_concurrent_t *) arg;
+    static uint32_t next_thread = 0u;
+    uint32_t thread = __atomic_fetch_add(&next_thread, 1u, __ATOMIC_RELAXED) % CONCURRENT_THREADS;
+    char key[32];
+    char value[32];
+    int *failed = malloc(sizeof(int));
+
+    *failed = 0;
+
+    // Each thread uses its own keys, so the final contents of the table are known
+    for (uint32_t i = 0u; i < CONCURRENT_ITEMS_PER_THREAD; i++)
+    {
+        int key_size = snprintf(key, sizeof(key), "thread%u-key%u", thread, i);
+        int value_size = snprintf(value, sizeof(value), "value%u", i);
+        *failed |= hashtable_concurrent_insert(table, key, key_size, value, value_size);
+    }
+
+    // Remove every other key
+    for (uint32_t i = 0u; i < CONCURRENT_ITEMS_PER_THREAD; i += 2u)
+    {
+        int key_size = snprintf(key, sizeof(key), "thread%u-key%u", thread, i);
+        *failed |= hashtable_concurrent_remove(table, key, key_size);
+    }
+
+    for (uint32_t i = 0u; i < CONCURRENT_ITEMS_PER_THREAD; i++)
+    {
+        int key_size = snprintf(key, sizeof(key), "thread%u-key%u", thread, i);
+        int expected_size = snprintf(value, sizeof(value), "value%u", i);
+        char retrieved[32];
+        hashtable_size_t value_size = 0u;
+
+        int ret = hashtable_concurrent_retrieve(table, key, key_size, retrieved, sizeof(retrieved), &value_size);
+        if (0u == (i % 2u))
+        {
+            *failed |= (1 != ret) || (0 != hashtable_concurrent_has_key(table, key, key_size));
+        }
+        else
+        {
+            *failed |= (0 != ret) || (expected_size != (int) value_size) ||
+                       (0 != memcmp(retrieved, value, value_size));
+        }
+    }
+
+    return failed;
+}
+
+
+// Tests that concurrent inserts/removes from several threads leave a consistent table
+void test_hashtable_concurrent_threads_insert_remove(void)
+{
+    hashtable_concurrent_t table;
+    pthread_t threads[CONCURRENT_THREADS];
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_concurrent_create(&table, NULL, _buffer, sizeof(_buffer)));
+
+    for (uint32_t i = 0u; i < CONCURRENT_THREADS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, _concurrent_worker, &table));
+    }
+
+    for (uint32_t i = 0u; i < CONCURRENT_THREADS; i++)
+    {
+        void *failed = NULL;
+        TEST_ASSERT_EQUAL_INT(0, pthread_join(threads[i], &failed));
+        TEST_ASSERT_EQUAL_INT(0, *((int *) failed));
+        free(failed);
+    }
+
+    uint32_t expected_count = CONCURRENT_THREADS * (CONCURRENT_ITEMS_PER_THREAD / 2u);
+    uint32_t entry_count = 0u;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_concurrent_entry_count(&table, &entry_count));
+    TEST_ASSERT_EQUAL_UINT32(expected_count, entry_count);
+
+    // With all locks held, the table can be iterated and compacted like any other table
+    hashtable_t *exclusive = hashtable_concurrent_exclusive_begin(&table);
+    TEST_ASSERT_TRUE(NULL != exclusive);
+    TEST_ASSERT_EQUAL_UINT32(expected_count, exclusive->entry_count);
+
+    uint32_t items = 0u;
+    char *key = NULL;
+    char *value = NULL;
+    hashtable_size_t key_size = 0u;
+    while (0 == hashtable_next_item(exclusive, &key, &key_size, &value, NULL))
+    {
+        items += 1u;
+    }
+    TEST_ASSERT_EQUAL_UINT32(expected_count, items);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_compact(exclusive));
+
+    hashtable_fragmentation_t info;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(exclusive, &info));
+    TEST_ASSERT_EQUAL_UINT32(0u, info.free_blocks);
+    TEST_ASSERT_EQUAL_INT(0, hashtable_concurrent_exclusive_end(&table));
+
+    TEST_ASSERT_EQUAL_INT(1, hashtable_concurrent_has_key(&table, "thread0-key1", 12u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_concurrent_has_key(&table, "thread0-key0", 12u));
+}
+
+#endif // HASHTABLE_CONCURRENT
+
+
+#ifdef HASHTABLE_RCU
+
+#define RCU_READER_THREADS (3u)
+#define RCU_STABLE_KEYS (500u)
+#define RCU_CHURN_KEYS (100u)
+#define RCU_WRITER_ROUNDS (200u)
+
+
+// Tests that hashtable_rcu_create rejects non-chaining engines, and read_begin rejects bad reader IDs
+void test_hashtable_rcu_create_invalid(void)
+{
+    hashtable_rcu_t table;
+    hashtable_config_t config;
+
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_rcu_create(NULL, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_default_config(&config, sizeof(_buffer)));
+    config.engine = HASHTABLE_ENGINE_OPEN_ADDRESSING;
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_rcu_create(&table, &config, _buffer, sizeof(_buffer)));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_create(&table, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(-1, hashtable_rcu_read_begin(&table, HASHTABLE_RCU_READERS));
+    TEST_ASSERT_EQUAL_INT(HASHTABLE_ERROR_INVALID_PARAM, hashtable_last_error());
+}
+
+
+// Tests that a replaced or removed pair is not reused while a reader may still hold its value
+void test_hashtable_rcu_removed_pair_kept_for_reader(void)
+{
+    hashtable_rcu_t table;
+    char *value = NULL;
+    hashtable_size_t value_size = 0u;
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_create(&table, NULL, _buffer, sizeof(_buffer)));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_insert(&table, "key", 3u, "value1", 6u));
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_read_begin(&table, 0u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_retrieve(&table, "key", 3u, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT(6, value_size);
+
+    // Replacing and then removing the key must not touch the value held by the reader
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_insert(&table, "key", 3u, "value2", 6u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_remove(&table, "key", 3u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_has_key(&table, "key", 3u));
+    TEST_ASSERT_EQUAL_INT(0u, table.table.entry_count);
+
+    for (uint32_t i = 0u; i < 100u; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_insert(&table, (char *) &i, sizeof(i), "value3", 6u));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, memcmp(value, "value1", 6u));
+    TEST_ASSERT_EQUAL_INT(1, hashtable_rcu_reclaim(&table));
+
+    hashtable_fragmentation_t info;
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table.table, &info));
+    TEST_ASSERT_EQUAL_UINT32(0u, info.free_blocks);
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_read_end(&table, 0u));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_reclaim(&table));
+    TEST_ASSERT_EQUAL_INT(0, hashtable_fragmentation(&table.table, &info));
+    TEST_ASSERT_EQUAL_UINT32(2u, info.free_blocks);
+}
+
+
+typedef struct
+{
+    hashtable_rcu_t *table;
+    uint32_t reader;
+    volatile int *stop;
+    int failed;
+} _rcu_reader_args_t;
+
+
+static int _rcu_value_matches(uint32_t key, const char *value, hashtable_size_t value_size)
+{
+    char expected[32];
+    int expected_size = snprintf(expected, sizeof(expected), "value%u", key);
+
+    // Values are "value<key>" followed by a round number, so any mix-up shows
+    return (value_size > (hashtable_size_t) expected_size) && (0 == memcmp(value, expected, expected_size));
+}
+
+
+static void *_rcu_reader(void *arg)
+{
+    _rcu_reader_args_t *args = (_rcu_reader_args_t *) arg;
+    uint32_t key = args->reader;
+
+    while (!__atomic_load_n(args->stop, __ATOMIC_RELAXED))
+    {
+        char *value = NULL;
+        hashtable_size_t value_size = 0u;
+
+        key = (key + 7u) % (RCU_STABLE_KEYS + RCU_CHURN_KEYS);
+
+        (void) hashtable_rcu_read_begin(args->table, args->reader);
+        int ret = hashtable_rcu_retrieve(args->table, (char *) &key, sizeof(key), &value, &value_size);
+
+        if (0 == ret)
+        {
+            args->failed |= !_rcu_value_matches(key, value, value_size);
+        }
+        else if (key < RCU_STABLE_KEYS)
+        {
+            // Stable keys are replaced, but never removed
+            args->failed = 1;
+        }
+
+        (void) hashtable_rcu_read_end(args->table, args->reader);
+    }
+
+    return NULL;
+}
+
+
+// Tests that reader threads always see complete values while one writer replaces and removes keys
+void test_hashtable_rcu_threads_readers_one_writer(void)
+{
+    hashtable_rcu_t table;
+    pthread_t threads[RCU_READER_THREADS];
+    _rcu_reader_args_t args[RCU_READER_THREADS];
+    volatile int stop = 0;
+    char value[32];
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_create(&table, NULL, _buffer, sizeof(_buffer)));
+
+    for (uint32_t key = 0u; key < RCU_STABLE_KEYS; key++)
+    {
+        int value_size = snprintf(value, sizeof(value), "value%u-0", key);
+        TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_insert(&table, (char *) &key, sizeof(key), value, value_size));
+    }
+
+    for (uint32_t i = 0u; i < RCU_READER_THREADS; i++)
+    {
+        args[i].table = &table;
+        args[i].reader = i;
+        args[i].stop = &stop;
+        args[i].failed = 0;
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, _rcu_reader, &args[i]));
+    }
+
+    for (uint32_t round = 1u; round <= RCU_WRITER_ROUNDS; round++)
+    {
+        // Replace some stable values, and add or remove all churn keys
+        for (uint32_t key = round % 10u; key < RCU_STABLE_KEYS; key += 10u)
+        {
+            int value_size = snprintf(value, sizeof(value), "value%u-%u", key, round);
+            TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_insert(&table, (char *) &key, sizeof(key), value, value_size));
+        }
+
+        for (uint32_t key = RCU_STABLE_KEYS; key < (RCU_STABLE_KEYS + RCU_CHURN_KEYS); key++)
+        {
+            if (0u == (round % 2u))
+            {
+                TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_remove(&table, (char *) &key, sizeof(key)));
+            }
+            else
+            {
+                int value_size = snprintf(value, sizeof(value), "value%u-%u", key, round);
+                TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_insert(&table, (char *) &key, sizeof(key),
+                                                              value, value_size));
+            }
+        }
+    }
+
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+    for (uint32_t i = 0u; i < RCU_READER_THREADS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, pthread_join(threads[i], NULL));
+        TEST_ASSERT_EQUAL_INT(0, args[i].failed);
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, hashtable_rcu_synchronize(&table));
+    TEST_ASSERT_EQUAL_UINT32(RCU_STABLE_KEYS, table.table.entry_count);
+}
+
+#endif // HASHTABLE_RCU
+
+
 int main(void)
 {
     UNITY_BEGIN();
@@ -981,9 +4156,16 @@ int main(void)
     RUN_TEST(test_hashtable_reset_cursor_null_table);
     RUN_TEST(test_hashtable_default_config_null_config);
     RUN_TEST(test_hashtable_clear_null_table);
+    RUN_TEST(test_hashtable_fragmentation_null_table);
+    RUN_TEST(test_hashtable_compact_null_table);
+    RUN_TEST(test_hashtable_attach_null_table);
+    RUN_TEST(test_hashtable_save_load_null_table);
+    RUN_TEST(test_hashtable_batch_null_table);
 
     // Woohoo now the more fun tests
+#ifndef HASHTABLE_CACHE_EVICTION
     RUN_TEST(test_hashtable_insert_buffer_full);
+#endif // HASHTABLE_CACHE_EVICTION
     RUN_TEST(test_hashtable_retrieve_no_such_key);
     RUN_TEST(test_hashtable_remove_no_such_key);
     RUN_TEST(test_hashtable_insert1000items);
@@ -1000,6 +4182,83 @@ int main(void)
     RUN_TEST(test_hashtable_insert_retrieve_zero_value_valid_ptr);
     RUN_TEST(test_hashtable_insert_retrieve_nonzero_value_invalid_ptr);
     RUN_TEST(test_hashtable_insert_retrieve_clear_insertagain_clearagain);
+    RUN_TEST(test_hashtable_insert_retrieve_remove_colliding_hashes);
+    RUN_TEST(test_hashtable_resize_all_items_migrated);
+    RUN_TEST(test_hashtable_resize_buffer_too_small);
+    RUN_TEST(test_hashtable_resize_incremental);
+    RUN_TEST(test_hashtable_open_addressing_insert1000items_remove500);
+    RUN_TEST(test_hashtable_open_addressing_insert_remove_churn);
+#ifndef HASHTABLE_CACHE_EVICTION
+    RUN_TEST(test_hashtable_open_addressing_slots_full);
+#endif // HASHTABLE_CACHE_EVICTION
+    RUN_TEST(test_hashtable_open_addressing_resize_incremental);
+    RUN_TEST(test_hashtable_fragmentation_remove_reinsert);
+    RUN_TEST(test_hashtable_fragmentation_split_large_free_block);
+    RUN_TEST(test_hashtable_compact_reclaims_removed_space);
+    RUN_TEST(test_hashtable_open_addressing_compact_reclaims_removed_space);
+    RUN_TEST(test_hashtable_compact_incremental);
+    RUN_TEST(test_hashtable_compact_during_resize);
+    RUN_TEST(test_hashtable_attach_existing_buffer);
+    RUN_TEST(test_hashtable_open_addressing_attach_existing_buffer);
+    RUN_TEST(test_hashtable_attach_invalid_buffer);
+    RUN_TEST(test_hashtable_save_load_all_items_restored);
+    RUN_TEST(test_hashtable_load_invalid_snapshot);
+    RUN_TEST(test_hashtable_batch_insert_retrieve);
+    RUN_TEST(test_hashtable_open_addressing_batch_insert_retrieve);
+#ifndef HASHTABLE_CACHE_EVICTION
+    RUN_TEST(test_hashtable_insert_batch_buffer_full);
+#endif // HASHTABLE_CACHE_EVICTION
+    RUN_TEST(test_hashtable_last_error);
+    RUN_TEST(test_hashtable_builtin_hash_functions);
+    RUN_TEST(test_hashtable_seeded_hash_config);
+    RUN_TEST(test_hashtable_sharded_create_invalid);
+    RUN_TEST(test_hashtable_sharded_insert_remove_iterate);
+    RUN_TEST(test_hashtable_array_count_rounding);
+    RUN_TEST(test_hashtable_open_addressing_array_count_rounding);
+    RUN_TEST(test_hashtable_remove_list_head);
+    RUN_TEST(test_hashtable_list_order);
+#ifdef HASHTABLE_BLOOM_FILTER
+    RUN_TEST(test_hashtable_bloom_filter);
+#endif // HASHTABLE_BLOOM_FILTER
+    RUN_TEST(test_hashtable_cursor_ranges);
+    RUN_TEST(test_hashtable_open_addressing_cursor_ranges);
+    RUN_TEST(test_hashtable_scan_arena);
+    RUN_TEST(test_hashtable_open_addressing_scan_arena);
+    RUN_TEST(test_hashtable_get_stats);
+    RUN_TEST(test_hashtable_analyze);
+#ifndef HASHTABLE_CACHE_EVICTION
+    RUN_TEST(test_hashtable_allocator_growth);
+    RUN_TEST(test_hashtable_open_addressing_allocator_growth);
+#endif // HASHTABLE_CACHE_EVICTION
+    RUN_TEST(test_hashtable_reserve_commit);
+    RUN_TEST(test_hashtable_open_addressing_reserve_commit);
+#ifdef HASHTABLE_CACHE_ALIGN_PAIRS
+    RUN_TEST(test_hashtable_cache_align_pairs);
+    RUN_TEST(test_hashtable_open_addressing_cache_align_pairs);
+#endif // HASHTABLE_CACHE_ALIGN_PAIRS
+    RUN_TEST(test_hashtable_hashed_variants);
+    RUN_TEST(test_hashtable_open_addressing_hashed_variants);
+    RUN_TEST(test_hashtable_get_or_insert);
+    RUN_TEST(test_hashtable_open_addressing_get_or_insert);
+    RUN_TEST(test_hashtable_bulk_load);
+    RUN_TEST(test_hashtable_open_addressing_bulk_load);
+#ifdef HASHTABLE_CACHE_EVICTION
+    RUN_TEST(test_hashtable_cache_eviction);
+    RUN_TEST(test_hashtable_open_addressing_cache_eviction);
+#endif // HASHTABLE_CACHE_EVICTION
+    RUN_TEST(test_hashtable_clear_incremental);
+    RUN_TEST(test_hashtable_open_addressing_clear_incremental);
+    RUN_TEST(test_hashtable_fixed_invalid_params);
+    RUN_TEST(test_hashtable_fixed_insert_remove_iterate);
+#ifdef HASHTABLE_CONCURRENT
+    RUN_TEST(test_hashtable_concurrent_create_invalid);
+    RUN_TEST(test_hashtable_concurrent_threads_insert_remove);
+#endif // HASHTABLE_CONCURRENT
+#ifdef HASHTABLE_RCU
+    RUN_TEST(test_hashtable_rcu_create_invalid);
+    RUN_TEST(test_hashtable_rcu_removed_pair_kept_for_reader);
+    RUN_TEST(test_hashtable_rcu_threads_readers_one_writer);
+#endif // HASHTABLE_RCU
 
     return UNITY_END();
 }